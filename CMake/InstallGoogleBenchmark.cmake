@@ -0,0 +1,59 @@
+find_package (benchmark QUIET ${LUGGCGL_BENCHMARK_MIN_VERSION})
+if (NOT benchmark_FOUND)
+	FetchContent_Declare (
+		benchmark
+		GIT_REPOSITORY [[https://github.com/google/benchmark.git]]
+		GIT_TAG "v${LUGGCGL_BENCHMARK_DOWNLOAD_VERSION}"
+		GIT_SHALLOW ON
+	)
+
+	FetchContent_GetProperties (benchmark)
+	if (NOT benchmark_POPULATED)
+		message (STATUS "Cloning benchmark…")
+		FetchContent_Populate (benchmark)
+	endif ()
+
+	set (benchmark_INSTALL_DIR "${FETCHCONTENT_BASE_DIR}/benchmark-install")
+	if (NOT EXISTS "${benchmark_INSTALL_DIR}")
+		file (MAKE_DIRECTORY ${benchmark_INSTALL_DIR})
+	endif ()
+
+	message (STATUS "Setting up CMake for benchmark…")
+	execute_process (
+		COMMAND ${CMAKE_COMMAND} -G "${CMAKE_GENERATOR}"
+		                         -A "${CMAKE_GENERATOR_PLATFORM}"
+		                         -DBENCHMARK_ENABLE_TESTING=OFF
+		                         -DBENCHMARK_ENABLE_GTEST_TESTS=OFF
+		                         -DCMAKE_INSTALL_PREFIX=${benchmark_INSTALL_DIR}
+		                         -DCMAKE_BUILD_TYPE=Release
+		                         ${benchmark_SOURCE_DIR}
+		OUTPUT_VARIABLE stdout
+		ERROR_VARIABLE stderr
+		RESULT_VARIABLE result
+		WORKING_DIRECTORY ${benchmark_BINARY_DIR}
+	)
+	if (result)
+		message (FATAL_ERROR "CMake setup for benchmark failed: ${result}\n"
+		                     "Standard output: ${stdout}\n"
+		                     "Error output: ${stderr}")
+	endif ()
+
+	message (STATUS "Building and installing benchmark…")
+	execute_process (
+		COMMAND ${CMAKE_COMMAND} --build ${benchmark_BINARY_DIR}
+		                         --config Release
+		                         --target install
+		OUTPUT_VARIABLE stdout
+		ERROR_VARIABLE stderr
+		RESULT_VARIABLE result
+	)
+	if (result)
+		message (FATAL_ERROR "Build step for benchmark failed: ${result}\n"
+		                     "Standard output: ${stdout}\n"
+		                     "Error output: ${stderr}")
+	endif ()
+
+	list (APPEND CMAKE_PREFIX_PATH ${benchmark_INSTALL_DIR}/lib/cmake)
+
+	set (benchmark_INSTALL_DIR)
+endif ()
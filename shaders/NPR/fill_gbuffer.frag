@@ -2,9 +2,9 @@
 
 uniform vec3 light_position;
 uniform vec3 camera_position;
-uniform vec3 diffuse_color;
 uniform float thickness;
 uniform bool is_sketching;
+uniform float resolution_scale; // keeps hatching as large on screen whatever the resolution
 
 in VS_OUT {
 	vec3 vertex;
@@ -12,6 +12,7 @@ in VS_OUT {
 	vec3 normal;
 	vec3 tangent;
 	vec3 binormal;
+	flat vec3 diffuse_color;
 } fs_in;
 
 out vec4 frag_color;
@@ -26,7 +27,7 @@ float balance(float sample_scale, float weight)
 
 float diagonal(float sample_scale, float thickness, float direction) 
 {
-	vec2 pixel = floor(vec2(gl_FragCoord));
+	vec2 pixel = floor(vec2(gl_FragCoord) / resolution_scale);
 	float a = 1.0;
 	float stroke_direction = pixel.x - pixel.y * direction;
 	float b = mod(stroke_direction, thickness);
@@ -38,7 +39,7 @@ float diagonal(float sample_scale, float thickness, float direction)
 }
 
 float circles(float sample_scale, float thickness) {
-  vec2 pixel = floor(vec2(gl_FragCoord));
+  vec2 pixel = floor(vec2(gl_FragCoord) / resolution_scale);
   float b = thickness / 2.0;
   if (mod((pixel.y), thickness * 2.0) > thickness)
     pixel.x += b;
@@ -68,7 +69,7 @@ void main()
 		frag_color = vec4(1.0) * clamp(dot(normalize(fs_in.normal), L), 0.0, 1.0);
 	else
 	{
-		vec3 color = diffuse_color;
+		vec3 color = fs_in.diffuse_color;
 		vec3 V = normalize(camera_position - fs_in.vertex);
 		vec3 shaded_color = shade(L, V, fs_in.normal, color);
 
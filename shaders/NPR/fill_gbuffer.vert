@@ -1,4 +1,5 @@
-#version 410
+#version 430
+#extension GL_ARB_shader_draw_parameters : require
 
 struct ViewProjTransforms
 {
@@ -11,14 +12,32 @@ layout (std140) uniform CameraViewProjTransforms
 	ViewProjTransforms camera;
 };
 
-uniform mat4 vertex_model_to_world;
-uniform mat4 normal_model_to_world;
+// One per mesh of the batch being drawn, indexed by the base instance of
+// its draw command; see `bonobo::draw_data`.
+struct Draw
+{
+	mat4 vertex_model_to_world;
+	mat4 normal_model_to_world;
+	vec4 diffuse_color;
+	vec4 bounds_min;
+	vec4 bounds_max;
+};
+
+layout (std430, binding = 4) readonly buffer Draws
+{
+	Draw draws[];
+};
+
+uniform bool are_directions_octahedral;
 
+// Directions are either three floats, a normalised 10:10:10:2 integer,
+// or two normalised 16-bit integers holding an octahedral encoding; see
+// `bonobo::vertex_layout`.
 layout (location = 0) in vec3 vertex;
-layout (location = 1) in vec3 normal;
+layout (location = 1) in vec4 normal;
 layout (location = 2) in vec3 texcoord;
-layout (location = 3) in vec3 tangent;
-layout (location = 4) in vec3 binormal;
+layout (location = 3) in vec4 tangent;
+layout (location = 4) in vec4 binormal;
 
 out VS_OUT {
 	vec3 vertex;
@@ -26,15 +45,31 @@ out VS_OUT {
 	vec3 normal;
 	vec3 tangent;
 	vec3 binormal;
+	flat vec3 diffuse_color;
 } vs_out;
 
 
+vec3 decodeDirection(vec4 encoded)
+{
+	if (!are_directions_octahedral)
+		return encoded.xyz;
+
+	vec3 direction = vec3(encoded.xy, 1.0 - abs(encoded.x) - abs(encoded.y));
+	if (direction.z < 0.0)
+		direction.xy = (1.0 - abs(direction.yx)) * vec2(direction.x >= 0.0 ? 1.0 : -1.0, direction.y >= 0.0 ? 1.0 : -1.0);
+	return direction;
+}
+
 void main() {
-	vs_out.vertex = vec3(vertex_model_to_world * vec4(vertex, 1.0));
+	Draw draw = draws[gl_BaseInstanceARB];
+	mat3 normal_model_to_world = mat3(draw.normal_model_to_world);
+
+	vs_out.vertex = vec3(draw.vertex_model_to_world * vec4(vertex, 1.0));
 	vs_out.texcoord = texcoord.xy;
-	vs_out.normal   = normalize(normal);
-	vs_out.tangent  = normalize(tangent);
-	vs_out.binormal = normalize(binormal);
+	vs_out.normal   = normalize(normal_model_to_world * decodeDirection(normal));
+	vs_out.tangent  = normalize(normal_model_to_world * decodeDirection(tangent));
+	vs_out.binormal = normalize(normal_model_to_world * decodeDirection(binormal));
+	vs_out.diffuse_color = draw.diffuse_color.rgb;
 
-	gl_Position = camera.view_projection * vertex_model_to_world * vec4(vertex, 1.0);
+	gl_Position = camera.view_projection * draw.vertex_model_to_world * vec4(vertex, 1.0);
 }
@@ -3,6 +3,9 @@
 uniform sampler2D diffuse_texture;
 uniform sampler2D silhouette_texture;
 uniform bool is_sketching;
+uniform bool has_silhouette; // if not set, silhouette_texture is left unbound
+uniform ivec2 render_size;   // texels rendered to, from the lower-left corner of both textures
+uniform ivec2 output_size;   // which both textures can be larger than
 
 
 in VS_OUT {
@@ -11,15 +14,73 @@ in VS_OUT {
 
 out vec4 frag_color;
 
+// How fast texels stop contributing to the upsampled colour, as their
+// colour strays from the one of the closest texel.
+const float colour_sharpness = 50.0;
+
+bool isLine(vec3 silhouette)
+{
+	return length(silhouette) < 0.9;
+}
+
 void main()
 {
-	vec3 diffuse  = texture(diffuse_texture,  fs_in.texcoord).rgb;
-	vec3 silhouette  = texture(silhouette_texture,  fs_in.texcoord).rgb;
+	vec3 final_color;
+
+	if (render_size == output_size) {
+		ivec2 texel = min(ivec2(fs_in.texcoord * vec2(render_size)), render_size - 1);
+		final_color = is_sketching ? vec3(1.0) : texelFetch(diffuse_texture, texel, 0).rgb;
+
+		if (has_silhouette) {
+			vec3 silhouette = texelFetch(silhouette_texture, texel, 0).rgb;
+			if (isLine(silhouette))
+				final_color = silhouette;
+		}
+	} else {
+		// Rendered at a lower resolution: go through the four closest
+		// texels. Colours get filtered bilinearly, except across edges
+		// where they differ from the closest texel, which would otherwise
+		// get blurred. Lines are kept or left out as a whole depending on
+		// how much they cover, so that they stay as sharp as at full
+		// resolution rather than fading out.
+		vec2 position = fs_in.texcoord * vec2(render_size) - 0.5;
+		ivec2 base = ivec2(floor(position));
+		vec2 fraction = position - vec2(base);
+		ivec2 closest = clamp(ivec2(floor(position + 0.5)), ivec2(0), render_size - 1);
+		vec3 guide = texelFetch(diffuse_texture, closest, 0).rgb;
+
+		vec3 diffuse_sum = vec3(0.0);
+		float diffuse_weight = 0.0;
+		vec3 line_sum = vec3(0.0);
+		float line_coverage = 0.0;
+		for (int i = 0; i < 4; ++i) {
+			ivec2 offset = ivec2(i & 1, i >> 1);
+			ivec2 texel = clamp(base + offset, ivec2(0), render_size - 1);
+			vec2 weights = mix(1.0 - fraction, fraction, vec2(offset));
+			float bilinear = weights.x * weights.y;
+
+			if (!is_sketching) {
+				vec3 diffuse = texelFetch(diffuse_texture, texel, 0).rgb;
+				vec3 difference = diffuse - guide;
+				float weight = bilinear * exp(-colour_sharpness * dot(difference, difference));
+				diffuse_sum += weight * diffuse;
+				diffuse_weight += weight;
+			}
 
-	vec3 final_color = is_sketching ? vec3(1.0) : diffuse;
+			if (has_silhouette) {
+				vec3 silhouette = texelFetch(silhouette_texture, texel, 0).rgb;
+				if (isLine(silhouette)) {
+					line_sum += bilinear * silhouette;
+					line_coverage += bilinear;
+				}
+			}
+		}
 
-	if (length(silhouette) < 0.9)
-		final_color = silhouette;
+		// The closest texel always weighs at least a quarter.
+		final_color = is_sketching ? vec3(1.0) : diffuse_sum / diffuse_weight;
+		if (line_coverage >= 0.5)
+			final_color = line_sum / line_coverage;
+	}
 
 	frag_color =  vec4(final_color, 1.0);
 }
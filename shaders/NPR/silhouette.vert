@@ -1,4 +1,5 @@
 #version 430
+#extension GL_ARB_shader_draw_parameters : require
 
 struct ViewProjTransforms
 {
@@ -11,7 +12,20 @@ layout (std140) uniform CameraViewProjTransforms
 	ViewProjTransforms camera;
 };
 
-uniform mat4 vertex_model_to_world;
+// See NPR/fill_gbuffer.vert.
+struct Draw
+{
+	mat4 vertex_model_to_world;
+	mat4 normal_model_to_world;
+	vec4 diffuse_color;
+	vec4 bounds_min;
+	vec4 bounds_max;
+};
+
+layout (std430, binding = 4) readonly buffer Draws
+{
+	Draw draws[];
+};
 
 layout (location = 0) in vec3 vertex;
 layout (location = 2) in vec3 texcoord;
@@ -23,6 +37,8 @@ out VS_OUT {
 
 
 void main() {
+	mat4 vertex_model_to_world = draws[gl_BaseInstanceARB].vertex_model_to_world;
+
 	vs_out.texcoord = texcoord.xy;
 	vs_out.vertex = vec3(vertex_model_to_world * vec4(vertex, 1.0));
 	gl_Position = camera.view_projection * vertex_model_to_world * vec4(vertex, 1.0);
@@ -0,0 +1,15 @@
+#version 430
+
+// Expand the segments appended by silhouette_edges.comp.
+
+uniform uint segment_vertices_capacity;
+
+layout (std430, binding = 2) readonly buffer SegmentVertices
+{
+	vec4 segment_vertices[];
+};
+
+void main() {
+	// Segments which did not fit are collapsed, and get clipped away.
+	gl_Position = uint(gl_VertexID) < segment_vertices_capacity ? segment_vertices[gl_VertexID] : vec4(0.0);
+}
@@ -0,0 +1,467 @@
+#include "benchmark.hpp"
+#include "nprr.hpp"
+
+#include "config.hpp"
+#include "core/Log.h"
+#ifdef LUGGCGL_HAS_HEADLESS
+#include "core/HeadlessContext.hpp"
+#endif
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+	struct Options
+	{
+		std::vector<std::string> scenes{"Sphere", "Sofa", "Face", "LEGO", "Sponza"}; // same as the Objects enum of nprr.cpp
+		std::vector<std::string> styles{"sketch", "comic"};
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> sizes{{640u, 360u}, {1280u, 720u}};
+		std::uint32_t frames_nb{30u};
+		std::uint32_t warmup_frames_nb{5u};
+		std::string path_filename{config::resources_path("camera_paths/benchmark_orbit.txt")};
+		std::string json_filename;
+		std::string csv_filename;
+		std::string label;
+		std::string baseline_filename;
+		float threshold{10.0f}; // in percent
+	};
+
+	//! \brief Timings of one metric, in milliseconds.
+	struct Metric
+	{
+		std::string name;
+		float average{0.0f};
+		float min{0.0f};
+		float max{0.0f};
+		float p99{0.0f};
+		std::size_t samples_nb{0u};
+	};
+
+	struct Case
+	{
+		std::string scene;
+		std::string style;
+		std::uint32_t width{0u};
+		std::uint32_t height{0u};
+		bool is_complete{false};
+		std::vector<Metric> metrics;
+	};
+
+	// scene, style, width, height and metric
+	using MetricKey = std::tuple<std::string, std::string, std::uint32_t, std::uint32_t, std::string>;
+
+	void printUsage(char const *program)
+	{
+		std::fprintf(stderr,
+					 "Usage: %s --benchmark [options]\n"
+					 "\n"
+					 "Renders every scene, style and size along the same camera path,\n"
+					 "without writing any frame, and reports the GPU time of each pass and\n"
+					 "the CPU time of each frame.\n"
+					 "\n"
+					 "Options:\n"
+					 "  --scenes <a,b,...>     scenes to render (default: Sphere,Sofa,Face,LEGO,Sponza)\n"
+					 "  --styles <a,b>         sketch and/or comic (default: sketch,comic)\n"
+					 "  --sizes <wxh,...>      resolutions to render at (default: 640x360,1280x720)\n"
+					 "  --frames <count>       timed frames per case (default: 30)\n"
+					 "  --warmup <count>       frames rendered before timing (default: 5)\n"
+					 "  --path <file>          batch script to take the camera path from\n"
+					 "                         (default: res/camera_paths/benchmark_orbit.txt)\n"
+					 "  --json <file>          write the report as JSON\n"
+					 "  --csv <file>           write the report as CSV, one metric per row\n"
+					 "  --label <text>         label of this run in the reports, e.g. a commit\n"
+					 "  --baseline <file>      CSV report to compare against\n"
+					 "  --threshold <percent>  slow-down over the baseline counted as a\n"
+					 "                         regression (default: 10)\n",
+					 program);
+	}
+
+	std::vector<std::string> splitList(std::string const &list)
+	{
+		std::vector<std::string> items;
+		std::istringstream stream(list);
+		std::string item;
+		while (std::getline(stream, item, ','))
+			if (!item.empty())
+				items.push_back(item);
+		return items;
+	}
+
+	bool parseOptions(int argc, char *argv[], Options &options)
+	{
+		for (int i = 2; i < argc; ++i)
+		{
+			auto const argument = std::string(argv[i]);
+			if (i + 1 >= argc)
+				return false;
+			auto const value = std::string(argv[++i]);
+			if (argument == "--scenes")
+				options.scenes = splitList(value);
+			else if (argument == "--styles")
+			{
+				options.styles = splitList(value);
+				for (auto const &style : options.styles)
+					if (style != "sketch" && style != "comic")
+						return false;
+			}
+			else if (argument == "--sizes")
+			{
+				options.sizes.clear();
+				for (auto const &size : splitList(value))
+				{
+					std::uint32_t width = 0u, height = 0u;
+					if (std::sscanf(size.c_str(), "%ux%u", &width, &height) != 2 || width == 0u || height == 0u)
+						return false;
+					options.sizes.emplace_back(width, height);
+				}
+			}
+			else if (argument == "--frames")
+				options.frames_nb = static_cast<std::uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+			else if (argument == "--warmup")
+				options.warmup_frames_nb = static_cast<std::uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+			else if (argument == "--path")
+				options.path_filename = value;
+			else if (argument == "--json")
+				options.json_filename = value;
+			else if (argument == "--csv")
+				options.csv_filename = value;
+			else if (argument == "--label")
+				options.label = value;
+			else if (argument == "--baseline")
+				options.baseline_filename = value;
+			else if (argument == "--threshold")
+				options.threshold = std::strtof(value.c_str(), nullptr);
+			else
+				return false;
+		}
+
+		return options.frames_nb != 0u && !options.scenes.empty() && !options.styles.empty() && !options.sizes.empty();
+	}
+
+	Metric toMetric(std::string const &name, GPUTimers::Statistics const &statistics)
+	{
+		Metric metric;
+		metric.name = name;
+		metric.average = statistics.average;
+		metric.min = statistics.min;
+		metric.max = statistics.max;
+		metric.p99 = statistics.p99;
+		metric.samples_nb = statistics.samples_nb;
+		return metric;
+	}
+
+	// Same statistics as the GPU passes, see `GPUTimers::GetStatistics()`.
+	Metric toMetric(std::string const &name, std::vector<float> durations)
+	{
+		Metric metric;
+		metric.name = name;
+		metric.samples_nb = durations.size();
+		if (durations.empty())
+			return metric;
+
+		auto const minmax = std::minmax_element(durations.begin(), durations.end());
+		metric.min = *minmax.first;
+		metric.max = *minmax.second;
+		float sum = 0.0f;
+		for (auto const duration : durations)
+			sum += duration;
+		metric.average = sum / static_cast<float>(durations.size());
+
+		auto const p99 = durations.begin() + static_cast<std::ptrdiff_t>((durations.size() * 99u) / 100u);
+		std::nth_element(durations.begin(), p99, durations.end());
+		metric.p99 = *p99;
+
+		return metric;
+	}
+
+	std::string metricName(std::string name)
+	{
+		std::transform(name.begin(), name.end(), name.begin(), [](char c)
+					   { return c == ' ' || c == '-' ? '_' : static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+		return "gpu_" + name;
+	}
+
+	// Strings written to the reports only come from the command line and
+	// the OpenGL implementation; escape the characters JSON requires to.
+	std::string escapeJSON(std::string const &text)
+	{
+		std::string escaped;
+		for (auto const c : text)
+		{
+			if (c == '"' || c == '\\')
+				escaped += '\\';
+			if (static_cast<unsigned char>(c) >= 0x20u)
+				escaped += c;
+		}
+		return escaped;
+	}
+
+	bool writeJSON(std::string const &filename, Options const &options, std::string const &renderer,
+				   std::string const &gl_version, std::vector<Case> const &cases)
+	{
+		std::ofstream json(filename);
+		if (!json)
+		{
+			LogError("Failed to open \"%s\" for writing", filename.c_str());
+			return false;
+		}
+
+		json << "{\n"
+			 << "\t\"label\": \"" << escapeJSON(options.label) << "\",\n"
+			 << "\t\"renderer\": \"" << escapeJSON(renderer) << "\",\n"
+			 << "\t\"gl_version\": \"" << escapeJSON(gl_version) << "\",\n"
+			 << "\t\"camera_path\": \"" << escapeJSON(options.path_filename) << "\",\n"
+			 << "\t\"frames\": " << options.frames_nb << ",\n"
+			 << "\t\"warmup_frames\": " << options.warmup_frames_nb << ",\n"
+			 << "\t\"cases\": [";
+		for (std::size_t i = 0u; i < cases.size(); ++i)
+		{
+			auto const &benchmark_case = cases[i];
+			json << (i == 0u ? "\n" : ",\n")
+				 << "\t\t{\n"
+				 << "\t\t\t\"scene\": \"" << escapeJSON(benchmark_case.scene) << "\",\n"
+				 << "\t\t\t\"style\": \"" << benchmark_case.style << "\",\n"
+				 << "\t\t\t\"width\": " << benchmark_case.width << ",\n"
+				 << "\t\t\t\"height\": " << benchmark_case.height << ",\n"
+				 << "\t\t\t\"complete\": " << (benchmark_case.is_complete ? "true" : "false") << ",\n"
+				 << "\t\t\t\"metrics\": {";
+			for (std::size_t j = 0u; j < benchmark_case.metrics.size(); ++j)
+			{
+				auto const &metric = benchmark_case.metrics[j];
+				json << (j == 0u ? "\n" : ",\n")
+					 << "\t\t\t\t\"" << metric.name << "\": {"
+					 << "\"avg_ms\": " << metric.average << ", \"min_ms\": " << metric.min
+					 << ", \"max_ms\": " << metric.max << ", \"p99_ms\": " << metric.p99
+					 << ", \"samples\": " << metric.samples_nb << "}";
+			}
+			json << "\n\t\t\t}\n\t\t}";
+		}
+		json << "\n\t]\n}\n";
+
+		if (!json)
+		{
+			LogError("Failed to write \"%s\"", filename.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	bool writeCSV(std::string const &filename, Options const &options, std::vector<Case> const &cases)
+	{
+		std::ofstream csv(filename);
+		if (!csv)
+		{
+			LogError("Failed to open \"%s\" for writing", filename.c_str());
+			return false;
+		}
+
+		// Labels are free text; keep them from adding columns.
+		auto label = options.label;
+		std::replace(label.begin(), label.end(), ',', ';');
+
+		csv << "label,scene,style,width,height,metric,avg_ms,min_ms,max_ms,p99_ms,samples\n";
+		for (auto const &benchmark_case : cases)
+			for (auto const &metric : benchmark_case.metrics)
+				csv << label << ',' << benchmark_case.scene << ',' << benchmark_case.style << ','
+					<< benchmark_case.width << ',' << benchmark_case.height << ',' << metric.name << ','
+					<< metric.average << ',' << metric.min << ',' << metric.max << ',' << metric.p99 << ','
+					<< metric.samples_nb << '\n';
+
+		if (!csv)
+		{
+			LogError("Failed to write \"%s\"", filename.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	bool readCSV(std::string const &filename, std::map<MetricKey, float> &averages)
+	{
+		std::ifstream csv(filename);
+		if (!csv)
+		{
+			LogError("Failed to open baseline \"%s\"", filename.c_str());
+			return false;
+		}
+
+		std::string line;
+		std::getline(csv, line); // header
+		for (std::size_t line_number = 2u; std::getline(csv, line); ++line_number)
+		{
+			if (line.empty())
+				continue;
+
+			std::vector<std::string> fields;
+			std::istringstream stream(line);
+			std::string field;
+			while (std::getline(stream, field, ','))
+				fields.push_back(field);
+			if (fields.size() != 11u)
+			{
+				LogError("%s:%zu: expected 11 fields, got %zu", filename.c_str(), line_number, fields.size());
+				return false;
+			}
+
+			auto const key = MetricKey{fields[1], fields[2],
+									   static_cast<std::uint32_t>(std::strtoul(fields[3].c_str(), nullptr, 10)),
+									   static_cast<std::uint32_t>(std::strtoul(fields[4].c_str(), nullptr, 10)),
+									   fields[5]};
+			averages[key] = std::strtof(fields[6].c_str(), nullptr);
+		}
+
+		return true;
+	}
+
+	//! \brief Print how the average of each metric changed since the
+	//!        baseline, and return the number of regressions.
+	std::size_t compareWithBaseline(std::map<MetricKey, float> const &baseline, std::vector<Case> const &cases, float threshold)
+	{
+		std::size_t regressions_nb = 0u;
+		std::printf("\n%-8s %-7s %-10s %-30s %10s %10s %8s\n", "scene", "style", "size", "metric", "base (ms)", "now (ms)", "change");
+		for (auto const &benchmark_case : cases)
+		{
+			char size[24];
+			std::snprintf(size, sizeof(size), "%ux%u", benchmark_case.width, benchmark_case.height);
+			for (auto const &metric : benchmark_case.metrics)
+			{
+				auto const baseline_metric = baseline.find(MetricKey{benchmark_case.scene, benchmark_case.style,
+																	 benchmark_case.width, benchmark_case.height, metric.name});
+				if (baseline_metric == baseline.end() || baseline_metric->second <= 0.0f)
+					continue;
+
+				auto const change = 100.0f * (metric.average - baseline_metric->second) / baseline_metric->second;
+				bool const is_regression = change > threshold;
+				if (is_regression)
+					++regressions_nb;
+				std::printf("%-8s %-7s %-10s %-30s %10.3f %10.3f %+7.1f%%%s\n", benchmark_case.scene.c_str(), benchmark_case.style.c_str(), size,
+							metric.name.c_str(), baseline_metric->second, metric.average, change, is_regression ? "  REGRESSION" : "");
+			}
+		}
+		return regressions_nb;
+	}
+} // namespace
+
+int edan35::runBenchmark(int argc, char *argv[])
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		printUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+#ifdef LUGGCGL_HAS_HEADLESS
+	// Bonobo would initialise GLFW, which fails without a display; only
+	// the logging part of it is needed here.
+	Log::Init();
+
+	HeadlessSettings path_settings;
+	std::map<MetricKey, float> baseline;
+	if (!loadBatchScript(options.path_filename, path_settings)
+		|| (!options.baseline_filename.empty() && !readCSV(options.baseline_filename, baseline)))
+	{
+		Log::Destroy();
+		return EXIT_FAILURE;
+	}
+
+	bool is_valid = true;
+	std::vector<Case> cases;
+	std::string renderer, gl_version;
+	{
+		HeadlessContext context;
+		is_valid = context.IsValid();
+		if (is_valid)
+		{
+			renderer = reinterpret_cast<char const *>(glGetString(GL_RENDERER));
+			gl_version = reinterpret_cast<char const *>(glGetString(GL_VERSION));
+		}
+
+		for (auto const &scene : options.scenes)
+			for (auto const &style : options.styles)
+				for (auto const &size : options.sizes)
+				{
+					if (!is_valid)
+						break;
+
+					// Only the camera path is taken from the script, so that
+					// all cases render the same frames.
+					HeadlessSettings settings;
+					settings.camera_path = path_settings.camera_path;
+					settings.frames_per_second = path_settings.frames_per_second;
+					settings.scene = scene;
+					settings.is_sketching = style == "sketch";
+					settings.width = size.first;
+					settings.height = size.second;
+					settings.frames_nb = options.warmup_frames_nb + options.frames_nb;
+					settings.warmup_frames_nb = options.warmup_frames_nb;
+					settings.write_frames = false;
+
+					LogInfo("Benchmarking %s in the %s style at %ux%u", scene.c_str(), style.c_str(), size.first, size.second);
+					Case benchmark_case;
+					benchmark_case.scene = scene;
+					benchmark_case.style = style;
+					benchmark_case.width = size.first;
+					benchmark_case.height = size.second;
+					try
+					{
+						NPRR nprr(settings);
+						nprr.run();
+
+						auto const &report = nprr.GetHeadlessReport();
+						benchmark_case.is_complete = report.is_complete;
+						benchmark_case.metrics.push_back(toMetric("cpu_frame", report.cpu_frame_times));
+						for (std::size_t pass = 0u; pass < report.pass_names.size(); ++pass)
+							if (report.pass_statistics[pass].samples_nb != 0u)
+								benchmark_case.metrics.push_back(toMetric(metricName(report.pass_names[pass]), report.pass_statistics[pass]));
+					}
+					catch (std::runtime_error const &e)
+					{
+						LogError(e.what());
+						is_valid = false;
+					}
+
+					if (!benchmark_case.is_complete)
+					{
+						LogError("Benchmark of %s in the %s style at %ux%u did not complete", scene.c_str(), style.c_str(), size.first, size.second);
+						is_valid = false;
+					}
+					cases.push_back(benchmark_case);
+				}
+	}
+
+	if (!options.json_filename.empty())
+		is_valid = writeJSON(options.json_filename, options, renderer, gl_version, cases) && is_valid;
+	if (!options.csv_filename.empty())
+		is_valid = writeCSV(options.csv_filename, options, cases) && is_valid;
+
+	if (!baseline.empty())
+	{
+		auto const regressions_nb = compareWithBaseline(baseline, cases, options.threshold);
+		if (regressions_nb != 0u)
+		{
+			LogError("%zu metrics are more than %.1f%% slower than in \"%s\"", regressions_nb, options.threshold, options.baseline_filename.c_str());
+			is_valid = false;
+		}
+	}
+
+	Log::Destroy();
+	return is_valid ? EXIT_SUCCESS : EXIT_FAILURE;
+#else
+	LogError("Benchmarking is not available: EGL was not found when configuring the build.");
+	return EXIT_FAILURE;
+#endif
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace edan35
+{
+	//! \brief Render every scene, in both styles and at several sizes,
+	//!        along a fixed camera path, and report their timings.
+	//!
+	//! Each case runs headlessly through a `HeadlessContext`, without
+	//! writing any frame; after a few warm-up frames, the GPU time of each
+	//! pass and the CPU time of each frame are recorded, and written as
+	//! JSON and/or CSV files which can be compared across commits. Given a
+	//! CSV report of an earlier run, the average times of both runs are
+	//! compared, and the run fails if any of them regressed by more than
+	//! a threshold.
+	//!
+	//! @param [in] argc number of arguments, `argv[1]` being "--benchmark"
+	//! @param [in] argv arguments, see `NPRR --benchmark --help`
+	//! @return EXIT_SUCCESS if all cases ran without regressing
+	int runBenchmark(int argc, char *argv[]);
+}
@@ -0,0 +1,47 @@
+#include "camera_path.hpp"
+
+#include "interpolation.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+void
+camera_path::evaluate(path const& camera_path, float const time,
+                      glm::vec3& position, glm::vec3& target)
+{
+	auto const& keyframes = camera_path.keyframes;
+	assert(!keyframes.empty());
+
+	if (keyframes.size() == 1u || time <= keyframes.front().time) {
+		position = keyframes.front().position;
+		target = keyframes.front().target;
+		return;
+	}
+	if (time >= keyframes.back().time) {
+		position = keyframes.back().position;
+		target = keyframes.back().target;
+		return;
+	}
+
+	// Index of the keyframe starting the segment `time` falls in.
+	auto const next = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+	                                   [](float value, keyframe const& k) { return value < k.time; });
+	auto const i = static_cast<std::size_t>(next - keyframes.begin()) - 1u;
+
+	auto const& k0 = keyframes[i == 0u ? 0u : i - 1u];
+	auto const& k1 = keyframes[i];
+	auto const& k2 = keyframes[i + 1u];
+	auto const& k3 = keyframes[std::min(i + 2u, keyframes.size() - 1u)];
+
+	auto const segment_duration = k2.time - k1.time;
+	auto const x = segment_duration > 0.0f ? (time - k1.time) / segment_duration : 0.0f;
+
+	position = interpolation::evalCatmullRom(k0.position, k1.position, k2.position, k3.position, camera_path.tension, x);
+	target = interpolation::evalCatmullRom(k0.target, k1.target, k2.target, k3.target, camera_path.tension, x);
+}
+
+float
+camera_path::duration(path const& camera_path)
+{
+	return camera_path.keyframes.empty() ? 0.0f : camera_path.keyframes.back().time;
+}
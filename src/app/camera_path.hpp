@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace camera_path
+{
+	//! \brief Where the camera is, and what it looks at, at a given time.
+	struct keyframe
+	{
+		float time{0.0f};         //!< in seconds
+		glm::vec3 position{0.0f};
+		glm::vec3 target{0.0f};
+	};
+
+	//! \brief Keyframes sorted by increasing time, along with the tension
+	//!        of the Catmull-Rom spline going through them.
+	struct path
+	{
+		std::vector<keyframe> keyframes;
+		float tension{0.5f};
+	};
+
+	//! \brief Compute where the camera is, and what it looks at, at a
+	//!        given time along a path.
+	//!
+	//! Both the positions and the targets go through a Catmull-Rom
+	//! spline, see `interpolation::evalCatmullRom()`; the first and last
+	//! keyframes are repeated so that the spline passes through all of
+	//! them, and times outside of the path stay on those keyframes.
+	//!
+	//! @param [in] camera_path path to evaluate; it should contain at least
+	//!             one keyframe
+	//! @param [in] time in seconds
+	//! @param [out] position position of the camera
+	//! @param [out] target point the camera looks at
+	void evaluate(path const& camera_path, float time,
+	              glm::vec3& position, glm::vec3& target);
+
+	//! \brief Time of the last keyframe, or 0 for an empty path.
+	float duration(path const& camera_path);
+}
@@ -3,8 +3,7 @@
 glm::vec3
 interpolation::evalLERP(glm::vec3 const& p0, glm::vec3 const& p1, float const x)
 {
-	//! \todo Implement this function
-	return glm::vec3();
+	return (1.0f - x) * p0 + x * p1;
 }
 
 glm::vec3
@@ -12,6 +11,12 @@ interpolation::evalCatmullRom(glm::vec3 const& p0, glm::vec3 const& p1,
                               glm::vec3 const& p2, glm::vec3 const& p3,
                               float const t, float const x)
 {
-	//! \todo Implement this function
-	return glm::vec3();
+	// q(x) = [1 x x² x³] · M · [p0 p1 p2 p3]ᵀ, with M the Catmull-Rom
+	// basis for tension t; the rows of M are expanded below.
+	auto const x2 = x * x;
+	auto const x3 = x2 * x;
+	return p1
+	     + x  * (-t * p0 + t * p2)
+	     + x2 * (2.0f * t * p0 + (t - 3.0f) * p1 + (3.0f - 2.0f * t) * p2 - t * p3)
+	     + x3 * (-t * p0 + (2.0f - t) * p1 + (t - 2.0f) * p2 + t * p3);
 }
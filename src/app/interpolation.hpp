@@ -25,13 +25,13 @@ namespace interpolation
 	//! @param [in] p1 \f$p[i]\f$
 	//! @param [in] p2 \f$p[i+1]\f$
 	//! @param [in] p3 \f$p[i+2]\f$
-	//! @param [in] t tension
+	//! @param [in] t tension; 0.5 gives the usual Catmull-Rom spline
 	//! @param [in] x distance ratio between p1 and p2 at which the
 	//!               interpolated point should be:
-	//!               * x == 0.0: result will be p0;
-	//!               * x == 1.0: result will be p1;
-	//!               * x == 0.5: result will be the midpoint of [p0,p1]
-	//!               * x ∈ ]0,1[: result will be somewhere on ]p0,p1[
+	//!               * x == 0.0: result will be p1;
+	//!               * x == 1.0: result will be p2;
+	//!               * x ∈ ]0,1[: result will be somewhere on the curve
+	//!                 between p1 and p2
 	//! @return interpolated position
 	glm::vec3 evalCatmullRom(glm::vec3 const&p0, glm::vec3 const&p1,
 	                         glm::vec3 const&p2, glm::vec3 const&p3,
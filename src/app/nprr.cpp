@@ -3,14 +3,26 @@
 #define GLM_FORCE_PURE 1
 
 #include "nprr.hpp"
+#include "benchmark.hpp"
 #include "parametric_shapes.hpp"
 
 #include "config.hpp"
 #include "core/Bonobo.h"
+#include "core/DynamicResolution.hpp"
 #include "core/FPSCamera.h"
+#include "core/FrameWriter.hpp"
+#include "core/gl_resources.hpp"
+#include "core/gl_state.hpp"
+#include "core/GPUTimers.hpp"
+#ifdef LUGGCGL_HAS_HEADLESS
+#include "core/HeadlessContext.hpp"
+#endif
 #include "core/helpers.hpp"
 #include "core/node.hpp"
 #include "core/opengl.hpp"
+#include "core/Profiler.h"
+#include "core/RenderGraph.hpp"
+#include "core/SceneRegistry.hpp"
 #include "core/ShaderProgramManager.hpp"
 
 #include <imgui.h>
@@ -19,11 +31,20 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <tinyfiledialogs.h>
 
+#include <algorithm>
 #include <array>
+#include <cassert>
+#include <chrono>
 #include <clocale>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
 #include <stdexcept>
 #include <random>
+#include <thread>
 
 namespace constant
 {
@@ -31,6 +52,17 @@ namespace constant
 	constexpr uint32_t noise_res_y = 1024;
 
 	constexpr float scale_lengths = 100.0f; // The scene is expressed in centimetres rather than metres, hence the x100.
+
+	constexpr GLuint silhouette_edges_group_size = 64u; // Has to match `local_size_x` in NPR/silhouette_edges.comp.
+	constexpr GLuint max_silhouette_groups_x = 65535u;
+	constexpr GLuint max_silhouette_segment_vertices = 1u << 22u; // 64 MiB worth of clip-space positions
+
+	constexpr GLuint cull_draws_group_size = 64u;	// Has to match `local_size_x` in NPR/cull_draws.comp.
+	constexpr GLsizei depth_pyramid_group_size = 8; // Has to match `local_size_x` and `local_size_y` in NPR/depth_pyramid.comp.
+	constexpr GLuint cull_meshlets_group_size = 64u; // Has to match `local_size_x` in NPR/cull_meshlets.comp.
+
+	constexpr GLsizei render_target_granularity = 128; // Resizing within 128 pixels keeps the same render targets.
+	constexpr std::chrono::milliseconds resize_delay{200}; // How long the window size has to stay the same before targets follow it.
 }
 
 namespace
@@ -53,17 +85,12 @@ namespace
 		Count
 	};
 
-	enum class Texture : uint32_t
-	{
-		DepthBuffer = 0u,
-		GBufferDiffuse,
-		Noise,
-		Silhouette,
-		Result,
-		Count
-	};
-	using Textures = std::array<GLuint, toU(Texture::Count)>;
-	Textures createTextures(GLsizei framebuffer_width, GLsizei framebuffer_height);
+	bonobo::gl::texture createNoiseTexture();
+
+	// Meshes get drawn a batch at a time, through multi-draw indirect
+	// calls whose draws find their data through gl_BaseInstanceARB; both
+	// are needed from the very first pass.
+	bool isBatchDrawingSupported();
 
 	enum class Sampler : uint32_t
 	{
@@ -73,40 +100,15 @@ namespace
 		Shadow,
 		Count
 	};
-	using Samplers = std::array<GLuint, toU(Sampler::Count)>;
+	using Samplers = std::array<bonobo::gl::sampler, toU(Sampler::Count)>;
 	Samplers createSamplers();
 
-	enum class FBO : uint32_t
-	{
-		GBuffer = 0u,
-		Noise,
-		Silhouette,
-		Resolve,
-		FinalWithDepth,
-		Count
-	};
-	using FBOs = std::array<GLuint, toU(FBO::Count)>;
-	FBOs createFramebufferObjects(Textures const &textures);
-
-	enum class ElapsedTimeQuery : uint32_t
-	{
-		GbufferGeneration = 0u,
-		Noise,
-		Silhouette,
-		Resolve,
-		GUI,
-		CopyToFramebuffer,
-		Count
-	};
-	using ElapsedTimeQueries = std::array<GLuint, toU(ElapsedTimeQuery::Count)>;
-	ElapsedTimeQueries createElapsedTimeQueries();
-
 	enum class UBO : uint32_t
 	{
 		CameraViewProjTransforms = 0u,
 		Count
 	};
-	using UBOs = std::array<GLuint, toU(UBO::Count)>;
+	using UBOs = std::array<bonobo::gl::buffer, toU(UBO::Count)>;
 	UBOs createUniformBufferObjects();
 
 	struct ViewProjTransforms
@@ -118,36 +120,127 @@ namespace
 	struct GBufferShaderLocations
 	{
 		GLuint ubo_CameraViewProjTransforms{0u};
-		GLuint vertex_model_to_world{0u};
-		GLuint normal_model_to_world{0u};
 		GLuint camera_position{0u};
 		GLuint light_position{0u};
-		GLuint diffuse_color{0u};
 		GLuint is_sketching{0u};
 		GLuint thickness{0u};
+		GLuint resolution_scale{0u};
+		GLuint are_directions_octahedral{0u};
 	};
 	void fillGBufferShaderLocations(GLuint gbuffer_shader, GBufferShaderLocations &locations);
 
 	struct SilhouetteShaderLocations
 	{
 		GLuint ubo_CameraViewProjTransforms{0u};
-		GLuint vertex_model_to_world{0u};
-		GLuint normal_model_to_world{0u};
 		GLuint light_position{0u};
 		GLuint noise_texture{0u};
 		GLuint is_sketching{0u};
 	};
 	void fillSilhouetteShaderLocations(GLuint silhouette_shader, SilhouetteShaderLocations &locations);
+
+	enum class SilhouetteBackend : uint32_t
+	{
+		GeometryShader = 0u, // one primitive per triangle, with its adjacency
+		EdgesGeometryShader, // one primitive per unique edge
+		ComputeShader,
+		Count
+	};
+
+	struct SilhouetteEdgesShaderLocations
+	{
+		GLuint ubo_CameraViewProjTransforms{0u};
+		GLuint vertex_model_to_world{0u};
+		GLuint light_position{0u};
+		GLuint noise_texture{0u};
+		GLuint is_sketching{0u};
+		GLuint edges_nb{0u};
+		GLuint first_edge{0u};
+		GLuint positions_offset{0u};
+		GLuint segment_vertices_capacity{0u};
+	};
+	void fillSilhouetteEdgesShaderLocations(GLuint silhouette_edges_shader, SilhouetteEdgesShaderLocations &locations);
+
+	// Line segments appended by the compute silhouette pass, and drawn
+	// through glDrawArraysIndirect().
+	struct SilhouetteSegments
+	{
+		bonobo::gl::buffer vertices;		 // clip-space positions of the segment endpoints
+		bonobo::gl::buffer draw_command;	 // DrawArraysIndirectCommand, whose count is the append counter
+		bonobo::gl::vertex_array vao;		 // without any attribute, as vertices are pulled from |vertices|
+		GLuint capacity{0u};				 // in vertices
+	};
+	SilhouetteSegments createSilhouetteSegments();
+	void reserveSilhouetteSegments(SilhouetteSegments &segments, GLuint vertices_nb);
+
+	struct CullDrawsShaderLocations
+	{
+		GLuint ubo_CameraViewProjTransforms{0u};
+		GLuint draws_nb{0u};
+		GLuint is_frustum_culling_enabled{0u};
+		GLuint is_occlusion_culling_enabled{0u};
+		GLuint occlusion_view_projection{0u};
+		GLuint depth_pyramid{0u};
+	};
+	void fillCullDrawsShaderLocations(GLuint cull_draws_shader, CullDrawsShaderLocations &locations);
+
+	struct CullMeshletsShaderLocations
+	{
+		GLuint ubo_CameraViewProjTransforms{0u};
+		GLuint meshlets_nb{0u};
+		GLuint light_position{0u};
+		GLuint is_frustum_culling_enabled{0u};
+	};
+	void fillCullMeshletsShaderLocations(GLuint cull_meshlets_shader, CullMeshletsShaderLocations &locations);
+
+	// Farthest depth over ever larger areas of the depth buffer, which the
+	// culling pass tests bounding boxes against; its first level has half
+	// the resolution of the depth buffer.
+	struct DepthPyramid
+	{
+		bonobo::gl::texture texture;
+		GLsizei width{0};				 // of the first level
+		GLsizei height{0};				 // of the first level
+		GLsizei levels_nb{0};
+		glm::mat4 view_projection{1.0f}; // of the frame it was last built from
+		int geometry_id{-1};			 // scene it was last built from, if any
+	};
+	DepthPyramid createDepthPyramid(GLsizei framebuffer_width, GLsizei framebuffer_height);
+
+	// Pixel buffers headless frames are read back into, alternately, so
+	// that reading a frame does not wait for the GPU to finish it.
+	struct FrameReadback
+	{
+		std::array<bonobo::gl::buffer, 2> buffers;
+		std::array<GLsync, 2> fences{}; // signalled once the matching buffer holds a whole frame
+	};
+	FrameReadback createFrameReadback(std::size_t frame_size);
+	void deleteFrameReadback(FrameReadback &readback);
+
+	// Size of the window the render targets are waiting to follow; the
+	// targets only get resized once the window stopped changing size for
+	// a little while, so that dragging its border does not reallocate them
+	// on every frame. The last result gets stretched over the window in
+	// the meantime.
+	struct PendingResize
+	{
+		int width{0};
+		int height{0};
+		std::chrono::high_resolution_clock::time_point since;
+	};
+	// Returns whether |width| and |height| were changed to the window
+	// size, which happens once it has been pending long enough.
+	bool applyPendingResize(PendingResize &pending, int window_width, int window_height,
+							std::chrono::high_resolution_clock::time_point now, int &width, int &height);
 } // namespace
 
 edan35::NPRR::NPRR(WindowManager &windowManager) : mCamera(0.5f * glm::half_pi<float>(),
 														   static_cast<float>(config::resolution_x) / static_cast<float>(config::resolution_y),
 														   0.01f * constant::scale_lengths, 30.0f * constant::scale_lengths),
-												   inputHandler(), mWindowManager(windowManager), window(nullptr)
+												   inputHandler(), mWindowManager(&windowManager), window(nullptr)
 {
 	WindowManager::WindowDatum window_datum{inputHandler, mCamera, config::resolution_x, config::resolution_y, 0, 0, 0, 0};
 
-	window = mWindowManager.CreateGLFWWindow("NPRR", window_datum, config::msaa_rate);
+	window = mWindowManager->CreateGLFWWindow("NPRR", window_datum, config::msaa_rate, false, true);
 	if (window == nullptr)
 	{
 		throw std::runtime_error("Failed to get a window: aborting!");
@@ -156,6 +249,19 @@ edan35::NPRR::NPRR(WindowManager &windowManager) : mCamera(0.5f * glm::half_pi<f
 	bonobo::init();
 }
 
+edan35::NPRR::NPRR(HeadlessSettings const &settings) : mCamera(0.5f * glm::half_pi<float>(),
+																 static_cast<float>(settings.width != 0u ? settings.width : config::resolution_x) / static_cast<float>(settings.height != 0u ? settings.height : config::resolution_y),
+																 0.01f * constant::scale_lengths, 30.0f * constant::scale_lengths),
+														 inputHandler(), mWindowManager(nullptr), window(nullptr), mHeadlessSettings(settings)
+{
+	if (mHeadlessSettings.width == 0u)
+		mHeadlessSettings.width = config::resolution_x;
+	if (mHeadlessSettings.height == 0u)
+		mHeadlessSettings.height = config::resolution_y;
+
+	bonobo::init();
+}
+
 edan35::NPRR::~NPRR()
 {
 	bonobo::deinit();
@@ -163,34 +269,27 @@ edan35::NPRR::~NPRR()
 
 void edan35::NPRR::run()
 {
-	auto diffuse_texture = bonobo::loadTexture2D(config::resources_path("textures/Paper_Wrinkled_001_basecolor.jpg"));
-
-	// Load the geometry
-	auto const sphere_geometry = bonobo::loadObjects(config::resources_path("scenes/sphere.obj"));
-	auto const sofa_geometry = bonobo::loadObjects(config::resources_path("scenes/sofa.obj"));
-	auto const face_geometry = bonobo::loadObjects(config::resources_path("scenes/face/face.obj"));
-	auto const lego_geometry = bonobo::loadObjects(config::resources_path("scenes/lego/lego.obj"));
-	auto const sponza_geometry = bonobo::loadObjects(config::resources_path("scenes/sponza/sponza.obj"));
-	if (sponza_geometry.empty())
+	if (!isBatchDrawingSupported())
 	{
-		LogError("Failed to load the Sponza model");
+		LogError("Drawing the scenes needs OpenGL 4.3 along with GL_ARB_shader_draw_parameters, which your computer does not expose: aborting.");
 		return;
 	}
 
-	const std::vector<std::vector<bonobo::mesh_data>> geometry_array = {
-		sphere_geometry,
-		sofa_geometry,
-		face_geometry,
-		lego_geometry,
-		sponza_geometry,
-	};
-	const char *geometry_names[] = {
-		"Sphere",
-		"Sofa",
-		"Face",
-		"LEGO",
-		"Sponza",
-	};
+	bonobo::gl::texture const diffuse_texture(bonobo::loadTexture2D(config::resources_path("textures/Paper_Wrinkled_001_basecolor.jpg")), GL_TEXTURE_2D);
+
+	// Register the geometry; each scene only gets loaded once it is
+	// first selected.
+	SceneRegistry scenes;
+	scenes.RegisterScene("Sphere", config::resources_path("scenes/sphere.obj"));
+	scenes.RegisterScene("Sofa", config::resources_path("scenes/sofa.obj"));
+	scenes.RegisterScene("Face", config::resources_path("scenes/face/face.obj"));
+	scenes.RegisterScene("LEGO", config::resources_path("scenes/lego/lego.obj"));
+	scenes.RegisterScene("Sponza", config::resources_path("scenes/sponza/sponza.obj"));
+	assert(scenes.GetSceneCount() == toU(Objects::Count));
+	int gpu_memory_budget_mib = static_cast<int>(scenes.GetGPUMemoryBudget() >> 20u);
+	std::vector<bonobo::mesh_data> const no_geometry;
+	std::vector<bonobo::mesh_batch> const no_batches;
+
 	const GLuint line_width[] = {
 		20u,
 		15u,
@@ -200,7 +299,31 @@ void edan35::NPRR::run()
 		5u,
 	};
 	int current_geometry_id = toU(Objects::Sphere);
-	auto current_geometry = geometry_array[current_geometry_id];
+
+	// Without a window, there is no one to pick the scene nor to wait
+	// for it to be loaded, textures included.
+	bool const is_headless = window == nullptr;
+	if (is_headless)
+	{
+		auto const scene_index = scenes.FindScene(mHeadlessSettings.scene);
+		if (scene_index == scenes.GetSceneCount())
+		{
+			LogError("Unknown scene \"%s\"", mHeadlessSettings.scene.c_str());
+			return;
+		}
+		current_geometry_id = static_cast<int>(scene_index);
+
+		while (scenes.AcquireScene(scene_index) == nullptr || scenes.HasPendingTextures(scene_index))
+		{
+			if (scenes.GetState(scene_index) == SceneRegistry::State::failed)
+			{
+				LogError("Failed to load scene \"%s\"", mHeadlessSettings.scene.c_str());
+				return;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			scenes.Update();
+		}
+	}
 
 	//
 	// Setup the camera
@@ -210,16 +333,36 @@ void edan35::NPRR::run()
 	mCamera.mMovementSpeed = 3.0f * constant::scale_lengths; // 3 m/s => 10.8 km/h.
 
 	int framebuffer_width, framebuffer_height;
-	glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+	if (is_headless)
+	{
+		framebuffer_width = static_cast<int>(mHeadlessSettings.width);
+		framebuffer_height = static_cast<int>(mHeadlessSettings.height);
+	}
+	else
+	{
+		glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+	}
 
 	//
 	// Setup OpenGL objects
 	// Look further down in this file to see the implementation of those functions.
 	//
-	Textures const textures = createTextures(framebuffer_width, framebuffer_height);
-	FBOs const fbos = createFramebufferObjects(textures);
+	auto const noise_texture = createNoiseTexture();
 	Samplers const samplers = createSamplers();
-	ElapsedTimeQueries const elapsed_time_queries = createElapsedTimeQueries();
+	// The render graph times each pass under its own name; listing them
+	// here only sets the order they are reported in.
+	// Headless runs keep the timings of all their frames, for the report.
+	GPUTimers gpu_timers({"Culling", "G-buffer generation", "Depth pyramid", "Meshlet culling", "Silhouette", "Resolve", "Copy to framebuffer", "GUI"},
+						 4u, is_headless ? std::max<std::size_t>(mHeadlessSettings.frames_nb, 128u) : 128u);
+	// Render targets, and the framebuffers made of them, are created by
+	// the graph as passes need them, with their sizes rounded up so that
+	// resizing the window does not always need new ones.
+	RenderGraph render_graph(gpu_timers, 60u, constant::render_target_granularity);
+	PendingResize pending_resize;
+	// The G-buffer and the silhouette get rendered to the lower-left
+	// corner of their targets, at a resolution picked to hold the target
+	// frame time; the resolve pass then brings them back to full size.
+	DynamicResolution dynamic_resolution(4u);
 	UBOs const ubos = createUniformBufferObjects();
 
 	//
@@ -264,6 +407,104 @@ void edan35::NPRR::run()
 	SilhouetteShaderLocations fill_silhouette_shader_locations;
 	fillSilhouetteShaderLocations(silhouette_shader, fill_silhouette_shader_locations);
 
+	// Same stages, but fed with each edge once as GL_LINES_ADJACENCY
+	// rather than each triangle with its neighbours.
+	GLuint silhouette_unique_edges_shader = 0u;
+	program_manager.CreateAndRegisterProgram("Silhouette unique edges",
+											 {{ShaderType::vertex, "NPR/silhouette.vert"},
+											  {ShaderType::fragment, "NPR/silhouette.frag"},
+											  {ShaderType::geometry, "NPR/silhouette_edges.geom"}},
+											 silhouette_unique_edges_shader);
+	if (silhouette_unique_edges_shader == 0u)
+	{
+		LogError("Failed to load Silhouette unique edges shader");
+		return;
+	}
+	SilhouetteShaderLocations silhouette_unique_edges_shader_locations;
+	fillSilhouetteShaderLocations(silhouette_unique_edges_shader, silhouette_unique_edges_shader_locations);
+
+	// The compute backend is only offered when compute shaders are
+	// available.
+	GLuint silhouette_edges_shader = 0u;
+	GLuint silhouette_segments_shader = 0u;
+	SilhouetteEdgesShaderLocations silhouette_edges_shader_locations;
+	GLint silhouette_segments_capacity_location = -1;
+	if (GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_compute_shader)
+	{
+		program_manager.CreateAndRegisterComputeProgram("Silhouette edges",
+														"NPR/silhouette_edges.comp",
+														silhouette_edges_shader);
+		program_manager.CreateAndRegisterProgram("Silhouette segments",
+												 {{ShaderType::vertex, "NPR/silhouette_segments.vert"},
+												  {ShaderType::fragment, "NPR/silhouette.frag"}},
+												 silhouette_segments_shader);
+	}
+	bool const is_compute_silhouette_supported = silhouette_edges_shader != 0u && silhouette_segments_shader != 0u;
+	if (is_compute_silhouette_supported)
+	{
+		fillSilhouetteEdgesShaderLocations(silhouette_edges_shader, silhouette_edges_shader_locations);
+		silhouette_segments_capacity_location = glGetUniformLocation(silhouette_segments_shader, "segment_vertices_capacity");
+	}
+	else
+	{
+		LogWarning("Compute shaders are not available: only the geometry shader silhouette backends can be used.");
+	}
+	SilhouetteSegments silhouette_segments = is_compute_silhouette_supported ? createSilhouetteSegments() : SilhouetteSegments{};
+	std::array<char const *, toU(SilhouetteBackend::Count)> const silhouette_backend_labels{
+		"Geometry shader (triangle adjacency)",
+		"Geometry shader (unique edges)",
+		"Compute shader"};
+	int silhouette_backend = toU(SilhouetteBackend::GeometryShader);
+
+	// Culling meshes on the GPU needs compute shaders as well.
+	GLuint cull_draws_shader = 0u;
+	GLuint depth_pyramid_shader = 0u;
+	CullDrawsShaderLocations cull_draws_shader_locations;
+	GLint depth_pyramid_source_location = -1;
+	GLint depth_pyramid_source_level_location = -1;
+	GLint depth_pyramid_source_size_location = -1;
+	if (GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_compute_shader)
+	{
+		program_manager.CreateAndRegisterComputeProgram("Cull draws",
+														"NPR/cull_draws.comp",
+														cull_draws_shader);
+		program_manager.CreateAndRegisterComputeProgram("Depth pyramid",
+														"NPR/depth_pyramid.comp",
+														depth_pyramid_shader);
+	}
+	bool const is_gpu_culling_supported = cull_draws_shader != 0u && depth_pyramid_shader != 0u;
+	if (is_gpu_culling_supported)
+	{
+		fillCullDrawsShaderLocations(cull_draws_shader, cull_draws_shader_locations);
+		depth_pyramid_source_location = glGetUniformLocation(depth_pyramid_shader, "source");
+		depth_pyramid_source_level_location = glGetUniformLocation(depth_pyramid_shader, "source_level");
+		depth_pyramid_source_size_location = glGetUniformLocation(depth_pyramid_shader, "source_size");
+	}
+	else
+	{
+		LogWarning("Compute shaders are not available: meshes will not be culled.");
+	}
+	DepthPyramid depth_pyramid = is_gpu_culling_supported ? createDepthPyramid(framebuffer_width, framebuffer_height) : DepthPyramid{};
+	bool is_frustum_culling_enabled = is_gpu_culling_supported;
+	bool is_occlusion_culling_enabled = is_gpu_culling_supported;
+
+	// So does skipping the meshlets which cannot hold any silhouette edge,
+	// before the triangle adjacency backend goes through the others.
+	GLuint cull_meshlets_shader = 0u;
+	CullMeshletsShaderLocations cull_meshlets_shader_locations;
+	if (GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_compute_shader)
+	{
+		program_manager.CreateAndRegisterComputeProgram("Cull meshlets",
+														"NPR/cull_meshlets.comp",
+														cull_meshlets_shader);
+	}
+	bool const is_meshlet_culling_supported = cull_meshlets_shader != 0u;
+	if (is_meshlet_culling_supported)
+		fillCullMeshletsShaderLocations(cull_meshlets_shader, cull_meshlets_shader_locations);
+	else
+		LogWarning("Compute shaders are not available: every triangle will go through the silhouette pass.");
+	bool is_meshlet_culling_enabled = is_meshlet_culling_supported;
+
 	GLuint resolve_sketch_shader = 0u;
 	program_manager.CreateAndRegisterProgram("Resolve deferred",
 											 {{ShaderType::vertex, "NPR/resolve_sketch.vert"},
@@ -281,12 +522,53 @@ void edan35::NPRR::run()
 
 	const GLuint debug_texture_id = bonobo::getDebugTextureID();
 
-	auto const bind_texture_with_sampler = [](GLenum target, unsigned int slot, GLuint program, std::string const &name, GLuint texture, GLuint sampler)
+	// Programs, textures and samplers get bound through the state
+	// tracker, which skips the bindings already in place; passes leave
+	// theirs as they are once done, for the next ones to reuse.
+	auto &state = bonobo::gl::get_state_tracker();
+
+	auto const bind_texture_with_sampler = [&state](GLenum target, unsigned int slot, GLuint program, char const *name, GLuint texture, GLuint sampler)
 	{
-		glActiveTexture(GL_TEXTURE0 + slot);
-		glBindTexture(target, texture);
-		glUniform1i(glGetUniformLocation(program, name.c_str()), static_cast<GLint>(slot));
-		glBindSampler(slot, sampler);
+		state.bind_texture(slot, target, texture);
+		glUniform1i(state.get_uniform_location(program, name), static_cast<GLint>(slot));
+		state.bind_sampler(slot, sampler);
+	};
+
+	// Draw every mesh of a batch, or only the ones the culling pass kept.
+	auto const draw_batch = [](bonobo::mesh_batch const &batch, GLenum mode, GLintptr commands_offset, bool is_culled)
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bonobo::draw_data_binding, batch.draws_bo);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, is_culled ? batch.culled_draw_commands_bo : batch.draw_commands_bo);
+		auto const *const commands = reinterpret_cast<GLvoid const *>(commands_offset);
+		if (is_culled && GLAD_GL_VERSION_4_6)
+		{
+			glBindBuffer(GL_PARAMETER_BUFFER, batch.visible_draws_nb_bo);
+			glMultiDrawElementsIndirectCount(mode, GL_UNSIGNED_INT, commands, 0, batch.draws_nb, 0);
+			glBindBuffer(GL_PARAMETER_BUFFER, 0u);
+		}
+		else
+		{
+			// Culled commands past the visible ones are zeroed out, and
+			// draw nothing.
+			glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, commands, batch.draws_nb, 0);
+		}
+	};
+
+	// Draw the meshlets of a batch the meshlet culling pass kept.
+	auto const draw_meshlets = [](bonobo::mesh_batch const &batch)
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bonobo::draw_data_binding, batch.draws_bo);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, batch.meshlet_draw_commands_bo);
+		if (GLAD_GL_VERSION_4_6)
+		{
+			glBindBuffer(GL_PARAMETER_BUFFER, batch.visible_meshlets_nb_bo);
+			glMultiDrawElementsIndirectCount(GL_TRIANGLES_ADJACENCY, GL_UNSIGNED_INT, nullptr, 0, batch.meshlets_nb, 0);
+			glBindBuffer(GL_PARAMETER_BUFFER, 0u);
+		}
+		else
+		{
+			glMultiDrawElementsIndirect(GL_TRIANGLES_ADJACENCY, GL_UNSIGNED_INT, nullptr, batch.meshlets_nb, 0);
+		}
 	};
 
 	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
@@ -294,49 +576,154 @@ void edan35::NPRR::run()
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_CULL_FACE);
 
-	glUseProgram(0u);
-
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbos[toU(FBO::Resolve)]);
-
-	bool is_sketching = true;
-	float hatching_thickness = 6.0f;
-	float light_pos_x = 2.5f;
-	float light_pos_y = 3.0f;
-	float light_pos_z = 4.0f;
+	bool is_sketching = is_headless ? mHeadlessSettings.is_sketching : true;
+	float hatching_thickness = is_headless ? mHeadlessSettings.hatching_thickness : 6.0f;
+	float light_pos_x = is_headless ? mHeadlessSettings.light_position.x : 2.5f;
+	float light_pos_y = is_headless ? mHeadlessSettings.light_position.y : 3.0f;
+	float light_pos_z = is_headless ? mHeadlessSettings.light_position.z : 4.0f;
 
 	auto seconds_nb = 0.0f;
-	std::array<GLuint64, toU(ElapsedTimeQuery::Count)> pass_elapsed_times;
 	auto lastTime = std::chrono::high_resolution_clock::now();
 	bool show_textures = false;
+	bool is_silhouette_enabled = true;
 	auto polygon_mode = bonobo::polygon_mode_t::fill;
 
 	bool show_logs = false;
 	bool show_gui = true;
 	bool shader_reload_failed = false;
-	bool copy_elapsed_times = true;
 	bool first_frame = true;
 	bool show_basis = false;
 	float basis_thickness_scale = 40.0f;
 	float basis_length_scale = 400.0f;
+	int trace_frames_nb = 60;
+	int trace_frames_left = 0;
+	std::string const trace_filename = "nprr_trace.json";
+
+	std::uint32_t frame_index = 0u;
+	std::uint32_t written_frames_nb = 0u;
+	auto const frame_size = static_cast<std::size_t>(framebuffer_width) * static_cast<std::size_t>(framebuffer_height) * 4u;
+	bool const is_writing_frames = is_headless && mHeadlessSettings.write_frames;
+	FrameReadback frame_readback = is_headless ? createFrameReadback(is_writing_frames ? frame_size : 0u) : FrameReadback{};
+	std::unique_ptr<FrameWriter> frame_writer = is_writing_frames ? std::make_unique<FrameWriter>() : nullptr;
+	auto const headless_start_time = std::chrono::high_resolution_clock::now();
+	mHeadlessReport = HeadlessReport{};
+
+	// Wait for the GPU to be done with a frame submitted by the loop below.
+	auto const wait_for_frame = [&](std::uint32_t index)
+	{
+		auto const readback_index = index % 2u;
+		if (frame_readback.fences[readback_index] == nullptr)
+			return;
+		GLenum wait_status;
+		do
+			wait_status = glClientWaitSync(frame_readback.fences[readback_index], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000u);
+		while (wait_status == GL_TIMEOUT_EXPIRED);
+		glDeleteSync(frame_readback.fences[readback_index]);
+		frame_readback.fences[readback_index] = nullptr;
+	};
+
+	// Wait for a frame read back by the loop below, and hand it over to
+	// the frame writer.
+	auto const write_frame = [&](std::uint32_t index)
+	{
+		ProfileScope("Read back frame");
+		auto const readback_index = index % 2u;
+		wait_for_frame(index);
+
+		auto texels = frame_writer->AcquireBuffer(frame_size);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, frame_readback.buffers[readback_index].get());
+		auto const *const mapped_texels = static_cast<std::uint8_t const *>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(frame_size), GL_MAP_READ_BIT));
+		if (mapped_texels != nullptr)
+		{
+			std::memcpy(texels.data(), mapped_texels, frame_size);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0u);
+		if (mapped_texels == nullptr)
+		{
+			LogError("Failed to map the pixel buffer of frame %u", index);
+			return false;
+		}
+
+		char frame_filename[32];
+		std::snprintf(frame_filename, sizeof(frame_filename), "/frame_%05u.png", index);
+		frame_writer->Write(mHeadlessSettings.output_folder + frame_filename,
+							static_cast<std::uint32_t>(framebuffer_width), static_cast<std::uint32_t>(framebuffer_height),
+							std::move(texels));
+		++written_frames_nb;
+		return frame_writer->GetFailedCount() == 0u;
+	};
+
+	Profiler::SetThreadName("Main");
+	if (is_headless && !mHeadlessSettings.trace_filename.empty())
+		Profiler::StartCapture();
 
-	while (!glfwWindowShouldClose(window))
+	while (is_headless ? frame_index < mHeadlessSettings.frames_nb : !glfwWindowShouldClose(window))
 	{
+		if (is_headless && frame_index != 0u && frame_index == mHeadlessSettings.warmup_frames_nb)
+		{
+			// Leave the warm-up frames out of the report; the wait is
+			// accounted to the last of them.
+			gpu_timers.WaitForPendingFrames();
+			gpu_timers.ResetStatistics();
+		}
+
+		Profiler::NewFrame();
+		if (trace_frames_left > 0 && --trace_frames_left == 0)
+		{
+			Profiler::StopCapture();
+			Profiler::WriteChromeTrace(trace_filename);
+		}
+		ProfileScope("Frame");
+
 		auto const nowTime = std::chrono::high_resolution_clock::now();
 		auto const deltaTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(nowTime - lastTime);
 		lastTime = nowTime;
+		if (is_headless && frame_index > mHeadlessSettings.warmup_frames_nb)
+			mHeadlessReport.cpu_frame_times.push_back(std::chrono::duration<float, std::milli>(deltaTimeUs).count());
 
-		auto &io = ImGui::GetIO();
-		inputHandler.SetUICapture(io.WantCaptureMouse, io.WantCaptureKeyboard);
-
-		glfwPollEvents();
-		inputHandler.Advance();
-		mCamera.Update(deltaTimeUs, inputHandler);
+		int window_width = framebuffer_width, window_height = framebuffer_height;
+		if (!is_headless)
+		{
+			auto &io = ImGui::GetIO();
+			inputHandler.SetUICapture(io.WantCaptureMouse, io.WantCaptureKeyboard);
+
+			glfwPollEvents();
+			inputHandler.Advance();
+			mCamera.Update(deltaTimeUs, inputHandler);
+
+			// The camera already follows the aspect ratio of the window,
+			// which stretching the result over it preserves.
+			glfwGetFramebufferSize(window, &window_width, &window_height);
+			if (applyPendingResize(pending_resize, window_width, window_height, nowTime, framebuffer_width, framebuffer_height)
+				&& is_gpu_culling_supported)
+			{
+				render_graph.ForgetImportedTexture(depth_pyramid.texture.get());
+				depth_pyramid = createDepthPyramid(framebuffer_width, framebuffer_height);
+			}
+		}
+		else if (!mHeadlessSettings.camera_path.keyframes.empty())
+		{
+			glm::vec3 camera_path_position, camera_path_target;
+			camera_path::evaluate(mHeadlessSettings.camera_path, static_cast<float>(frame_index) / mHeadlessSettings.frames_per_second,
+								  camera_path_position, camera_path_target);
+			mCamera.mWorld.SetTranslate(camera_path_position * constant::scale_lengths);
+			mCamera.mWorld.LookAt(camera_path_target * constant::scale_lengths);
+		}
+		gpu_timers.BeginFrame();
+		dynamic_resolution.Update(gpu_timers);
 
 		camera_view_proj_transforms.view_projection = mCamera.GetWorldToClipMatrix();
 		camera_view_proj_transforms.view_projection_inverse = mCamera.GetClipToWorldMatrix();
 
 		auto const view_projection = camera_view_proj_transforms.view_projection;
 
+		scenes.Update();
+		auto const *const acquired_geometry = scenes.AcquireScene(static_cast<std::size_t>(current_geometry_id));
+		auto const &current_geometry = acquired_geometry != nullptr ? *acquired_geometry : no_geometry;
+		auto const *const acquired_batches = scenes.GetSceneBatches(static_cast<std::size_t>(current_geometry_id));
+		auto const &current_batches = acquired_batches != nullptr ? *acquired_batches : no_batches;
+
 		if (inputHandler.GetKeycodeState(GLFW_KEY_R) & JUST_PRESSED)
 		{
 			shader_reload_failed = !program_manager.ReloadAllPrograms();
@@ -350,6 +737,22 @@ void edan35::NPRR::run()
 			else
 			{
 				fillGBufferShaderLocations(fill_gbuffer_shader, fill_gbuffer_shader_locations);
+				fillSilhouetteShaderLocations(silhouette_shader, fill_silhouette_shader_locations);
+				fillSilhouetteShaderLocations(silhouette_unique_edges_shader, silhouette_unique_edges_shader_locations);
+				if (is_compute_silhouette_supported)
+				{
+					fillSilhouetteEdgesShaderLocations(silhouette_edges_shader, silhouette_edges_shader_locations);
+					silhouette_segments_capacity_location = glGetUniformLocation(silhouette_segments_shader, "segment_vertices_capacity");
+				}
+				if (is_gpu_culling_supported)
+				{
+					fillCullDrawsShaderLocations(cull_draws_shader, cull_draws_shader_locations);
+					depth_pyramid_source_location = glGetUniformLocation(depth_pyramid_shader, "source");
+					depth_pyramid_source_level_location = glGetUniformLocation(depth_pyramid_shader, "source_level");
+					depth_pyramid_source_size_location = glGetUniformLocation(depth_pyramid_shader, "source_size");
+				}
+				if (is_meshlet_culling_supported)
+					fillCullMeshletsShaderLocations(cull_meshlets_shader, cull_meshlets_shader_locations);
 			}
 		}
 
@@ -358,286 +761,851 @@ void edan35::NPRR::run()
 		if (inputHandler.GetKeycodeState(GLFW_KEY_F2) & JUST_RELEASED)
 			show_gui = !show_gui;
 
-		mWindowManager.NewImGuiFrame();
+		if (!is_headless)
+			mWindowManager->NewImGuiFrame();
 
-		if (!first_frame && show_gui && copy_elapsed_times)
-		{
-			// Copy all timings back from the GPU to the CPU.
-			for (GLuint i = 0; i < pass_elapsed_times.size(); ++i)
-			{
-				glGetQueryObjectui64v(elapsed_time_queries[i], GL_QUERY_RESULT, pass_elapsed_times.data() + i);
-			}
-		}
 		glm::vec3 light_position = glm::vec3(light_pos_x, light_pos_y, light_pos_z) * constant::scale_lengths;
 		glm::vec3 camera_position = mCamera.mWorld.GetTranslation();
+		// The silhouette is the one seen from the camera.
+		glm::vec3 const silhouette_light_position = camera_position;
 		//
 		// Update per-frame changing UBOs.
 		//
-		glBindBuffer(GL_UNIFORM_BUFFER, ubos[toU(UBO::CameraViewProjTransforms)]);
-		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(camera_view_proj_transforms), &camera_view_proj_transforms);
-		glBindBuffer(GL_UNIFORM_BUFFER, 0u);
+		ubos[toU(UBO::CameraViewProjTransforms)].upload(0, sizeof(camera_view_proj_transforms), &camera_view_proj_transforms);
+
+		//
+		// Declare the passes of this frame, along with what they read and
+		// write; passes whose results end up unused are skipped when the
+		// graph gets executed, at the end of the frame.
+		//
+		state.begin_frame();
+		render_graph.BeginFrame();
+		RenderGraph::TextureDescription const colour_description{GL_RGBA8, framebuffer_width, framebuffer_height};
+		auto const depth_buffer = render_graph.CreateTexture("Depth buffer", {GL_DEPTH24_STENCIL8, framebuffer_width, framebuffer_height});
+		auto const gbuffer_diffuse = render_graph.CreateTexture("GBuffer diffuse", colour_description);
+		auto const silhouette = render_graph.CreateTexture("Silhouette", colour_description);
+		auto const result = render_graph.CreateTexture("Final result", colour_description);
+		auto const noise = render_graph.ImportTexture("Noise", noise_texture.get(), {GL_RGBA8, constant::noise_res_x, constant::noise_res_y});
+		auto const culled_draws = render_graph.CreateBuffer("Culled draw commands");
+		auto const culled_meshlets = render_graph.CreateBuffer("Culled meshlet commands");
+		render_graph.MarkOutput(result);
+
+		// Targets keep the size of the framebuffer, so that changing the
+		// resolution never reallocates them.
+		float const resolution_scale = dynamic_resolution.GetScale();
+		GLsizei const render_width = dynamic_resolution.GetScaledSize(framebuffer_width);
+		GLsizei const render_height = dynamic_resolution.GetScaledSize(framebuffer_height);
+
+		bool const is_culling = is_gpu_culling_supported && (is_frustum_culling_enabled || is_occlusion_culling_enabled);
+		// The depth pyramid lags one frame behind, so meshes coming into
+		// view from behind an occluder show up one frame late.
+		bool const is_occlusion_culling = is_culling && is_occlusion_culling_enabled && depth_pyramid.geometry_id == current_geometry_id;
+		bool const is_culling_meshlets = is_meshlet_culling_enabled && silhouette_backend == toU(SilhouetteBackend::GeometryShader);
+		auto const pyramid = is_gpu_culling_supported ? render_graph.ImportTexture("Depth pyramid", depth_pyramid.texture.get(), {GL_R32F, depth_pyramid.width, depth_pyramid.height})
+													  : RenderGraph::invalid_resource;
 
 		if (!shader_reload_failed)
 		{
 			//
-			// Pass1: Render scene into the g-buffer
+			// Pass 0: Cull meshes outside of the view frustum, or hidden
+			// behind the depth of the previous frame, compacting the draw
+			// commands of the remaining ones for both following passes
 			//
-			utils::opengl::debug::beginDebugGroup("Fill G-buffer");
-			glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::GbufferGeneration)]);
-
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::GBuffer)]);
-			glViewport(0, 0, framebuffer_width, framebuffer_height);
-			glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
-
-			glUseProgram(fill_gbuffer_shader);
-			glUniform3fv(fill_gbuffer_shader_locations.light_position, 1, glm::value_ptr(light_position));
-			glUniform3fv(fill_gbuffer_shader_locations.camera_position, 1, glm::value_ptr(camera_position));
-			glUniform1f(fill_gbuffer_shader_locations.thickness, hatching_thickness);
-			glUniform1i(fill_gbuffer_shader_locations.is_sketching, is_sketching);
-			for (std::size_t i = 0; i < current_geometry.size(); ++i)
+			if (is_culling)
 			{
-				auto const &geometry = current_geometry[i];
-				auto const &diffuse_color = current_geometry[i].material.diffuse;
-
-				utils::opengl::debug::beginDebugGroup(geometry.name);
-
-				auto const vertex_model_to_world = glm::mat4(1.0f);
-				auto const normal_model_to_world = glm::mat4(1.0f);
-
-				glUniformMatrix4fv(fill_gbuffer_shader_locations.vertex_model_to_world, 1, GL_FALSE, glm::value_ptr(vertex_model_to_world));
-				glUniformMatrix4fv(fill_gbuffer_shader_locations.normal_model_to_world, 1, GL_FALSE, glm::value_ptr(normal_model_to_world));
-				glUniform3fv(fill_gbuffer_shader_locations.diffuse_color, 1, glm::value_ptr(diffuse_color));
-
-				glBindVertexArray(geometry.vao);
-				glDrawElements(GL_TRIANGLES_ADJACENCY, geometry.adjacency_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const *>(0x0));
-
-				utils::opengl::debug::endDebugGroup();
+				auto culling_pass = render_graph.AddPass("Culling");
+				if (is_occlusion_culling)
+					culling_pass.Read(pyramid, RenderGraph::Access::sampled);
+				culling_pass.Write(culled_draws, RenderGraph::Access::storage_store)
+					.Execute([&]()
+							 {
+					state.use_program(cull_draws_shader);
+					glUniform1i(cull_draws_shader_locations.is_frustum_culling_enabled, is_frustum_culling_enabled);
+					glUniform1i(cull_draws_shader_locations.is_occlusion_culling_enabled, is_occlusion_culling);
+					glUniformMatrix4fv(cull_draws_shader_locations.occlusion_view_projection, 1, GL_FALSE, glm::value_ptr(depth_pyramid.view_projection));
+					// Sampled with its own parameters, to go through its mipmaps.
+					state.bind_texture(0u, GL_TEXTURE_2D, depth_pyramid.texture.get());
+					state.bind_sampler(0u, 0u);
+					glUniform1i(cull_draws_shader_locations.depth_pyramid, 0);
+					for (auto const &batch : current_batches)
+					{
+						glBindBuffer(GL_SHADER_STORAGE_BUFFER, batch.culled_draw_commands_bo);
+						glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+						glBindBuffer(GL_SHADER_STORAGE_BUFFER, batch.visible_draws_nb_bo);
+						glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+						glUniform1ui(cull_draws_shader_locations.draws_nb, static_cast<GLuint>(batch.draws_nb));
+						glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bonobo::draw_data_binding, batch.draws_bo);
+						glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5u, batch.draw_commands_bo);
+						glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6u, batch.culled_draw_commands_bo);
+						glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7u, batch.visible_draws_nb_bo);
+						glDispatchCompute((static_cast<GLuint>(batch.draws_nb) + constant::cull_draws_group_size - 1u) / constant::cull_draws_group_size, 1u, 1u);
+					}
+
+					for (GLuint binding = bonobo::draw_data_binding; binding < 8u; ++binding)
+						glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0u);
+					glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0u); });
 			}
 
-			glEndQuery(GL_TIME_ELAPSED);
-			utils::opengl::debug::endDebugGroup();
-
-			glBindTexture(GL_TEXTURE_2D, 0);
-			glBindVertexArray(0u);
-			glUseProgram(0u);
+			//
+			// Pass1: Render scene into the g-buffer
+			//
+			auto gbuffer_pass = render_graph.AddPass("G-buffer generation");
+			if (is_culling)
+				gbuffer_pass.Read(culled_draws, RenderGraph::Access::indirect);
+			gbuffer_pass.Write(gbuffer_diffuse, RenderGraph::Access::color_attachment)
+				.Write(depth_buffer, RenderGraph::Access::depth_attachment)
+				.SetViewport(render_width, render_height)
+				.Execute([&]()
+						 {
+				glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+
+				state.use_program(fill_gbuffer_shader);
+				glUniform3fv(fill_gbuffer_shader_locations.light_position, 1, glm::value_ptr(light_position));
+				glUniform3fv(fill_gbuffer_shader_locations.camera_position, 1, glm::value_ptr(camera_position));
+				glUniform1f(fill_gbuffer_shader_locations.thickness, hatching_thickness);
+				glUniform1f(fill_gbuffer_shader_locations.resolution_scale, resolution_scale);
+				glUniform1i(fill_gbuffer_shader_locations.is_sketching, is_sketching);
+				// All meshes of a batch go through a single draw call, each
+				// fetching its transforms and colour through the base
+				// instance of its command, gl_BaseInstanceARB; unlike
+				// gl_DrawIDARB, it still matches the mesh once culling
+				// compacted the commands.
+				for (auto const &batch : current_batches)
+				{
+					utils::opengl::debug::beginDebugGroup(batch.name);
+
+					glUniform1i(fill_gbuffer_shader_locations.are_directions_octahedral, batch.are_directions_octahedral);
+					glBindVertexArray(batch.vao);
+					draw_batch(batch, GL_TRIANGLES_ADJACENCY, 0, is_culling);
+
+					utils::opengl::debug::endDebugGroup();
+				}
+				glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0u);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bonobo::draw_data_binding, 0u);
+
+				glBindVertexArray(0u); });
 
 			//
-			// Pass 2: Find the silhouette
+			// Reduce the depth buffer for the culling pass of the next
+			// frame; the graph issues the barrier before that pass samples
+			// the last level
 			//
-			light_position = camera_position;
-			utils::opengl::debug::beginDebugGroup("Silhouette");
-			glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::Silhouette)]);
-
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::Silhouette)]);
-			glViewport(0, 0, framebuffer_width, framebuffer_height);
-			glClear(GL_COLOR_BUFFER_BIT);
-
-			glUseProgram(silhouette_shader);
-			glUniform3fv(fill_silhouette_shader_locations.light_position, 1, glm::value_ptr(light_position));
-			glUniform1i(fill_silhouette_shader_locations.is_sketching, is_sketching);
-			for (std::size_t i = 0; i < current_geometry.size(); ++i)
+			if (is_culling && is_occlusion_culling_enabled)
 			{
-				auto const &geometry = current_geometry[i];
-
-				utils::opengl::debug::beginDebugGroup(geometry.name);
-
-				auto const vertex_model_to_world = glm::mat4(1.0f);
-				auto const normal_model_to_world = glm::mat4(1.0f);
-
-				glUniformMatrix4fv(fill_silhouette_shader_locations.vertex_model_to_world, 1, GL_FALSE, glm::value_ptr(vertex_model_to_world));
-				glUniformMatrix4fv(fill_silhouette_shader_locations.normal_model_to_world, 1, GL_FALSE, glm::value_ptr(normal_model_to_world));
-
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::Noise)]);
-				glUniform1i(fill_silhouette_shader_locations.noise_texture, 0);
-				glBindSampler(0u, samplers[toU(Sampler::Nearest)]);
-
-				glBindVertexArray(geometry.vao);
-				if (is_sketching)
-					glLineWidth(1u);
-				else
-					glLineWidth(line_width[current_geometry_id]);
-				glDrawElements(GL_TRIANGLES_ADJACENCY, geometry.adjacency_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const *>(0x0));
-
-				utils::opengl::debug::endDebugGroup();
+				render_graph.AddPass("Depth pyramid")
+					.Read(depth_buffer, RenderGraph::Access::sampled)
+					.Write(pyramid, RenderGraph::Access::image_store)
+					.Execute([&]()
+							 {
+					state.use_program(depth_pyramid_shader);
+					glUniform1i(depth_pyramid_source_location, 0);
+					for (GLsizei level = 0; level < depth_pyramid.levels_nb; ++level)
+					{
+						// The first level reduces the depth buffer itself, which
+						// has no mipmaps to fall back on.
+						if (level != 0)
+							glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+						state.bind_texture(0u, GL_TEXTURE_2D, level == 0 ? render_graph.GetTexture(depth_buffer) : depth_pyramid.texture.get());
+						state.bind_sampler(0u, level == 0 ? samplers[toU(Sampler::Nearest)].get() : 0u);
+						glUniform1i(depth_pyramid_source_level_location, std::max(level - 1, 0));
+						// Only the part of the depth buffer rendered to gets
+						// reduced, stretched over the whole first level.
+						if (level == 0)
+							glUniform2i(depth_pyramid_source_size_location, render_width, render_height);
+						else
+							glUniform2i(depth_pyramid_source_size_location, std::max(depth_pyramid.width >> (level - 1), 1), std::max(depth_pyramid.height >> (level - 1), 1));
+						glBindImageTexture(0u, depth_pyramid.texture.get(), level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+						auto const width = std::max(depth_pyramid.width >> level, 1);
+						auto const height = std::max(depth_pyramid.height >> level, 1);
+						glDispatchCompute(static_cast<GLuint>((width + constant::depth_pyramid_group_size - 1) / constant::depth_pyramid_group_size),
+										  static_cast<GLuint>((height + constant::depth_pyramid_group_size - 1) / constant::depth_pyramid_group_size), 1u);
+					}
+					glBindImageTexture(0u, 0u, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+					depth_pyramid.view_projection = camera_view_proj_transforms.view_projection;
+					depth_pyramid.geometry_id = current_geometry_id; });
 			}
 
-			glEndQuery(GL_TIME_ELAPSED);
-			utils::opengl::debug::endDebugGroup();
-			glBindVertexArray(0u);
-			glUseProgram(0u);
-
 			//
-			// Pass 3: Compute final image using both the g-buffer and  the light accumulation buffer
+			// Skip the meshlets whose triangles, along with their
+			// neighbours, all face towards the light or all face away
+			// from it, as none of their edges can be on the silhouette
 			//
-			utils::opengl::debug::beginDebugGroup("Resolve");
-			glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::Resolve)]);
-
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::Resolve)]);
-			glUseProgram(resolve_sketch_shader);
-			glViewport(0, 0, framebuffer_width, framebuffer_height);
-
-			glUniform1i(glGetUniformLocation(resolve_sketch_shader, "is_sketching"), is_sketching);
-
-			bind_texture_with_sampler(GL_TEXTURE_2D, 0, resolve_sketch_shader, "diffuse_texture", textures[toU(Texture::GBufferDiffuse)], samplers[toU(Sampler::Nearest)]);
-			bind_texture_with_sampler(GL_TEXTURE_2D, 1, resolve_sketch_shader, "silhouette_texture", textures[toU(Texture::Silhouette)], samplers[toU(Sampler::Nearest)]);
-			bonobo::drawFullscreen();
+			if (is_culling_meshlets)
+			{
+				render_graph.AddPass("Meshlet culling")
+					.Write(culled_meshlets, RenderGraph::Access::storage_store)
+					.Execute([&]()
+							 {
+					state.use_program(cull_meshlets_shader);
+					glUniform3fv(cull_meshlets_shader_locations.light_position, 1, glm::value_ptr(silhouette_light_position));
+					glUniform1i(cull_meshlets_shader_locations.is_frustum_culling_enabled, is_frustum_culling_enabled);
+					for (auto const &batch : current_batches)
+					{
+						if (batch.meshlets_nb == 0)
+							continue;
+
+						glBindBuffer(GL_SHADER_STORAGE_BUFFER, batch.meshlet_draw_commands_bo);
+						glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+						glBindBuffer(GL_SHADER_STORAGE_BUFFER, batch.visible_meshlets_nb_bo);
+						glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+						glUniform1ui(cull_meshlets_shader_locations.meshlets_nb, static_cast<GLuint>(batch.meshlets_nb));
+						glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bonobo::draw_data_binding, batch.draws_bo);
+						glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8u, batch.meshlets_bo);
+						glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9u, batch.meshlet_draw_commands_bo);
+						glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 10u, batch.visible_meshlets_nb_bo);
+						glDispatchCompute((static_cast<GLuint>(batch.meshlets_nb) + constant::cull_meshlets_group_size - 1u) / constant::cull_meshlets_group_size, 1u, 1u);
+					}
+
+					glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bonobo::draw_data_binding, 0u);
+					for (GLuint binding = 8u; binding < 11u; ++binding)
+						glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0u);
+					glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0u); });
+			}
 
-			glBindSampler(1, 0u);
-			glBindSampler(0, 0u);
-			glUseProgram(0u);
+			//
+			// Pass 2: Find the silhouette, depth tested against the
+			// g-buffer
+			//
+			auto silhouette_pass = render_graph.AddPass("Silhouette");
+			if (is_culling && silhouette_backend != toU(SilhouetteBackend::ComputeShader))
+				silhouette_pass.Read(culled_draws, RenderGraph::Access::indirect);
+			if (is_culling_meshlets)
+				silhouette_pass.Read(culled_meshlets, RenderGraph::Access::indirect);
+			silhouette_pass.Read(noise, RenderGraph::Access::sampled)
+				.Read(depth_buffer, RenderGraph::Access::depth_attachment)
+				.Write(depth_buffer, RenderGraph::Access::depth_attachment)
+				.Write(silhouette, RenderGraph::Access::color_attachment)
+				.SetViewport(render_width, render_height)
+				.Execute([&]()
+						 {
+				glClear(GL_COLOR_BUFFER_BIT);
+
+				// Lines get thinner along with the resolution, to end up as
+				// thick once upsampled.
+				auto const silhouette_line_width = is_sketching ? 1.0f : std::max(static_cast<float>(line_width[current_geometry_id]) * resolution_scale, 1.0f);
+
+				if (silhouette_backend == toU(SilhouetteBackend::ComputeShader))
+				{
+					// Classify each edge once in a compute shader, appending
+					// silhouette segments to a buffer; the number of vertices
+					// appended directly feeds the indirect draw.
+					GLuint edges_nb = 0u;
+					for (auto const &geometry : current_geometry)
+						edges_nb += static_cast<GLuint>(geometry.edges_nb);
+					reserveSilhouetteSegments(silhouette_segments, edges_nb * (is_sketching ? 12u : 2u));
+
+					GLuint const empty_draw_command[] = {0u, 1u, 0u, 0u};
+					silhouette_segments.draw_command.upload(0, sizeof(empty_draw_command), empty_draw_command);
+
+					state.use_program(silhouette_edges_shader);
+					glUniform3fv(silhouette_edges_shader_locations.light_position, 1, glm::value_ptr(silhouette_light_position));
+					glUniform1i(silhouette_edges_shader_locations.is_sketching, is_sketching);
+					glUniform1ui(silhouette_edges_shader_locations.segment_vertices_capacity, silhouette_segments.capacity);
+					state.bind_texture(0u, GL_TEXTURE_2D, render_graph.GetTexture(noise));
+					glUniform1i(silhouette_edges_shader_locations.noise_texture, 0);
+					state.bind_sampler(0u, samplers[toU(Sampler::Nearest)].get());
+					glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2u, silhouette_segments.vertices.get());
+					glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3u, silhouette_segments.draw_command.get());
+					for (auto const &geometry : current_geometry)
+					{
+						if (geometry.edges_nb == 0)
+							continue;
+
+						utils::opengl::debug::beginDebugGroup(geometry.name);
+
+						auto const vertex_model_to_world = glm::mat4(1.0f);
+						glUniformMatrix4fv(silhouette_edges_shader_locations.vertex_model_to_world, 1, GL_FALSE, glm::value_ptr(vertex_model_to_world));
+						glUniform1ui(silhouette_edges_shader_locations.edges_nb, static_cast<GLuint>(geometry.edges_nb));
+						glUniform1ui(silhouette_edges_shader_locations.first_edge, geometry.first_edge);
+						glUniform1ui(silhouette_edges_shader_locations.positions_offset, static_cast<GLuint>(geometry.positions_offset / sizeof(GLfloat)));
+						glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0u, geometry.bo);
+						glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1u, geometry.edges_bo);
+
+						auto const groups_nb = (static_cast<GLuint>(geometry.edges_nb) + constant::silhouette_edges_group_size - 1u) / constant::silhouette_edges_group_size;
+						auto const groups_x = std::min(groups_nb, constant::max_silhouette_groups_x);
+						glDispatchCompute(groups_x, (groups_nb + groups_x - 1u) / groups_x, 1u);
+
+						utils::opengl::debug::endDebugGroup();
+					}
+					glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+					state.use_program(silhouette_segments_shader);
+					glUniform1ui(silhouette_segments_capacity_location, silhouette_segments.capacity);
+					glBindVertexArray(silhouette_segments.vao.get());
+					glLineWidth(silhouette_line_width);
+					glDrawArraysIndirect(GL_LINES, reinterpret_cast<GLvoid const *>(0x0));
+
+					for (GLuint binding = 0u; binding < 4u; ++binding)
+						glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0u);
+					glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0u);
+				}
+				else
+				{
+					// Both geometry shader backends share their inputs; they only
+					// differ in the primitives they are fed with.
+					bool const use_unique_edges = silhouette_backend == toU(SilhouetteBackend::EdgesGeometryShader);
+					auto const &locations = use_unique_edges ? silhouette_unique_edges_shader_locations : fill_silhouette_shader_locations;
+					state.use_program(use_unique_edges ? silhouette_unique_edges_shader : silhouette_shader);
+					glUniform3fv(locations.light_position, 1, glm::value_ptr(silhouette_light_position));
+					glUniform1i(locations.is_sketching, is_sketching);
+					state.bind_texture(0u, GL_TEXTURE_2D, render_graph.GetTexture(noise));
+					glUniform1i(locations.noise_texture, 0);
+					state.bind_sampler(0u, samplers[toU(Sampler::Nearest)].get());
+					glLineWidth(silhouette_line_width);
+					for (auto const &batch : current_batches)
+					{
+						if (use_unique_edges && batch.edges_vao == 0u)
+							continue;
+
+						utils::opengl::debug::beginDebugGroup(batch.name);
+
+						if (use_unique_edges)
+						{
+							glBindVertexArray(batch.edges_vao);
+							draw_batch(batch, GL_LINES_ADJACENCY, batch.edge_commands_offset(), is_culling);
+						}
+						else if (is_culling_meshlets && batch.meshlets_nb != 0)
+						{
+							glBindVertexArray(batch.vao);
+							draw_meshlets(batch);
+						}
+						else
+						{
+							glBindVertexArray(batch.vao);
+							draw_batch(batch, GL_TRIANGLES_ADJACENCY, 0, is_culling);
+						}
+
+						utils::opengl::debug::endDebugGroup();
+					}
+					glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0u);
+					glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bonobo::draw_data_binding, 0u);
+				}
+
+				glBindVertexArray(0u); });
 
-			glEndQuery(GL_TIME_ELAPSED);
-			utils::opengl::debug::endDebugGroup();
+			//
+			// Pass 3: Compute final image using both the g-buffer and the
+			// silhouette; the latter, and all passes leading to it, get
+			// skipped when it is disabled
+			//
+			auto resolve_pass = render_graph.AddPass("Resolve");
+			resolve_pass.Read(gbuffer_diffuse, RenderGraph::Access::sampled);
+			if (is_silhouette_enabled)
+				resolve_pass.Read(silhouette, RenderGraph::Access::sampled);
+			resolve_pass.Write(result, RenderGraph::Access::color_attachment)
+				.Execute([&]()
+						 {
+				state.use_program(resolve_sketch_shader);
+
+				glUniform1i(state.get_uniform_location(resolve_sketch_shader, "is_sketching"), is_sketching);
+				glUniform1i(state.get_uniform_location(resolve_sketch_shader, "has_silhouette"), is_silhouette_enabled);
+				glUniform2i(state.get_uniform_location(resolve_sketch_shader, "render_size"), render_width, render_height);
+				glUniform2i(state.get_uniform_location(resolve_sketch_shader, "output_size"), framebuffer_width, framebuffer_height);
+
+				bind_texture_with_sampler(GL_TEXTURE_2D, 0, resolve_sketch_shader, "diffuse_texture", render_graph.GetTexture(gbuffer_diffuse), samplers[toU(Sampler::Nearest)].get());
+				if (is_silhouette_enabled)
+					bind_texture_with_sampler(GL_TEXTURE_2D, 1, resolve_sketch_shader, "silhouette_texture", render_graph.GetTexture(silhouette), samplers[toU(Sampler::Nearest)].get());
+				bonobo::drawFullscreen(); });
 		}
 
-		if (show_basis)
+		auto const readback_index = frame_index % 2u;
+		if (is_writing_frames)
 		{
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::FinalWithDepth)]);
+			// Start reading this frame into one pixel buffer without
+			// waiting for it; see below.
+			render_graph.AddPass("Read back")
+				.Read(result, RenderGraph::Access::transfer)
+				.HasSideEffects()
+				.Execute([&]()
+						 {
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, frame_readback.buffers[readback_index].get());
+					glReadPixels(0, 0, framebuffer_width, framebuffer_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, 0u); });
 		}
 
-		utils::opengl::debug::beginDebugGroup("Draw GUI");
-		glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::GUI)]);
-
-		//
-		// Display 3D helpers
-		//
-		if (show_basis)
+		if (!is_headless)
 		{
-			bonobo::renderBasis(basis_thickness_scale, basis_length_scale, mCamera.GetWorldToClipMatrix());
-			// If the basis were not shown, FBO::Resolve
-			// is still bound so there is no need to rebind it.
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::Resolve)]);
-		}
+			//
+			// Blit the result back to the default framebuffer, stretching
+			// it until the render targets follow a resize of the window.
+			//
+			render_graph.AddPass("Copy to framebuffer")
+				.Read(result, RenderGraph::Access::transfer)
+				.HasSideEffects()
+				.Execute([&]()
+						 {
+				bool const is_stretched = window_width != framebuffer_width || window_height != framebuffer_height;
+				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0u);
+				glBlitFramebuffer(0, 0, framebuffer_width, framebuffer_height, 0, 0, window_width, window_height, GL_COLOR_BUFFER_BIT, is_stretched ? GL_LINEAR : GL_NEAREST); });
 
-		//
-		// Output content of the g-buffer as well as of the shadowmap, for debugging purposes
-		//
-		if (show_textures)
-		{
-			bonobo::displayTexture({-0.95f, 0.55f}, {-0.55f, 0.95f}, textures[toU(Texture::DepthBuffer)], samplers[toU(Sampler::Linear)], {0, 0, 0, -1}, glm::uvec2(framebuffer_width, framebuffer_height), true, mCamera.mNear, mCamera.mFar);
-			bonobo::displayTexture({-0.95f, 0.05f}, {-0.55f, 0.45f}, textures[toU(Texture::GBufferDiffuse)], samplers[toU(Sampler::Linear)], {0, 1, 2, -1}, glm::uvec2(framebuffer_width, framebuffer_height));
-			if (is_sketching)
-				bonobo::displayTexture({0.55f, -0.95f}, {0.95f, -0.55f}, textures[toU(Texture::Noise)], samplers[toU(Sampler::Linear)], {0, 0, 0, -1}, glm::uvec2(framebuffer_width, framebuffer_height));
-			else
-				bonobo::displayTexture({-0.95f, -0.45f}, {-0.55f, -0.05f}, textures[toU(Texture::Silhouette)], samplers[toU(Sampler::Linear)], {0, 1, 2, -1}, glm::uvec2(framebuffer_width, framebuffer_height));
+			//
+			// Draw the GUI and debug views on top, at the size of the window
+			//
+			auto gui_pass = render_graph.AddPass("GUI");
+			gui_pass.HasSideEffects();
+			if (show_textures)
+			{
+				gui_pass.Read(depth_buffer, RenderGraph::Access::sampled)
+					.Read(gbuffer_diffuse, RenderGraph::Access::sampled)
+					.Read(is_sketching ? noise : silhouette, RenderGraph::Access::sampled);
+			}
+			gui_pass.Execute([&]()
+							 {
+				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0u);
+				glViewport(0, 0, window_width, window_height);
+
+				//
+				// Display 3D helpers, on top of the scene whose depth buffer
+				// does not match the size of the window
+				//
+				if (show_basis)
+				{
+					glClear(GL_DEPTH_BUFFER_BIT);
+					bonobo::renderBasis(basis_thickness_scale, basis_length_scale, mCamera.GetWorldToClipMatrix());
+				}
+
+				//
+				// Output content of the g-buffer as well as of the shadowmap, for debugging purposes
+				//
+				if (show_textures)
+				{
+					bonobo::displayTexture({-0.95f, 0.55f}, {-0.55f, 0.95f}, render_graph.GetTexture(depth_buffer), samplers[toU(Sampler::Linear)].get(), {0, 0, 0, -1}, glm::uvec2(window_width, window_height), true, mCamera.mNear, mCamera.mFar);
+					bonobo::displayTexture({-0.95f, 0.05f}, {-0.55f, 0.45f}, render_graph.GetTexture(gbuffer_diffuse), samplers[toU(Sampler::Linear)].get(), {0, 1, 2, -1}, glm::uvec2(window_width, window_height));
+					if (is_sketching)
+						bonobo::displayTexture({0.55f, -0.95f}, {0.95f, -0.55f}, render_graph.GetTexture(noise), samplers[toU(Sampler::Linear)].get(), {0, 0, 0, -1}, glm::uvec2(window_width, window_height));
+					else
+						bonobo::displayTexture({-0.95f, -0.45f}, {-0.55f, -0.05f}, render_graph.GetTexture(silhouette), samplers[toU(Sampler::Linear)].get(), {0, 1, 2, -1}, glm::uvec2(window_width, window_height));
+				}
+
+				//
+				// Reset viewport back to normal
+				//
+				glViewport(0, 0, window_width, window_height);
+
+				bool opened = ImGui::Begin("Render Time", nullptr, ImGuiWindowFlags_None);
+				if (opened)
+				{
+					ImGui::Text("Frame CPU time: %.3f ms", std::chrono::duration<float, std::milli>(deltaTimeUs).count());
+
+					ImGui::Text("Frames not timed, GPU too far behind: %llu", static_cast<unsigned long long>(gpu_timers.GetSkippedFrameCount()));
+
+					if (ImGui::BeginTable("Pass durations", 6, ImGuiTableFlags_SizingFixedFit))
+					{
+						ImGui::TableSetupColumn("Pass");
+						ImGui::TableSetupColumn("GPU time [ms]");
+						ImGui::TableSetupColumn("Min");
+						ImGui::TableSetupColumn("Avg");
+						ImGui::TableSetupColumn("Max");
+						ImGui::TableSetupColumn("P99");
+						ImGui::TableHeadersRow();
+
+						// Over the last frames collected; results arrive a few
+						// frames late, as they are never waited for.
+						for (std::size_t pass = 0u; pass < gpu_timers.GetPassCount(); ++pass)
+						{
+							auto const statistics = gpu_timers.GetStatistics(pass);
+							if (statistics.samples_nb == 0u)
+								continue;
+
+							ImGui::TableNextColumn();
+							ImGui::Text("%s", gpu_timers.GetPassName(pass).c_str());
+							for (auto const duration : {statistics.last, statistics.min, statistics.average, statistics.max, statistics.p99})
+							{
+								ImGui::TableNextColumn();
+								ImGui::Text("%.3f", duration);
+							}
+						}
+
+						ImGui::EndTable();
+					}
+
+					// Textures are assigned before any pass runs.
+					auto const &graph_statistics = render_graph.GetStatistics();
+					ImGui::Text("Passes: %zu run, %zu skipped", graph_statistics.passes_nb - graph_statistics.culled_passes_nb, graph_statistics.culled_passes_nb);
+					ImGui::Text("Render targets: %zu textures, %.1f MiB, for %zu transient ones, %.1f MiB",
+								graph_statistics.allocated_textures_nb, static_cast<float>(graph_statistics.allocated_memory) / (1024.0f * 1024.0f),
+								graph_statistics.transient_textures_nb, static_cast<float>(graph_statistics.transient_memory) / (1024.0f * 1024.0f));
+					auto const &state_statistics = state.get_frame_statistics();
+					ImGui::Text("Bindings: %zu issued, %zu redundant ones skipped", state_statistics.issued_calls_nb, state_statistics.avoided_calls_nb);
+
+					// Every debug group is recorded, both on the CPU and the GPU.
+					ImGui::Separator();
+					ImGui::SliderInt("Frames to capture", &trace_frames_nb, 1, 600);
+					if (trace_frames_left > 0)
+						ImGui::Text("Capturing, %d frames left", trace_frames_left);
+					else if (ImGui::Button("Capture trace"))
+					{
+						Profiler::StartCapture();
+						trace_frames_left = trace_frames_nb;
+					}
+					ImGui::Text("Written to %s, for chrome://tracing or Perfetto", trace_filename.c_str());
+				}
+				ImGui::End();
+
+				opened = ImGui::Begin("Scene Controls", nullptr, ImGuiWindowFlags_None);
+				if (opened)
+				{
+					ImGui::Checkbox("Show textures", &show_textures);
+					ImGui::Checkbox("Sketching?", &is_sketching);
+					ImGui::Checkbox("Silhouette", &is_silhouette_enabled);
+					// The compute backend comes last, and is left out when
+					// unsupported.
+					ImGui::Combo("Silhouette backend", &silhouette_backend, silhouette_backend_labels.data(),
+								 static_cast<int>(is_compute_silhouette_supported ? toU(SilhouetteBackend::Count) : toU(SilhouetteBackend::ComputeShader)));
+					if (is_gpu_culling_supported)
+					{
+						ImGui::Checkbox("Frustum culling", &is_frustum_culling_enabled);
+						ImGui::Checkbox("Occlusion culling", &is_occlusion_culling_enabled);
+					}
+					if (is_meshlet_culling_supported && silhouette_backend == toU(SilhouetteBackend::GeometryShader))
+						ImGui::Checkbox("Meshlet culling", &is_meshlet_culling_enabled);
+					scenes.SelectScene("Geometry", current_geometry_id);
+					if (ImGui::SliderInt("GPU memory budget (MiB)", &gpu_memory_budget_mib, 64, 4096))
+						scenes.SetGPUMemoryBudget(static_cast<std::size_t>(gpu_memory_budget_mib) << 20u);
+					ImGui::Text("GPU memory used by scenes: %.1f MiB", static_cast<float>(scenes.GetGPUMemoryUsage()) / (1024.0f * 1024.0f));
+					ImGui::Separator();
+					auto &resolution_settings = dynamic_resolution.GetSettings();
+					ImGui::Checkbox("Dynamic resolution", &resolution_settings.is_enabled);
+					if (resolution_settings.is_enabled)
+					{
+						ImGui::SliderFloat("Target frame time (ms)", &resolution_settings.target_frame_time, 4.0f, 50.0f);
+						ImGui::SliderFloat("Min resolution scale", &resolution_settings.min_scale, 0.25f, resolution_settings.max_scale);
+					}
+					ImGui::SliderFloat("Max resolution scale", &resolution_settings.max_scale, 0.25f, 1.0f);
+					ImGui::Text("Rendering at %dx%d (%.0f%%), GPU frame time %.2f ms", render_width, render_height,
+								100.0 * resolution_scale, dynamic_resolution.GetAverageFrameTime());
+					ImGui::Separator();
+					if (!is_sketching)
+					{
+						ImGui::SliderFloat("Hatching Thickness", &hatching_thickness, 4.0f, 30.0f);
+						ImGui::Separator();
+						ImGui::SliderFloat("Light X", &light_pos_x, -50.0f, 50.0f);
+						ImGui::SliderFloat("Light Y", &light_pos_y, -50.0f, 50.0f);
+						ImGui::SliderFloat("Light Z", &light_pos_z, -50.0f, 50.0f);
+					}
+
+					// ImGui::Checkbox("Show basis", &show_basis);
+					// ImGui::SliderFloat("Basis thickness scale", &basis_thickness_scale, 0.0f, 100.0f);
+					// ImGui::SliderFloat("Basis length scale", &basis_length_scale, 0.0f, 100.0f);
+				}
+				ImGui::End();
+
+				if (show_logs)
+					Log::View::Render();
+				mWindowManager->RenderImGuiFrame(show_gui); });
 		}
 
-		//
-		// Reset viewport back to normal
-		//
-		glViewport(0, 0, framebuffer_width, framebuffer_height);
+		render_graph.Execute();
 
-		bool opened = ImGui::Begin("Render Time", nullptr, ImGuiWindowFlags_None);
-		if (opened)
+		if (is_headless)
 		{
-			ImGui::Text("Frame CPU time: %.3f ms", std::chrono::duration<float, std::milli>(deltaTimeUs).count());
-
-			ImGui::Checkbox("Copy elapsed times back to CPU", &copy_elapsed_times);
-
-			if (ImGui::BeginTable("Pass durations", 2, ImGuiTableFlags_SizingFixedFit))
+			// Collect the previous frame from the other pixel buffer, so
+			// that the GPU works on this frame while the previous one gets
+			// copied out, and the frame writer encodes it while the next
+			// ones are rendered.
+			// When frames are only timed, the fences still keep the GPU
+			// at most two frames behind, as when writing them.
+			frame_readback.fences[readback_index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+			first_frame = false;
+			++frame_index;
+			if (frame_index > 1u)
 			{
-				ImGui::TableSetupColumn("Pass");
-				ImGui::TableSetupColumn("GPU time [ms]");
-				ImGui::TableHeadersRow();
-
-				ImGui::TableNextColumn();
-				ImGui::Text("Gbuffer gen.");
-				ImGui::TableNextColumn();
-				ImGui::Text("%.3f", pass_elapsed_times[toU(ElapsedTimeQuery::GbufferGeneration)] / 1000000.0f);
-
-				ImGui::TableNextColumn();
-				ImGui::Text("Silhouette det.");
-				ImGui::TableNextColumn();
-				ImGui::Text("%.3f", pass_elapsed_times[toU(ElapsedTimeQuery::Silhouette)] / 1000000.0f);
-
-				ImGui::TableNextColumn();
-				ImGui::Text("Resolve");
-				ImGui::TableNextColumn();
-				ImGui::Text("%.3f", pass_elapsed_times[toU(ElapsedTimeQuery::Resolve)] / 1000000.0f);
-
-				ImGui::TableNextColumn();
-				ImGui::Text("GUI");
-				ImGui::TableNextColumn();
-				ImGui::Text("%.3f", pass_elapsed_times[toU(ElapsedTimeQuery::GUI)] / 1000000.0f);
-
-				ImGui::TableNextColumn();
-				ImGui::Text("Copy to framebuffer");
-				ImGui::TableNextColumn();
-				ImGui::Text("%.3f", pass_elapsed_times[toU(ElapsedTimeQuery::CopyToFramebuffer)] / 1000000.0f);
-
-				ImGui::EndTable();
+				if (!is_writing_frames)
+					wait_for_frame(frame_index - 2u);
+				else if (!write_frame(frame_index - 2u))
+					break;
 			}
+			continue;
 		}
-		ImGui::End();
 
-		opened = ImGui::Begin("Scene Controls", nullptr, ImGuiWindowFlags_None);
-		if (opened)
 		{
-			ImGui::Checkbox("Show textures", &show_textures);
-			ImGui::Checkbox("Sketching?", &is_sketching);
-			bool changed = ImGui::Combo("Geometry", &current_geometry_id, geometry_names, IM_ARRAYSIZE(geometry_names), toU(Objects::Count));
-			current_geometry = geometry_array[current_geometry_id];
-			ImGui::Separator();
-			if (!is_sketching)
-			{
-				ImGui::SliderFloat("Hatching Thickness", &hatching_thickness, 4.0f, 30.0f);
-				ImGui::Separator();
-				ImGui::SliderFloat("Light X", &light_pos_x, -50.0f, 50.0f);
-				ImGui::SliderFloat("Light Y", &light_pos_y, -50.0f, 50.0f);
-				ImGui::SliderFloat("Light Z", &light_pos_z, -50.0f, 50.0f);
-			}
-
-			// ImGui::Checkbox("Show basis", &show_basis);
-			// ImGui::SliderFloat("Basis thickness scale", &basis_thickness_scale, 0.0f, 100.0f);
-			// ImGui::SliderFloat("Basis length scale", &basis_length_scale, 0.0f, 100.0f);
+			ProfileScope("Swap buffers");
+			glfwSwapBuffers(window);
 		}
-		ImGui::End();
 
-		if (show_logs)
-			Log::View::Render();
-		mWindowManager.RenderImGuiFrame(show_gui);
-
-		glEndQuery(GL_TIME_ELAPSED);
-		utils::opengl::debug::endDebugGroup();
+		first_frame = false;
+	}
 
-		//
-		// Blit the result back to the default framebuffer.
-		//
-		utils::opengl::debug::beginDebugGroup("Copy to default framebuffer");
-		glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::CopyToFramebuffer)]);
+	if (is_headless)
+	{
+		if (frame_index > mHeadlessSettings.warmup_frames_nb)
+			mHeadlessReport.cpu_frame_times.push_back(std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - lastTime).count());
 
-		// FBO::Resolve has already been bound to GL_READ_FRAMEBUFFER before rendering the first frame,
-		// as no other frame buffer gets bound to it.
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0u);
-		glBlitFramebuffer(0, 0, framebuffer_width, framebuffer_height, 0, 0, framebuffer_width, framebuffer_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		// The last frame only got read back, and the writer still has to
+		// encode the frames queued so far.
+		if (is_writing_frames)
+		{
+			if (frame_index != 0u && frame_writer->GetFailedCount() == 0u)
+				write_frame(frame_index - 1u);
+			frame_writer->Flush();
+		}
+		auto const duration = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - headless_start_time).count();
+		gpu_timers.WaitForPendingFrames();
 
-		glEndQuery(GL_TIME_ELAPSED);
-		utils::opengl::debug::endDebugGroup();
+		mHeadlessReport.is_complete = frame_index == mHeadlessSettings.frames_nb;
+		for (std::size_t pass = 0u; pass < gpu_timers.GetPassCount(); ++pass)
+		{
+			mHeadlessReport.pass_names.push_back(gpu_timers.GetPassName(pass));
+			mHeadlessReport.pass_statistics.push_back(gpu_timers.GetStatistics(pass));
+		}
 
-		glfwSwapBuffers(window);
+		auto const average_ms = [&gpu_timers](char const *pass_name)
+		{
+			auto const pass = gpu_timers.FindPass(pass_name);
+			if (pass == gpu_timers.GetPassCount())
+				return 0.0f;
+			auto const statistics = gpu_timers.GetStatistics(pass);
+			return statistics.total_samples_nb != 0u ? static_cast<float>(statistics.total / static_cast<double>(statistics.total_samples_nb)) : 0.0f;
+		};
+		if (written_frames_nb != 0u)
+		{
+			LogInfo("Rendered %u frames of %dx%d to \"%s\" in %.2f s; average GPU times: G-buffer %.3f ms, silhouette %.3f ms, resolve %.3f ms; "
+					"PNG encoding: %.1f ms per frame on %zu threads",
+					written_frames_nb, framebuffer_width, framebuffer_height, mHeadlessSettings.output_folder.c_str(), duration,
+					average_ms("G-buffer generation"), average_ms("Silhouette"), average_ms("Resolve"),
+					frame_writer->GetEncodeDuration() / static_cast<double>(written_frames_nb), frame_writer->GetWorkerCount());
+		}
+		else if (!is_writing_frames && frame_index != 0u)
+		{
+			LogInfo("Rendered %u frames of %dx%d in %.2f s; average GPU times: G-buffer %.3f ms, silhouette %.3f ms, resolve %.3f ms",
+					frame_index, framebuffer_width, framebuffer_height, duration,
+					average_ms("G-buffer generation"), average_ms("Silhouette"), average_ms("Resolve"));
+		}
+		frame_writer.reset();
+		deleteFrameReadback(frame_readback);
 
-		first_frame = false;
+		if (Profiler::IsCapturing())
+		{
+			Profiler::StopCapture();
+			Profiler::WriteChromeTrace(mHeadlessSettings.trace_filename);
+		}
 	}
 
-	glDeleteBuffers(static_cast<GLsizei>(ubos.size()), ubos.data());
-	glDeleteQueries(static_cast<GLsizei>(elapsed_time_queries.size()), elapsed_time_queries.data());
-	glDeleteSamplers(static_cast<GLsizei>(samplers.size()), samplers.data());
-	glDeleteFramebuffers(static_cast<GLsizei>(fbos.size()), fbos.data());
-	glDeleteTextures(static_cast<GLsizei>(textures.size()), textures.data());
-
 	glDeleteProgram(resolve_sketch_shader);
 	resolve_sketch_shader = 0u;
+	glDeleteProgram(cull_meshlets_shader);
+	cull_meshlets_shader = 0u;
+	glDeleteProgram(depth_pyramid_shader);
+	depth_pyramid_shader = 0u;
+	glDeleteProgram(cull_draws_shader);
+	cull_draws_shader = 0u;
+	glDeleteProgram(silhouette_segments_shader);
+	silhouette_segments_shader = 0u;
+	glDeleteProgram(silhouette_edges_shader);
+	silhouette_edges_shader = 0u;
+	glDeleteProgram(silhouette_unique_edges_shader);
+	silhouette_unique_edges_shader = 0u;
 	glDeleteProgram(fill_gbuffer_shader);
 	fill_gbuffer_shader = 0u;
 	glDeleteProgram(fallback_shader);
 	fallback_shader = 0u;
 }
 
-int main()
+namespace
+{
+	void printUsage(char const *program)
+	{
+		std::fprintf(stderr,
+					 "Usage: %s [--headless [options] | --benchmark [options]]\n"
+					 "\n"
+					 "Without arguments, NPRR opens a window. With --headless, it renders\n"
+					 "offscreen through EGL and writes frame_<index>.png files instead.\n"
+					 "\n"
+					 "Headless options:\n"
+					 "  --output <folder>    existing folder to write the frames to (default: .)\n"
+					 "  --frames <count>     number of frames to render (default: 1)\n"
+					 "  --size <w>x<h>       resolution of the frames (default: %ux%u)\n"
+					 "  --scene <name>       Sphere, Sofa, Face, LEGO or Sponza (default: Sphere)\n"
+					 "  --style sketch|comic rendering style (default: sketch)\n"
+					 "  --trace <file>       write a Chrome trace of the whole run to that file\n"
+					 "  --script <file>      batch script with a camera path and style settings;\n"
+					 "                       options after it override its settings\n"
+					 "\n"
+					 "Batch scripts hold one setting per line, and # starts a comment:\n"
+					 "  scene <name>, size <w>x<h>, frames <count>, style sketch|comic\n"
+					 "  hatching_thickness <value>   width of the comic style hatches\n"
+					 "  light <x> <y> <z>            light position, in metres\n"
+					 "  fps <value>                  frames per second along the path (default: 30)\n"
+					 "  tension <value>              Catmull-Rom tension (default: 0.5)\n"
+					 "  keyframe <time> <px> <py> <pz> <tx> <ty> <tz>\n"
+					 "                               camera position and target, in metres, at the\n"
+					 "                               given time in seconds; keyframes are sorted by\n"
+					 "                               increasing time\n"
+					 "Without frames, the whole path gets rendered.\n"
+					 "\n"
+					 "With --benchmark, NPRR times every scene, style and size along a\n"
+					 "fixed camera path instead; run it with --benchmark --help for its\n"
+					 "options.\n",
+					 program, config::resolution_x, config::resolution_y);
+	}
+} // namespace
+
+bool edan35::loadBatchScript(std::string const &filename, HeadlessSettings &settings)
+{
+	std::ifstream script(filename);
+	if (!script)
+	{
+		LogError("Failed to open batch script \"%s\"", filename.c_str());
+		return false;
+	}
+
+	bool has_frames_nb = false;
+	camera_path::path path;
+	std::string line;
+	for (std::size_t line_number = 1u; std::getline(script, line); ++line_number)
+	{
+		auto const comment_start = line.find('#');
+		if (comment_start != std::string::npos)
+			line.erase(comment_start);
+
+		std::istringstream fields(line);
+		std::string setting;
+		if (!(fields >> setting))
+			continue;
+
+		bool is_valid = true;
+		if (setting == "scene")
+			is_valid = static_cast<bool>(fields >> settings.scene);
+		else if (setting == "size")
+		{
+			std::string size;
+			is_valid = (fields >> size) && std::sscanf(size.c_str(), "%ux%u", &settings.width, &settings.height) == 2 && settings.width != 0u && settings.height != 0u;
+		}
+		else if (setting == "frames")
+			is_valid = has_frames_nb = static_cast<bool>(fields >> settings.frames_nb);
+		else if (setting == "style")
+		{
+			std::string style;
+			is_valid = (fields >> style) && (style == "sketch" || style == "comic");
+			settings.is_sketching = style == "sketch";
+		}
+		else if (setting == "hatching_thickness")
+			is_valid = static_cast<bool>(fields >> settings.hatching_thickness);
+		else if (setting == "light")
+			is_valid = static_cast<bool>(fields >> settings.light_position.x >> settings.light_position.y >> settings.light_position.z);
+		else if (setting == "fps")
+			is_valid = (fields >> settings.frames_per_second) && settings.frames_per_second > 0.0f;
+		else if (setting == "tension")
+			is_valid = static_cast<bool>(fields >> path.tension);
+		else if (setting == "keyframe")
+		{
+			camera_path::keyframe keyframe;
+			is_valid = (fields >> keyframe.time
+							  >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z
+							  >> keyframe.target.x >> keyframe.target.y >> keyframe.target.z)
+					   && (path.keyframes.empty() || keyframe.time > path.keyframes.back().time);
+			path.keyframes.push_back(keyframe);
+		}
+		else
+			is_valid = false;
+
+		if (!is_valid)
+		{
+			LogError("%s:%zu: invalid setting \"%s\"", filename.c_str(), line_number, line.c_str());
+			return false;
+		}
+	}
+
+	settings.camera_path = path;
+	if (!has_frames_nb && !path.keyframes.empty())
+		settings.frames_nb = static_cast<std::uint32_t>(camera_path::duration(path) * settings.frames_per_second) + 1u;
+
+	return true;
+}
+
+namespace
+{
+	bool parseHeadlessOptions(int argc, char *argv[], edan35::HeadlessSettings &settings)
+	{
+		for (int i = 2; i < argc; ++i)
+		{
+			auto const argument = std::string(argv[i]);
+			if (i + 1 >= argc)
+				return false;
+			auto const value = std::string(argv[++i]);
+			if (argument == "--output")
+				settings.output_folder = value;
+			else if (argument == "--frames")
+				settings.frames_nb = static_cast<std::uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+			else if (argument == "--size")
+			{
+				if (std::sscanf(value.c_str(), "%ux%u", &settings.width, &settings.height) != 2 || settings.width == 0u || settings.height == 0u)
+					return false;
+			}
+			else if (argument == "--scene")
+				settings.scene = value;
+			else if (argument == "--style" && (value == "sketch" || value == "comic"))
+				settings.is_sketching = value == "sketch";
+			else if (argument == "--trace")
+				settings.trace_filename = value;
+			else if (argument == "--script")
+			{
+				if (!edan35::loadBatchScript(value, settings))
+					return false;
+			}
+			else
+				return false;
+		}
+
+		return true;
+	}
+
+	int runHeadless(edan35::HeadlessSettings const &settings)
+	{
+#ifdef LUGGCGL_HAS_HEADLESS
+		// Bonobo would initialise GLFW, which fails without a display;
+		// only the logging part of it is needed here.
+		Log::Init();
+		bool is_valid = false;
+		{
+			HeadlessContext context;
+			is_valid = context.IsValid();
+			if (is_valid)
+			{
+				try
+				{
+					edan35::NPRR nprr(settings);
+					nprr.run();
+				}
+				catch (std::runtime_error const &e)
+				{
+					LogError(e.what());
+					is_valid = false;
+				}
+			}
+		}
+		Log::Destroy();
+		return is_valid ? EXIT_SUCCESS : EXIT_FAILURE;
+#else
+		static_cast<void>(settings);
+		LogError("Headless rendering is not available: EGL was not found when configuring the build.");
+		return EXIT_FAILURE;
+#endif
+	}
+} // namespace
+
+int main(int argc, char *argv[])
 {
 	std::setlocale(LC_ALL, "");
 
+	if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0)
+		return edan35::runBenchmark(argc, argv);
+
+	if (argc > 1)
+	{
+		edan35::HeadlessSettings settings;
+		if (std::strcmp(argv[1], "--headless") != 0 || !parseHeadlessOptions(argc, argv, settings))
+		{
+			printUsage(argv[0]);
+			return EXIT_FAILURE;
+		}
+		return runHeadless(settings);
+	}
+
 	Bonobo framework;
 
 	try
@@ -650,6 +1618,7 @@ int main()
 		LogError(e.what());
 	}
 }
+
 namespace
 {
 	void fill_noise_data(glm::vec3 *tex_arr, GLsizei framebuffer_width, GLsizei framebuffer_height)
@@ -662,181 +1631,67 @@ namespace
 			tex_arr[i] = glm::vec3(dis(gen));
 	}
 
-	Textures createTextures(GLsizei framebuffer_width, GLsizei framebuffer_height)
+	bonobo::gl::texture createNoiseTexture()
 	{
-		Textures textures;
-		glGenTextures(static_cast<GLsizei>(textures.size()), textures.data());
-
-		glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::DepthBuffer)]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, framebuffer_width, framebuffer_height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-		utils::opengl::debug::nameObject(GL_TEXTURE, textures[toU(Texture::DepthBuffer)], "Depth buffer");
-
-		glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::GBufferDiffuse)]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, framebuffer_width, framebuffer_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-		utils::opengl::debug::nameObject(GL_TEXTURE, textures[toU(Texture::GBufferDiffuse)], "GBuffer diffuse");
-
 		glm::vec3 *noise_data = new glm::vec3[constant::noise_res_x * constant::noise_res_y];
 		fill_noise_data(noise_data, constant::noise_res_x, constant::noise_res_y);
-		glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::Noise)]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, constant::noise_res_x, constant::noise_res_y, 0, GL_RGBA, GL_UNSIGNED_BYTE, noise_data);
-		utils::opengl::debug::nameObject(GL_TEXTURE, textures[toU(Texture::Noise)], "Noise");
-
-		glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::Silhouette)]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, framebuffer_width, framebuffer_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-		utils::opengl::debug::nameObject(GL_TEXTURE, textures[toU(Texture::Silhouette)], "Silhouette");
-
-		glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::Result)]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, framebuffer_width, framebuffer_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-		utils::opengl::debug::nameObject(GL_TEXTURE, textures[toU(Texture::Result)], "Final result");
-
-		glBindTexture(GL_TEXTURE_2D, 0u);
+		auto texture = bonobo::gl::texture::create_2d(GL_RGBA8, constant::noise_res_x, constant::noise_res_y, 1, "Noise");
+		texture.upload(0, constant::noise_res_x, constant::noise_res_y, GL_RGBA, GL_UNSIGNED_BYTE, noise_data);
 		delete[] noise_data;
 
-		return textures;
+		return texture;
 	}
 
 	Samplers createSamplers()
 	{
 		Samplers samplers;
-		glGenSamplers(static_cast<GLsizei>(samplers.size()), samplers.data());
 
 		// For sampling 2-D textures without interpolation.
-		glSamplerParameteri(samplers[toU(Sampler::Nearest)], GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glSamplerParameteri(samplers[toU(Sampler::Nearest)], GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		utils::opengl::debug::nameObject(GL_SAMPLER, samplers[toU(Sampler::Nearest)], "Nearest");
+		auto &nearest = samplers[toU(Sampler::Nearest)] = bonobo::gl::sampler::create("Nearest");
+		nearest.set_parameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		nearest.set_parameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
 		// For sampling 2-D textures without mipmaps.
-		glSamplerParameteri(samplers[toU(Sampler::Linear)], GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glSamplerParameteri(samplers[toU(Sampler::Linear)], GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		utils::opengl::debug::nameObject(GL_SAMPLER, samplers[toU(Sampler::Linear)], "Linear");
+		auto &linear = samplers[toU(Sampler::Linear)] = bonobo::gl::sampler::create("Linear");
+		linear.set_parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		linear.set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
 		// For sampling 2-D textures with mipmaps.
-		glSamplerParameteri(samplers[toU(Sampler::Mipmaps)], GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glSamplerParameteri(samplers[toU(Sampler::Mipmaps)], GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		utils::opengl::debug::nameObject(GL_SAMPLER, samplers[toU(Sampler::Mipmaps)], "Mimaps");
+		auto &mipmaps = samplers[toU(Sampler::Mipmaps)] = bonobo::gl::sampler::create("Mipmaps");
+		mipmaps.set_parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		mipmaps.set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
 		// For sampling 2-D shadow maps
-		glSamplerParameteri(samplers[toU(Sampler::Shadow)], GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glSamplerParameteri(samplers[toU(Sampler::Shadow)], GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glSamplerParameteri(samplers[toU(Sampler::Shadow)], GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
-		glSamplerParameteri(samplers[toU(Sampler::Shadow)], GL_TEXTURE_COMPARE_FUNC, GL_LESS);
-		utils::opengl::debug::nameObject(GL_SAMPLER, samplers[toU(Sampler::Shadow)], "Shadow");
+		auto &shadow = samplers[toU(Sampler::Shadow)] = bonobo::gl::sampler::create("Shadow");
+		shadow.set_parameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		shadow.set_parameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		shadow.set_parameter(GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		shadow.set_parameter(GL_TEXTURE_COMPARE_FUNC, GL_LESS);
 
 		return samplers;
 	}
 
-	FBOs createFramebufferObjects(Textures const &textures)
-	{
-		auto const validate_fbo = [](std::string const &fbo_name)
-		{
-			auto const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-			if (status == GL_FRAMEBUFFER_COMPLETE)
-				return;
-
-			LogError("Framebuffer \"%s\" is not complete: check the logs for additional information.", fbo_name.data());
-		};
-
-		FBOs fbos;
-		glGenFramebuffers(static_cast<GLsizei>(fbos.size()), fbos.data());
-
-		glBindFramebuffer(GL_FRAMEBUFFER, fbos[toU(FBO::GBuffer)]);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[toU(Texture::GBufferDiffuse)], 0);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[toU(Texture::DepthBuffer)], 0);
-		glReadBuffer(GL_NONE);				// Disable reading back from the colour attachments, as unnecessary in this assignment.
-		glDrawBuffer(GL_COLOR_ATTACHMENT0); // The fragment shader output at location 0 will be written to colour attachment 0 (i.e. the rendering result texture).
-		validate_fbo("GBuffer");
-		utils::opengl::debug::nameObject(GL_FRAMEBUFFER, fbos[toU(FBO::GBuffer)], "GBuffer");
-
-		glBindFramebuffer(GL_FRAMEBUFFER, fbos[toU(FBO::Silhouette)]);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[toU(Texture::Silhouette)], 0);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[toU(Texture::DepthBuffer)], 0);
-		glReadBuffer(GL_NONE);				// Disable reading back from the colour attachments, as unnecessary in this assignment.
-		glDrawBuffer(GL_COLOR_ATTACHMENT0); // The fragment shader output at location 0 will be written to colour attachment 0 (i.e. the rendering result texture).
-		validate_fbo("Silhouette");
-		utils::opengl::debug::nameObject(GL_FRAMEBUFFER, fbos[toU(FBO::Silhouette)], "Silhouette");
-
-		glBindFramebuffer(GL_FRAMEBUFFER, fbos[toU(FBO::Noise)]);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[toU(Texture::Noise)], 0);
-		glReadBuffer(GL_COLOR_ATTACHMENT0); // Colour attachment result 0 (i.e. the rendering result texture) will be blitted to the screen.
-		glDrawBuffer(GL_COLOR_ATTACHMENT0); // The fragment shader output at location 0 will be written to colour attachment 0 (i.e. the rendering result texture).
-		validate_fbo("Noise");
-		utils::opengl::debug::nameObject(GL_FRAMEBUFFER, fbos[toU(FBO::Noise)], "Noise");
-
-		glBindFramebuffer(GL_FRAMEBUFFER, fbos[toU(FBO::Resolve)]);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[toU(Texture::Result)], 0);
-		glReadBuffer(GL_COLOR_ATTACHMENT0); // Colour attachment result 0 (i.e. the rendering result texture) will be blitted to the screen.
-		glDrawBuffer(GL_COLOR_ATTACHMENT0); // The fragment shader output at location 0 will be written to colour attachment 0 (i.e. the rendering result texture).
-		validate_fbo("Resolve");
-		utils::opengl::debug::nameObject(GL_FRAMEBUFFER, fbos[toU(FBO::Resolve)], "Resolve");
-
-		glBindFramebuffer(GL_FRAMEBUFFER, fbos[toU(FBO::FinalWithDepth)]);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[toU(Texture::Result)], 0);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[toU(Texture::DepthBuffer)], 0);
-		glReadBuffer(GL_NONE);				// Disable reading back from the colour attachments, as unnecessary in this assignment.
-		glDrawBuffer(GL_COLOR_ATTACHMENT0); // The fragment shader output at location 0 will be written to colour attachment 0 (i.e. the rendering result texture).
-		validate_fbo("Final with depth");
-		utils::opengl::debug::nameObject(GL_FRAMEBUFFER, fbos[toU(FBO::FinalWithDepth)], "Cone wireframe");
-
-		glBindFramebuffer(GL_FRAMEBUFFER, 0u);
-		return fbos;
-	}
-
-	ElapsedTimeQueries createElapsedTimeQueries()
-	{
-		ElapsedTimeQueries queries;
-		glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
-
-		if (utils::opengl::debug::isSupported())
-		{
-			// Queries (like any other OpenGL object) need to have been used at least
-			// once to ensure their resources have been allocated so we can call
-			// `glObjectLabel()` on them.
-			auto const register_query = [](GLuint const query)
-			{
-				glBeginQuery(GL_TIME_ELAPSED, query);
-				glEndQuery(GL_TIME_ELAPSED);
-			};
-
-			register_query(queries[toU(ElapsedTimeQuery::GbufferGeneration)]);
-			utils::opengl::debug::nameObject(GL_QUERY, queries[toU(ElapsedTimeQuery::GbufferGeneration)], "GBuffer generation");
-
-			register_query(queries[toU(ElapsedTimeQuery::Noise)]);
-			utils::opengl::debug::nameObject(GL_QUERY, queries[toU(ElapsedTimeQuery::Noise)], "Noise generation");
-
-			register_query(queries[toU(ElapsedTimeQuery::Resolve)]);
-			utils::opengl::debug::nameObject(GL_QUERY, queries[toU(ElapsedTimeQuery::Resolve)], "Resolve");
-
-			register_query(queries[toU(ElapsedTimeQuery::GUI)]);
-			utils::opengl::debug::nameObject(GL_QUERY, queries[toU(ElapsedTimeQuery::GUI)], "GUI");
-		}
-
-		return queries;
-	}
-
 	UBOs createUniformBufferObjects()
 	{
 		UBOs ubos;
-		glGenBuffers(static_cast<GLsizei>(ubos.size()), ubos.data());
 
-		glBindBuffer(GL_UNIFORM_BUFFER, ubos[toU(UBO::CameraViewProjTransforms)]);
-		glBufferData(GL_UNIFORM_BUFFER, sizeof(ViewProjTransforms), nullptr, GL_STREAM_DRAW);
-		glBindBufferBase(GL_UNIFORM_BUFFER, toU(UBO::CameraViewProjTransforms), ubos[toU(UBO::CameraViewProjTransforms)]);
-		utils::opengl::debug::nameObject(GL_BUFFER, ubos[toU(UBO::CameraViewProjTransforms)], "Camera view-projection transforms");
+		// Updated every frame, through `bonobo::gl::buffer::upload()`.
+		auto &camera_view_proj_transforms = ubos[toU(UBO::CameraViewProjTransforms)];
+		camera_view_proj_transforms = bonobo::gl::buffer::create(sizeof(ViewProjTransforms), nullptr, GL_DYNAMIC_STORAGE_BIT, "Camera view-projection transforms");
+		glBindBufferBase(GL_UNIFORM_BUFFER, toU(UBO::CameraViewProjTransforms), camera_view_proj_transforms.get());
 
-		glBindBuffer(GL_UNIFORM_BUFFER, 0u);
 		return ubos;
 	}
 
 	void fillGBufferShaderLocations(GLuint gbuffer_shader, GBufferShaderLocations &locations)
 	{
 		locations.ubo_CameraViewProjTransforms = glGetUniformBlockIndex(gbuffer_shader, "CameraViewProjTransforms");
-		locations.vertex_model_to_world = glGetUniformLocation(gbuffer_shader, "vertex_model_to_world");
-		locations.normal_model_to_world = glGetUniformLocation(gbuffer_shader, "normal_model_to_world");
 		locations.camera_position = glGetUniformLocation(gbuffer_shader, "camera_position");
 		locations.light_position = glGetUniformLocation(gbuffer_shader, "light_position");
-		locations.diffuse_color = glGetUniformLocation(gbuffer_shader, "diffuse_color");
 		locations.is_sketching = glGetUniformLocation(gbuffer_shader, "is_sketching");
 		locations.thickness = glGetUniformLocation(gbuffer_shader, "thickness");
+		locations.resolution_scale = glGetUniformLocation(gbuffer_shader, "resolution_scale");
+		locations.are_directions_octahedral = glGetUniformLocation(gbuffer_shader, "are_directions_octahedral");
 
 		glUniformBlockBinding(gbuffer_shader, locations.ubo_CameraViewProjTransforms, toU(UBO::CameraViewProjTransforms));
 	}
@@ -844,8 +1699,6 @@ namespace
 	void fillSilhouetteShaderLocations(GLuint silhouette_shader, SilhouetteShaderLocations &locations)
 	{
 		locations.ubo_CameraViewProjTransforms = glGetUniformBlockIndex(silhouette_shader, "CameraViewProjTransforms");
-		locations.vertex_model_to_world = glGetUniformLocation(silhouette_shader, "vertex_model_to_world");
-		locations.normal_model_to_world = glGetUniformLocation(silhouette_shader, "normal_model_to_world");
 		locations.light_position = glGetUniformLocation(silhouette_shader, "light_position");
 		locations.noise_texture = glGetUniformLocation(silhouette_shader, "noise_texture");
 		locations.is_sketching = glGetUniformLocation(silhouette_shader, "is_sketching");
@@ -853,4 +1706,145 @@ namespace
 		glUniformBlockBinding(silhouette_shader, locations.ubo_CameraViewProjTransforms, toU(UBO::CameraViewProjTransforms));
 	}
 
+	void fillSilhouetteEdgesShaderLocations(GLuint silhouette_edges_shader, SilhouetteEdgesShaderLocations &locations)
+	{
+		locations.ubo_CameraViewProjTransforms = glGetUniformBlockIndex(silhouette_edges_shader, "CameraViewProjTransforms");
+		locations.vertex_model_to_world = glGetUniformLocation(silhouette_edges_shader, "vertex_model_to_world");
+		locations.light_position = glGetUniformLocation(silhouette_edges_shader, "light_position");
+		locations.noise_texture = glGetUniformLocation(silhouette_edges_shader, "noise_texture");
+		locations.is_sketching = glGetUniformLocation(silhouette_edges_shader, "is_sketching");
+		locations.edges_nb = glGetUniformLocation(silhouette_edges_shader, "edges_nb");
+		locations.first_edge = glGetUniformLocation(silhouette_edges_shader, "first_edge");
+		locations.positions_offset = glGetUniformLocation(silhouette_edges_shader, "positions_offset");
+		locations.segment_vertices_capacity = glGetUniformLocation(silhouette_edges_shader, "segment_vertices_capacity");
+
+		glUniformBlockBinding(silhouette_edges_shader, locations.ubo_CameraViewProjTransforms, toU(UBO::CameraViewProjTransforms));
+	}
+
+	SilhouetteSegments createSilhouetteSegments()
+	{
+		SilhouetteSegments segments;
+
+		// The vertices only get a buffer once their capacity is known.
+		segments.draw_command = bonobo::gl::buffer::create(4 * sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT, "Silhouette segments draw command");
+		segments.vao = bonobo::gl::vertex_array::create("Silhouette segments");
+
+		return segments;
+	}
+
+	void reserveSilhouetteSegments(SilhouetteSegments &segments, GLuint vertices_nb)
+	{
+		// Only ever grow, up to a fixed limit; segments which do not fit
+		// are dropped by the shaders.
+		vertices_nb = std::min(vertices_nb, constant::max_silhouette_segment_vertices);
+		if (vertices_nb <= segments.capacity)
+			return;
+
+		// Immutable storage can not grow, hence a new buffer; it is only
+		// ever accessed by the GPU.
+		segments.capacity = std::max(vertices_nb, std::min(2u * segments.capacity, constant::max_silhouette_segment_vertices));
+		segments.vertices = bonobo::gl::buffer::create(static_cast<GLsizeiptr>(segments.capacity) * static_cast<GLsizeiptr>(sizeof(glm::vec4)), nullptr, 0u,
+													   "Silhouette segment vertices");
+	}
+
+	void fillCullDrawsShaderLocations(GLuint cull_draws_shader, CullDrawsShaderLocations &locations)
+	{
+		locations.ubo_CameraViewProjTransforms = glGetUniformBlockIndex(cull_draws_shader, "CameraViewProjTransforms");
+		locations.draws_nb = glGetUniformLocation(cull_draws_shader, "draws_nb");
+		locations.is_frustum_culling_enabled = glGetUniformLocation(cull_draws_shader, "is_frustum_culling_enabled");
+		locations.is_occlusion_culling_enabled = glGetUniformLocation(cull_draws_shader, "is_occlusion_culling_enabled");
+		locations.occlusion_view_projection = glGetUniformLocation(cull_draws_shader, "occlusion_view_projection");
+		locations.depth_pyramid = glGetUniformLocation(cull_draws_shader, "depth_pyramid");
+
+		glUniformBlockBinding(cull_draws_shader, locations.ubo_CameraViewProjTransforms, toU(UBO::CameraViewProjTransforms));
+	}
+
+	void fillCullMeshletsShaderLocations(GLuint cull_meshlets_shader, CullMeshletsShaderLocations &locations)
+	{
+		locations.ubo_CameraViewProjTransforms = glGetUniformBlockIndex(cull_meshlets_shader, "CameraViewProjTransforms");
+		locations.meshlets_nb = glGetUniformLocation(cull_meshlets_shader, "meshlets_nb");
+		locations.light_position = glGetUniformLocation(cull_meshlets_shader, "light_position");
+		locations.is_frustum_culling_enabled = glGetUniformLocation(cull_meshlets_shader, "is_frustum_culling_enabled");
+
+		glUniformBlockBinding(cull_meshlets_shader, locations.ubo_CameraViewProjTransforms, toU(UBO::CameraViewProjTransforms));
+	}
+
+	DepthPyramid createDepthPyramid(GLsizei framebuffer_width, GLsizei framebuffer_height)
+	{
+		DepthPyramid pyramid;
+		pyramid.width = std::max(framebuffer_width / 2, 1);
+		pyramid.height = std::max(framebuffer_height / 2, 1);
+		pyramid.levels_nb = bonobo::gl::get_levels_nb(pyramid.width, pyramid.height);
+
+		pyramid.texture = bonobo::gl::texture::create_2d(GL_R32F, pyramid.width, pyramid.height, pyramid.levels_nb, "Depth pyramid");
+		pyramid.texture.set_parameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		pyramid.texture.set_parameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		return pyramid;
+	}
+
+	bool applyPendingResize(PendingResize &pending, int window_width, int window_height,
+							std::chrono::high_resolution_clock::time_point now, int &width, int &height)
+	{
+		// Minimised windows have no size to follow.
+		if (window_width <= 0 || window_height <= 0 || (window_width == width && window_height == height))
+		{
+			pending.width = width;
+			pending.height = height;
+			return false;
+		}
+		if (window_width != pending.width || window_height != pending.height)
+		{
+			pending.width = window_width;
+			pending.height = window_height;
+			pending.since = now;
+			return false;
+		}
+		if (now - pending.since < constant::resize_delay)
+			return false;
+
+		width = window_width;
+		height = window_height;
+		return true;
+	}
+
+	FrameReadback createFrameReadback(std::size_t frame_size)
+	{
+		FrameReadback readback;
+
+		// Only needed when writing frames out.
+		if (frame_size == 0u)
+			return readback;
+		for (auto &buffer : readback.buffers)
+			buffer = bonobo::gl::buffer::create(static_cast<GLsizeiptr>(frame_size), nullptr, GL_MAP_READ_BIT, "Frame readback");
+
+		return readback;
+	}
+
+	void deleteFrameReadback(FrameReadback &readback)
+	{
+		for (auto const fence : readback.fences)
+			if (fence != nullptr)
+				glDeleteSync(fence);
+		readback = FrameReadback{};
+	}
+
+	bool isBatchDrawingSupported()
+	{
+		if (!GLAD_GL_VERSION_4_3)
+			return false;
+
+		// The loader does not track this extension, which the shaders
+		// still need on OpenGL 4.6 for the ARB-suffixed built-ins.
+		GLint extensions_nb = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extensions_nb);
+		for (GLint i = 0; i < extensions_nb; ++i)
+		{
+			auto const *const extension = reinterpret_cast<char const *>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+			if (extension != nullptr && std::strcmp(extension, "GL_ARB_shader_draw_parameters") == 0)
+				return true;
+		}
+		return false;
+	}
+
 } // namespace
@@ -1,13 +1,59 @@
 #pragma once
 
+#include "camera_path.hpp"
+
+#include "core/GPUTimers.hpp"
 #include "core/InputHandler.h"
 #include "core/FPSCamera.h"
 #include "core/WindowManager.hpp"
 
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
 class Window;
 
 namespace edan35
 {
+	//! \brief What to render when running without a window.
+	struct HeadlessSettings
+	{
+		std::string output_folder{"."}; //!< existing folder the frames are written to
+		std::uint32_t width{0u};        //!< 0 to use the configured window width
+		std::uint32_t height{0u};       //!< 0 to use the configured window height
+		std::uint32_t frames_nb{1u};
+		std::string scene{"Sphere"};    //!< name the scene is registered with
+		bool is_sketching{true};        //!< sketch style if set, comic style otherwise
+		float hatching_thickness{6.0f}; //!< only used by the comic style
+		glm::vec3 light_position{2.5f, 3.0f, 4.0f}; //!< in metres
+		camera_path::path camera_path;  //!< empty to keep the default camera
+		float frames_per_second{30.0f}; //!< frame i is taken at time i / fps along the camera path
+		std::string trace_filename;     //!< if not empty, profiling scopes of the whole run get written there
+		bool write_frames{true};        //!< only time the frames if unset
+		std::uint32_t warmup_frames_nb{0u}; //!< first frames left out of the report, included in `frames_nb`
+	};
+
+	//! \brief Timings of a headless run, over the frames following the
+	//!        warm-up ones.
+	struct HeadlessReport
+	{
+		bool is_complete{false};        //!< whether all frames got rendered
+		std::vector<std::string> pass_names;
+		std::vector<GPUTimers::Statistics> pass_statistics; //!< one per pass
+		std::vector<float> cpu_frame_times; //!< in milliseconds
+	};
+
+	//! \brief Read the settings of a batch script, see `NPRR --help`, on
+	//!        top of the given ones.
+	//!
+	//! @param [in] filename batch script to read
+	//! @param [in,out] settings settings the script overrides
+	//! @return false if the script could not be read, or holds an invalid
+	//!         setting
+	bool loadBatchScript(std::string const &filename, HeadlessSettings &settings);
+
 	//! \brief Wrapper class for Assignment 2
 	class NPRR
 	{
@@ -18,6 +64,17 @@ namespace edan35
 		//! window to draw to.
 		NPRR(WindowManager &windowManager);
 
+		//! \brief Constructor for rendering without a window.
+		//!
+		//! An OpenGL context, such as a `HeadlessContext`, has to be
+		//! current already. `run()` then renders the requested number
+		//! of frames into FBO::Resolve, moving the camera along the
+		//! camera path if any, and writes each one to
+		//! `frame_<index>.png` in the output folder; frames are read back
+		//! asynchronously and encoded by a `FrameWriter`, while the next
+		//! ones get rendered.
+		explicit NPRR(HeadlessSettings const &settings);
+
 		//! \brief Default destructor.
 		//!
 		//! It will release the bonobo modules initialised by the
@@ -28,10 +85,15 @@ namespace edan35
 		//! render loop.
 		void run();
 
+		//! \brief Timings of the last headless `run()`.
+		HeadlessReport const &GetHeadlessReport() const { return mHeadlessReport; }
+
 	private:
 		FPSCameraf mCamera;
 		InputHandler inputHandler;
-		WindowManager &mWindowManager;
+		WindowManager *mWindowManager;
 		GLFWwindow *window;
+		HeadlessSettings mHeadlessSettings;
+		HeadlessReport mHeadlessReport;
 	};
 }
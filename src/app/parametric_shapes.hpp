@@ -2,8 +2,63 @@
 
 #include "core/helpers.hpp"
 
+#include <glm/glm.hpp>
+
+#include <vector>
+
 namespace parametric_shapes
 {
+	//! \brief Geometry of a shape, generated on the CPU; one entry per
+	//!        vertex in each attribute.
+	struct geometry
+	{
+		std::vector<glm::vec3> vertices;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec3> texcoords;
+		std::vector<glm::vec3> tangents;
+		std::vector<glm::vec3> binormals;
+		std::vector<glm::uvec3> index_sets; //!< one per triangle
+	};
+
+	//! \brief Make a shape available to OpenGL.
+	//!
+	//! @param shape the geometry to upload
+	//! @return wrapper around OpenGL objects' name containing the geometry
+	//!         data
+	bonobo::mesh_data upload(geometry const &shape);
+
+	//! \brief Generate the geometry of `createQuad()`, without touching
+	//!        OpenGL.
+	geometry generateQuad(float const width, float const height,
+						  unsigned int const horizontal_split_count = 0u,
+						  unsigned int const vertical_split_count = 0u);
+
+	//! \brief Generate the geometry of `createDisk()`, without touching
+	//!        OpenGL.
+	geometry generateDisk(float const radius,
+						  unsigned int const horizontal_split_count = 0u,
+						  unsigned int const vertical_split_count = 0u);
+
+	//! \brief Generate the geometry of `createSphere()`, without touching
+	//!        OpenGL.
+	geometry generateSphere(float const radius,
+							unsigned int const longitude_split_count,
+							unsigned int const latitude_split_count);
+
+	//! \brief Generate the geometry of `createTorus()`, without touching
+	//!        OpenGL.
+	geometry generateTorus(float const major_radius,
+						   float const minor_radius,
+						   unsigned int const major_split_count,
+						   unsigned int const minor_split_count);
+
+	//! \brief Generate the geometry of `createCircleRing()`, without
+	//!        touching OpenGL.
+	geometry generateCircleRing(float const radius,
+								float const spread_length,
+								unsigned int const circle_split_count,
+								unsigned int const spread_split_count);
+
 	//! \brief Create a quad a given tesselation level and make it
 	//!        available to OpenGL.
 	//!
@@ -0,0 +1,314 @@
+#include "core/adjacency.hpp"
+#include "core/meshlets.hpp"
+#include "core/parallel.hpp"
+#include "core/vertex_cache.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	struct Edge
+	{
+		std::uint32_t p1;
+		std::uint32_t p2;
+	};
+	bool operator==(Edge const& lhs, Edge const& rhs)
+	{
+		return lhs.p1 == rhs.p1 && lhs.p2 == rhs.p2;
+	}
+	struct EdgeHash
+	{
+		std::size_t operator()(Edge const& edge) const noexcept
+		{
+			std::size_t h1 = std::hash<unsigned int>{}(edge.p1);
+			std::size_t h2 = std::hash<unsigned int>{}(edge.p2);
+			return h1 ^ (h2 << 1);
+		}
+	};
+
+	// The hash-map based adjacency builder that used to live in
+	// `bonobo::loadObjects()`, kept as a reference point.
+	std::vector<std::uint32_t> buildWithHashMap(std::vector<std::uint32_t> const& indices)
+	{
+		std::unordered_map<Edge, std::uint32_t, EdgeHash> edge_adj_map;
+		for (std::size_t i = 0u; i < indices.size(); i += 3u) {
+			auto const iv1 = indices[i + 0u];
+			auto const iv2 = indices[i + 1u];
+			auto const iv3 = indices[i + 2u];
+			edge_adj_map[Edge{iv1, iv2}] = iv3;
+			edge_adj_map[Edge{iv2, iv3}] = iv1;
+			edge_adj_map[Edge{iv3, iv1}] = iv2;
+		}
+
+		std::vector<std::uint32_t> adjacency_indices(indices.size() * 2u);
+		for (std::size_t i = 0u; i < indices.size(); i += 3u) {
+			auto const iv1 = indices[i + 0u];
+			auto const iv2 = indices[i + 1u];
+			auto const iv3 = indices[i + 2u];
+			Edge const edges[3] = {Edge{iv2, iv1}, Edge{iv3, iv2}, Edge{iv1, iv3}};
+
+			adjacency_indices[2u * i + 0u] = iv1;
+			adjacency_indices[2u * i + 2u] = iv2;
+			adjacency_indices[2u * i + 4u] = iv3;
+			for (std::size_t j = 0u; j < 3u; ++j) {
+				auto const it = edge_adj_map.find(edges[j]);
+				adjacency_indices[2u * i + j * 2u + 1u] = it != edge_adj_map.end() ? it->second
+				                                                                    : edge_adj_map[Edge{edges[j].p2, edges[j].p1}];
+			}
+		}
+		return adjacency_indices;
+	}
+
+	// Regular grid of roughly |triangles_nb| triangles, shuffled into a
+	// non-coherent order similar to what scanned meshes look like.
+	std::vector<std::uint32_t> makeGrid(std::size_t triangles_nb, std::uint32_t& vertices_nb)
+	{
+		auto const side = static_cast<std::uint32_t>(std::ceil(std::sqrt(static_cast<double>(triangles_nb) / 2.0)));
+		vertices_nb = (side + 1u) * (side + 1u);
+
+		std::vector<std::uint32_t> indices;
+		indices.reserve(side * side * 6u);
+		for (std::uint32_t y = 0u; y < side; ++y) {
+			for (std::uint32_t x = 0u; x < side; ++x) {
+				auto const v00 = y * (side + 1u) + x;
+				auto const v10 = v00 + 1u;
+				auto const v01 = v00 + side + 1u;
+				auto const v11 = v01 + 1u;
+				indices.insert(indices.end(), {v00, v10, v11, v00, v11, v01});
+			}
+		}
+
+		std::uint64_t state = 0x2545F4914F6CDD1DULL;
+		auto const triangles = indices.size() / 3u;
+		for (std::size_t i = triangles - 1u; i > 0u; --i) {
+			state ^= state << 13u;
+			state ^= state >> 7u;
+			state ^= state << 17u;
+			auto const j = static_cast<std::size_t>(state % (i + 1u));
+			for (std::size_t k = 0u; k < 3u; ++k)
+				std::swap(indices[i * 3u + k], indices[j * 3u + k]);
+		}
+		return indices;
+	}
+
+	using Position = std::array<float, 3>;
+
+	// Positions for the vertices of `makeGrid()`, on a bumpy height field
+	// so that a fair share of edges end up on the silhouette.
+	std::vector<Position> makeGridPositions(std::uint32_t vertices_nb)
+	{
+		auto const row_length = static_cast<std::uint32_t>(std::lround(std::sqrt(static_cast<double>(vertices_nb))));
+		std::vector<Position> positions(vertices_nb);
+		for (std::uint32_t v = 0u; v < vertices_nb; ++v) {
+			auto const x = static_cast<float>(v % row_length);
+			auto const y = static_cast<float>(v / row_length);
+			positions[v] = {x, y, std::sin(0.7f * x) * std::cos(0.3f * y)};
+		}
+		return positions;
+	}
+
+	bool isFacingLight(Position const& a, Position const& b, Position const& c, Position const& light)
+	{
+		Position const ab = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+		Position const ac = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+		Position const normal = {ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0]};
+		return normal[0] * (light[0] - a[0]) + normal[1] * (light[1] - a[1]) + normal[2] * (light[2] - a[2]) > 0.00001f;
+	}
+
+	Position const light_position = {-10.0f, -20.0f, 5.0f};
+
+	// Same classification as NPR/silhouette.geom: each front-facing
+	// triangle tests its three neighbours, so every shared edge is looked
+	// at from both sides.
+	std::size_t classifyTriangles(std::uint32_t const* adjacency, std::size_t triangles_nb, std::vector<Position> const& positions, std::size_t& face_tests)
+	{
+		std::size_t silhouette_edges_nb = 0u;
+		for (std::size_t t = 0u; t < 6u * triangles_nb; t += 6u) {
+			auto const* const triangle = adjacency + t;
+			++face_tests;
+			if (!isFacingLight(positions[triangle[0]], positions[triangle[2]], positions[triangle[4]], light_position))
+				continue;
+			for (std::size_t e = 0u; e < 3u; ++e) {
+				++face_tests;
+				auto const v0 = triangle[2u * e];
+				auto const v1 = triangle[(2u * e + 2u) % 6u];
+				if (!isFacingLight(positions[v1], positions[v0], positions[triangle[2u * e + 1u]], light_position))
+					++silhouette_edges_nb;
+			}
+		}
+		return silhouette_edges_nb;
+	}
+
+	std::size_t classifyTriangleAdjacency(std::vector<std::uint32_t> const& adjacency, std::vector<Position> const& positions, std::size_t& face_tests)
+	{
+		return classifyTriangles(adjacency.data(), adjacency.size() / 6u, positions, face_tests);
+	}
+
+	// Same as `classifyTriangleAdjacency()`, but skipping the meshlets
+	// NPR/cull_meshlets.comp would discard.
+	std::size_t classifyMeshlets(std::vector<std::uint32_t> const& adjacency, std::vector<bonobo::meshlets::meshlet> const& meshlets,
+	                             std::vector<Position> const& positions, std::size_t& face_tests, std::size_t& kept_meshlets_nb)
+	{
+		auto const eye = glm::vec3(light_position[0], light_position[1], light_position[2]);
+		std::size_t silhouette_edges_nb = 0u;
+		for (auto const& meshlet : meshlets) {
+			if (bonobo::meshlets::is_silhouette_free(meshlet, eye))
+				continue;
+			++kept_meshlets_nb;
+			silhouette_edges_nb += classifyTriangles(adjacency.data() + 6u * meshlet.first_triangle, meshlet.triangles_nb, positions, face_tests);
+		}
+		return silhouette_edges_nb;
+	}
+
+	// Same classification as NPR/silhouette_edges.geom and .comp: each
+	// edge is looked at once, testing both of its faces.
+	std::size_t classifyUniqueEdges(std::vector<std::uint32_t> const& edges, std::vector<Position> const& positions, std::size_t& face_tests)
+	{
+		std::size_t silhouette_edges_nb = 0u;
+		for (std::size_t e = 0u; e < edges.size(); e += 4u) {
+			face_tests += 2u;
+			auto const& v0 = positions[edges[e + 1u]];
+			auto const& v1 = positions[edges[e + 2u]];
+			if (isFacingLight(v0, v1, positions[edges[e]], light_position) != isFacingLight(v1, v0, positions[edges[e + 3u]], light_position))
+				++silhouette_edges_nb;
+		}
+		return silhouette_edges_nb;
+	}
+
+	void BM_AdjacencyHashMap(benchmark::State& state)
+	{
+		std::uint32_t vertices_nb = 0u;
+		auto const indices = makeGrid(static_cast<std::size_t>(state.range(0)), vertices_nb);
+		for (auto _ : state)
+			benchmark::DoNotOptimize(buildWithHashMap(indices));
+		state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(indices.size() / 3u));
+	}
+
+	void BM_AdjacencyRadixSort(benchmark::State& state)
+	{
+		std::uint32_t vertices_nb = 0u;
+		auto const indices = makeGrid(static_cast<std::size_t>(state.range(0)), vertices_nb);
+		for (auto _ : state)
+			benchmark::DoNotOptimize(bonobo::adjacency::build(indices.data(), indices.size() / 3u, vertices_nb));
+		state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(indices.size() / 3u));
+	}
+
+	void BM_AdjacencyRadixSortWorkers(benchmark::State& state)
+	{
+		std::uint32_t vertices_nb = 0u;
+		auto const indices = makeGrid(static_cast<std::size_t>(state.range(0)), vertices_nb);
+		auto const workers_nb = static_cast<std::size_t>(state.range(1));
+		for (auto _ : state)
+			benchmark::DoNotOptimize(bonobo::adjacency::build(indices.data(), indices.size() / 3u, vertices_nb, workers_nb));
+		state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(indices.size() / 3u));
+	}
+
+	// How well the radix sort scales, from 1 thread up to all cores.
+	void WorkerCounts(benchmark::internal::Benchmark* benchmark)
+	{
+		auto const max_workers_nb = static_cast<std::int64_t>(utils::parallel::worker_count());
+		for (std::int64_t triangles_nb : {100000, 1000000}) {
+			for (std::int64_t workers_nb = 1; workers_nb < max_workers_nb; workers_nb *= 2)
+				benchmark->Args({triangles_nb, workers_nb});
+			benchmark->Args({triangles_nb, max_workers_nb});
+		}
+	}
+
+	void BM_ExtractEdges(benchmark::State& state)
+	{
+		std::uint32_t vertices_nb = 0u;
+		auto const indices = makeGrid(static_cast<std::size_t>(state.range(0)), vertices_nb);
+		auto const adjacency = bonobo::adjacency::build(indices.data(), indices.size() / 3u, vertices_nb);
+		for (auto _ : state)
+			benchmark::DoNotOptimize(bonobo::adjacency::extract_edges(adjacency.data(), adjacency.size() / 6u));
+		state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(indices.size() / 3u));
+	}
+
+	// The two silhouette layouts, classified on the CPU the way their
+	// shaders do; besides time, compare how many bytes of indices each
+	// one fetches and how many face orientations it evaluates per frame.
+	void BM_SilhouetteTriangleAdjacency(benchmark::State& state)
+	{
+		std::uint32_t vertices_nb = 0u;
+		auto const indices = makeGrid(static_cast<std::size_t>(state.range(0)), vertices_nb);
+		auto const positions = makeGridPositions(vertices_nb);
+		auto const adjacency = bonobo::adjacency::build(indices.data(), indices.size() / 3u, vertices_nb);
+		std::size_t face_tests = 0u;
+		std::size_t silhouette_edges_nb = 0u;
+		for (auto _ : state) {
+			face_tests = 0u;
+			silhouette_edges_nb = classifyTriangleAdjacency(adjacency, positions, face_tests);
+			benchmark::DoNotOptimize(silhouette_edges_nb);
+		}
+		state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(indices.size() / 3u));
+		state.counters["index_bytes"] = static_cast<double>(adjacency.size() * sizeof(std::uint32_t));
+		state.counters["face_tests"] = static_cast<double>(face_tests);
+		state.counters["silhouette_edges"] = static_cast<double>(silhouette_edges_nb);
+	}
+
+	void BM_SilhouetteUniqueEdges(benchmark::State& state)
+	{
+		std::uint32_t vertices_nb = 0u;
+		auto const indices = makeGrid(static_cast<std::size_t>(state.range(0)), vertices_nb);
+		auto const positions = makeGridPositions(vertices_nb);
+		auto const adjacency = bonobo::adjacency::build(indices.data(), indices.size() / 3u, vertices_nb);
+		auto const edges = bonobo::adjacency::extract_edges(adjacency.data(), adjacency.size() / 6u);
+		std::size_t face_tests = 0u;
+		std::size_t silhouette_edges_nb = 0u;
+		for (auto _ : state) {
+			face_tests = 0u;
+			silhouette_edges_nb = classifyUniqueEdges(edges, positions, face_tests);
+			benchmark::DoNotOptimize(silhouette_edges_nb);
+		}
+		state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(indices.size() / 3u));
+		state.counters["index_bytes"] = static_cast<double>(edges.size() * sizeof(std::uint32_t));
+		state.counters["face_tests"] = static_cast<double>(face_tests);
+		state.counters["silhouette_edges"] = static_cast<double>(silhouette_edges_nb);
+	}
+
+	// Meshlets only make sense over triangles ordered by Tipsify, as
+	// meshes are once imported.
+	void BM_SilhouetteMeshlets(benchmark::State& state)
+	{
+		std::uint32_t vertices_nb = 0u;
+		auto indices = makeGrid(static_cast<std::size_t>(state.range(0)), vertices_nb);
+		auto const positions = makeGridPositions(vertices_nb);
+		auto const order = bonobo::vertex_cache::order_triangles(indices.data(), indices.size() / 3u, vertices_nb, 16u);
+		std::vector<std::uint32_t> ordered_indices(indices.size());
+		for (std::size_t t = 0u; t < order.size(); ++t)
+			std::copy_n(indices.data() + 3u * order[t], 3u, ordered_indices.data() + 3u * t);
+		auto const adjacency = bonobo::adjacency::build(ordered_indices.data(), ordered_indices.size() / 3u, vertices_nb);
+		auto const meshlets = bonobo::meshlets::build(adjacency.data(), adjacency.size() / 6u, positions.front().data(), vertices_nb);
+		std::size_t face_tests = 0u;
+		std::size_t kept_meshlets_nb = 0u;
+		std::size_t silhouette_edges_nb = 0u;
+		for (auto _ : state) {
+			face_tests = 0u;
+			kept_meshlets_nb = 0u;
+			silhouette_edges_nb = classifyMeshlets(adjacency, meshlets, positions, face_tests, kept_meshlets_nb);
+			benchmark::DoNotOptimize(silhouette_edges_nb);
+		}
+		state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(indices.size() / 3u));
+		state.counters["face_tests"] = static_cast<double>(face_tests);
+		state.counters["silhouette_edges"] = static_cast<double>(silhouette_edges_nb);
+		state.counters["kept_meshlets"] = static_cast<double>(kept_meshlets_nb) / static_cast<double>(std::max<std::size_t>(meshlets.size(), 1u));
+	}
+}
+
+BENCHMARK(BM_AdjacencyHashMap)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_AdjacencyRadixSort)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_AdjacencyRadixSortWorkers)->Apply(WorkerCounts)->ArgNames({"triangles", "workers"})->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ExtractEdges)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_SilhouetteTriangleAdjacency)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_SilhouetteUniqueEdges)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_SilhouetteMeshlets)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,386 @@
+#include "app/parametric_shapes.hpp"
+#include "core/adjacency.hpp"
+#include "core/helpers.hpp"
+#include "core/Log.h"
+#include "core/mesh_cache.hpp"
+#include "core/scene_data.hpp"
+#include "core/various.hpp"
+#include "core/vertex_cache.hpp"
+#include "core/vertex_layout.hpp"
+#include "core/welding.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Everything measured here runs on the CPU only: no OpenGL context gets
+// created, and shapes are generated without being uploaded.
+namespace
+{
+	std::uint64_t nextRandom(std::uint64_t& state)
+	{
+		state ^= state << 13u;
+		state ^= state >> 7u;
+		state ^= state << 17u;
+		return state;
+	}
+
+	// Vertex positions of a bumpy grid of roughly |triangles_nb|
+	// triangles, with each triangle having its own three vertices, as
+	// Assimp hands them over when normals or texture coordinates differ
+	// between faces. With |jitter| set, every copy of a position is moved
+	// by up to that distance, as if written out with a limited precision.
+	std::vector<float> makeTriangleSoup(std::size_t triangles_nb, float jitter)
+	{
+		auto const side = static_cast<std::uint32_t>(std::ceil(std::sqrt(static_cast<double>(triangles_nb) / 2.0)));
+		auto const position = [side](std::uint32_t x, std::uint32_t y, float* out)
+		{
+			auto const fx = static_cast<float>(x) / static_cast<float>(side);
+			auto const fy = static_cast<float>(y) / static_cast<float>(side);
+			out[0] = fx;
+			out[1] = fy;
+			out[2] = 0.1f * std::sin(20.0f * fx) * std::cos(13.0f * fy);
+		};
+
+		std::vector<float> positions;
+		positions.reserve(static_cast<std::size_t>(side) * side * 18u);
+		for (std::uint32_t y = 0u; y < side; ++y) {
+			for (std::uint32_t x = 0u; x < side; ++x) {
+				std::uint32_t const corners[6][2] = {{x, y}, {x + 1u, y}, {x + 1u, y + 1u},
+				                                     {x, y}, {x + 1u, y + 1u}, {x, y + 1u}};
+				for (auto const& corner : corners) {
+					float vertex[3];
+					position(corner[0], corner[1], vertex);
+					positions.insert(positions.end(), vertex, vertex + 3);
+				}
+			}
+		}
+
+		if (jitter > 0.0f) {
+			std::uint64_t state = 0x9E3779B97F4A7C15ULL;
+			for (auto& coordinate : positions)
+				coordinate += jitter * (static_cast<float>(nextRandom(state) % 2001u) / 1000.0f - 1.0f);
+		}
+		return positions;
+	}
+
+	// Same processing as `bonobo::loadSceneData()` does for each mesh once
+	// Assimp is done: welding, remapping the faces, ordering them for the
+	// vertex cache, then building the adjacency indices, ordering the
+	// vertices and extracting the edges.
+	std::size_t processMesh(std::vector<float> const& positions, bonobo::welding::config const& weld_config)
+	{
+		auto const vertices_nb = static_cast<std::uint32_t>(positions.size() / 3u);
+		auto const welded = bonobo::welding::weld(positions.data(), vertices_nb, weld_config);
+		auto const& welded_indices = welded.remap; // one triangle per three consecutive vertices
+		auto const triangles_nb = welded_indices.size() / 3u;
+		auto const order = bonobo::vertex_cache::order_triangles(welded_indices.data(), triangles_nb, vertices_nb, bonobo::vertex_cache::config{}.cache_size);
+		std::vector<std::uint32_t> indices(welded_indices.size());
+		for (std::size_t t = 0u; t < triangles_nb; ++t)
+			std::copy_n(welded_indices.data() + 3u * order[t], 3u, indices.data() + 3u * t);
+		auto adjacency = bonobo::adjacency::build(indices.data(), triangles_nb, vertices_nb);
+		std::uint32_t used_vertices_nb = 0u;
+		auto const remap = bonobo::vertex_cache::order_vertices(adjacency.data(), adjacency.size(), vertices_nb, used_vertices_nb);
+		for (auto& index : adjacency)
+			index = remap[index];
+		auto const edges = bonobo::adjacency::extract_edges(adjacency.data(), adjacency.size() / 6u);
+		return edges.size();
+	}
+
+	void BM_WeldExact(benchmark::State& state)
+	{
+		auto const positions = makeTriangleSoup(static_cast<std::size_t>(state.range(0)), 0.0f);
+		auto const vertices_nb = static_cast<std::uint32_t>(positions.size() / 3u);
+		std::uint32_t unique_vertices_nb = 0u;
+		for (auto _ : state) {
+			auto const welded = bonobo::welding::weld(positions.data(), vertices_nb);
+			unique_vertices_nb = welded.unique_vertices_nb;
+			benchmark::DoNotOptimize(welded.remap.data());
+		}
+		state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(vertices_nb));
+		state.counters["unique_vertices"] = static_cast<double>(unique_vertices_nb);
+	}
+
+	void BM_WeldGrid(benchmark::State& state)
+	{
+		bonobo::welding::config weld_config;
+		weld_config.mode = bonobo::welding::mode_t::grid;
+		auto const positions = makeTriangleSoup(static_cast<std::size_t>(state.range(0)), 0.25f * weld_config.epsilon);
+		auto const vertices_nb = static_cast<std::uint32_t>(positions.size() / 3u);
+		std::uint32_t unique_vertices_nb = 0u;
+		for (auto _ : state) {
+			auto const welded = bonobo::welding::weld(positions.data(), vertices_nb, weld_config);
+			unique_vertices_nb = welded.unique_vertices_nb;
+			benchmark::DoNotOptimize(welded.remap.data());
+		}
+		state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(vertices_nb));
+		state.counters["unique_vertices"] = static_cast<double>(unique_vertices_nb);
+	}
+
+	void BM_AdjacencyFromWelded(benchmark::State& state)
+	{
+		auto const positions = makeTriangleSoup(static_cast<std::size_t>(state.range(0)), 0.0f);
+		auto const vertices_nb = static_cast<std::uint32_t>(positions.size() / 3u);
+		auto const indices = bonobo::welding::weld(positions.data(), vertices_nb).remap;
+		for (auto _ : state)
+			benchmark::DoNotOptimize(bonobo::adjacency::build(indices.data(), indices.size() / 3u, vertices_nb));
+		state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(indices.size() / 3u));
+	}
+
+	void BM_ProcessMesh(benchmark::State& state)
+	{
+		auto const positions = makeTriangleSoup(static_cast<std::size_t>(state.range(0)), 0.0f);
+		for (auto _ : state)
+			benchmark::DoNotOptimize(processMesh(positions, bonobo::welding::config{}));
+		state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(positions.size() / 9u));
+	}
+
+	// Order the welded triangles of a grid for the vertex cache, after
+	// shuffling them as the triangles of scanned meshes tend to be.
+	void BM_OrderTriangles(benchmark::State& state)
+	{
+		auto const positions = makeTriangleSoup(static_cast<std::size_t>(state.range(0)), 0.0f);
+		auto const vertices_nb = static_cast<std::uint32_t>(positions.size() / 3u);
+		auto const welded_indices = bonobo::welding::weld(positions.data(), vertices_nb).remap;
+		auto const triangles_nb = welded_indices.size() / 3u;
+		std::vector<std::uint32_t> indices(welded_indices.size());
+		std::uint64_t random_state = 0x9E3779B97F4A7C15ULL;
+		std::vector<std::uint32_t> shuffled(triangles_nb);
+		for (std::uint32_t t = 0u; t < triangles_nb; ++t)
+			shuffled[t] = t;
+		for (std::size_t t = triangles_nb; t > 1u; --t)
+			std::swap(shuffled[t - 1u], shuffled[nextRandom(random_state) % t]);
+		for (std::size_t t = 0u; t < triangles_nb; ++t)
+			std::copy_n(welded_indices.data() + 3u * shuffled[t], 3u, indices.data() + 3u * t);
+
+		auto const cache_size = bonobo::vertex_cache::config{}.cache_size;
+		std::vector<std::uint32_t> order;
+		for (auto _ : state) {
+			order = bonobo::vertex_cache::order_triangles(indices.data(), triangles_nb, vertices_nb, cache_size);
+			benchmark::DoNotOptimize(order.data());
+		}
+		state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(triangles_nb));
+		state.counters["acmr_before"] = bonobo::vertex_cache::acmr(indices.data(), triangles_nb, 3u, vertices_nb, cache_size);
+		state.counters["acmr_after"] = bonobo::vertex_cache::acmr(indices.data(), triangles_nb, 3u, vertices_nb, cache_size, order.data());
+	}
+
+	// Encode a mesh with all five attributes, its directions stored as
+	// `vertex_layout::format` number range(1); the first case, float3,
+	// matches the former planar layout.
+	void BM_BuildVertexLayout(benchmark::State& state)
+	{
+		auto const positions = makeTriangleSoup(static_cast<std::size_t>(state.range(0)), 0.0f);
+		auto directions = positions;
+		for (std::size_t v = 0u; v < directions.size(); v += 3u) {
+			auto const length = std::sqrt(directions[v] * directions[v] + directions[v + 1u] * directions[v + 1u] + directions[v + 2u] * directions[v + 2u]);
+			for (std::size_t c = 0u; c < 3u; ++c)
+				directions[v + c] = length > 0.0f ? directions[v + c] / length : 0.0f;
+		}
+		auto const vertices_nb = static_cast<std::uint32_t>(positions.size() / 3u);
+
+		bonobo::vertex_layout::config layout_config;
+		layout_config.directions = static_cast<bonobo::vertex_layout::format>(state.range(1));
+		layout_config.texcoords = layout_config.directions == bonobo::vertex_layout::format::float3 ? bonobo::vertex_layout::format::float3 : bonobo::vertex_layout::format::half2;
+		std::array<float const*, 5> const sources{{positions.data(), directions.data(), positions.data(), directions.data(), directions.data()}};
+
+		std::vector<std::uint8_t> vertex_data;
+		bonobo::vertex_layout::attributes layout;
+		for (auto _ : state) {
+			bonobo::vertex_layout::build(layout_config, vertices_nb, sources, vertex_data, layout);
+			benchmark::DoNotOptimize(vertex_data.data());
+		}
+		state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(vertices_nb));
+		state.counters["bytes_per_vertex"] = static_cast<double>(vertex_data.size()) / static_cast<double>(std::max(vertices_nb, 1u));
+	}
+
+	// Write the triangle soup as an OBJ file with per-face normals, so that
+	// Assimp keeps the vertices of each face apart.
+	std::string writeObj(std::size_t triangles_nb)
+	{
+		auto const filename = "bench_assets_" + std::to_string(triangles_nb) + ".obj";
+		auto const positions = makeTriangleSoup(triangles_nb, 0.0f);
+		std::ofstream obj(filename);
+		for (std::size_t v = 0u; v < positions.size(); v += 3u)
+			obj << "v " << positions[v] << ' ' << positions[v + 1u] << ' ' << positions[v + 2u] << '\n';
+		for (std::size_t t = 0u; t < positions.size() / 9u; ++t)
+			obj << "vn 0 0 " << ((t % 2u) == 0u ? 1 : -1) << '\n';
+		for (std::size_t t = 0u; t < positions.size() / 9u; ++t)
+			obj << "f " << 3u * t + 1u << "//" << t + 1u << ' ' << 3u * t + 2u << "//" << t + 1u << ' ' << 3u * t + 3u << "//" << t + 1u << '\n';
+		return filename;
+	}
+
+	void BM_LoadSceneData(benchmark::State& state)
+	{
+		auto const filename = writeObj(static_cast<std::size_t>(state.range(0)));
+		auto const cache_path = bonobo::mesh_cache::path_for(filename);
+		for (auto _ : state) {
+			state.PauseTiming();
+			std::remove(cache_path.c_str());
+			state.ResumeTiming();
+
+			bonobo::scene_data scene;
+			if (!bonobo::loadSceneData(filename, scene)) {
+				state.SkipWithError("Failed to load the generated scene");
+				break;
+			}
+			benchmark::DoNotOptimize(scene.meshes.data());
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+		std::remove(cache_path.c_str());
+		std::remove(filename.c_str());
+	}
+
+	void BM_LoadSceneDataCached(benchmark::State& state)
+	{
+		auto const filename = writeObj(static_cast<std::size_t>(state.range(0)));
+		auto const cache_path = bonobo::mesh_cache::path_for(filename);
+		bonobo::scene_data scene;
+		if (!bonobo::loadSceneData(filename, scene))
+			state.SkipWithError("Failed to load the generated scene");
+		for (auto _ : state) {
+			if (!bonobo::loadSceneData(filename, scene)) {
+				state.SkipWithError("Failed to load the generated scene");
+				break;
+			}
+			benchmark::DoNotOptimize(scene.meshes.data());
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+		std::remove(cache_path.c_str());
+		std::remove(filename.c_str());
+	}
+
+	void BM_GetTextureData(benchmark::State& state)
+	{
+		// Smooth gradients with some noise on top, which compress about
+		// as well as photographs do.
+		auto const size = static_cast<std::uint32_t>(state.range(0));
+		std::vector<std::uint8_t> texels(static_cast<std::size_t>(size) * size * 4u);
+		std::uint64_t random_state = 0x2545F4914F6CDD1DULL;
+		for (std::uint32_t y = 0u; y < size; ++y)
+			for (std::uint32_t x = 0u; x < size; ++x) {
+				auto* const texel = texels.data() + (static_cast<std::size_t>(y) * size + x) * 4u;
+				auto const noise = static_cast<std::uint32_t>(nextRandom(random_state) % 16u);
+				texel[0] = static_cast<std::uint8_t>((x * 255u) / size ^ noise);
+				texel[1] = static_cast<std::uint8_t>((y * 255u) / size ^ noise);
+				texel[2] = static_cast<std::uint8_t>(((x + y) * 127u) / size);
+				texel[3] = 255u;
+			}
+		auto const filename = "bench_assets_" + std::to_string(size) + ".png";
+		if (!bonobo::writePNG(filename, size, size, texels.data())) {
+			state.SkipWithError("Failed to write the generated image");
+			return;
+		}
+
+		for (auto _ : state) {
+			std::uint32_t width = 0u, height = 0u;
+			benchmark::DoNotOptimize(bonobo::getTextureData(filename, width, height, true));
+		}
+		state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(texels.size()));
+		std::remove(filename.c_str());
+	}
+
+	void BM_SlurpFile(benchmark::State& state)
+	{
+		auto const filename = std::string("bench_assets_slurp.bin");
+		{
+			std::vector<char> content(static_cast<std::size_t>(state.range(0)), 'x');
+			std::ofstream file(filename, std::ios::binary);
+			file.write(content.data(), static_cast<std::streamsize>(content.size()));
+		}
+		for (auto _ : state)
+			benchmark::DoNotOptimize(utils::slurp_file(filename));
+		state.SetBytesProcessed(state.iterations() * state.range(0));
+		std::remove(filename.c_str());
+	}
+
+	// Split counts are picked so that each shape has roughly the
+	// requested number of triangles, two per quad of the parametrisation.
+	unsigned int splitCount(std::int64_t triangles_nb, double quads_per_edge_squared)
+	{
+		auto const edges_nb = std::sqrt(static_cast<double>(triangles_nb) / (2.0 * quads_per_edge_squared));
+		return static_cast<unsigned int>(std::max(1.0, std::ceil(edges_nb))) - 1u;
+	}
+
+	void BM_GenerateQuad(benchmark::State& state)
+	{
+		auto const split_count = splitCount(state.range(0), 1.0);
+		for (auto _ : state)
+			benchmark::DoNotOptimize(parametric_shapes::generateQuad(1.0f, 1.0f, split_count, split_count));
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	void BM_GenerateDisk(benchmark::State& state)
+	{
+		auto const split_count = splitCount(state.range(0), 1.0);
+		for (auto _ : state)
+			benchmark::DoNotOptimize(parametric_shapes::generateDisk(1.0f, split_count, split_count));
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	void BM_GenerateSphere(benchmark::State& state)
+	{
+		// Twice as many longitudinal edges as latitudinal ones.
+		auto const latitude_split_count = splitCount(state.range(0), 2.0);
+		for (auto _ : state)
+			benchmark::DoNotOptimize(parametric_shapes::generateSphere(1.0f, 2u * latitude_split_count + 1u, latitude_split_count));
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	void BM_GenerateTorus(benchmark::State& state)
+	{
+		// Four times as many edges around the major ring as around the
+		// minor one.
+		auto const minor_split_count = splitCount(state.range(0), 4.0);
+		for (auto _ : state)
+			benchmark::DoNotOptimize(parametric_shapes::generateTorus(1.0f, 0.25f, 4u * minor_split_count + 3u, minor_split_count));
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	void BM_GenerateCircleRing(benchmark::State& state)
+	{
+		auto const split_count = splitCount(state.range(0), 1.0);
+		for (auto _ : state)
+			benchmark::DoNotOptimize(parametric_shapes::generateCircleRing(1.0f, 0.5f, split_count, split_count));
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+}
+
+BENCHMARK(BM_WeldExact)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_WeldGrid)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_AdjacencyFromWelded)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ProcessMesh)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_OrderTriangles)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_BuildVertexLayout)->ArgsProduct({{1000, 100000, 10000000}, {0, 1, 2}})->Unit(benchmark::kMillisecond)->UseRealTime();
+// Text OBJ files grow past a gigabyte at 10M triangles; stop at 1M.
+BENCHMARK(BM_LoadSceneData)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_LoadSceneDataCached)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_GetTextureData)->RangeMultiplier(4)->Range(256, 4096)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_SlurpFile)->RangeMultiplier(16)->Range(1 << 10, 1 << 28)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_GenerateQuad)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_GenerateDisk)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_GenerateSphere)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_GenerateTorus)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_GenerateCircleRing)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+int main(int argc, char** argv)
+{
+	// Loading a scene logs a few lines each time, which would drown the
+	// results.
+	Log::SetVerbosity(Log::Type::TYPE_INFO, Log::Verbosity::WHISPER);
+	Log::SetVerbosity(Log::Type::TYPE_TRIVIA, Log::Verbosity::WHISPER);
+
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+		return 1;
+	benchmark::RunSpecifiedBenchmarks();
+	return 0;
+}
@@ -0,0 +1,78 @@
+#include "DynamicResolution.hpp"
+
+#include "GPUTimers.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Scales below that leave too few pixels for lines to survive.
+	float constexpr smallest_scale = 0.25f;
+	float constexpr scale_step = 1.0f / 40.0f;
+	// Largest changes in a single update; dropping the resolution is
+	// allowed to go faster than raising it back, as missing the target
+	// is worse than rendering at a lower resolution for a little longer.
+	float constexpr max_decrease = 0.1f;
+	float constexpr max_increase = 0.05f;
+	// The scale only changes when the average frame time leaves
+	// [band_lower * target, target], aiming for the middle of it.
+	float constexpr band_lower = 0.8f;
+	float constexpr band_middle = 0.9f;
+	float constexpr smoothing = 0.2f;
+}
+
+DynamicResolution::DynamicResolution(std::size_t const frames_in_flight) : frames_in_flight(frames_in_flight)
+{
+}
+
+void DynamicResolution::Update(GPUTimers const& timers)
+{
+	auto const upper = std::min(std::max(settings.max_scale, smallest_scale), 1.0f);
+	auto const lower = std::min(std::max(settings.min_scale, smallest_scale), upper);
+	SetScale(settings.is_enabled ? std::min(std::max(scale, lower), upper) : upper);
+
+	auto const collected_frames_nb = timers.GetCollectedFrameCount();
+	if (collected_frames_nb == last_collected_frame)
+		return;
+	last_collected_frame = collected_frames_nb;
+	if (ignored_frames_nb != 0u) {
+		--ignored_frames_nb;
+		return;
+	}
+
+	auto const frame_time = timers.GetLastFrameDuration();
+	average_frame_time = has_average ? average_frame_time + smoothing * (frame_time - average_frame_time) : frame_time;
+	has_average = true;
+	if (!settings.is_enabled)
+		return;
+
+	auto const target = settings.target_frame_time;
+	if (!(average_frame_time > 0.0f) || (average_frame_time <= target && average_frame_time >= band_lower * target))
+		return;
+
+	auto desired = scale * std::sqrt(band_middle * target / average_frame_time);
+	desired = std::min(std::max(desired, scale - max_decrease), scale + max_increase);
+	// Rounding down makes sure a frame time above the target always
+	// lowers the scale by at least one step.
+	desired = std::floor(desired / scale_step + 0.001f) * scale_step;
+	SetScale(std::min(std::max(desired, lower), upper));
+}
+
+int DynamicResolution::GetScaledSize(int const size) const
+{
+	return std::max(static_cast<int>(std::lround(static_cast<float>(size) * scale)), 1);
+}
+
+void DynamicResolution::SetScale(float const new_scale)
+{
+	if (new_scale == scale)
+		return;
+
+	// Carry the average over to the new scale, so that it does not take
+	// several frames to reflect the change.
+	auto const ratio = new_scale / scale;
+	average_frame_time *= ratio * ratio;
+	scale = new_scale;
+	ignored_frames_nb = frames_in_flight;
+}
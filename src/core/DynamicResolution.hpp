@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class GPUTimers;
+
+//! \brief Pick the scale at which to render, so that frames take about as
+//!        long on the GPU as a given target.
+//!
+//! The cost of a frame is assumed to grow with its number of pixels,
+//! that is with the square of the scale. Each new frame duration
+//! collected by the `GPUTimers` goes into a moving average; when the
+//! latter leaves a band below the target, the scale is moved towards the
+//! one expected to bring it back in the middle of the band, by bounded
+//! steps so that a single slow frame does not halve the resolution. The
+//! frames still in flight when the scale changes were rendered at the
+//! previous one, so they get ignored.
+//!
+//! Scales are quantised, to keep the resolution from changing every
+//! frame by a pixel or two.
+class DynamicResolution
+{
+public:
+	struct Settings
+	{
+		bool is_enabled{false};
+		float target_frame_time{1000.0f / 60.0f}; //!< in milliseconds
+		float min_scale{0.5f};
+		float max_scale{1.0f};                    //!< also the scale used when disabled
+	};
+
+	//! @param [in] frames_in_flight number of frames the GPU can lag
+	//!             behind, which is how many durations get ignored after
+	//!             changing the scale
+	explicit DynamicResolution(std::size_t frames_in_flight = 4u);
+
+	//! \brief Look at the frame durations collected since the last call,
+	//!        and update the scale accordingly; to be called once per
+	//!        frame, after `GPUTimers::BeginFrame()`.
+	void Update(GPUTimers const& timers);
+
+	//! \brief Factor to apply to the width and height of the render
+	//!        targets, within [min_scale, max_scale].
+	float GetScale() const { return scale; }
+
+	//! \brief Scale |size|, keeping at least one pixel.
+	int GetScaledSize(int size) const;
+
+	//! \brief Average of the last frame durations, in milliseconds, kept
+	//!        up to date even when disabled.
+	float GetAverageFrameTime() const { return average_frame_time; }
+
+	Settings& GetSettings() { return settings; }
+	Settings const& GetSettings() const { return settings; }
+
+private:
+	void SetScale(float new_scale);
+
+	Settings settings;
+	std::size_t frames_in_flight;
+	float scale{1.0f};
+	float average_frame_time{0.0f};
+	std::uint64_t last_collected_frame{0u};
+	std::size_t ignored_frames_nb{0u};
+	bool has_average{false};
+};
@@ -0,0 +1,108 @@
+#include "FrameWriter.hpp"
+
+#include "helpers.hpp"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+FrameWriter::FrameWriter(std::size_t const workers_nb, std::size_t const max_pending_frames)
+{
+	auto const threads_nb = std::max<std::size_t>(workers_nb, 1u);
+	this->max_pending_frames = max_pending_frames != 0u ? max_pending_frames : 2u * threads_nb;
+
+	workers.reserve(threads_nb);
+	for (std::size_t i = 0u; i < threads_nb; ++i)
+		workers.emplace_back(&FrameWriter::RunWorker, this);
+}
+
+FrameWriter::~FrameWriter()
+{
+	// Unlike texture requests, queued frames are not dropped: workers
+	// only exit once the queue is empty.
+	{
+		std::lock_guard<std::mutex> const lock(jobs_mutex);
+		is_stopping = true;
+	}
+	jobs_available.notify_all();
+	for (auto& worker : workers)
+		worker.join();
+}
+
+std::vector<std::uint8_t> FrameWriter::AcquireBuffer(std::size_t const size)
+{
+	std::vector<std::uint8_t> buffer;
+	{
+		std::lock_guard<std::mutex> const lock(jobs_mutex);
+		if (!free_buffers.empty()) {
+			buffer = std::move(free_buffers.back());
+			free_buffers.pop_back();
+		}
+	}
+	buffer.resize(size);
+	return buffer;
+}
+
+void FrameWriter::Write(std::string filename, std::uint32_t const width, std::uint32_t const height,
+                        std::vector<std::uint8_t> texels)
+{
+	{
+		std::unique_lock<std::mutex> lock(jobs_mutex);
+		job_done.wait(lock, [this]() { return jobs.size() < max_pending_frames; });
+		jobs.push_back({std::move(filename), width, height, std::move(texels)});
+	}
+	jobs_available.notify_one();
+}
+
+void FrameWriter::Flush()
+{
+	std::unique_lock<std::mutex> lock(jobs_mutex);
+	job_done.wait(lock, [this]() { return jobs.empty() && busy_workers_nb == 0u; });
+}
+
+std::size_t FrameWriter::GetFailedCount()
+{
+	std::lock_guard<std::mutex> const lock(jobs_mutex);
+	return failed_nb;
+}
+
+double FrameWriter::GetEncodeDuration()
+{
+	std::lock_guard<std::mutex> const lock(jobs_mutex);
+	return encode_duration;
+}
+
+void FrameWriter::RunWorker()
+{
+	Profiler::SetThreadName("Frame writer");
+	for (;;) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(jobs_mutex);
+			jobs_available.wait(lock, [this]() { return is_stopping || !jobs.empty(); });
+			if (jobs.empty())
+				return;
+			job = std::move(jobs.front());
+			jobs.pop_front();
+			++busy_workers_nb;
+		}
+		// Room was made in the queue.
+		job_done.notify_all();
+
+		ProfileScope("Encode frame");
+		auto const encode_start_time = std::chrono::high_resolution_clock::now();
+		bool const is_written = bonobo::writePNG(job.filename, job.width, job.height, job.texels.data());
+		auto const duration = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - encode_start_time).count();
+
+		{
+			std::lock_guard<std::mutex> const lock(jobs_mutex);
+			--busy_workers_nb;
+			if (!is_written)
+				++failed_nb;
+			encode_duration += duration;
+			free_buffers.push_back(std::move(job.texels));
+		}
+		job_done.notify_all();
+	}
+}
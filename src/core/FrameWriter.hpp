@@ -0,0 +1,86 @@
+#pragma once
+
+#include "core/parallel.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//! \brief Encode rendered frames to PNG files in the background.
+//!
+//! Frames are handed over with `Write()` and encoded by a pool of worker
+//! threads, so that the thread owning the OpenGL context can go on
+//! rendering the next frames in the meantime. At most a fixed number of
+//! frames wait to be encoded: past that, `Write()` blocks until a worker
+//! is done with one, which bounds the memory used when rendering is
+//! faster than encoding. Texel buffers are recycled once written, see
+//! `AcquireBuffer()`.
+class FrameWriter
+{
+public:
+	//! @param [in] workers_nb number of encoding threads
+	//! @param [in] max_pending_frames number of frames which can be
+	//!             waiting for a worker before `Write()` blocks; 0 picks
+	//!             two per worker
+	explicit FrameWriter(std::size_t workers_nb = utils::parallel::worker_count(),
+	                     std::size_t max_pending_frames = 0u);
+
+	//! \brief Write all frames still queued, then stop the workers.
+	~FrameWriter();
+
+	FrameWriter(FrameWriter const&) = delete;
+	FrameWriter& operator=(FrameWriter const&) = delete;
+
+	//! \brief Get a buffer of `size` bytes to read a frame into, reusing
+	//!        the storage of an already written frame when possible.
+	std::vector<std::uint8_t> AcquireBuffer(std::size_t size);
+
+	//! \brief Queue a frame for writing to a PNG file.
+	//!
+	//! @param [in] filename of the PNG file to write
+	//! @param [in] width width of the frame
+	//! @param [in] height height of the frame
+	//! @param [in] texels RGBA8 texels, bottom row first as returned by
+	//!             `glReadPixels()`
+	void Write(std::string filename, std::uint32_t width, std::uint32_t height,
+	           std::vector<std::uint8_t> texels);
+
+	//! \brief Wait until all queued frames have been written.
+	void Flush();
+
+	//! \brief Number of frames which could not be written so far.
+	std::size_t GetFailedCount();
+
+	//! \brief Time spent encoding and writing frames so far, summed
+	//!        over all workers, in milliseconds.
+	double GetEncodeDuration();
+
+	std::size_t GetWorkerCount() const { return workers.size(); }
+
+private:
+	struct Job {
+		std::string filename;
+		std::uint32_t width;
+		std::uint32_t height;
+		std::vector<std::uint8_t> texels;
+	};
+
+	void RunWorker();
+
+	std::vector<std::thread> workers;
+	std::mutex jobs_mutex;
+	std::condition_variable jobs_available;
+	std::condition_variable job_done;
+	std::deque<Job> jobs;
+	std::vector<std::vector<std::uint8_t>> free_buffers;
+	std::size_t max_pending_frames;
+	std::size_t busy_workers_nb = 0u;
+	std::size_t failed_nb = 0u;
+	double encode_duration = 0.0;
+	bool is_stopping = false;
+};
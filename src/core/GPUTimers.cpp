@@ -0,0 +1,224 @@
+#include "GPUTimers.hpp"
+
+#include "opengl.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <utility>
+
+namespace
+{
+	enum : std::uint8_t {
+		pass_not_timed = 0u,
+		pass_begun,
+		pass_ended
+	};
+}
+
+GPUTimers::GPUTimers(std::vector<std::string> pass_names, std::size_t const frames_in_flight, std::size_t const history_size)
+	: pass_names(std::move(pass_names)), history_size(std::max<std::size_t>(history_size, 1u))
+{
+	auto const passes_nb = this->pass_names.size();
+
+	frames.resize(std::max<std::size_t>(frames_in_flight, 1u));
+	for (auto& frame : frames) {
+		frame.queries.resize(2u * passes_nb);
+		frame.pass_states.resize(passes_nb, pass_not_timed);
+		CreateQueries(frame, 0u);
+	}
+
+	histories.resize(passes_nb);
+	for (auto& history : histories)
+		history.durations.resize(this->history_size);
+}
+
+GPUTimers::~GPUTimers()
+{
+	for (auto const& frame : frames)
+		if (!frame.queries.empty())
+			glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+}
+
+std::size_t GPUTimers::RegisterPass(std::string const& name)
+{
+	auto const pass = FindPass(name);
+	if (pass != pass_names.size())
+		return pass;
+
+	pass_names.push_back(name);
+	for (auto& frame : frames) {
+		frame.queries.resize(2u * pass_names.size(), 0u);
+		frame.pass_states.push_back(pass_not_timed);
+		CreateQueries(frame, pass);
+	}
+
+	histories.emplace_back();
+	histories.back().durations.resize(history_size);
+
+	return pass;
+}
+
+std::size_t GPUTimers::FindPass(std::string const& name) const
+{
+	return static_cast<std::size_t>(std::find(pass_names.begin(), pass_names.end(), name) - pass_names.begin());
+}
+
+void GPUTimers::BeginFrame()
+{
+	// Frames complete in order, so stop at the first one which is not.
+	for (std::size_t i = 1u; i <= frames.size(); ++i) {
+		auto& frame = frames[(current_frame + i) % frames.size()];
+		if (!frame.is_pending)
+			continue;
+		if (!IsAvailable(frame))
+			break;
+		Collect(frame);
+	}
+
+	current_frame = (current_frame + 1u) % frames.size();
+	auto& frame = frames[current_frame];
+	is_current_frame_timed = !frame.is_pending;
+	if (!is_current_frame_timed) {
+		++skipped_frames_nb;
+		return;
+	}
+	std::fill(frame.pass_states.begin(), frame.pass_states.end(), pass_not_timed);
+}
+
+void GPUTimers::BeginPass(std::size_t const pass)
+{
+	assert(pass < pass_names.size());
+	if (!is_current_frame_timed)
+		return;
+
+	auto& frame = frames[current_frame];
+	glQueryCounter(frame.queries[2u * pass], GL_TIMESTAMP);
+	frame.pass_states[pass] = pass_begun;
+}
+
+void GPUTimers::EndPass(std::size_t const pass)
+{
+	assert(pass < pass_names.size());
+	if (!is_current_frame_timed)
+		return;
+
+	auto& frame = frames[current_frame];
+	if (frame.pass_states[pass] != pass_begun)
+		return;
+	glQueryCounter(frame.queries[2u * pass + 1u], GL_TIMESTAMP);
+	frame.pass_states[pass] = pass_ended;
+	frame.is_pending = true;
+}
+
+void GPUTimers::WaitForPendingFrames()
+{
+	for (std::size_t i = 1u; i <= frames.size(); ++i) {
+		auto& frame = frames[(current_frame + i) % frames.size()];
+		if (frame.is_pending)
+			Collect(frame);
+	}
+}
+
+void GPUTimers::ResetStatistics()
+{
+	for (auto& history : histories) {
+		history.next = 0u;
+		history.samples_nb = 0u;
+		history.total = 0.0;
+		history.total_samples_nb = 0u;
+	}
+}
+
+GPUTimers::Statistics GPUTimers::GetStatistics(std::size_t const pass) const
+{
+	assert(pass < pass_names.size());
+	auto const& history = histories[pass];
+
+	Statistics statistics;
+	statistics.samples_nb = history.samples_nb;
+	statistics.total = history.total;
+	statistics.total_samples_nb = history.total_samples_nb;
+	if (history.samples_nb == 0u)
+		return statistics;
+
+	auto const capacity = history.durations.size();
+	statistics.last = history.durations[(history.next + capacity - 1u) % capacity];
+
+	std::vector<float> durations(history.durations.begin(), history.durations.begin() + static_cast<std::ptrdiff_t>(history.samples_nb));
+	auto const minmax = std::minmax_element(durations.begin(), durations.end());
+	statistics.min = *minmax.first;
+	statistics.max = *minmax.second;
+	float sum = 0.0f;
+	for (auto const duration : durations)
+		sum += duration;
+	statistics.average = sum / static_cast<float>(durations.size());
+
+	auto const p99 = durations.begin() + static_cast<std::ptrdiff_t>((durations.size() * 99u) / 100u);
+	std::nth_element(durations.begin(), p99, durations.end());
+	statistics.p99 = *p99;
+
+	return statistics;
+}
+
+void GPUTimers::CreateQueries(Frame& frame, std::size_t const first_pass)
+{
+	if (first_pass == pass_names.size())
+		return;
+	auto* const queries = frame.queries.data() + 2u * first_pass;
+	glGenQueries(static_cast<GLsizei>(2u * (pass_names.size() - first_pass)), queries);
+
+	if (!utils::opengl::debug::isSupported())
+		return;
+
+	// Queries only get created on first use, and can not be labelled
+	// before.
+	for (std::size_t pass = first_pass; pass < pass_names.size(); ++pass) {
+		glQueryCounter(frame.queries[2u * pass], GL_TIMESTAMP);
+		glQueryCounter(frame.queries[2u * pass + 1u], GL_TIMESTAMP);
+		utils::opengl::debug::nameObject(GL_QUERY, frame.queries[2u * pass], pass_names[pass] + " begin");
+		utils::opengl::debug::nameObject(GL_QUERY, frame.queries[2u * pass + 1u], pass_names[pass] + " end");
+	}
+}
+
+bool GPUTimers::IsAvailable(Frame const& frame) const
+{
+	for (std::size_t pass = 0u; pass < frame.pass_states.size(); ++pass) {
+		if (frame.pass_states[pass] != pass_ended)
+			continue;
+		for (std::size_t i = 2u * pass; i <= 2u * pass + 1u; ++i) {
+			GLuint is_available = GL_FALSE;
+			glGetQueryObjectuiv(frame.queries[i], GL_QUERY_RESULT_AVAILABLE, &is_available);
+			if (is_available == GL_FALSE)
+				return false;
+		}
+	}
+	return true;
+}
+
+void GPUTimers::Collect(Frame& frame)
+{
+	GLuint64 frame_begin = std::numeric_limits<GLuint64>::max(), frame_end = 0u;
+	for (std::size_t pass = 0u; pass < frame.pass_states.size(); ++pass) {
+		if (frame.pass_states[pass] != pass_ended)
+			continue;
+
+		GLuint64 begin = 0u, end = 0u;
+		glGetQueryObjectui64v(frame.queries[2u * pass], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(frame.queries[2u * pass + 1u], GL_QUERY_RESULT, &end);
+		auto const duration = static_cast<float>(end > begin ? end - begin : 0u) / 1000000.0f;
+		frame_begin = std::min(frame_begin, begin);
+		frame_end = std::max(frame_end, end);
+
+		auto& history = histories[pass];
+		history.durations[history.next] = duration;
+		history.next = (history.next + 1u) % history.durations.size();
+		history.samples_nb = std::min(history.samples_nb + 1u, history.durations.size());
+		history.total += static_cast<double>(duration);
+		++history.total_samples_nb;
+	}
+	frame.is_pending = false;
+
+	last_frame_duration = static_cast<float>(frame_end > frame_begin ? frame_end - frame_begin : 0u) / 1000000.0f;
+	++collected_frames_nb;
+}
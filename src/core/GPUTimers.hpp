@@ -0,0 +1,129 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//! \brief Time rendering passes on the GPU, without ever waiting for the
+//!        results.
+//!
+//! Each pass is bracketed by two `GL_TIMESTAMP` queries which, unlike
+//! `GL_TIME_ELAPSED` ones, may overlap or nest. The queries of the last
+//! few frames are kept in a ring: `BeginFrame()` polls the frames still
+//! in flight through `GL_QUERY_RESULT_AVAILABLE`, and only reads back the
+//! ones the GPU is done with. If the GPU lags further behind than the
+//! ring covers, the new frame is simply not timed.
+//!
+//! The durations of the last frames are kept per pass, to report rolling
+//! statistics, along with totals over all the frames timed.
+//!
+//! All methods must be called from the thread owning the OpenGL context.
+class GPUTimers
+{
+public:
+	//! \brief Durations of a pass, in milliseconds.
+	struct Statistics
+	{
+		float last{0.0f};
+		float min{0.0f};
+		float average{0.0f};
+		float max{0.0f};
+		float p99{0.0f};
+		std::size_t samples_nb{0u};         //!< number of frames the values above cover
+		double total{0.0};                  //!< over all the frames timed so far
+		std::uint64_t total_samples_nb{0u};
+	};
+
+	//! @param [in] pass_names one name per pass, used to label queries
+	//! @param [in] frames_in_flight number of frames whose results can be
+	//!             waited for at any given time
+	//! @param [in] history_size number of frames the rolling statistics
+	//!             cover
+	explicit GPUTimers(std::vector<std::string> pass_names,
+	                   std::size_t frames_in_flight = 4u,
+	                   std::size_t history_size = 128u);
+	~GPUTimers();
+
+	GPUTimers(GPUTimers const&) = delete;
+	GPUTimers& operator=(GPUTimers const&) = delete;
+
+	//! \brief Get the index of the pass called |name|, adding it after the
+	//!        existing ones if there is none yet.
+	//!
+	//! Frames already in flight do not time the added pass.
+	std::size_t RegisterPass(std::string const& name);
+
+	//! \brief Get the index of the pass called |name|, or
+	//!        `GetPassCount()` if there is none.
+	std::size_t FindPass(std::string const& name) const;
+
+	//! \brief Collect the results of earlier frames which are available,
+	//!        and start timing a new frame.
+	void BeginFrame();
+
+	//! \brief Record the GPU time at which a pass starts; passes can be
+	//!        left out of a frame.
+	void BeginPass(std::size_t pass);
+
+	//! \brief Record the GPU time at which a pass ends.
+	void EndPass(std::size_t pass);
+
+	//! \brief Wait for all frames still in flight, and collect them.
+	//!
+	//! This does stall, and is meant for the end of offline renders.
+	void WaitForPendingFrames();
+
+	//! \brief Forget all durations collected so far, for example once
+	//!        warm-up frames are done; frames still in flight will be
+	//!        collected as usual.
+	void ResetStatistics();
+
+	Statistics GetStatistics(std::size_t pass) const;
+
+	std::size_t GetPassCount() const { return pass_names.size(); }
+	std::string const& GetPassName(std::size_t pass) const { return pass_names[pass]; }
+
+	//! \brief Time between the start of the first pass and the end of the
+	//!        last one, in milliseconds, for the frame collected last.
+	float GetLastFrameDuration() const { return last_frame_duration; }
+
+	//! \brief Number of frames collected so far, which tells whether
+	//!        `GetLastFrameDuration()` changed since it was last looked at.
+	std::uint64_t GetCollectedFrameCount() const { return collected_frames_nb; }
+
+	//! \brief Number of frames which were not timed, because the GPU was
+	//!        too far behind.
+	std::uint64_t GetSkippedFrameCount() const { return skipped_frames_nb; }
+
+private:
+	struct Frame {
+		std::vector<GLuint> queries;    // begin and end timestamps of each pass
+		std::vector<std::uint8_t> pass_states;
+		bool is_pending{false};
+	};
+
+	struct History {
+		std::vector<float> durations;   // ring of the last durations
+		std::size_t next{0u};
+		std::size_t samples_nb{0u};
+		double total{0.0};
+		std::uint64_t total_samples_nb{0u};
+	};
+
+	void CreateQueries(Frame& frame, std::size_t first_pass);
+	bool IsAvailable(Frame const& frame) const;
+	void Collect(Frame& frame);
+
+	std::vector<std::string> pass_names;
+	std::vector<Frame> frames;
+	std::vector<History> histories;
+	std::size_t history_size;
+	std::size_t current_frame{0u};
+	bool is_current_frame_timed{false};
+	std::uint64_t skipped_frames_nb{0u};
+	std::uint64_t collected_frames_nb{0u};
+	float last_frame_duration{0.0f};
+};
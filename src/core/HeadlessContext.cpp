@@ -0,0 +1,151 @@
+#include "HeadlessContext.hpp"
+
+#include "Log.h"
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstring>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+namespace
+{
+	// Same version as the one requested for windows.
+	const int default_opengl_major_version = 4;
+	const int default_opengl_minor_version = 1;
+
+	bool hasExtension(char const* extensions, char const* name)
+	{
+		if (extensions == nullptr)
+			return false;
+
+		auto const name_length = std::strlen(name);
+		for (char const* start = extensions; (start = std::strstr(start, name)) != nullptr; start += name_length) {
+			bool const starts_word = start == extensions || start[-1] == ' ';
+			bool const ends_word = start[name_length] == ' ' || start[name_length] == '\0';
+			if (starts_word && ends_word)
+				return true;
+		}
+		return false;
+	}
+
+	EGLDisplay getDisplay(std::string& platform_name)
+	{
+		auto const client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+		auto const get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+		if (get_platform_display != nullptr && hasExtension(client_extensions, "EGL_MESA_platform_surfaceless")) {
+			auto const display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+			if (display != EGL_NO_DISPLAY) {
+				platform_name = "surfaceless";
+				return display;
+			}
+		}
+
+		auto const query_devices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+		if (get_platform_display != nullptr && query_devices != nullptr && hasExtension(client_extensions, "EGL_EXT_platform_device")) {
+			EGLDeviceEXT device = EGL_NO_DEVICE_EXT;
+			EGLint devices_nb = 0;
+			if (query_devices(1, &device, &devices_nb) && devices_nb > 0) {
+				auto const display = get_platform_display(EGL_PLATFORM_DEVICE_EXT, device, nullptr);
+				if (display != EGL_NO_DISPLAY) {
+					platform_name = "device";
+					return display;
+				}
+			}
+		}
+
+		platform_name = "default";
+		return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+} // anonymous namespace
+
+HeadlessContext::HeadlessContext()
+{
+	auto const display = getDisplay(mPlatformName);
+	EGLint major = 0, minor = 0;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+		LogError("[EGL] Failed to initialise a display (error 0x%x).", eglGetError());
+		return;
+	}
+	mDisplay = display;
+
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		LogError("[EGL] Desktop OpenGL is not supported by EGL %d.%d.", major, minor);
+		return;
+	}
+
+	// Pbuffer support is only needed as a fallback, for implementations
+	// without surfaceless contexts.
+	EGLint const config_attributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_NONE
+	};
+	EGLConfig config = nullptr;
+	EGLint configs_nb = 0;
+	if (!eglChooseConfig(display, config_attributes, &config, 1, &configs_nb) || configs_nb == 0) {
+		LogError("[EGL] No configuration supports desktop OpenGL.");
+		return;
+	}
+
+	EGLint const context_attributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, default_opengl_major_version,
+		EGL_CONTEXT_MINOR_VERSION, default_opengl_minor_version,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+#if DEBUG_LEVEL >= 2
+		EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+#endif
+		EGL_NONE
+	};
+	auto const context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+	if (context == EGL_NO_CONTEXT) {
+		LogError("Couldn't create an OpenGL %d.%d context through EGL (error 0x%x).", default_opengl_major_version, default_opengl_minor_version, eglGetError());
+		return;
+	}
+
+	EGLSurface surface = EGL_NO_SURFACE;
+	if (!hasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context")) {
+		EGLint const surface_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+		surface = eglCreatePbufferSurface(display, config, surface_attributes);
+	}
+	if (!eglMakeCurrent(display, surface, surface, context)) {
+		LogError("[EGL] Failed to make the context current (error 0x%x).", eglGetError());
+		if (surface != EGL_NO_SURFACE)
+			eglDestroySurface(display, surface);
+		eglDestroyContext(display, context);
+		return;
+	}
+	mSurface = surface;
+
+	if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress))) {
+		LogError("[GLAD]: Failed to initialise OpenGL context.");
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(display, context);
+		return;
+	}
+	mContext = context;
+
+	LogInfo("Using OpenGL %d.%d through EGL %d.%d (%s platform) on \"%s\".", GLVersion.major, GLVersion.minor,
+	        major, minor, mPlatformName.c_str(), reinterpret_cast<char const*>(glGetString(GL_RENDERER)));
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	if (mDisplay == nullptr)
+		return;
+
+	eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (mSurface != nullptr)
+		eglDestroySurface(mDisplay, mSurface);
+	if (mContext != nullptr)
+		eglDestroyContext(mDisplay, mContext);
+	eglTerminate(mDisplay);
+}
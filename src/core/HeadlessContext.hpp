@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+
+//! \brief An OpenGL context which is not tied to any window, for rendering
+//!        on machines without a display.
+//!
+//! The context is created through EGL, preferring Mesa's surfaceless
+//! platform and then the first EGL device, so that it works both with a
+//! GPU and with the llvmpipe software rasteriser. It requests the same
+//! OpenGL version and profile as `WindowManager::CreateGLFWWindow()`,
+//! and loads the OpenGL functions through GLAD once made current.
+//!
+//! Nothing is drawn to a default framebuffer: everything has to be
+//! rendered into framebuffer objects, and read back from there.
+//!
+//! Note: Only one instance of this class should be alive at any given
+//! time, as GLAD only keeps track of one context.
+class HeadlessContext
+{
+public:
+	HeadlessContext();
+	~HeadlessContext();
+
+	HeadlessContext(HeadlessContext const&) = delete;
+	HeadlessContext& operator=(HeadlessContext const&) = delete;
+
+	//! \brief Whether the context got created and made current.
+	bool IsValid() const noexcept { return mContext != nullptr; }
+
+	//! \brief Name of the EGL platform the context was created on, for
+	//!        logging purposes.
+	std::string const& GetPlatformName() const noexcept { return mPlatformName; }
+
+private:
+	void* mDisplay{nullptr}; // EGLDisplay
+	void* mContext{nullptr}; // EGLContext
+	void* mSurface{nullptr}; // EGLSurface, only used if surfaceless contexts are not supported
+	std::string mPlatformName;
+};
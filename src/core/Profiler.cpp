@@ -0,0 +1,381 @@
+#include "Profiler.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Profiler {
+
+namespace {
+
+// Each thread keeps its last events in a ring of that many entries.
+constexpr std::size_t events_per_thread = std::size_t(1u) << 18u;
+constexpr std::size_t name_length = 48u;
+constexpr std::size_t gpu_frames_in_flight = 4u;
+constexpr std::size_t gpu_queries_increment = 256u;
+constexpr std::size_t not_timed = std::numeric_limits<std::size_t>::max();
+
+struct Event {
+	char name[name_length];
+	std::int64_t begin;    // in nanoseconds since `epoch`
+	std::int64_t duration; // in nanoseconds
+};
+
+// Only the owning thread appends to `events`, publishing them through
+// `count`; readers only look at published events.
+struct ThreadBuffer {
+	std::unique_ptr<Event[]> events;
+	std::atomic<std::size_t> count{0u};
+	std::atomic<std::size_t> capture_begin{0u};
+	std::uint32_t id{0u};
+	std::string name;
+};
+
+struct OpenScope {
+	Event event;
+	bool is_recorded;
+};
+
+struct GPUScope {
+	Event event;
+	std::size_t query; // begin timestamp; the end one follows it
+	bool is_ended;
+};
+
+struct GPUFrame {
+	std::vector<GLuint> queries;
+	std::vector<GPUScope> scopes;
+	std::size_t used_queries_nb{0u};
+	bool is_pending{false};
+};
+
+// Only ever accessed from the thread owning the OpenGL context.
+struct GPUState {
+	std::array<GPUFrame, gpu_frames_in_flight> frames;
+	std::size_t current_frame{0u};
+	bool is_frame_timed{true};
+	std::vector<std::size_t> open_scopes; // indices into the scopes of the current frame
+	std::int64_t clock_offset{0};         // GPU time minus CPU time, in nanoseconds
+	std::uint64_t skipped_frames_nb{0u};
+};
+
+std::atomic<bool> is_capturing{false};
+auto const epoch = std::chrono::steady_clock::now();
+GPUState gpu;
+
+thread_local ThreadBuffer* thread_buffer = nullptr;
+thread_local std::vector<OpenScope> open_scopes;
+
+std::mutex& getRegistryMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+// Buffers outlive their threads, so that their events can still be
+// written out; the first one holds the GPU scopes.
+std::vector<std::unique_ptr<ThreadBuffer>>& getRegistry()
+{
+	static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	if (buffers.empty()) {
+		buffers.push_back(std::make_unique<ThreadBuffer>());
+		buffers.back()->name = "GPU";
+	}
+	return buffers;
+}
+
+ThreadBuffer& registerBuffer()
+{
+	std::lock_guard<std::mutex> const lock(getRegistryMutex());
+	auto& buffers = getRegistry();
+	buffers.push_back(std::make_unique<ThreadBuffer>());
+	auto& buffer = *buffers.back();
+	buffer.id = static_cast<std::uint32_t>(buffers.size() - 1u);
+	buffer.name = "Thread " + std::to_string(buffer.id);
+	return buffer;
+}
+
+ThreadBuffer& getThreadBuffer()
+{
+	if (thread_buffer == nullptr)
+		thread_buffer = &registerBuffer();
+	return *thread_buffer;
+}
+
+ThreadBuffer& getGPUBuffer()
+{
+	std::lock_guard<std::mutex> const lock(getRegistryMutex());
+	return *getRegistry().front();
+}
+
+std::int64_t now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void copyName(char (&destination)[name_length], char const* name)
+{
+	std::strncpy(destination, name, name_length - 1u);
+	destination[name_length - 1u] = '\0';
+}
+
+void record(ThreadBuffer& buffer, Event const& event)
+{
+	if (buffer.events == nullptr)
+		buffer.events.reset(new Event[events_per_thread]);
+
+	auto const index = buffer.count.load(std::memory_order_relaxed);
+	buffer.events[index % events_per_thread] = event;
+	buffer.count.store(index + 1u, std::memory_order_release);
+}
+
+// Timestamps are assumed to become available in the order they were
+// issued, so only the last one gets checked.
+bool isAvailable(GPUFrame const& frame)
+{
+	if (frame.used_queries_nb == 0u)
+		return true;
+
+	GLuint is_available = GL_FALSE;
+	glGetQueryObjectuiv(frame.queries[frame.used_queries_nb - 1u], GL_QUERY_RESULT_AVAILABLE, &is_available);
+	return is_available != GL_FALSE;
+}
+
+void collect(GPUFrame& frame)
+{
+	auto& buffer = getGPUBuffer();
+	for (auto& scope : frame.scopes) {
+		if (!scope.is_ended)
+			continue;
+
+		GLuint64 begin = 0u, end = 0u;
+		glGetQueryObjectui64v(frame.queries[scope.query], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(frame.queries[scope.query + 1u], GL_QUERY_RESULT, &end);
+		scope.event.begin = static_cast<std::int64_t>(begin) - gpu.clock_offset;
+		scope.event.duration = end > begin ? static_cast<std::int64_t>(end - begin) : 0;
+		record(buffer, scope.event);
+	}
+	frame.scopes.clear();
+	frame.used_queries_nb = 0u;
+	frame.is_pending = false;
+}
+
+void writeEscaped(std::FILE* file, char const* text)
+{
+	for (; *text != '\0'; ++text) {
+		auto const c = static_cast<unsigned char>(*text);
+		if (c == '"' || c == '\\')
+			std::fprintf(file, "\\%c", c);
+		else if (c < 0x20u)
+			std::fprintf(file, "\\u%04x", c);
+		else
+			std::fputc(c, file);
+	}
+}
+
+} // anonymous namespace
+
+void StartCapture()
+{
+	is_capturing.store(false);
+
+	// Results of an earlier capture still in flight are dropped.
+	for (auto& frame : gpu.frames) {
+		frame.scopes.clear();
+		frame.used_queries_nb = 0u;
+		frame.is_pending = false;
+	}
+	for (auto& scope : gpu.open_scopes)
+		scope = not_timed;
+	gpu.is_frame_timed = true;
+	gpu.skipped_frames_nb = 0u;
+
+	GLint64 gpu_time = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpu_time);
+	gpu.clock_offset = static_cast<std::int64_t>(gpu_time) - now();
+
+	{
+		std::lock_guard<std::mutex> const lock(getRegistryMutex());
+		for (auto const& buffer : getRegistry())
+			buffer->capture_begin.store(buffer->count.load(std::memory_order_acquire));
+	}
+
+	is_capturing.store(true);
+}
+
+void StopCapture()
+{
+	is_capturing.store(false);
+}
+
+bool IsCapturing()
+{
+	return is_capturing.load(std::memory_order_relaxed);
+}
+
+void SetThreadName(std::string const& name)
+{
+	auto& buffer = getThreadBuffer();
+	std::lock_guard<std::mutex> const lock(getRegistryMutex());
+	buffer.name = name;
+}
+
+void BeginScope(char const* name)
+{
+	OpenScope scope;
+	scope.is_recorded = IsCapturing();
+	if (scope.is_recorded) {
+		copyName(scope.event.name, name);
+		scope.event.begin = now();
+	}
+	open_scopes.push_back(scope);
+}
+
+void EndScope()
+{
+	if (open_scopes.empty())
+		return;
+
+	auto scope = open_scopes.back();
+	open_scopes.pop_back();
+	if (!scope.is_recorded || !IsCapturing())
+		return;
+
+	scope.event.duration = now() - scope.event.begin;
+	record(getThreadBuffer(), scope.event);
+}
+
+void BeginGPUScope(std::string const& name)
+{
+	BeginScope(name.c_str());
+	if (!IsCapturing() || !gpu.is_frame_timed) {
+		gpu.open_scopes.push_back(not_timed);
+		return;
+	}
+
+	auto& frame = gpu.frames[gpu.current_frame];
+	if (frame.used_queries_nb + 2u > frame.queries.size()) {
+		auto const previous_size = frame.queries.size();
+		frame.queries.resize(previous_size + gpu_queries_increment);
+		glGenQueries(static_cast<GLsizei>(gpu_queries_increment), frame.queries.data() + previous_size);
+	}
+
+	GPUScope scope;
+	copyName(scope.event.name, name.c_str());
+	scope.query = frame.used_queries_nb;
+	scope.is_ended = false;
+	frame.used_queries_nb += 2u;
+	glQueryCounter(frame.queries[scope.query], GL_TIMESTAMP);
+
+	gpu.open_scopes.push_back(frame.scopes.size());
+	frame.scopes.push_back(scope);
+}
+
+void EndGPUScope()
+{
+	if (!gpu.open_scopes.empty()) {
+		auto const index = gpu.open_scopes.back();
+		gpu.open_scopes.pop_back();
+		if (index != not_timed) {
+			auto& frame = gpu.frames[gpu.current_frame];
+			auto& scope = frame.scopes[index];
+			glQueryCounter(frame.queries[scope.query + 1u], GL_TIMESTAMP);
+			scope.is_ended = true;
+			frame.is_pending = true;
+		}
+	}
+	EndScope();
+}
+
+void NewFrame()
+{
+	// Frames complete in order, so stop at the first one which is not.
+	for (std::size_t i = 1u; i <= gpu.frames.size(); ++i) {
+		auto& frame = gpu.frames[(gpu.current_frame + i) % gpu.frames.size()];
+		if (!frame.is_pending)
+			continue;
+		if (!isAvailable(frame))
+			break;
+		collect(frame);
+	}
+
+	// Scopes spanning frames are only timed on the CPU.
+	for (auto& scope : gpu.open_scopes)
+		scope = not_timed;
+
+	gpu.current_frame = (gpu.current_frame + 1u) % gpu.frames.size();
+	auto& frame = gpu.frames[gpu.current_frame];
+	gpu.is_frame_timed = !frame.is_pending;
+	if (!gpu.is_frame_timed) {
+		++gpu.skipped_frames_nb;
+		return;
+	}
+	frame.scopes.clear();
+	frame.used_queries_nb = 0u;
+}
+
+bool WriteChromeTrace(std::string const& filename)
+{
+	for (auto& frame : gpu.frames)
+		if (frame.is_pending)
+			collect(frame);
+
+	std::FILE* file = std::fopen(filename.c_str(), "w");
+	if (file == nullptr) {
+		LogError("Failed to open trace file %s", filename.c_str());
+		return false;
+	}
+
+	std::lock_guard<std::mutex> const lock(getRegistryMutex());
+	auto const& buffers = getRegistry();
+
+	std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool is_first = true;
+	std::size_t events_nb = 0u, dropped_events_nb = 0u;
+	for (auto const& buffer : buffers) {
+		std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", is_first ? "" : ",\n", buffer->id);
+		writeEscaped(file, buffer->name.c_str());
+		std::fprintf(file, "\"}},\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"sort_index\":%u}}", buffer->id, buffer->id);
+		is_first = false;
+
+		auto const end = buffer->count.load(std::memory_order_acquire);
+		auto const capture_begin = std::min(buffer->capture_begin.load(), end);
+		auto const begin = std::max(capture_begin, end > events_per_thread ? end - events_per_thread : std::size_t(0u));
+		dropped_events_nb += begin - capture_begin;
+		for (auto i = begin; i < end; ++i) {
+			auto const& event = buffer->events[i % events_per_thread];
+			std::fprintf(file, ",\n{\"name\":\"");
+			writeEscaped(file, event.name);
+			std::fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+			             buffer->id, static_cast<double>(event.begin) / 1000.0, static_cast<double>(event.duration) / 1000.0);
+		}
+		events_nb += end - begin;
+	}
+	std::fprintf(file, "\n]}\n");
+
+	bool const is_written = std::ferror(file) == 0;
+	std::fclose(file);
+	if (!is_written) {
+		LogError("Failed to write trace file %s", filename.c_str());
+		return false;
+	}
+
+	LogInfo("Wrote %zu profiling events to %s", events_nb, filename.c_str());
+	if (dropped_events_nb != 0u)
+		LogWarning("%zu profiling events were overwritten before being written; capture fewer frames to keep them all.", dropped_events_nb);
+	if (gpu.skipped_frames_nb != 0u)
+		LogWarning("%llu frames were not timed on the GPU, as it was too far behind.", static_cast<unsigned long long>(gpu.skipped_frames_nb));
+
+	return true;
+}
+
+};
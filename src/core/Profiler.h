@@ -0,0 +1,92 @@
+/*
+ * Hierarchical CPU and GPU profiling, exported as Chrome trace events
+ */
+
+#include "BuildSettings.h"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <string>
+
+#pragma once
+
+//! \brief Record nested scopes while a capture is running, and write
+//!        them out as a Chrome `trace_event` JSON file, which can be
+//!        opened in Perfetto or chrome://tracing.
+//!
+//! CPU scopes can be opened on any thread: each thread appends its
+//! events to its own buffer, without taking any lock, and the buffers
+//! are only gathered when writing the trace. Scopes opened on the
+//! thread owning the OpenGL context through `BeginGPUScope()` are also
+//! bracketed by two `GL_TIMESTAMP` queries; those are polled by
+//! `NewFrame()` and only read back once available, and their results
+//! end up on a separate "GPU" track. Every debug group, see
+//! `utils::opengl::debug::beginDebugGroup()`, is such a scope.
+//!
+//! Outside of captures, opening a scope costs an atomic load; with
+//! ENABLE_PROFILING set to 0, the `ProfileScope()` macro and debug groups
+//! do not record anything at all.
+namespace Profiler {
+
+//! \brief Start recording scopes, dropping those of any earlier capture.
+//!
+//! Must be called from the thread owning the OpenGL context.
+void StartCapture();
+
+//! \brief Stop recording scopes; those still open are not recorded.
+void StopCapture();
+
+bool IsCapturing();
+
+//! \brief Name the calling thread in the traces.
+void SetThreadName(std::string const& name);
+
+//! \brief Open a CPU scope on the calling thread.
+void BeginScope(char const* name);
+
+//! \brief Close the most recently opened scope of the calling thread.
+void EndScope();
+
+//! \brief Open a scope timed both on the CPU and on the GPU.
+//!
+//! Must be called from the thread owning the OpenGL context.
+void BeginGPUScope(std::string const& name);
+
+//! \brief Close the most recently opened GPU scope.
+void EndGPUScope();
+
+//! \brief Collect the GPU timestamps which are available; call once per
+//!        frame, from the thread owning the OpenGL context.
+void NewFrame();
+
+//! \brief Write all the scopes recorded by the last capture.
+//!
+//! Must be called from the thread owning the OpenGL context, as it
+//! waits for the GPU timestamps still in flight.
+//!
+//! @param [in] filename of the JSON file to write
+//! @return false if the file could not be written
+bool WriteChromeTrace(std::string const& filename);
+
+//! \brief Open a CPU scope for the lifetime of the object.
+class Scope
+{
+public:
+	explicit Scope(char const* name) { BeginScope(name); }
+	~Scope() { EndScope(); }
+
+	Scope(Scope const&) = delete;
+	Scope& operator=(Scope const&) = delete;
+};
+
+};
+
+#define PROFILER_CONCATENATE_(a, b)	a##b
+#define PROFILER_CONCATENATE(a, b)	PROFILER_CONCATENATE_(a, b)
+
+#if defined ENABLE_PROFILING && ENABLE_PROFILING != 0
+#	define ProfileScope(name)		Profiler::Scope const PROFILER_CONCATENATE(profiler_scope_, __LINE__)(name)
+#else
+#	define ProfileScope(name)
+#endif
@@ -0,0 +1,456 @@
+#include "RenderGraph.hpp"
+
+#include "GPUTimers.hpp"
+#include "Log.h"
+#include "opengl.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <limits>
+
+namespace
+{
+	bool isAttachment(RenderGraph::Access const access)
+	{
+		return access == RenderGraph::Access::color_attachment || access == RenderGraph::Access::depth_attachment;
+	}
+
+	// Writes which later accesses only see after a glMemoryBarrier().
+	bool isIncoherentWrite(RenderGraph::Access const access)
+	{
+		return access == RenderGraph::Access::image_store || access == RenderGraph::Access::storage_store;
+	}
+
+	GLbitfield getBarrierBit(RenderGraph::Access const access)
+	{
+		switch (access) {
+		case RenderGraph::Access::sampled:
+			return GL_TEXTURE_FETCH_BARRIER_BIT;
+		case RenderGraph::Access::image_load:
+		case RenderGraph::Access::image_store:
+			return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+		case RenderGraph::Access::storage_load:
+		case RenderGraph::Access::storage_store:
+			return GL_SHADER_STORAGE_BARRIER_BIT;
+		case RenderGraph::Access::indirect:
+			return GL_COMMAND_BARRIER_BIT;
+		case RenderGraph::Access::color_attachment:
+		case RenderGraph::Access::depth_attachment:
+		case RenderGraph::Access::transfer:
+			return GL_FRAMEBUFFER_BARRIER_BIT;
+		}
+		return GL_ALL_BARRIER_BITS;
+	}
+
+	GLenum getDepthAttachmentPoint(GLenum const internal_format)
+	{
+		return internal_format == GL_DEPTH24_STENCIL8 || internal_format == GL_DEPTH32F_STENCIL8
+		     ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+	}
+
+	std::size_t getBytesPerTexel(GLenum const internal_format)
+	{
+		switch (internal_format) {
+		case GL_R8:
+			return 1u;
+		case GL_RG8:
+		case GL_R16F:
+			return 2u;
+		case GL_RGBA16F:
+		case GL_RG32F:
+		case GL_DEPTH32F_STENCIL8:
+			return 8u;
+		case GL_RGBA32F:
+			return 16u;
+		default:
+			return 4u;
+		}
+	}
+
+	std::size_t getMemoryUsage(RenderGraph::TextureDescription const& description)
+	{
+		return static_cast<std::size_t>(description.width) * static_cast<std::size_t>(description.height)
+		     * getBytesPerTexel(description.internal_format);
+	}
+
+	GLsizei roundUp(GLsizei const size, GLsizei const granularity)
+	{
+		return std::max((size + granularity - 1) / granularity, 1) * granularity;
+	}
+
+	bool operator==(RenderGraph::TextureDescription const& lhs, RenderGraph::TextureDescription const& rhs)
+	{
+		return lhs.internal_format == rhs.internal_format && lhs.width == rhs.width && lhs.height == rhs.height;
+	}
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::Read(Resource const resource, Access const access)
+{
+	assert(resource < graph.resources.size());
+	assert(!isIncoherentWrite(access));
+	graph.passes[pass].uses.push_back({resource, access, 0u, false});
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::Write(Resource const resource, Access const access, GLuint const color_attachment)
+{
+	assert(resource < graph.resources.size());
+	assert(isIncoherentWrite(access) || isAttachment(access));
+	graph.passes[pass].uses.push_back({resource, access, color_attachment, true});
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::HasSideEffects()
+{
+	graph.passes[pass].has_side_effects = true;
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::SetViewport(GLsizei const width, GLsizei const height)
+{
+	assert(width > 0 && height > 0);
+	graph.passes[pass].viewport_width = width;
+	graph.passes[pass].viewport_height = height;
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::Execute(std::function<void()> callback)
+{
+	graph.passes[pass].callback = std::move(callback);
+	return *this;
+}
+
+RenderGraph::RenderGraph(GPUTimers& timers, std::uint32_t const release_delay, GLsizei const size_granularity)
+	: timers(timers), release_delay(release_delay), size_granularity(std::max(size_granularity, 1))
+{
+}
+
+RenderGraph::~RenderGraph() = default;
+
+void RenderGraph::BeginFrame()
+{
+	++frame;
+	resources.clear();
+	passes.clear();
+}
+
+RenderGraph::Resource RenderGraph::CreateTexture(std::string name, TextureDescription const& description)
+{
+	assert(description.width > 0 && description.height > 0);
+
+	ResourceNode resource;
+	resource.name = std::move(name);
+	resource.kind = ResourceKind::transient_texture;
+	resource.description = description;
+	resources.push_back(std::move(resource));
+	return static_cast<Resource>(resources.size() - 1u);
+}
+
+RenderGraph::Resource RenderGraph::ImportTexture(std::string name, GLuint const texture, TextureDescription const& description)
+{
+	ResourceNode resource;
+	resource.name = std::move(name);
+	resource.kind = ResourceKind::imported_texture;
+	resource.description = description;
+	resource.texture = texture;
+	auto const pending_barriers = imported_pending_barriers.find(texture);
+	if (pending_barriers != imported_pending_barriers.end())
+		resource.pending_barriers = pending_barriers->second;
+	resources.push_back(std::move(resource));
+	return static_cast<Resource>(resources.size() - 1u);
+}
+
+void RenderGraph::ForgetImportedTexture(GLuint const texture)
+{
+	imported_pending_barriers.erase(texture);
+	for (auto framebuffer = framebuffers.begin(); framebuffer != framebuffers.end();) {
+		bool const uses_texture = std::any_of(framebuffer->first.begin(), framebuffer->first.end(), [texture](std::pair<GLenum, GLuint> const& attachment) {
+			return attachment.second == texture;
+		});
+		if (!uses_texture) {
+			++framebuffer;
+			continue;
+		}
+		framebuffer = framebuffers.erase(framebuffer);
+	}
+}
+
+RenderGraph::Resource RenderGraph::CreateBuffer(std::string name)
+{
+	ResourceNode resource;
+	resource.name = std::move(name);
+	resource.kind = ResourceKind::buffer;
+	resources.push_back(std::move(resource));
+	return static_cast<Resource>(resources.size() - 1u);
+}
+
+void RenderGraph::MarkOutput(Resource const resource)
+{
+	assert(resource < resources.size());
+	resources[resource].is_output = true;
+}
+
+RenderGraph::PassBuilder RenderGraph::AddPass(std::string name)
+{
+	Pass pass;
+	pass.timer = timers.RegisterPass(name);
+	pass.name = std::move(name);
+	passes.push_back(std::move(pass));
+	return PassBuilder(*this, passes.size() - 1u);
+}
+
+void RenderGraph::Execute()
+{
+	statistics = Statistics{};
+	statistics.passes_nb = passes.size();
+
+	// Walk the passes backwards, keeping the ones which write a resource
+	// read by a pass kept after them; what a kept pass overwrites without
+	// reading it is no longer needed from the passes before, while what it
+	// reads is. Whatever is in imported textures at the end outlives the
+	// frame.
+	std::vector<bool> is_needed(resources.size(), false);
+	for (std::size_t i = 0u; i < resources.size(); ++i)
+		is_needed[i] = resources[i].is_output || resources[i].kind == ResourceKind::imported_texture;
+	std::vector<bool> is_kept(passes.size(), false);
+	for (auto i = passes.size(); i-- > 0u;) {
+		auto const& pass = passes[i];
+		is_kept[i] = pass.has_side_effects
+		          || std::any_of(pass.uses.begin(), pass.uses.end(), [&is_needed](Use const& use) {
+		                 return use.is_write && is_needed[use.resource];
+		             });
+		if (!is_kept[i])
+			continue;
+		for (auto const& use : pass.uses)
+			if (use.is_write)
+				is_needed[use.resource] = false;
+		for (auto const& use : pass.uses)
+			if (!use.is_write)
+				is_needed[use.resource] = true;
+	}
+
+	std::vector<std::size_t> executed_passes;
+	for (std::size_t i = 0u; i < passes.size(); ++i)
+		if (is_kept[i])
+			executed_passes.push_back(i);
+	statistics.culled_passes_nb = passes.size() - executed_passes.size();
+
+	AssignTextures(executed_passes);
+	ReleaseUnusedTextures();
+
+	for (auto const i : executed_passes) {
+		auto const& pass = passes[i];
+
+		utils::opengl::debug::beginDebugGroup(pass.name);
+		timers.BeginPass(pass.timer);
+
+		InsertBarriers(pass);
+		BindAttachments(pass);
+		if (pass.callback)
+			pass.callback();
+		for (auto const& use : pass.uses)
+			if (isIncoherentWrite(use.access))
+				resources[use.resource].pending_barriers = GL_ALL_BARRIER_BITS;
+
+		timers.EndPass(pass.timer);
+		utils::opengl::debug::endDebugGroup();
+	}
+
+	for (auto const& resource : resources) {
+		if (resource.kind != ResourceKind::imported_texture)
+			continue;
+		if (resource.pending_barriers != 0u)
+			imported_pending_barriers[resource.texture] = resource.pending_barriers;
+		else
+			imported_pending_barriers.erase(resource.texture);
+	}
+
+	statistics.pooled_textures_nb = pool.size();
+	for (auto const& pooled : pool)
+		statistics.pooled_memory += getMemoryUsage(pooled.description);
+	statistics.framebuffers_nb = framebuffers.size();
+}
+
+GLuint RenderGraph::GetTexture(Resource const resource) const
+{
+	assert(resource < resources.size());
+	return resources[resource].texture;
+}
+
+RenderGraph::TextureDescription const& RenderGraph::GetDescription(Resource const resource) const
+{
+	assert(resource < resources.size());
+	return resources[resource].description;
+}
+
+void RenderGraph::AssignTextures(std::vector<std::size_t> const& executed_passes)
+{
+	// Lifetimes, as indices into |executed_passes|; outputs live until
+	// the end of the frame.
+	auto constexpr unused = std::numeric_limits<std::size_t>::max();
+	std::vector<std::size_t> first_use(resources.size(), unused);
+	std::vector<std::size_t> last_use(resources.size(), 0u);
+	for (std::size_t order = 0u; order < executed_passes.size(); ++order)
+		for (auto const& use : passes[executed_passes[order]].uses) {
+			first_use[use.resource] = std::min(first_use[use.resource], order);
+			last_use[use.resource] = order;
+		}
+	for (std::size_t i = 0u; i < resources.size(); ++i)
+		if (resources[i].is_output && first_use[i] != unused)
+			last_use[i] = executed_passes.size();
+
+	for (auto& pooled : pool)
+		pooled.busy_until = 0u;
+
+	// Going through the passes in order, hand each transient texture the
+	// first pooled one with the same description which no earlier texture
+	// still uses; the assignments stay the same from one frame to the next
+	// as long as the passes do, which keeps framebuffers cached.
+	for (std::size_t order = 0u; order < executed_passes.size(); ++order) {
+		for (auto const& use : passes[executed_passes[order]].uses) {
+			auto& resource = resources[use.resource];
+			if (resource.kind != ResourceKind::transient_texture || first_use[use.resource] != order || resource.texture != 0u)
+				continue;
+
+			auto allocated = resource.description;
+			allocated.width = roundUp(allocated.width, size_granularity);
+			allocated.height = roundUp(allocated.height, size_granularity);
+			auto pooled = std::find_if(pool.begin(), pool.end(), [&allocated, order](PooledTexture const& candidate) {
+				return candidate.busy_until <= order && candidate.description == allocated;
+			});
+			if (pooled == pool.end()) {
+				PooledTexture texture;
+				texture.description = allocated;
+				texture.texture = bonobo::gl::texture::create_2d(allocated.internal_format, allocated.width, allocated.height, 1, resource.name);
+				pool.push_back(std::move(texture));
+				pooled = std::prev(pool.end());
+			}
+			if (pooled->last_used_frame != frame) {
+				++statistics.allocated_textures_nb;
+				statistics.allocated_memory += getMemoryUsage(pooled->description);
+			}
+			pooled->busy_until = last_use[use.resource] + 1u;
+			pooled->last_used_frame = frame;
+			resource.texture = pooled->texture.get();
+
+			++statistics.transient_textures_nb;
+			statistics.transient_memory += getMemoryUsage(resource.description);
+		}
+	}
+}
+
+void RenderGraph::ReleaseUnusedTextures()
+{
+	auto const is_stale = [this](std::uint64_t last_used_frame) {
+		return frame - last_used_frame > release_delay;
+	};
+
+	for (auto framebuffer = framebuffers.begin(); framebuffer != framebuffers.end();) {
+		bool const uses_stale_texture = std::any_of(framebuffer->first.begin(), framebuffer->first.end(), [this, &is_stale](std::pair<GLenum, GLuint> const& attachment) {
+			auto const pooled = std::find_if(pool.begin(), pool.end(), [&attachment](PooledTexture const& candidate) {
+				return candidate.texture.get() == attachment.second;
+			});
+			return pooled != pool.end() && is_stale(pooled->last_used_frame);
+		});
+		if (!uses_stale_texture && !is_stale(framebuffer->second.last_used_frame)) {
+			++framebuffer;
+			continue;
+		}
+		framebuffer = framebuffers.erase(framebuffer);
+	}
+
+	auto const first_stale = std::stable_partition(pool.begin(), pool.end(), [&is_stale](PooledTexture const& pooled) {
+		return !is_stale(pooled.last_used_frame);
+	});
+	pool.erase(first_stale, pool.end());
+}
+
+GLuint RenderGraph::GetFramebuffer(FramebufferKey const& key, std::string const& name)
+{
+	auto framebuffer = framebuffers.find(key);
+	if (framebuffer == framebuffers.end()) {
+		Framebuffer created;
+		created.fbo = bonobo::gl::framebuffer::create(name);
+
+		std::vector<GLenum> draw_buffers;
+		for (auto const& attachment : key) {
+			created.fbo.attach(attachment.first, attachment.second);
+			if (attachment.first < GL_COLOR_ATTACHMENT0 || attachment.first > GL_COLOR_ATTACHMENT15)
+				continue;
+			auto const index = static_cast<std::size_t>(attachment.first - GL_COLOR_ATTACHMENT0);
+			draw_buffers.resize(std::max(draw_buffers.size(), index + 1u), GL_NONE);
+			draw_buffers[index] = attachment.first;
+		}
+		// Colour attachment 0 is the one blitted or read back from.
+		created.fbo.set_read_buffer(!draw_buffers.empty() && draw_buffers[0] != GL_NONE ? GL_COLOR_ATTACHMENT0 : GL_NONE);
+		if (draw_buffers.empty())
+			draw_buffers.push_back(GL_NONE);
+		created.fbo.set_draw_buffers(draw_buffers);
+		created.fbo.is_complete(name);
+
+		framebuffer = framebuffers.emplace(key, std::move(created)).first;
+	}
+	framebuffer->second.last_used_frame = frame;
+	return framebuffer->second.fbo.get();
+}
+
+void RenderGraph::InsertBarriers(Pass const& pass)
+{
+	GLbitfield barriers = 0u;
+	for (auto const& use : pass.uses)
+		barriers |= resources[use.resource].pending_barriers & getBarrierBit(use.access);
+	if (barriers == 0u)
+		return;
+
+	glMemoryBarrier(barriers);
+	++statistics.barriers_nb;
+
+	// Barriers apply to all earlier writes, whichever resources they went
+	// to.
+	for (auto& resource : resources)
+		resource.pending_barriers &= ~barriers;
+	for (auto& pending_barriers : imported_pending_barriers)
+		pending_barriers.second &= ~barriers;
+}
+
+void RenderGraph::BindAttachments(Pass const& pass)
+{
+	FramebufferKey attachments;
+	GLsizei width = 0, height = 0;
+	for (auto const& use : pass.uses) {
+		if (!isAttachment(use.access))
+			continue;
+		auto const& resource = resources[use.resource];
+		auto const point = use.access == Access::color_attachment
+		                 ? GL_COLOR_ATTACHMENT0 + use.color_attachment
+		                 : getDepthAttachmentPoint(resource.description.internal_format);
+		if (std::find(attachments.begin(), attachments.end(), std::make_pair(point, resource.texture)) != attachments.end())
+			continue;
+		attachments.emplace_back(point, resource.texture);
+		width = resource.description.width;
+		height = resource.description.height;
+	}
+	// Creating a framebuffer changes the bindings, so get all of them first.
+	GLuint draw_framebuffer = 0u, read_framebuffer = 0u;
+	if (!attachments.empty()) {
+		std::sort(attachments.begin(), attachments.end());
+		draw_framebuffer = GetFramebuffer(attachments, pass.name);
+	}
+	for (auto const& use : pass.uses) {
+		if (use.access != Access::transfer)
+			continue;
+		auto const& resource = resources[use.resource];
+		read_framebuffer = GetFramebuffer({{GL_COLOR_ATTACHMENT0, resource.texture}}, resource.name);
+	}
+
+	if (draw_framebuffer != 0u) {
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw_framebuffer);
+		if (pass.viewport_width != 0)
+			glViewport(0, 0, std::min(pass.viewport_width, width), std::min(pass.viewport_height, height));
+		else
+			glViewport(0, 0, width, height);
+	}
+	if (read_framebuffer != 0u)
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, read_framebuffer);
+}
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "gl_resources.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class GPUTimers;
+
+//! \brief Rendering passes declared along with the resources they read
+//!        and write, which the graph then schedules, wires up and times.
+//!
+//! Passes and resources get declared anew every frame, between
+//! `BeginFrame()` and `Execute()`, so that options can change which
+//! passes exist and what they access; passes run in the order they were
+//! added. `Execute()` then:
+//! * skips the passes none of whose writes end up being read by a later
+//!   pass, written to an imported resource, or marked as an output, unless
+//!   they have side effects;
+//! * assigns a texture to each transient texture of the remaining passes,
+//!   from a pool kept across frames; transient textures with the same
+//!   description whose lifetimes do not overlap share the same texture,
+//!   OpenGL offering no way to alias the memory of different textures;
+//! * rounds the size of the textures it allocates up to a multiple of a
+//!   given granularity, so that the same textures keep being used as long
+//!   as the size of the targets stays in the same bucket, for example
+//!   while a window gets resized;
+//! * binds, before each pass, a framebuffer made of the attachments it
+//!   declared, created on first use and cached, along with a viewport
+//!   covering them, or the part of them the pass asked for;
+//! * issues the `glMemoryBarrier()` needed by each access to a resource
+//!   last written through image stores or shader storage writes;
+//! * brackets each pass with a debug group and GPU timestamps, under the
+//!   name of the pass.
+//!
+//! Buffers are only tracked for ordering and barriers: passes bind the
+//! buffers they use themselves.
+//!
+//! All methods must be called from the thread owning the OpenGL context.
+class RenderGraph
+{
+public:
+	using Resource = std::uint32_t;
+	static constexpr Resource invalid_resource = ~Resource(0u);
+
+	enum class Access : std::uint8_t {
+		sampled = 0u,     //!< read through a sampler
+		image_load,       //!< read through imageLoad()
+		image_store,      //!< written through imageStore()
+		storage_load,     //!< buffer read from a shader
+		storage_store,    //!< buffer written from a shader
+		indirect,         //!< buffer holding draw or dispatch commands, or their count
+		color_attachment, //!< drawn to; only needs reading if blending or not clearing it
+		depth_attachment, //!< depth tested against; only needs reading if not clearing it
+		transfer          //!< read through glBlitFramebuffer() or glReadPixels()
+	};
+
+	struct TextureDescription
+	{
+		GLenum internal_format{GL_RGBA8};
+		GLsizei width{0};
+		GLsizei height{0};
+	};
+
+	//! \brief Resource and pass counts of the frame last executed.
+	struct Statistics
+	{
+		std::size_t passes_nb{0u};
+		std::size_t culled_passes_nb{0u};
+		std::size_t transient_textures_nb{0u};  //!< used by the passes which were kept
+		std::size_t transient_memory{0u};       //!< in bytes, if none of them were aliased
+		std::size_t allocated_textures_nb{0u};  //!< actually assigned to the former
+		std::size_t allocated_memory{0u};       //!< in bytes
+		std::size_t pooled_textures_nb{0u};     //!< including the ones left unused this frame
+		std::size_t pooled_memory{0u};          //!< in bytes
+		std::size_t framebuffers_nb{0u};
+		std::size_t barriers_nb{0u};
+	};
+
+	//! \brief Declaration of the accesses of a pass, returned by
+	//!        `AddPass()`.
+	class PassBuilder
+	{
+	public:
+		//! @param [in] access anything but |image_store| and
+		//!             |storage_store|; reading an attachment also
+		//!             attaches it
+		PassBuilder& Read(Resource resource, Access access);
+
+		//! @param [in] access |image_store|, |storage_store| or one of
+		//!             the attachments
+		//! @param [in] color_attachment index of the colour attachment
+		//!             the resource gets attached to, when |access| is
+		//!             |color_attachment|
+		PassBuilder& Write(Resource resource, Access access, GLuint color_attachment = 0u);
+
+		//! \brief Keep the pass even if nothing reads what it writes, for
+		//!        example when it draws to the default framebuffer.
+		PassBuilder& HasSideEffects();
+
+		//! \brief Only draw to the lower-left |width| by |height| corner of
+		//!        the attachments, rather than to all of them.
+		//!
+		//! This lets passes render at a lower resolution into targets of
+		//! the full size, which do not have to be reallocated whenever the
+		//! resolution changes; whatever lies outside of that corner is
+		//! left as is.
+		PassBuilder& SetViewport(GLsizei width, GLsizei height);
+
+		//! \brief Set the function recording the commands of the pass,
+		//!        called from `Execute()` with its framebuffer bound.
+		PassBuilder& Execute(std::function<void()> callback);
+
+	private:
+		friend class RenderGraph;
+		PassBuilder(RenderGraph& graph, std::size_t pass) : graph(graph), pass(pass) {}
+
+		RenderGraph& graph;
+		std::size_t pass;
+	};
+
+	//! @param [in] timers where each pass gets timed, as the pass of the
+	//!             same name, which is registered if needed
+	//! @param [in] release_delay number of frames a pooled texture stays
+	//!             unused before getting deleted
+	//! @param [in] size_granularity what the width and height of pooled
+	//!             textures are multiples of
+	explicit RenderGraph(GPUTimers& timers, std::uint32_t release_delay = 60u, GLsizei size_granularity = 1);
+	~RenderGraph();
+
+	RenderGraph(RenderGraph const&) = delete;
+	RenderGraph& operator=(RenderGraph const&) = delete;
+
+	//! \brief Forget the passes and resources declared for the previous
+	//!        frame; pooled textures and framebuffers are kept.
+	void BeginFrame();
+
+	//! \brief Declare a texture only living during this frame, whose
+	//!        content is undefined until a pass writes it.
+	//!
+	//! The texture it gets assigned can be larger than described, as its
+	//! size is rounded up to the granularity: passes only get to draw to
+	//! its lower-left corner, and should only read from there.
+	Resource CreateTexture(std::string name, TextureDescription const& description);
+
+	//! \brief Declare a texture managed outside of the graph, whose
+	//!        content is kept across frames; writing it is a side effect.
+	//!
+	//! Framebuffers it gets attached to are cached, so it has to outlive
+	//! the graph in that case, unless `ForgetImportedTexture()` is called
+	//! before deleting it.
+	Resource ImportTexture(std::string name, GLuint texture, TextureDescription const& description);
+
+	//! \brief Drop everything kept about |texture| from previous frames,
+	//!        such as the framebuffers it is attached to, before it gets
+	//!        deleted; to be called outside of `BeginFrame()` and
+	//!        `Execute()`.
+	void ForgetImportedTexture(GLuint texture);
+
+	//! \brief Declare a buffer the passes bind themselves, which is only
+	//!        tracked to order them and to issue barriers.
+	Resource CreateBuffer(std::string name);
+
+	//! \brief Keep the passes writing |resource| as well as the ones they
+	//!        depend on, and keep its texture valid after `Execute()`.
+	void MarkOutput(Resource resource);
+
+	//! \brief Add a pass, running after all the ones added before.
+	PassBuilder AddPass(std::string name);
+
+	//! \brief Cull the passes whose results are not needed, assign
+	//!        textures to the transient ones, and run the others.
+	void Execute();
+
+	//! \brief Get the texture assigned to |resource|, from within a pass
+	//!        using it or after `Execute()` for the outputs.
+	//!
+	//! @return the texture, or 0 if none of the passes kept uses it
+	GLuint GetTexture(Resource resource) const;
+
+	TextureDescription const& GetDescription(Resource resource) const;
+
+	Statistics const& GetStatistics() const { return statistics; }
+
+private:
+	enum class ResourceKind : std::uint8_t {
+		transient_texture = 0u,
+		imported_texture,
+		buffer
+	};
+
+	struct ResourceNode
+	{
+		std::string name;
+		ResourceKind kind{ResourceKind::buffer};
+		TextureDescription description;
+		GLuint texture{0u};
+		bool is_output{false};
+		GLbitfield pending_barriers{0u}; // still needed since the last incoherent write
+	};
+
+	struct Use
+	{
+		Resource resource{invalid_resource};
+		Access access{Access::sampled};
+		GLuint color_attachment{0u};
+		bool is_write{false};
+	};
+
+	struct Pass
+	{
+		std::string name;
+		std::vector<Use> uses;
+		std::function<void()> callback;
+		std::size_t timer{0u};
+		GLsizei viewport_width{0};   // all of the attachments if 0
+		GLsizei viewport_height{0};
+		bool has_side_effects{false};
+	};
+
+	struct PooledTexture
+	{
+		TextureDescription description; // as allocated, with its size rounded up
+		bonobo::gl::texture texture;
+		std::uint64_t last_used_frame{0u};
+		std::size_t busy_until{0u}; // last pass using it, plus one, during the current frame
+	};
+
+	// Attachment points and textures, sorted.
+	using FramebufferKey = std::vector<std::pair<GLenum, GLuint>>;
+
+	struct Framebuffer
+	{
+		bonobo::gl::framebuffer fbo;
+		std::uint64_t last_used_frame{0u};
+	};
+
+	void AssignTextures(std::vector<std::size_t> const& executed_passes);
+	void ReleaseUnusedTextures();
+	GLuint GetFramebuffer(FramebufferKey const& key, std::string const& name);
+	void InsertBarriers(Pass const& pass);
+	void BindAttachments(Pass const& pass);
+
+	GPUTimers& timers;
+	std::uint32_t release_delay;
+	GLsizei size_granularity;
+	std::uint64_t frame{0u};
+
+	std::vector<ResourceNode> resources;
+	std::vector<Pass> passes;
+
+	std::vector<PooledTexture> pool;
+	std::map<FramebufferKey, Framebuffer> framebuffers;
+	std::unordered_map<GLuint, GLbitfield> imported_pending_barriers; // carried over to the next frames
+
+	Statistics statistics;
+};
@@ -0,0 +1,275 @@
+#include "SceneRegistry.hpp"
+
+#include "gl_resources.hpp"
+#include "Log.h"
+#include "Profiler.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <unordered_set>
+
+namespace
+{
+	//! \brief Estimate how much GPU memory the buffers and textures of
+	//!        |meshes| use.
+	//!
+	//! Uncompressed textures are assumed to use four bytes per texel,
+	//! plus a third for their mipmaps, while block-compressed ones report
+	//! the exact size of each of their levels. Buffers shared by the
+	//! meshes of a batch are only counted once.
+	std::size_t estimateGPUMemoryUsage(std::vector<bonobo::mesh_data> const& meshes,
+	                                   std::vector<bonobo::mesh_batch> const& batches)
+	{
+		std::size_t usage = 0u;
+		std::unordered_set<GLuint> buffers, textures;
+		for (auto const& mesh : meshes) {
+			buffers.insert({mesh.bo, mesh.ibo, mesh.edges_bo});
+			for (auto const& binding : mesh.bindings)
+				if (binding.second != bonobo::getDebugTextureID())
+					textures.insert(binding.second);
+		}
+		for (auto const& batch : batches)
+			buffers.insert({batch.draw_commands_bo, batch.draws_bo, batch.culled_draw_commands_bo, batch.visible_draws_nb_bo,
+			                batch.meshlets_bo, batch.meshlet_draw_commands_bo, batch.visible_meshlets_nb_bo});
+		buffers.erase(0u);
+
+		for (auto const buffer : buffers) {
+			GLint64 buffer_size = 0;
+			glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+			glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &buffer_size);
+			usage += static_cast<std::size_t>(buffer_size);
+		}
+		glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+
+		for (auto const texture : textures) {
+			// Only borrowed: the meshes keep owning their textures.
+			bonobo::gl::texture borrowed(texture, GL_TEXTURE_2D);
+			if (borrowed.get_level_parameter(0, GL_TEXTURE_COMPRESSED) == GL_TRUE) {
+				auto const max_level = borrowed.get_parameter(GL_TEXTURE_MAX_LEVEL);
+				for (GLint level = 0; level <= max_level; ++level)
+					usage += static_cast<std::size_t>(borrowed.get_level_parameter(level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE));
+			} else {
+				auto const width = borrowed.get_level_parameter(0, GL_TEXTURE_WIDTH);
+				auto const height = borrowed.get_level_parameter(0, GL_TEXTURE_HEIGHT);
+				usage += static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4u * 4u / 3u;
+			}
+			borrowed.release();
+		}
+
+		return usage;
+	}
+}
+
+SceneRegistry::SceneRegistry(std::size_t const gpu_memory_budget) : gpu_memory_budget(gpu_memory_budget)
+{
+}
+
+SceneRegistry::~SceneRegistry()
+{
+	for (auto& entry : scene_entries) {
+		// Loading can not be interrupted, so wait for it to finish
+		// before tearing everything down.
+		if (entry.load_result.valid())
+			entry.load_result.wait();
+		bonobo::releaseObjects(entry.meshes, &texture_streamer);
+		bonobo::releaseBatches(entry.batches);
+	}
+}
+
+std::size_t SceneRegistry::RegisterScene(char const* const scene_name, std::string const& filename, bonobo::welding::config const& weld_config, bool const with_edges, bonobo::vertex_layout::config const& layout_config, bonobo::vertex_cache::config const& cache_config)
+{
+	scene_entries.emplace_back();
+	scene_entries.back().filename = filename;
+	scene_entries.back().weld_config = weld_config;
+	scene_entries.back().with_edges = with_edges;
+	scene_entries.back().layout_config = layout_config;
+	scene_entries.back().cache_config = cache_config;
+	scene_names.emplace_back(scene_name);
+
+	return scene_entries.size() - 1u;
+}
+
+std::vector<bonobo::mesh_data> const* SceneRegistry::AcquireScene(std::size_t const scene_index)
+{
+	if (scene_index >= scene_entries.size()) {
+		LogError("Invalid scene index '%zu': only %zu scenes are registered.", scene_index, scene_entries.size());
+		return nullptr;
+	}
+
+	auto& entry = scene_entries[scene_index];
+	entry.last_acquired_frame = frame_index;
+
+	switch (entry.state) {
+	case State::loaded:
+		return &entry.meshes;
+	case State::unloaded:
+	{
+		auto pending_load = std::make_shared<PendingLoad>();
+		entry.pending_load = pending_load;
+		entry.load_start_time = std::chrono::high_resolution_clock::now();
+		entry.load_result = std::async(std::launch::async, [pending_load, filename = entry.filename, weld_config = entry.weld_config, with_edges = entry.with_edges, layout_config = entry.layout_config, cache_config = entry.cache_config]() {
+			Profiler::SetThreadName("Scene loader");
+			ProfileScope("Load scene");
+			return bonobo::loadSceneData(filename, pending_load->scene, weld_config, with_edges, layout_config, cache_config,
+			                             [&pending_load](float progress) {
+			                                 pending_load->progress.store(progress, std::memory_order_relaxed);
+			                             });
+		});
+		entry.state = State::loading;
+		return nullptr;
+	}
+	default:
+		return nullptr;
+	}
+}
+
+void SceneRegistry::Update()
+{
+	ProfileScope("Update scenes");
+	texture_streamer.Update();
+
+	for (auto& entry : scene_entries) {
+		if (entry.state == State::loaded && entry.has_pending_textures
+		    && bonobo::resolvePendingTextures(entry.meshes, texture_streamer)) {
+			entry.has_pending_textures = false;
+			entry.gpu_memory_usage = estimateGPUMemoryUsage(entry.meshes, entry.batches);
+			LogInfo("All textures of scene \"%s\" are resident after %.3f s, using about %.1f MiB of GPU memory.",
+			        entry.filename.c_str(),
+			        std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - entry.load_start_time).count(),
+			        static_cast<float>(entry.gpu_memory_usage) / (1024.0f * 1024.0f));
+		}
+
+		if (entry.state != State::loading
+		    || entry.load_result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			continue;
+
+		if (entry.load_result.get()) {
+			ProfileScope("Upload scene");
+			entry.meshes = bonobo::uploadSceneData(entry.pending_load->scene, &texture_streamer, &entry.batches);
+			entry.has_pending_textures = !bonobo::resolvePendingTextures(entry.meshes, texture_streamer);
+			entry.gpu_memory_usage = estimateGPUMemoryUsage(entry.meshes, entry.batches);
+			entry.state = State::loaded;
+			LogInfo("Scene \"%s\" ready after %.3f s, using about %.1f MiB of GPU memory.",
+			        entry.filename.c_str(),
+			        std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - entry.load_start_time).count(),
+			        static_cast<float>(entry.gpu_memory_usage) / (1024.0f * 1024.0f));
+		} else {
+			LogError("Failed to load scene \"%s\".", entry.filename.c_str());
+			entry.state = State::failed;
+		}
+
+		// Release the CPU copy of the scene, or its mapped cache.
+		entry.pending_load.reset();
+	}
+
+	EvictScenes();
+	++frame_index;
+}
+
+void SceneRegistry::EvictScenes()
+{
+	auto usage = GetGPUMemoryUsage();
+	while (usage > gpu_memory_budget) {
+		SceneEntry* oldest_entry = nullptr;
+		for (auto& entry : scene_entries) {
+			if (entry.state != State::loaded || entry.last_acquired_frame >= frame_index)
+				continue;
+			if (oldest_entry == nullptr || entry.last_acquired_frame < oldest_entry->last_acquired_frame)
+				oldest_entry = &entry;
+		}
+		if (oldest_entry == nullptr)
+			return;
+
+		LogInfo("Unloading scene \"%s\" to stay within the GPU memory budget (%.1f/%.1f MiB used).",
+		        oldest_entry->filename.c_str(),
+		        static_cast<float>(usage) / (1024.0f * 1024.0f),
+		        static_cast<float>(gpu_memory_budget) / (1024.0f * 1024.0f));
+		bonobo::releaseObjects(oldest_entry->meshes, &texture_streamer);
+		bonobo::releaseBatches(oldest_entry->batches);
+		oldest_entry->has_pending_textures = false;
+		usage -= oldest_entry->gpu_memory_usage;
+		oldest_entry->gpu_memory_usage = 0u;
+		oldest_entry->state = State::unloaded;
+	}
+}
+
+SceneRegistry::State SceneRegistry::GetState(std::size_t const scene_index) const
+{
+	return scene_index < scene_entries.size() ? scene_entries[scene_index].state : State::failed;
+}
+
+std::vector<bonobo::mesh_batch> const* SceneRegistry::GetSceneBatches(std::size_t const scene_index) const
+{
+	if (scene_index >= scene_entries.size() || scene_entries[scene_index].state != State::loaded)
+		return nullptr;
+
+	return &scene_entries[scene_index].batches;
+}
+
+bool SceneRegistry::HasPendingTextures(std::size_t const scene_index) const
+{
+	return scene_index < scene_entries.size() && scene_entries[scene_index].has_pending_textures;
+}
+
+float SceneRegistry::GetLoadingProgress(std::size_t const scene_index) const
+{
+	if (scene_index >= scene_entries.size())
+		return 0.0f;
+
+	auto const& entry = scene_entries[scene_index];
+	if (entry.state != State::loading)
+		return entry.state == State::loaded ? 1.0f : 0.0f;
+
+	return entry.pending_load->progress.load(std::memory_order_relaxed);
+}
+
+float SceneRegistry::GetLoadingDuration(std::size_t const scene_index) const
+{
+	if (scene_index >= scene_entries.size() || scene_entries[scene_index].state != State::loading)
+		return 0.0f;
+
+	return std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - scene_entries[scene_index].load_start_time).count();
+}
+
+std::size_t SceneRegistry::FindScene(std::string const& scene_name) const
+{
+	auto const it = std::find(scene_names.begin(), scene_names.end(), scene_name);
+	return static_cast<std::size_t>(std::distance(scene_names.begin(), it));
+}
+
+bool SceneRegistry::SelectScene(std::string const& label, std::int32_t& scene_index) const
+{
+	bool const was_selection_changed = ImGui::Combo(label.c_str(), &scene_index, scene_names.data(), static_cast<int>(scene_names.size()));
+	if (scene_index < 0 || static_cast<std::size_t>(scene_index) >= scene_entries.size())
+		return was_selection_changed;
+
+	switch (GetState(static_cast<std::size_t>(scene_index))) {
+	case State::loading:
+	{
+		// The Assimp import itself does not report any progress, so show
+		// how long it has been going on for as well.
+		char overlay[64];
+		std::snprintf(overlay, sizeof(overlay), "Loading… %.1f s", GetLoadingDuration(static_cast<std::size_t>(scene_index)));
+		ImGui::ProgressBar(GetLoadingProgress(static_cast<std::size_t>(scene_index)), ImVec2(-1.0f, 0.0f), overlay);
+		break;
+	}
+	case State::failed:
+		ImGui::TextColored(ImVec4(0.7f, 0.0f, 0.0f, 1.0f), "Failed to load; see the logs for details.");
+		break;
+	default:
+		break;
+	}
+
+	return was_selection_changed;
+}
+
+std::size_t SceneRegistry::GetGPUMemoryUsage() const
+{
+	std::size_t usage = 0u;
+	for (auto const& entry : scene_entries)
+		usage += entry.gpu_memory_usage;
+	return usage;
+}
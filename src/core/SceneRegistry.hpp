@@ -0,0 +1,138 @@
+#pragma once
+
+#include "core/helpers.hpp"
+#include "core/TextureStreamer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+//! \brief Set of scenes which are only loaded once they are first
+//!        needed, and unloaded again when GPU memory runs short.
+//!
+//! Scenes are imported and processed on a background thread through
+//! `bonobo::loadSceneData()`; only the final upload happens on the thread
+//! owning the OpenGL context, during `Update()`. Once the estimated GPU
+//! memory used by all loaded scenes exceeds the budget, the scenes which
+//! were acquired the longest time ago are released, except for the ones
+//! acquired during the current frame.
+class SceneRegistry
+{
+public:
+	enum class State : std::uint32_t {
+		unloaded = 0u,
+		loading,
+		loaded,
+		failed
+	};
+
+	//! @param [in] gpu_memory_budget in bytes
+	explicit SceneRegistry(std::size_t gpu_memory_budget = std::size_t(512u) << 20u);
+	~SceneRegistry();
+
+	SceneRegistry(SceneRegistry const&) = delete;
+	SceneRegistry& operator=(SceneRegistry const&) = delete;
+
+	//! \brief Add a scene to the registry, without loading it.
+	//!
+	//! @param [in] with_edges see `bonobo::loadSceneData()`
+	//! @param [in] layout_config see `bonobo::loadSceneData()`
+	//! @param [in] cache_config see `bonobo::loadSceneData()`
+	//! @return the index of the scene, to be used with the other methods
+	std::size_t RegisterScene(char const* const scene_name, std::string const& filename,
+	                          bonobo::welding::config const& weld_config = bonobo::welding::config{},
+	                          bool with_edges = true,
+	                          bonobo::vertex_layout::config const& layout_config = bonobo::vertex_layout::config{},
+	                          bonobo::vertex_cache::config const& cache_config = bonobo::vertex_cache::config{});
+
+	//! \brief Retrieve the meshes of a scene, starting to load it if
+	//!        needed.
+	//!
+	//! @return the meshes of the scene, or nullptr if it is not loaded
+	//!         (yet); the pointer stays valid until the next call to
+	//!         `Update()`
+	std::vector<bonobo::mesh_data> const* AcquireScene(std::size_t scene_index);
+
+	//! \brief Upload scenes which finished loading, and release the ones
+	//!        no longer fitting in the budget; call once per frame, from
+	//!        the thread owning the OpenGL context.
+	void Update();
+
+	State GetState(std::size_t scene_index) const;
+
+	//! \brief Retrieve the batches the meshes of a loaded scene got
+	//!        uploaded into, see `bonobo::uploadSceneData()`.
+	//!
+	//! @return the batches, or nullptr if the scene is not loaded; the
+	//!         pointer stays valid until the next call to `Update()`
+	std::vector<bonobo::mesh_batch> const* GetSceneBatches(std::size_t scene_index) const;
+
+	//! \brief Whether a loaded scene still samples placeholder textures
+	//!        for some of its meshes, while the actual ones stream in.
+	bool HasPendingTextures(std::size_t scene_index) const;
+
+	//! \brief Fraction of the meshes of a loading scene which have been
+	//!        processed so far.
+	float GetLoadingProgress(std::size_t scene_index) const;
+
+	//! \brief Seconds elapsed since a scene started loading.
+	float GetLoadingDuration(std::size_t scene_index) const;
+
+	//! \brief Show a combo box to pick a scene, along with the loading
+	//!        progress of the selected one.
+	//!
+	//! @return whether the selection changed
+	bool SelectScene(std::string const& label, std::int32_t& scene_index) const;
+
+	void SetGPUMemoryBudget(std::size_t budget) { gpu_memory_budget = budget; }
+	std::size_t GetGPUMemoryBudget() const { return gpu_memory_budget; }
+
+	//! \brief Estimated GPU memory used by the loaded scenes, in bytes.
+	std::size_t GetGPUMemoryUsage() const;
+
+	std::size_t GetSceneCount() const { return scene_entries.size(); }
+
+	//! \brief Look up a scene by the name it was registered with.
+	//!
+	//! @return the index of the scene, or `GetSceneCount()` if no scene
+	//!         has that name
+	std::size_t FindScene(std::string const& scene_name) const;
+
+private:
+	// Shared with the loading thread, which may outlive an unloaded
+	// entry.
+	struct PendingLoad {
+		bonobo::scene_data scene;
+		std::atomic<float> progress{0.0f};
+	};
+
+	struct SceneEntry {
+		std::string filename;
+		bonobo::welding::config weld_config;
+		bool with_edges{true};
+		bonobo::vertex_layout::config layout_config;
+		bonobo::vertex_cache::config cache_config;
+		State state = State::unloaded;
+		std::vector<bonobo::mesh_data> meshes;
+		std::vector<bonobo::mesh_batch> batches;
+		std::size_t gpu_memory_usage = 0u;
+		bool has_pending_textures = false;
+		std::uint64_t last_acquired_frame = 0u;
+		std::shared_ptr<PendingLoad> pending_load;
+		std::future<bool> load_result;
+		std::chrono::high_resolution_clock::time_point load_start_time;
+	};
+
+	void EvictScenes();
+
+	TextureStreamer texture_streamer;
+	std::vector<SceneEntry> scene_entries;
+	std::vector<char const*> scene_names;
+	std::size_t gpu_memory_budget;
+	std::uint64_t frame_index = 1u;
+};
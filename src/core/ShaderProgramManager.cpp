@@ -2,6 +2,7 @@
 
 #include "config.hpp"
 
+#include "gl_state.hpp"
 #include "Log.h"
 #include "opengl.hpp"
 #include "various.hpp"
@@ -14,6 +15,7 @@ ShaderProgramManager::~ShaderProgramManager()
 {
 	for (auto const& i : program_entries) {
 		if (i.first != 0u) {
+			bonobo::gl::get_state_tracker().forget_program(i.first);
 			glDeleteProgram(i.first);
 			i.first = 0u;
 		}
@@ -55,8 +57,10 @@ bool ShaderProgramManager::ReloadAllPrograms()
 	bool encountered_failures = false;
 	for (std::size_t i = 0; i < program_entries.size(); ++i) {
 		auto& program = program_entries[i].first;
-		if (program != 0u)
+		if (program != 0u) {
+			bonobo::gl::get_state_tracker().forget_program(program);
 			glDeleteProgram(program);
+		}
 		program = 0u;
 		ProcessProgram(i);
 		encountered_failures |= program == 0u;
@@ -109,6 +113,10 @@ void ShaderProgramManager::ProcessProgram(std::size_t const program_index)
 	program = utils::opengl::shader::generate_program(shaders);
 	utils::opengl::debug::nameObject(GL_PROGRAM, program, program_names[program_index]);
 
+	// Uniform locations get looked up in the reflection of the program
+	// from now on, rather than through OpenGL.
+	bonobo::gl::get_state_tracker().register_program(program);
+
 	for (auto& shader : shaders)
 		glDeleteShader(shader);
 }
@@ -0,0 +1,279 @@
+#include "TextureStreamer.hpp"
+
+#include "gl_resources.hpp"
+#include "helpers.hpp"
+#include "Log.h"
+#include "opengl.hpp"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+namespace
+{
+	constexpr std::size_t staging_alignment = 64u;
+
+	std::size_t alignStaging(std::size_t value)
+	{
+		return (value + staging_alignment - 1u) & ~(staging_alignment - 1u);
+	}
+}
+
+TextureStreamer::TextureStreamer(std::size_t const workers_nb, std::size_t const staging_size, std::size_t const upload_budget) : upload_budget(upload_budget)
+{
+	// Persistent mappings need glBufferStorage(); without it, texels are
+	// uploaded straight from client memory.
+	if (GLAD_GL_VERSION_4_4 && staging_size != 0u) {
+		GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glGenBuffers(1, &staging_buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging_buffer);
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(staging_size), nullptr, flags);
+		staging_data = static_cast<std::uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(staging_size), flags));
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0u);
+		if (staging_data != nullptr) {
+			this->staging_size = staging_size;
+			utils::opengl::debug::nameObject(GL_BUFFER, staging_buffer, "Texture streaming staging buffer");
+		} else {
+			LogWarning("Failed to map the texture streaming staging buffer; falling back to direct uploads.");
+			glDeleteBuffers(1, &staging_buffer);
+			staging_buffer = 0u;
+		}
+	}
+
+	for (auto const block_format : {bonobo::texture_container::format::bc1, bonobo::texture_container::format::bc3, bonobo::texture_container::format::bc7})
+		for (auto const is_srgb : {false, true})
+			are_compressed_formats_supported[static_cast<std::size_t>(block_format)][is_srgb ? 1u : 0u] = bonobo::isCompressedFormatSupported(block_format, is_srgb);
+
+	workers.reserve(std::max<std::size_t>(workers_nb, 1u));
+	for (std::size_t i = 0u; i < std::max<std::size_t>(workers_nb, 1u); ++i)
+		workers.emplace_back(&TextureStreamer::RunWorker, this);
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	{
+		std::lock_guard<std::mutex> const lock(queues_mutex);
+		is_stopping = true;
+		decode_jobs.clear();
+	}
+	jobs_available.notify_all();
+	for (auto& worker : workers)
+		worker.join();
+
+	for (auto const& staging_fence : staging_fences)
+		glDeleteSync(staging_fence.fence);
+	if (staging_buffer != 0u) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging_buffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0u);
+		glDeleteBuffers(1, &staging_buffer);
+	}
+}
+
+GLuint TextureStreamer::RequestTexture2D(std::string const& filename, bool const generate_mipmap)
+{
+	// Its storage only gets allocated once decoded, which is when its
+	// size and format become known.
+	auto const texture = bonobo::gl::texture::create(GL_TEXTURE_2D, filename).release();
+	assert(texture != 0u);
+
+	auto const request_id = next_request_id++;
+	pending_requests.emplace(texture, request_id);
+	{
+		std::lock_guard<std::mutex> const lock(queues_mutex);
+		decode_jobs.push_back({request_id, texture, filename, generate_mipmap});
+	}
+	jobs_available.notify_one();
+
+	return texture;
+}
+
+void TextureStreamer::Cancel(GLuint const texture)
+{
+	auto const request = pending_requests.find(texture);
+	if (request == pending_requests.end())
+		return;
+
+	auto const request_id = request->second;
+	pending_requests.erase(request);
+
+	// The name may be deleted and handed out again right after this, so
+	// drop anything still referring to this request; images being decoded
+	// right now get discarded by Update() instead.
+	std::lock_guard<std::mutex> const lock(queues_mutex);
+	auto const is_cancelled_job = [request_id](DecodeJob const& job) { return job.request_id == request_id; };
+	decode_jobs.erase(std::remove_if(decode_jobs.begin(), decode_jobs.end(), is_cancelled_job), decode_jobs.end());
+	auto const is_cancelled_image = [request_id](DecodedImage const& image) { return image.request_id == request_id; };
+	decoded_images.erase(std::remove_if(decoded_images.begin(), decoded_images.end(), is_cancelled_image), decoded_images.end());
+}
+
+bool TextureStreamer::IsResident(GLuint const texture) const
+{
+	return pending_requests.find(texture) == pending_requests.end();
+}
+
+void TextureStreamer::Update()
+{
+	if (pending_requests.empty())
+		return;
+
+	ProfileScope("Upload textures");
+	ReclaimStaging();
+
+	std::size_t uploaded_bytes = 0u;
+	while (uploaded_bytes < upload_budget) {
+		DecodedImage image;
+		{
+			std::lock_guard<std::mutex> const lock(queues_mutex);
+			if (decoded_images.empty())
+				break;
+			image = std::move(decoded_images.front());
+			decoded_images.pop_front();
+		}
+
+		auto const request = pending_requests.find(image.texture);
+		if (request == pending_requests.end() || request->second != image.request_id)
+			continue;
+
+		auto const upload_start_time = std::chrono::high_resolution_clock::now();
+
+		auto const& payload = image.is_compressed ? image.compressed.data : image.texels;
+		std::size_t staging_offset = 0u;
+		bool const is_staged = staging_data != nullptr && AllocateStaging(payload.size(), staging_offset);
+		if (staging_data != nullptr && !is_staged && payload.size() <= staging_size) {
+			// The ring is full of texels the GPU has not consumed yet:
+			// try again next frame rather than waiting for it.
+			std::lock_guard<std::mutex> const lock(queues_mutex);
+			decoded_images.push_front(std::move(image));
+			break;
+		}
+
+		GLvoid const* source = payload.data();
+		if (is_staged) {
+			std::memcpy(staging_data + staging_offset, payload.data(), payload.size());
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging_buffer);
+			source = reinterpret_cast<GLvoid const*>(staging_offset);
+		}
+		if (image.is_compressed) {
+			// Block-compressed images come with their own mipmap chain.
+			bonobo::uploadCompressedTexture2D(image.texture, image.compressed, source);
+		} else {
+			// Only borrowed, the texture belonging to whoever requested it.
+			bonobo::gl::texture texture(image.texture, GL_TEXTURE_2D);
+			auto const width = static_cast<GLsizei>(image.width);
+			auto const height = static_cast<GLsizei>(image.height);
+			texture.allocate(GL_RGBA8, width, height, image.generate_mipmap ? bonobo::gl::get_levels_nb(width, height) : 1);
+			texture.upload(0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, source);
+			texture.set_parameter(GL_TEXTURE_MIN_FILTER, image.generate_mipmap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+			texture.set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			if (image.generate_mipmap)
+				texture.generate_mipmap();
+			texture.release();
+		}
+		if (is_staged)
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0u);
+
+		pending_requests.erase(request);
+		uploaded_bytes += payload.size();
+
+		LogTrivia("Texture \"%s\" streamed in: %s, decoded in %.3f ms, uploaded%s in %.3f ms",
+		          image.filename.c_str(), image.is_compressed ? bonobo::texture_container::format_name(image.compressed.block_format) : "RGBA8",
+		          image.decode_duration, is_staged ? " through the staging buffer" : "",
+		          std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - upload_start_time).count());
+	}
+
+	if (staging_frame_used) {
+		staging_fences.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), staging_frame_begin});
+		staging_frame_used = false;
+	}
+}
+
+void TextureStreamer::RunWorker()
+{
+	Profiler::SetThreadName("Texture decoder");
+	for (;;) {
+		DecodeJob job;
+		{
+			std::unique_lock<std::mutex> lock(queues_mutex);
+			jobs_available.wait(lock, [this]() { return is_stopping || !decode_jobs.empty(); });
+			if (is_stopping)
+				return;
+			job = std::move(decode_jobs.front());
+			decode_jobs.pop_front();
+		}
+
+		ProfileScope("Decode texture");
+		auto const decode_start_time = std::chrono::high_resolution_clock::now();
+		DecodedImage image{job.request_id, job.texture, bonobo::findCompressedTexture(job.filename), job.generate_mipmap, 0u, 0u, {}, 0.0f, false, {}};
+		image.is_compressed = bonobo::texture_container::is_container(image.filename)
+		                   && bonobo::texture_container::read(image.filename, image.compressed);
+		if (image.is_compressed && !IsCompressedFormatSupported(image.compressed)) {
+			LogWarning("Ignoring texture container \"%s\": %s%s textures are not supported by this OpenGL context.",
+			           image.filename.c_str(), bonobo::texture_container::format_name(image.compressed.block_format), image.compressed.is_srgb ? " sRGB" : "");
+			image.is_compressed = false;
+		}
+		if (!image.is_compressed) {
+			image.filename = std::move(job.filename);
+			image.texels = bonobo::getTextureData(image.filename, image.width, image.height, true);
+		}
+		image.decode_duration = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - decode_start_time).count();
+
+		std::lock_guard<std::mutex> const lock(queues_mutex);
+		decoded_images.push_back(std::move(image));
+	}
+}
+
+bool TextureStreamer::IsCompressedFormatSupported(bonobo::texture_container::compressed_image const& image) const
+{
+	return are_compressed_formats_supported[static_cast<std::size_t>(image.block_format)][image.is_srgb ? 1u : 0u];
+}
+
+bool TextureStreamer::AllocateStaging(std::size_t const size, std::size_t& offset)
+{
+	auto const aligned_size = alignStaging(size);
+	if (aligned_size > staging_size)
+		return false;
+
+	// Ranges handed out this frame or still read by the GPU span from
+	// |oldest| to |staging_head|, possibly wrapping around. The head never
+	// catches up with |oldest| exactly, so that a full ring can not be
+	// mistaken for an empty one.
+	bool const is_in_use = staging_frame_used || !staging_fences.empty();
+	if (!is_in_use)
+		staging_head = 0u;
+	auto const oldest = !staging_fences.empty() ? staging_fences.front().begin : staging_frame_begin;
+
+	if (!is_in_use || staging_head >= oldest) {
+		if (staging_head + aligned_size <= staging_size)
+			offset = staging_head;
+		else if (aligned_size < oldest)
+			offset = 0u;
+		else
+			return false;
+	} else if (staging_head + aligned_size < oldest) {
+		offset = staging_head;
+	} else {
+		return false;
+	}
+
+	if (!staging_frame_used) {
+		staging_frame_begin = offset;
+		staging_frame_used = true;
+	}
+	staging_head = offset + aligned_size;
+	return true;
+}
+
+void TextureStreamer::ReclaimStaging()
+{
+	while (!staging_fences.empty()) {
+		auto const status = glClientWaitSync(staging_fences.front().fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			return;
+		glDeleteSync(staging_fences.front().fence);
+		staging_fences.pop_front();
+	}
+}
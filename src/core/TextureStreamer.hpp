@@ -0,0 +1,129 @@
+#pragma once
+
+#include "core/parallel.hpp"
+#include "core/texture_container.hpp"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//! \brief Load 2D-textures in the background.
+//!
+//! Images are decoded by a pool of worker threads, or read as is when a
+//! block-compressed version of them is available in a format the OpenGL
+//! context supports (see `bonobo::findCompressedTexture()`), and then
+//! uploaded
+//! during `Update()` on the thread owning the OpenGL context, through a
+//! persistently-mapped pixel buffer ring when OpenGL 4.4 is available.
+//! Each call to `Update()` uploads at most a fixed amount of texel data,
+//! so that streaming a whole scene in does not stall any single frame.
+//!
+//! Texture names are handed out as soon as a texture is requested, but
+//! they should not be sampled from until `IsResident()` returns true;
+//! `bonobo::getDebugTextureID()` is a suitable placeholder until then.
+class TextureStreamer
+{
+public:
+	//! @param [in] workers_nb number of decoding threads
+	//! @param [in] staging_size size in bytes of the pixel buffer ring
+	//! @param [in] upload_budget maximum number of bytes of texel data
+	//!             uploaded per call to `Update()`
+	explicit TextureStreamer(std::size_t workers_nb = utils::parallel::worker_count(),
+	                         std::size_t staging_size = std::size_t(64u) << 20u,
+	                         std::size_t upload_budget = std::size_t(32u) << 20u);
+	~TextureStreamer();
+
+	TextureStreamer(TextureStreamer const&) = delete;
+	TextureStreamer& operator=(TextureStreamer const&) = delete;
+
+	//! \brief Queue an image file for loading.
+	//!
+	//! Must be called from the thread owning the OpenGL context.
+	//!
+	//! @param [in] filename image to load
+	//! @param [in] generate_mipmap whether to generate the mipmap chain
+	//!             once uploaded
+	//! @return the name of the texture the image will be uploaded to;
+	//!         the caller owns it, and should `Cancel()` it before
+	//!         deleting it if it is not resident yet
+	GLuint RequestTexture2D(std::string const& filename, bool generate_mipmap = true);
+
+	//! \brief Stop loading a texture which is not resident yet.
+	void Cancel(GLuint texture);
+
+	//! \brief Whether a texture obtained from `RequestTexture2D()` has
+	//!        been fully uploaded.
+	bool IsResident(GLuint texture) const;
+
+	//! \brief Upload decoded images, within the per-call budget; call once
+	//!        per frame, from the thread owning the OpenGL context.
+	void Update();
+
+	//! \brief Number of textures requested but not resident yet.
+	std::size_t GetPendingCount() const { return pending_requests.size(); }
+
+private:
+	struct DecodeJob {
+		std::uint64_t request_id;
+		GLuint texture;
+		std::string filename;
+		bool generate_mipmap;
+	};
+
+	struct DecodedImage {
+		std::uint64_t request_id;
+		GLuint texture;
+		std::string filename;
+		bool generate_mipmap;
+		std::uint32_t width;
+		std::uint32_t height;
+		std::vector<std::uint8_t> texels;
+		float decode_duration;
+		bool is_compressed;
+		bonobo::texture_container::compressed_image compressed;
+	};
+
+	struct StagingFence {
+		GLsync fence;
+		std::size_t begin;
+	};
+
+	void RunWorker();
+	bool IsCompressedFormatSupported(bonobo::texture_container::compressed_image const& image) const;
+	bool AllocateStaging(std::size_t size, std::size_t& offset);
+	void ReclaimStaging();
+
+	// Queried once on the OpenGL thread, as the workers can not; indexed
+	// by block format, then by whether it is sRGB.
+	std::array<std::array<bool, 2u>, 3u> are_compressed_formats_supported{};
+
+	std::vector<std::thread> workers;
+	std::mutex queues_mutex;
+	std::condition_variable jobs_available;
+	std::deque<DecodeJob> decode_jobs;
+	std::deque<DecodedImage> decoded_images;
+	bool is_stopping = false;
+
+	// Only accessed from the OpenGL thread: maps texture names to the
+	// request that will fill them in.
+	std::unordered_map<GLuint, std::uint64_t> pending_requests;
+	std::uint64_t next_request_id = 1u;
+	std::size_t upload_budget;
+
+	GLuint staging_buffer = 0u;
+	std::uint8_t* staging_data = nullptr;
+	std::size_t staging_size = 0u;
+	std::size_t staging_head = 0u;
+	std::size_t staging_frame_begin = 0u;
+	bool staging_frame_used = false;
+	std::deque<StagingFence> staging_fences;
+};
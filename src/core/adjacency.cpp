@@ -0,0 +1,192 @@
+#include "adjacency.hpp"
+
+#include "core/parallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+namespace
+{
+	// Below this many elements, a chunk is not worth a thread of its own.
+	constexpr std::size_t min_chunk_size = 16384u;
+
+	constexpr unsigned int radix_bits = 8u;
+	constexpr std::size_t radix_buckets = std::size_t(1u) << radix_bits;
+
+	unsigned int bitWidth(std::uint32_t value)
+	{
+		unsigned int width = 0u;
+		while (value != 0u) {
+			++width;
+			value >>= 1u;
+		}
+		return width;
+	}
+
+	//! \brief Stable LSD radix sort of |keys|, carrying |values| along.
+	//!
+	//! Only the lowest |key_bits| bits of the keys are considered. Each
+	//! pass builds one histogram per chunk, turns them into scatter
+	//! offsets so that chunks write to disjoint ranges, and then scatters
+	//! all chunks concurrently.
+	void radixSort(std::vector<std::uint64_t>& keys, std::vector<std::uint32_t>& values, unsigned int key_bits, std::size_t workers_nb)
+	{
+		auto const count = keys.size();
+		std::vector<std::uint64_t> keys_tmp(count);
+		std::vector<std::uint32_t> values_tmp(count);
+
+		auto const chunks_nb = utils::parallel::chunk_count(count, min_chunk_size, workers_nb);
+		std::vector<std::array<std::size_t, radix_buckets>> offsets(chunks_nb);
+
+		for (unsigned int shift = 0u; shift < key_bits; shift += radix_bits) {
+			utils::parallel::for_each_chunk(count, min_chunk_size,
+				[&keys, &offsets, shift](std::size_t begin, std::size_t end, std::size_t chunk) {
+					auto& histogram = offsets[chunk];
+					histogram.fill(0u);
+					for (std::size_t i = begin; i < end; ++i)
+						++histogram[(keys[i] >> shift) & (radix_buckets - 1u)];
+				}, workers_nb);
+
+			std::size_t offset = 0u;
+			for (std::size_t bucket = 0u; bucket < radix_buckets; ++bucket) {
+				for (std::size_t chunk = 0u; chunk < chunks_nb; ++chunk) {
+					auto const bucket_count = offsets[chunk][bucket];
+					offsets[chunk][bucket] = offset;
+					offset += bucket_count;
+				}
+			}
+
+			utils::parallel::for_each_chunk(count, min_chunk_size,
+				[&keys, &values, &keys_tmp, &values_tmp, &offsets, shift](std::size_t begin, std::size_t end, std::size_t chunk) {
+					auto& scatter_offsets = offsets[chunk];
+					for (std::size_t i = begin; i < end; ++i) {
+						auto const destination = scatter_offsets[(keys[i] >> shift) & (radix_buckets - 1u)]++;
+						keys_tmp[destination] = keys[i];
+						values_tmp[destination] = values[i];
+					}
+				}, workers_nb);
+
+			keys.swap(keys_tmp);
+			values.swap(values_tmp);
+		}
+	}
+}
+
+std::vector<std::uint32_t>
+bonobo::adjacency::build(std::uint32_t const* indices, std::size_t triangles_nb, std::uint32_t vertices_nb, std::size_t workers_nb)
+{
+	std::vector<std::uint32_t> adjacency_indices(triangles_nb * 6u);
+	if (triangles_nb == 0u)
+		return adjacency_indices;
+
+	// Pack both ends of each edge in a single key, using as few bits as
+	// possible to keep the number of radix passes down. The smallest index
+	// goes first so that both half-edges of an edge share the same key and
+	// end up next to each other once sorted.
+	auto const vertex_bits = std::max(bitWidth(vertices_nb - 1u), 1u);
+	auto const key_bits = 2u * vertex_bits;
+
+	auto const half_edges_nb = triangles_nb * 3u;
+	auto const next_corner = [](std::size_t half_edge) {
+		return half_edge - (half_edge % 3u) + ((half_edge + 1u) % 3u);
+	};
+	std::vector<std::uint64_t> keys(half_edges_nb);
+	std::vector<std::uint32_t> half_edges(half_edges_nb);
+	utils::parallel::for_each_chunk(half_edges_nb, min_chunk_size,
+		[indices, vertices_nb, vertex_bits, &next_corner, &keys, &half_edges](std::size_t begin, std::size_t end, std::size_t /*chunk*/) {
+			for (std::size_t i = begin; i < end; ++i) {
+				auto const from = indices[i];
+				auto const to = indices[next_corner(i)];
+				assert(from < vertices_nb && to < vertices_nb);
+				keys[i] = (static_cast<std::uint64_t>(std::min(from, to)) << vertex_bits) | static_cast<std::uint64_t>(std::max(from, to));
+				half_edges[i] = static_cast<std::uint32_t>(i);
+			}
+		}, workers_nb);
+
+	radixSort(keys, half_edges, key_bits, workers_nb);
+
+	// Triangles with a repeated vertex, as left by welding, have no area
+	// and are nobody's neighbour.
+	auto const is_degenerate = [indices](std::size_t half_edge) {
+		auto const* const triangle = indices + (half_edge - half_edge % 3u);
+		return triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0];
+	};
+
+	utils::parallel::for_each_chunk(half_edges_nb, min_chunk_size,
+		[indices, &next_corner, &is_degenerate, &keys, &half_edges, &adjacency_indices](std::size_t begin, std::size_t end, std::size_t /*chunk*/) {
+			// Only process the runs of equal keys starting in this chunk;
+			// a run straddling the start belongs to the previous chunk.
+			while (begin != 0u && begin < end && keys[begin] == keys[begin - 1u])
+				++begin;
+
+			std::size_t run_end = begin;
+			for (std::size_t run_begin = begin; run_begin < end; run_begin = run_end) {
+				while (run_end < keys.size() && keys[run_end] == keys[run_begin])
+					++run_end;
+
+				// Edges without a neighbour fall back to the opposite vertex
+				// of their own triangle.
+				for (std::size_t i = run_begin; i < run_end; ++i) {
+					auto const half_edge = half_edges[i];
+					auto const corner = (half_edge / 3u) * 6u + (half_edge % 3u) * 2u;
+					adjacency_indices[corner + 0u] = indices[half_edge];
+					adjacency_indices[corner + 1u] = indices[next_corner(next_corner(half_edge))];
+				}
+
+				// All half-edges of a run join the same two vertices: pair
+				// the ones going up with the ones going down, in order, in
+				// a single pass. On non-manifold edges, the ones left
+				// unpaired keep their fallback.
+				auto const goes_up = [indices, &next_corner, &is_degenerate](std::uint32_t half_edge) {
+					return indices[half_edge] < indices[next_corner(half_edge)] && !is_degenerate(half_edge);
+				};
+				auto const goes_down = [indices, &next_corner, &is_degenerate](std::uint32_t half_edge) {
+					return indices[half_edge] > indices[next_corner(half_edge)] && !is_degenerate(half_edge);
+				};
+				for (std::size_t up = run_begin, down = run_begin;; ++up, ++down) {
+					while (up < run_end && !goes_up(half_edges[up]))
+						++up;
+					while (down < run_end && !goes_down(half_edges[down]))
+						++down;
+					if (up == run_end || down == run_end)
+						break;
+
+					auto const up_half_edge = half_edges[up];
+					auto const down_half_edge = half_edges[down];
+					adjacency_indices[(up_half_edge / 3u) * 6u + (up_half_edge % 3u) * 2u + 1u] = indices[next_corner(next_corner(down_half_edge))];
+					adjacency_indices[(down_half_edge / 3u) * 6u + (down_half_edge % 3u) * 2u + 1u] = indices[next_corner(next_corner(up_half_edge))];
+				}
+			}
+		});
+
+	return adjacency_indices;
+}
+
+std::vector<std::uint32_t>
+bonobo::adjacency::extract_edges(std::uint32_t const* adjacency_indices, std::size_t triangles_nb)
+{
+	// A closed mesh has one and a half times as many edges as triangles.
+	std::vector<std::uint32_t> edges;
+	edges.reserve(triangles_nb * 3u / 2u * 4u);
+
+	for (std::size_t t = 0u; t < triangles_nb; ++t) {
+		auto const* const triangle = adjacency_indices + 6u * t;
+		for (std::size_t e = 0u; e < 3u; ++e) {
+			auto const v0 = triangle[2u * e];
+			auto const v1 = triangle[(2u * e + 2u) % 6u];
+			auto const own_opposite = triangle[(2u * e + 4u) % 6u];
+			auto const neighbour_opposite = triangle[2u * e + 1u];
+
+			// Shared edges show up once in each direction, in both
+			// triangles; only keep the one going up.
+			bool const is_boundary = neighbour_opposite == own_opposite;
+			if (v0 > v1 && !is_boundary)
+				continue;
+
+			edges.insert(edges.end(), {own_opposite, v0, v1, neighbour_opposite});
+		}
+	}
+
+	return edges;
+}
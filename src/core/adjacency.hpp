@@ -0,0 +1,61 @@
+#pragma once
+
+#include "core/parallel.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Helpers for building index buffers suitable for
+	//!        GL_TRIANGLES_ADJACENCY draws.
+	namespace adjacency
+	{
+		//! \brief Build the adjacency index buffer of an indexed triangle
+		//!        list.
+		//!
+		//! Every triangle (v0, v1, v2) is expanded to the six indices
+		//! (v0, a01, v1, a12, v2, a20), where aXY is the vertex opposite to
+		//! the edge XY in the neighbouring triangle, which is the layout
+		//! expected by `NPR/silhouette.geom`. Edges without a neighbour
+		//! reference the opposite vertex of their own triangle instead.
+		//!
+		//! Neighbours are found by radix sorting the packed 64-bit keys of
+		//! all edges, which brings both halves of each edge next to each
+		//! other, and then pairing them up in a single pass over each run
+		//! of equal keys; both steps are spread over |workers_nb| threads.
+		//! Triangles with a repeated vertex are never paired with anyone.
+		//!
+		//! @param [in] indices three indices per triangle; they should be
+		//!             welded, i.e. triangles sharing an edge should use the
+		//!             same indices for it
+		//! @param [in] triangles_nb number of triangles in |indices|
+		//! @param [in] vertices_nb number of vertices referenced by
+		//!             |indices|; all indices have to be strictly less
+		//!             than this value
+		//! @param [in] workers_nb maximum number of threads to use
+		//! @return six indices per triangle
+		std::vector<std::uint32_t> build(std::uint32_t const* indices,
+		                                 std::size_t triangles_nb,
+		                                 std::uint32_t vertices_nb,
+		                                 std::size_t workers_nb = utils::parallel::worker_count());
+
+		//! \brief Extract every edge of an adjacency index buffer once.
+		//!
+		//! Each edge (v0, v1) is stored as the four indices
+		//! (o0, v0, v1, o1), where (v0, v1, o0) is the triangle going
+		//! through the edge in that direction, and (v1, v0, o1) its
+		//! neighbour; this is the order `GL_LINES_ADJACENCY` expects.
+		//! Edges without a neighbour have o1 equal to o0: their neighbour
+		//! then is the triangle itself seen from behind.
+		//!
+		//! @param [in] adjacency_indices six indices per triangle, as
+		//!             returned by `build()`
+		//! @param [in] triangles_nb number of triangles in
+		//!             |adjacency_indices|
+		//! @return four indices per edge
+		std::vector<std::uint32_t> extract_edges(std::uint32_t const* adjacency_indices,
+		                                         std::size_t triangles_nb);
+	}
+}
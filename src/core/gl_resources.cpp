@@ -0,0 +1,440 @@
+#include "gl_resources.hpp"
+
+#include "gl_state.hpp"
+#include "Log.h"
+#include "opengl.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	GLenum getBindingTarget(GLenum const target)
+	{
+		return target == GL_TEXTURE_1D ? GL_TEXTURE_BINDING_1D : GL_TEXTURE_BINDING_2D;
+	}
+
+	// Without direct state access, edits go through a binding point, whose
+	// previous binding gets restored afterwards; the rendering code sets
+	// its bindings before each use, but the texture streamer and the GUI
+	// expect them to stay put in between.
+	class ScopedTextureBinding
+	{
+	public:
+		ScopedTextureBinding(GLenum const target, GLuint const texture) : target(target)
+		{
+			GLint bound = 0;
+			glGetIntegerv(getBindingTarget(target), &bound);
+			previous = static_cast<GLuint>(bound);
+			glBindTexture(target, texture);
+		}
+		~ScopedTextureBinding() { glBindTexture(target, previous); }
+
+	private:
+		GLenum target;
+		GLuint previous{0u};
+	};
+
+	bool hasTextureStorage()
+	{
+		return GLAD_GL_VERSION_4_2;
+	}
+
+	bool hasBufferStorage()
+	{
+		return GLAD_GL_VERSION_4_4;
+	}
+
+	// Pixel format and type compatible with |internal_format|, to emulate
+	// immutable storage with glTexImage*().
+	void getTransferFormat(GLenum const internal_format, GLenum& format, GLenum& type)
+	{
+		switch (internal_format) {
+			case GL_R8:    format = GL_RED;  type = GL_UNSIGNED_BYTE; return;
+			case GL_RG8:   format = GL_RG;   type = GL_UNSIGNED_BYTE; return;
+			case GL_RGB8:  format = GL_RGB;  type = GL_UNSIGNED_BYTE; return;
+			case GL_R32F:  format = GL_RED;  type = GL_FLOAT;         return;
+			case GL_RG16F:
+			case GL_RG32F: format = GL_RG;   type = GL_FLOAT;         return;
+			case GL_RGB16F:
+			case GL_RGB32F: format = GL_RGB; type = GL_FLOAT;         return;
+			case GL_RGBA16F:
+			case GL_RGBA32F: format = GL_RGBA; type = GL_FLOAT;       return;
+			case GL_DEPTH_COMPONENT16:
+			case GL_DEPTH_COMPONENT24:
+			case GL_DEPTH_COMPONENT32F: format = GL_DEPTH_COMPONENT; type = GL_FLOAT; return;
+			case GL_DEPTH24_STENCIL8: format = GL_DEPTH_STENCIL; type = GL_UNSIGNED_INT_24_8; return;
+			default:       format = GL_RGBA; type = GL_UNSIGNED_BYTE; return;
+		}
+	}
+
+	GLenum getUsage(GLbitfield const flags)
+	{
+		if (flags & GL_MAP_READ_BIT)
+			return GL_STREAM_READ;
+		if (flags & (GL_DYNAMIC_STORAGE_BIT | GL_MAP_WRITE_BIT))
+			return GL_DYNAMIC_DRAW;
+		return GL_STATIC_DRAW;
+	}
+}
+
+bool
+bonobo::gl::has_direct_state_access()
+{
+	return GLAD_GL_VERSION_4_5;
+}
+
+GLsizei
+bonobo::gl::get_levels_nb(GLsizei const width, GLsizei const height)
+{
+	GLsizei levels_nb = 1;
+	for (auto size = std::max(width, height); size > 1; size /= 2)
+		++levels_nb;
+	return levels_nb;
+}
+
+GLenum
+bonobo::gl::get_sized_format(GLenum const internal_format)
+{
+	switch (internal_format) {
+		case GL_RED:  return GL_R8;
+		case GL_RG:   return GL_RG8;
+		case GL_RGB:  return GL_RGB8;
+		case GL_RGBA: return GL_RGBA8;
+		case GL_DEPTH_COMPONENT: return GL_DEPTH_COMPONENT32F;
+		case GL_DEPTH_STENCIL:   return GL_DEPTH24_STENCIL8;
+		default:      return internal_format;
+	}
+}
+
+void
+bonobo::gl::texture_traits::destroy(GLuint const id)
+{
+	get_state_tracker().forget_texture(id);
+	glDeleteTextures(1, &id);
+}
+
+void
+bonobo::gl::sampler_traits::destroy(GLuint const id)
+{
+	get_state_tracker().forget_sampler(id);
+	glDeleteSamplers(1, &id);
+}
+
+bonobo::gl::texture
+bonobo::gl::texture::create(GLenum const target, std::string const& name)
+{
+	GLuint id = 0u;
+	if (has_direct_state_access()) {
+		glCreateTextures(target, 1, &id);
+	} else {
+		// The name only turns into an object once bound, which labelling
+		// it requires.
+		glGenTextures(1, &id);
+		ScopedTextureBinding const binding(target, id);
+	}
+	utils::opengl::debug::nameObject(GL_TEXTURE, id, name);
+	return texture(id, target);
+}
+
+bonobo::gl::texture
+bonobo::gl::texture::create_2d(GLenum const internal_format, GLsizei const width, GLsizei const height,
+                               GLsizei const levels_nb, std::string const& name)
+{
+	auto result = create(GL_TEXTURE_2D, name);
+	result.allocate(internal_format, width, height, levels_nb);
+	return result;
+}
+
+void
+bonobo::gl::texture::allocate(GLenum const internal_format, GLsizei const width, GLsizei const height,
+                              GLsizei const levels_nb) const
+{
+	auto const format = get_sized_format(internal_format);
+	if (has_direct_state_access()) {
+		if (target == GL_TEXTURE_1D)
+			glTextureStorage1D(get(), levels_nb, format, width);
+		else
+			glTextureStorage2D(get(), levels_nb, format, width, height);
+		return;
+	}
+
+	ScopedTextureBinding const binding(target, get());
+	if (hasTextureStorage()) {
+		if (target == GL_TEXTURE_1D)
+			glTexStorage1D(target, levels_nb, format, width);
+		else
+			glTexStorage2D(target, levels_nb, format, width, height);
+		return;
+	}
+
+	// Mutable storage, made complete the same way immutable one is.
+	GLenum transfer_format, transfer_type;
+	getTransferFormat(format, transfer_format, transfer_type);
+	for (GLsizei level = 0; level < levels_nb; ++level) {
+		auto const level_width = std::max(width >> level, 1);
+		auto const level_height = std::max(height >> level, 1);
+		if (target == GL_TEXTURE_1D)
+			glTexImage1D(target, level, format, level_width, 0, transfer_format, transfer_type, nullptr);
+		else
+			glTexImage2D(target, level, format, level_width, level_height, 0, transfer_format, transfer_type, nullptr);
+	}
+	glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels_nb - 1);
+}
+
+void
+bonobo::gl::texture::upload(GLint const level, GLsizei const width, GLsizei const height,
+                            GLenum const format, GLenum const type, GLvoid const* const data) const
+{
+	if (has_direct_state_access()) {
+		if (target == GL_TEXTURE_1D)
+			glTextureSubImage1D(get(), level, 0, width, format, type, data);
+		else
+			glTextureSubImage2D(get(), level, 0, 0, width, height, format, type, data);
+		return;
+	}
+
+	ScopedTextureBinding const binding(target, get());
+	if (target == GL_TEXTURE_1D)
+		glTexSubImage1D(target, level, 0, width, format, type, data);
+	else
+		glTexSubImage2D(target, level, 0, 0, width, height, format, type, data);
+}
+
+void
+bonobo::gl::texture::upload_compressed(GLint const level, GLsizei const width, GLsizei const height,
+                                       GLenum const internal_format, GLsizei const size,
+                                       GLvoid const* const data) const
+{
+	if (has_direct_state_access()) {
+		glCompressedTextureSubImage2D(get(), level, 0, 0, width, height, internal_format, size, data);
+		return;
+	}
+
+	ScopedTextureBinding const binding(target, get());
+	glCompressedTexSubImage2D(target, level, 0, 0, width, height, internal_format, size, data);
+}
+
+void
+bonobo::gl::texture::set_parameter(GLenum const parameter, GLint const value) const
+{
+	if (has_direct_state_access()) {
+		glTextureParameteri(get(), parameter, value);
+		return;
+	}
+
+	ScopedTextureBinding const binding(target, get());
+	glTexParameteri(target, parameter, value);
+}
+
+void
+bonobo::gl::texture::generate_mipmap() const
+{
+	if (has_direct_state_access()) {
+		glGenerateTextureMipmap(get());
+		return;
+	}
+
+	ScopedTextureBinding const binding(target, get());
+	glGenerateMipmap(target);
+}
+
+GLint
+bonobo::gl::texture::get_parameter(GLenum const parameter) const
+{
+	GLint value = 0;
+	if (has_direct_state_access()) {
+		glGetTextureParameteriv(get(), parameter, &value);
+		return value;
+	}
+
+	ScopedTextureBinding const binding(target, get());
+	glGetTexParameteriv(target, parameter, &value);
+	return value;
+}
+
+GLint
+bonobo::gl::texture::get_level_parameter(GLint const level, GLenum const parameter) const
+{
+	GLint value = 0;
+	if (has_direct_state_access()) {
+		glGetTextureLevelParameteriv(get(), level, parameter, &value);
+		return value;
+	}
+
+	ScopedTextureBinding const binding(target, get());
+	glGetTexLevelParameteriv(target, level, parameter, &value);
+	return value;
+}
+
+bonobo::gl::buffer
+bonobo::gl::buffer::create(GLsizeiptr const size, GLvoid const* const data, GLbitfield const flags,
+                           std::string const& name)
+{
+	// Unlike mutable storage, immutable one can not be empty.
+	auto const storage_size = std::max<GLsizeiptr>(size, 1);
+	auto const storage_data = size != 0 ? data : nullptr;
+
+	GLuint id = 0u;
+	if (has_direct_state_access()) {
+		glCreateBuffers(1, &id);
+		glNamedBufferStorage(id, storage_size, storage_data, flags);
+	} else {
+		GLint bound = 0;
+		glGetIntegerv(GL_COPY_WRITE_BUFFER_BINDING, &bound);
+		glGenBuffers(1, &id);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+		if (hasBufferStorage())
+			glBufferStorage(GL_COPY_WRITE_BUFFER, storage_size, storage_data, flags);
+		else
+			glBufferData(GL_COPY_WRITE_BUFFER, size, data, getUsage(flags));
+		glBindBuffer(GL_COPY_WRITE_BUFFER, static_cast<GLuint>(bound));
+	}
+	utils::opengl::debug::nameObject(GL_BUFFER, id, name);
+	return buffer(id);
+}
+
+void
+bonobo::gl::buffer::upload(GLintptr const offset, GLsizeiptr const size, GLvoid const* const data) const
+{
+	if (has_direct_state_access()) {
+		glNamedBufferSubData(get(), offset, size, data);
+		return;
+	}
+
+	GLint bound = 0;
+	glGetIntegerv(GL_COPY_WRITE_BUFFER_BINDING, &bound);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, get());
+	glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, static_cast<GLuint>(bound));
+}
+
+bonobo::gl::framebuffer
+bonobo::gl::framebuffer::create(std::string const& name)
+{
+	GLuint id = 0u;
+	if (has_direct_state_access()) {
+		glCreateFramebuffers(1, &id);
+	} else {
+		GLint bound = 0;
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &bound);
+		glGenFramebuffers(1, &id);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, id);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(bound));
+	}
+	utils::opengl::debug::nameObject(GL_FRAMEBUFFER, id, name);
+	return framebuffer(id);
+}
+
+namespace
+{
+	// Framebuffer counterpart of ScopedTextureBinding, for the edits that
+	// have no DSA equivalent before OpenGL 4.5.
+	class ScopedFramebufferBinding
+	{
+	public:
+		explicit ScopedFramebufferBinding(GLuint const framebuffer)
+		{
+			GLint bound = 0;
+			glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &bound);
+			previous = static_cast<GLuint>(bound);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+		}
+		~ScopedFramebufferBinding() { glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous); }
+
+	private:
+		GLuint previous{0u};
+	};
+}
+
+void
+bonobo::gl::framebuffer::attach(GLenum const attachment, GLuint const texture, GLint const level) const
+{
+	if (has_direct_state_access()) {
+		glNamedFramebufferTexture(get(), attachment, texture, level);
+		return;
+	}
+
+	ScopedFramebufferBinding const binding(get());
+	glFramebufferTexture(GL_DRAW_FRAMEBUFFER, attachment, texture, level);
+}
+
+void
+bonobo::gl::framebuffer::set_draw_buffers(std::vector<GLenum> const& draw_buffers) const
+{
+	auto const draw_buffers_nb = static_cast<GLsizei>(draw_buffers.size());
+	if (has_direct_state_access()) {
+		glNamedFramebufferDrawBuffers(get(), draw_buffers_nb, draw_buffers.data());
+		return;
+	}
+
+	ScopedFramebufferBinding const binding(get());
+	glDrawBuffers(draw_buffers_nb, draw_buffers.data());
+}
+
+void
+bonobo::gl::framebuffer::set_read_buffer(GLenum const read_buffer) const
+{
+	if (has_direct_state_access()) {
+		glNamedFramebufferReadBuffer(get(), read_buffer);
+		return;
+	}
+
+	GLint bound = 0;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &bound);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, get());
+	glReadBuffer(read_buffer);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(bound));
+}
+
+bool
+bonobo::gl::framebuffer::is_complete(std::string const& name) const
+{
+	GLenum status;
+	if (has_direct_state_access()) {
+		status = glCheckNamedFramebufferStatus(get(), GL_DRAW_FRAMEBUFFER);
+	} else {
+		ScopedFramebufferBinding const binding(get());
+		status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+	}
+	if (status == GL_FRAMEBUFFER_COMPLETE)
+		return true;
+
+	LogError("Framebuffer \"%s\" is incomplete (status 0x%04x).", name.c_str(), status);
+	return false;
+}
+
+bonobo::gl::sampler
+bonobo::gl::sampler::create(std::string const& name)
+{
+	GLuint id = 0u;
+	// Unlike other kinds, generated samplers are objects right away.
+	if (has_direct_state_access())
+		glCreateSamplers(1, &id);
+	else
+		glGenSamplers(1, &id);
+	utils::opengl::debug::nameObject(GL_SAMPLER, id, name);
+	return sampler(id);
+}
+
+void
+bonobo::gl::sampler::set_parameter(GLenum const parameter, GLint const value) const
+{
+	glSamplerParameteri(get(), parameter, value);
+}
+
+bonobo::gl::vertex_array
+bonobo::gl::vertex_array::create(std::string const& name)
+{
+	GLuint id = 0u;
+	if (has_direct_state_access()) {
+		glCreateVertexArrays(1, &id);
+	} else {
+		GLint bound = 0;
+		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &bound);
+		glGenVertexArrays(1, &id);
+		glBindVertexArray(id);
+		glBindVertexArray(static_cast<GLuint>(bound));
+	}
+	utils::opengl::debug::nameObject(GL_VERTEX_ARRAY, id, name);
+	return vertex_array(id);
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Owners of OpenGL objects, deleting them when going out of
+	//!        scope, and creating and editing them through direct state
+	//!        access where available.
+	//!
+	//! With OpenGL 4.5, objects are edited without ever getting bound,
+	//! which leaves the bindings of the rendering code alone; otherwise
+	//! they get bound to edit them, and the previous binding is restored
+	//! right after. Textures get immutable storage from OpenGL 4.2 on, so
+	//! that drivers can check their completeness once rather than at every
+	//! draw, and buffers from OpenGL 4.4 on; older contexts, such as the
+	//! 4.1 ones of macOS, get mutable storage set up the same way.
+	//!
+	//! All objects get labelled with the name they are created with, for
+	//! debuggers and debug messages, and all functions must be called from
+	//! the thread owning the OpenGL context.
+	namespace gl
+	{
+		//! \brief Whether objects get edited without binding them.
+		bool has_direct_state_access();
+
+		//! \brief Number of levels of a full mipmap chain.
+		GLsizei get_levels_nb(GLsizei width, GLsizei height);
+
+		//! \brief Sized counterpart of an unsized internal format such as
+		//!        GL_RGBA, as immutable storage needs; other formats are
+		//!        returned as is.
+		GLenum get_sized_format(GLenum internal_format);
+
+		//! \brief Name of an object of a given kind, deleted along with
+		//!        its owner; see the aliases below.
+		template <typename Traits>
+		class handle
+		{
+		public:
+			handle() = default;
+			//! \brief Take ownership of |id|.
+			explicit handle(GLuint id) noexcept : id(id) {}
+			~handle() { reset(); }
+
+			handle(handle const&) = delete;
+			handle& operator=(handle const&) = delete;
+			handle(handle&& other) noexcept : id(other.release()) {}
+			handle& operator=(handle&& other) noexcept
+			{
+				if (this != &other)
+					reset(other.release());
+				return *this;
+			}
+
+			GLuint get() const noexcept { return id; }
+			explicit operator bool() const noexcept { return id != 0u; }
+
+			//! \brief Give up ownership of the object, without deleting it.
+			GLuint release() noexcept
+			{
+				auto const released = id;
+				id = 0u;
+				return released;
+			}
+
+			//! \brief Delete the object owned so far, if any, and take
+			//!        ownership of |new_id|.
+			void reset(GLuint new_id = 0u) noexcept
+			{
+				if (id != 0u)
+					Traits::destroy(id);
+				id = new_id;
+			}
+
+		private:
+			GLuint id{0u};
+		};
+
+		// Textures and samplers also get forgotten by the state tracker of
+		// gl_state.hpp, as OpenGL unbinds them when deleted.
+		struct texture_traits      { static void destroy(GLuint id); };
+		struct buffer_traits       { static void destroy(GLuint id) { glDeleteBuffers(1, &id); } };
+		struct framebuffer_traits  { static void destroy(GLuint id) { glDeleteFramebuffers(1, &id); } };
+		struct sampler_traits      { static void destroy(GLuint id); };
+		struct vertex_array_traits { static void destroy(GLuint id) { glDeleteVertexArrays(1, &id); } };
+
+		//! \brief 1D- or 2D-texture, with immutable storage.
+		class texture : public handle<texture_traits>
+		{
+		public:
+			texture() = default;
+			//! \brief Take ownership of |id|, created for |target|.
+			texture(GLuint id, GLenum target) noexcept : handle(id), target(target) {}
+
+			//! \brief Create a texture without any storage yet, see
+			//!        `allocate()`.
+			static texture create(GLenum target, std::string const& name);
+
+			//! \brief Create a 2D-texture along with its storage.
+			static texture create_2d(GLenum internal_format, GLsizei width, GLsizei height,
+			                         GLsizei levels_nb, std::string const& name);
+
+			//! \brief Give the texture its immutable storage, which can
+			//!        only be done once; |height| is ignored for 1D-ones.
+			void allocate(GLenum internal_format, GLsizei width, GLsizei height, GLsizei levels_nb) const;
+
+			//! \brief Replace the content of a whole level, from client
+			//!        memory or from the buffer bound to
+			//!        GL_PIXEL_UNPACK_BUFFER.
+			void upload(GLint level, GLsizei width, GLsizei height,
+			            GLenum format, GLenum type, GLvoid const* data) const;
+
+			//! \brief Same as `upload()`, for block-compressed levels.
+			void upload_compressed(GLint level, GLsizei width, GLsizei height,
+			                       GLenum internal_format, GLsizei size, GLvoid const* data) const;
+
+			void set_parameter(GLenum parameter, GLint value) const;
+			void generate_mipmap() const;
+
+			//! \brief Same as glGetTexParameteriv(), without disturbing
+			//!        the current bindings.
+			GLint get_parameter(GLenum parameter) const;
+
+			//! \brief Same as glGetTexLevelParameteriv(), without
+			//!        disturbing the current bindings.
+			GLint get_level_parameter(GLint level, GLenum parameter) const;
+
+			GLenum get_target() const noexcept { return target; }
+
+		private:
+			GLenum target{GL_TEXTURE_2D};
+		};
+
+		class buffer : public handle<buffer_traits>
+		{
+		public:
+			using handle::handle;
+
+			//! \brief Create a buffer of |size| bytes, filled with |data|
+			//!        unless null.
+			//!
+			//! @param [in] flags as for glBufferStorage(); without
+			//!             immutable storage, they pick the usage hint of
+			//!             the mutable one instead
+			static buffer create(GLsizeiptr size, GLvoid const* data, GLbitfield flags, std::string const& name);
+
+			//! \brief Only possible if created with GL_DYNAMIC_STORAGE_BIT.
+			void upload(GLintptr offset, GLsizeiptr size, GLvoid const* data) const;
+		};
+
+		class framebuffer : public handle<framebuffer_traits>
+		{
+		public:
+			using handle::handle;
+
+			static framebuffer create(std::string const& name);
+
+			//! \brief Attach a level of |texture| at |attachment|, or
+			//!        detach whatever was there if |texture| is 0.
+			void attach(GLenum attachment, GLuint texture, GLint level = 0) const;
+
+			void set_draw_buffers(std::vector<GLenum> const& draw_buffers) const;
+			void set_read_buffer(GLenum read_buffer) const;
+
+			//! \brief Check the framebuffer is complete, logging an error
+			//!        under |name| otherwise.
+			bool is_complete(std::string const& name) const;
+		};
+
+		class sampler : public handle<sampler_traits>
+		{
+		public:
+			using handle::handle;
+
+			static sampler create(std::string const& name);
+
+			void set_parameter(GLenum parameter, GLint value) const;
+		};
+
+		class vertex_array : public handle<vertex_array_traits>
+		{
+		public:
+			using handle::handle;
+
+			static vertex_array create(std::string const& name);
+		};
+	}
+}
@@ -0,0 +1,199 @@
+#include "gl_state.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+bonobo::gl::program_interface::program_interface(GLuint const program)
+{
+	if (program == 0u)
+		return;
+
+	// Arrays are reported once, under the name of their first element;
+	// they are also recorded without the subscript, as OpenGL accepts
+	// both, while other elements get resolved on lookup.
+	auto const add_uniform = [this](std::string name, GLint const location, GLint const array_size) {
+		if (location < 0)
+			return;
+		uniform_locations[name] = location;
+		auto const subscript = name.size() > 3u ? name.rfind("[0]") : std::string::npos;
+		if (subscript != std::string::npos && subscript + 3u == name.size()) {
+			name.resize(subscript);
+			uniform_locations[name] = location;
+			uniform_array_sizes[name] = array_size;
+		}
+	};
+
+	// OpenGL 4.3 reports all properties of a uniform at once, including
+	// its location, while older contexts need a query per uniform.
+	if (GLAD_GL_VERSION_4_3) {
+		GLint uniforms_nb = 0, max_name_length = 0;
+		glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniforms_nb);
+		glGetProgramInterfaceiv(program, GL_UNIFORM, GL_MAX_NAME_LENGTH, &max_name_length);
+		std::vector<GLchar> name(static_cast<std::size_t>(max_name_length) + 1u);
+		GLenum const properties[] = { GL_LOCATION, GL_ARRAY_SIZE };
+		for (GLint i = 0; i < uniforms_nb; ++i) {
+			GLint values[2] = { -1, 1 };
+			glGetProgramResourceiv(program, GL_UNIFORM, static_cast<GLuint>(i), 2, properties, 2, nullptr, values);
+			if (values[0] < 0) // in a block
+				continue;
+
+			GLsizei length = 0;
+			glGetProgramResourceName(program, GL_UNIFORM, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, name.data());
+			add_uniform(std::string(name.data(), static_cast<std::size_t>(length)), values[0], values[1]);
+		}
+	} else {
+		GLint uniforms_nb = 0, max_name_length = 0;
+		glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniforms_nb);
+		glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+		std::vector<GLchar> name(static_cast<std::size_t>(max_name_length) + 1u);
+		for (GLint i = 0; i < uniforms_nb; ++i) {
+			GLsizei length = 0;
+			GLint array_size = 1;
+			GLenum type = GL_NONE;
+			glGetActiveUniform(program, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, &array_size, &type, name.data());
+			add_uniform(std::string(name.data(), static_cast<std::size_t>(length)), glGetUniformLocation(program, name.data()), array_size);
+		}
+	}
+}
+
+GLint
+bonobo::gl::program_interface::get_uniform_location(char const* const name) const
+{
+	auto const it = uniform_locations.find(name);
+	if (it != uniform_locations.end())
+		return it->second;
+
+	// Array elements past the first one follow it.
+	auto const length = std::strlen(name);
+	auto const* const subscript = std::strrchr(name, '[');
+	if (subscript == nullptr || length == 0u || name[length - 1u] != ']')
+		return -1;
+	auto const array = uniform_array_sizes.find(std::string(name, subscript));
+	if (array == uniform_array_sizes.end())
+		return -1;
+	char* end = nullptr;
+	auto const index = std::strtol(subscript + 1, &end, 10);
+	if (end != name + length - 1u || index < 0 || index >= array->second)
+		return -1;
+	return uniform_locations.find(array->first)->second + static_cast<GLint>(index);
+}
+
+void
+bonobo::gl::state_tracker::register_program(GLuint const program)
+{
+	forget_program(program);
+	if (program != 0u)
+		program_interfaces.emplace(program, program_interface(program));
+}
+
+void
+bonobo::gl::state_tracker::forget_program(GLuint const program)
+{
+	program_interfaces.erase(program);
+
+	// A deleted program stays in use until another one replaces it, which
+	// could be a new program getting the same name.
+	if (program == this->program)
+		is_program_known = false;
+}
+
+GLint
+bonobo::gl::state_tracker::get_uniform_location(GLuint const program, char const* const name) const
+{
+	auto const it = program_interfaces.find(program);
+	return it != program_interfaces.end() ? it->second.get_uniform_location(name)
+	                                      : glGetUniformLocation(program, name);
+}
+
+void
+bonobo::gl::state_tracker::use_program(GLuint const program)
+{
+	if (count(is_program_known && program == this->program))
+		return;
+
+	glUseProgram(program);
+	is_program_known = true;
+	this->program = program;
+}
+
+void
+bonobo::gl::state_tracker::bind_texture(GLuint const unit, GLenum const target, GLuint const texture)
+{
+	auto const binding = textures.find({unit, target});
+	if (count(binding != textures.end() && binding->second == texture))
+		return;
+
+	if (!is_active_unit_known || active_unit != unit) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		is_active_unit_known = true;
+		active_unit = unit;
+	}
+	glBindTexture(target, texture);
+	textures[{unit, target}] = texture;
+}
+
+void
+bonobo::gl::state_tracker::bind_sampler(GLuint const unit, GLuint const sampler)
+{
+	auto const binding = samplers.find(unit);
+	if (count(binding != samplers.end() && binding->second == sampler))
+		return;
+
+	glBindSampler(unit, sampler);
+	samplers[unit] = sampler;
+}
+
+void
+bonobo::gl::state_tracker::forget_texture(GLuint const texture)
+{
+	if (texture == 0u)
+		return;
+	for (auto& binding : textures)
+		if (binding.second == texture)
+			binding.second = 0u;
+}
+
+void
+bonobo::gl::state_tracker::forget_sampler(GLuint const sampler)
+{
+	if (sampler == 0u)
+		return;
+	for (auto& binding : samplers)
+		if (binding.second == sampler)
+			binding.second = 0u;
+}
+
+void
+bonobo::gl::state_tracker::invalidate()
+{
+	is_program_known = false;
+	is_active_unit_known = false;
+	textures.clear();
+	samplers.clear();
+}
+
+void
+bonobo::gl::state_tracker::begin_frame()
+{
+	frame_statistics = current_statistics;
+	current_statistics = statistics{};
+	invalidate();
+}
+
+bool
+bonobo::gl::state_tracker::count(bool const is_redundant)
+{
+	if (is_redundant)
+		++current_statistics.avoided_calls_nb;
+	else
+		++current_statistics.issued_calls_nb;
+	return is_redundant;
+}
+
+bonobo::gl::state_tracker&
+bonobo::gl::get_state_tracker()
+{
+	static state_tracker tracker;
+	return tracker;
+}
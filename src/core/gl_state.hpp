@@ -0,0 +1,117 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace bonobo
+{
+	namespace gl
+	{
+		//! \brief Locations of the active uniforms of a linked program,
+		//!        queried once rather than by name at every use.
+		class program_interface
+		{
+		public:
+			program_interface() = default;
+
+			//! \brief Reflect the uniforms of |program|, which has to be
+			//!        linked successfully.
+			explicit program_interface(GLuint program);
+
+			//! \brief Same as glGetUniformLocation(): -1 unless |name| is
+			//!        an active uniform outside of any block.
+			GLint get_uniform_location(char const* name) const;
+			GLint get_uniform_location(std::string const& name) const { return get_uniform_location(name.c_str()); }
+
+			std::size_t get_uniforms_nb() const noexcept { return uniform_locations.size() - uniform_array_sizes.size(); }
+
+		private:
+			std::map<std::string, GLint, std::less<>> uniform_locations;
+			std::map<std::string, GLint, std::less<>> uniform_array_sizes;
+		};
+
+		//! \brief Shadow copy of the program, texture and sampler bindings,
+		//!        to skip the calls which would not change them.
+		//!
+		//! It only knows about the bindings made through it, and about the
+		//! objects deleted through the handles of gl_resources.hpp or the
+		//! shader program manager; code binding or deleting such objects
+		//! by itself has to call `invalidate()` afterwards, which
+		//! `begin_frame()` does as well.
+		//!
+		//! It also keeps the reflection of the programs registered to it,
+		//! until they get forgotten.
+		class state_tracker
+		{
+		public:
+			struct statistics {
+				std::size_t issued_calls_nb{0u};
+				std::size_t avoided_calls_nb{0u};
+			};
+
+			//! \brief Reflect the uniforms of |program|, replacing what
+			//!        was known about an earlier program of the same name.
+			void register_program(GLuint program);
+
+			//! \brief To be called before deleting |program|, as its name
+			//!        can be reused by the next program to get linked.
+			void forget_program(GLuint program);
+
+			//! \brief Location of a uniform of |program|, out of its
+			//!        reflection if registered, or from OpenGL otherwise.
+			GLint get_uniform_location(GLuint program, char const* name) const;
+
+			void use_program(GLuint program);
+
+			//! \brief Bind |texture| to |target| of texture unit |unit|;
+			//!        this leaves |unit| as the active texture unit.
+			void bind_texture(GLuint unit, GLenum target, GLuint texture);
+
+			void bind_sampler(GLuint unit, GLuint sampler);
+
+			//! \brief To be called when deleting |texture|, which OpenGL
+			//!        unbinds from every texture unit.
+			void forget_texture(GLuint texture);
+
+			//! \brief To be called when deleting |sampler|, which OpenGL
+			//!        unbinds from every texture unit.
+			void forget_sampler(GLuint sampler);
+
+			//! \brief Assume nothing about the current bindings, so that
+			//!        the next call to each binding function goes through.
+			void invalidate();
+
+			//! \brief Start counting the calls of a new frame, and
+			//!        invalidate the bindings, as the GUI and the loading
+			//!        of scenes may have changed them in between.
+			void begin_frame();
+
+			//! \brief Calls issued and avoided during the previous frame.
+			statistics const& get_frame_statistics() const noexcept { return frame_statistics; }
+
+		private:
+			bool count(bool is_redundant);
+
+			std::unordered_map<GLuint, program_interface> program_interfaces;
+
+			bool is_program_known{false};
+			GLuint program{0u};
+			bool is_active_unit_known{false};
+			GLuint active_unit{0u};
+			std::map<std::pair<GLuint, GLenum>, GLuint> textures; // by unit and target
+			std::map<GLuint, GLuint> samplers;                    // by unit
+
+			statistics current_statistics;
+			statistics frame_statistics;
+		};
+
+		//! \brief Tracker of the one OpenGL context the application uses.
+		state_tracker& get_state_tracker();
+	}
+}
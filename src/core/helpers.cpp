@@ -2,53 +2,38 @@
 #include "helpers.hpp"
 
 #include "core/Log.h"
+#include "core/TextureStreamer.hpp"
+#include "core/gl_resources.hpp"
+#include "core/gl_state.hpp"
 #include "core/opengl.hpp"
 #include "core/various.hpp"
 
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <imgui.h>
 #include <stb_image.h>
+#include <stb_image_write.h>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
 #include <memory>
 
-struct Edge
-{
-	size_t p1;
-	size_t p2;
-};
-bool operator==(const Edge &lhs, const Edge &rhs)
-{
-	return lhs.p1 == rhs.p1 && lhs.p2 == rhs.p2;
-}
-
-template <>
-struct std::hash<Edge>
-{
-	std::size_t operator()(Edge const &edge) const noexcept
-	{
-		std::size_t h1 = std::hash<unsigned int>{}(edge.p1);
-		std::size_t h2 = std::hash<unsigned int>{}(edge.p2);
-		return h1 ^ (h2 << 1);
-	}
-};
-
-template <>
-struct std::hash<aiVector3D>
-{
-	std::size_t operator()(aiVector3D const &v) const noexcept
-	{
-		std::size_t h1 = std::hash<unsigned int>{}(v[0]);
-		std::size_t h2 = std::hash<unsigned int>{}(v[1]);
-		std::size_t h3 = std::hash<unsigned int>{}(v[2]);
-		return ((h1 ^ (h2 << 1)) >> 1) ^ (h3 << 1);
-	}
-};
+// S3TC is only exposed through GL_EXT_texture_compression_s3tc and its
+// sRGB counterpart, which are not part of the generated loader; see
+// `bonobo::isCompressedFormatSupported()` for when they can be used.
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
 
 namespace
 {
@@ -72,6 +57,71 @@ namespace
 
 	void setupBasisData();
 	void createDebugTexture();
+	bonobo::mesh_data uploadMesh(bonobo::mesh_view const &mesh);
+	std::vector<bonobo::mesh_data> uploadBatches(std::vector<bonobo::mesh_view> const &meshes, std::vector<bonobo::mesh_batch> &batches);
+
+	//! \brief Point the |attributes| listed in |bindings| at the buffer
+	//!        bound to GL_ARRAY_BUFFER; missing ones are skipped.
+	void setupVertexAttributes(bonobo::vertex_layout::attributes const &attributes, std::string const &name,
+							   std::initializer_list<bonobo::shader_bindings> bindings)
+	{
+		for (auto const binding : bindings)
+		{
+			auto const location = static_cast<GLuint>(binding);
+			auto const &attribute = attributes[location];
+			if (attribute.offset < 0)
+				continue;
+
+			auto const stride = static_cast<GLsizei>(attribute.stride);
+			auto const offset = reinterpret_cast<GLvoid const *>(attribute.offset);
+			glEnableVertexAttribArray(location);
+			switch (attribute.type)
+			{
+			case bonobo::vertex_layout::format::float3:
+				glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, stride, offset);
+				break;
+			case bonobo::vertex_layout::format::snorm_10_10_10_2:
+				glVertexAttribPointer(location, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, offset);
+				break;
+			case bonobo::vertex_layout::format::octahedral_snorm16:
+				glVertexAttribPointer(location, 2, GL_SHORT, GL_TRUE, stride, offset);
+				break;
+			case bonobo::vertex_layout::format::half2:
+				glVertexAttribPointer(location, 2, GL_HALF_FLOAT, GL_FALSE, stride, offset);
+				break;
+			default:
+				LogError("Mesh \"%s\" uses an unknown format for attribute %u.", name.c_str(), location);
+				glDisableVertexAttribArray(location);
+			}
+		}
+	}
+
+	bool hasExtension(char const *name)
+	{
+		GLint extensions_nb = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extensions_nb);
+		for (GLint i = 0; i < extensions_nb; ++i)
+		{
+			auto const *const extension = reinterpret_cast<char const *>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+			if (extension != nullptr && std::strcmp(extension, name) == 0)
+				return true;
+		}
+		return false;
+	}
+
+	GLenum getCompressedInternalFormat(bonobo::texture_container::compressed_image const &image)
+	{
+		switch (image.block_format)
+		{
+		case bonobo::texture_container::format::bc1:
+			return image.is_srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		case bonobo::texture_container::format::bc3:
+			return image.is_srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case bonobo::texture_container::format::bc7:
+			return image.is_srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+		}
+		return GL_NONE;
+	}
 }
 
 namespace local
@@ -98,24 +148,30 @@ void bonobo::init()
 	local::fullscreen_shader = bonobo::createProgram("common/fullscreen.vert", "common/fullscreen.frag");
 	if (local::fullscreen_shader == 0u)
 		LogError("Failed to load \"fullscreen.vert\" and \"fullscreen.frag\"");
+	bonobo::gl::get_state_tracker().register_program(local::fullscreen_shader);
 }
 
 void bonobo::deinit()
 {
+	auto &state = bonobo::gl::get_state_tracker();
+
+	state.forget_texture(debug_texture_id);
 	glDeleteTextures(1, &debug_texture_id);
 	debug_texture_id = 0u;
 
+	state.forget_program(basis.shader);
 	glDeleteProgram(basis.shader);
 	glDeleteBuffers(1, &basis.ibo);
 	glDeleteBuffers(1, &basis.vbo);
 	glDeleteVertexArrays(1, &basis.vao);
 
+	state.forget_program(local::fullscreen_shader);
 	glDeleteProgram(local::fullscreen_shader);
 	glDeleteVertexArrays(1, &local::display_vao);
 }
 
-static std::vector<std::uint8_t>
-getTextureData(std::string const &filename, std::uint32_t &width, std::uint32_t &height, bool flip)
+std::vector<std::uint8_t>
+bonobo::getTextureData(std::string const &filename, std::uint32_t &width, std::uint32_t &height, bool flip)
 {
 	auto const channels_nb = 4u;
 	stbi_set_flip_vertically_on_load_thread(flip ? 1 : 0);
@@ -137,366 +193,323 @@ getTextureData(std::string const &filename, std::uint32_t &width, std::uint32_t
 	return image;
 }
 
+bool
+bonobo::writePNG(std::string const &filename, std::uint32_t width, std::uint32_t height, std::uint8_t const *texels)
+{
+	// Walk the rows backwards through a negative stride, rather than
+	// through `stbi_flip_vertically_on_write()` which is global state.
+	auto const stride = static_cast<int>(width) * 4;
+	auto const *const top_row = texels + static_cast<std::size_t>(height - 1u) * static_cast<std::size_t>(stride);
+	if (width == 0u || height == 0u || stbi_write_png(filename.c_str(), static_cast<int>(width), static_cast<int>(height), 4, top_row, -stride) == 0)
+	{
+		LogError("Failed to write image file %s", filename.c_str());
+		return false;
+	}
+
+	return true;
+}
+
 std::vector<bonobo::mesh_data>
-bonobo::loadObjects(std::string const &filename)
+bonobo::loadObjects(std::string const &filename, welding::config const &weld_config, bool with_edges, vertex_layout::config const &layout_config, vertex_cache::config const &cache_config)
 {
-	auto const scene_start_time = std::chrono::high_resolution_clock::now();
+	scene_data scene;
+	if (!loadSceneData(filename, scene, weld_config, with_edges, layout_config, cache_config))
+		return {};
 
-	std::vector<bonobo::mesh_data> objects;
+	return uploadSceneData(scene);
+}
 
-	auto const end_of_basedir = filename.rfind("/");
-	auto const parent_folder = (end_of_basedir != std::string::npos ? filename.substr(0, end_of_basedir) : ".") + "/";
-	Assimp::Importer importer;
-	auto const assimp_scene = importer.ReadFile(filename, aiProcess_Triangulate | aiProcess_SortByPType | aiProcess_CalcTangentSpace);
-	if (assimp_scene == nullptr || assimp_scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || assimp_scene->mRootNode == nullptr)
-	{
-		LogError("Assimp failed to load \"%s\": %s", filename.c_str(), importer.GetErrorString());
-		return objects;
-	}
+std::vector<bonobo::mesh_data>
+bonobo::uploadSceneData(scene_data const &scene, TextureStreamer *texture_streamer, std::vector<mesh_batch> *batches)
+{
+	auto const upload_start_time = std::chrono::high_resolution_clock::now();
+
+	// Several meshes usually share the same material, so only load each
+	// image once.
+	std::unordered_map<std::string, GLuint> loaded_textures;
+	float textures_duration = 0.0f;
 
-	if (assimp_scene->mNumMeshes == 0u)
+	std::vector<bonobo::mesh_data> objects;
+	if (batches != nullptr)
 	{
-		LogError("No mesh available; loading \"%s\" must have had issues", filename.c_str());
-		return objects;
+		objects = uploadBatches(scene.meshes, *batches);
 	}
-
-	LogInfo("┭ Loading \"%s\"…", filename.c_str());
-
-	std::vector<bool> are_materials_used(assimp_scene->mNumMaterials, false);
-	for (size_t j = 0; j < assimp_scene->mNumMeshes; ++j)
+	else
 	{
-		auto const assimp_object_mesh = assimp_scene->mMeshes[j];
-		auto const material_id = assimp_object_mesh->mMaterialIndex;
-		if (material_id >= assimp_scene->mNumMaterials)
-			LogError("Mesh \"%s\" has a material index of %u, but only %u materials are present.", assimp_object_mesh->mName.C_Str(), material_id, assimp_scene->mNumMaterials);
-		else
-			are_materials_used[material_id] = true;
+		objects.reserve(scene.meshes.size());
+		for (auto const &mesh : scene.meshes)
+			objects.push_back(uploadMesh(mesh));
 	}
 
-	auto const materials_start_time = std::chrono::high_resolution_clock::now();
-	std::vector<texture_bindings> materials_bindings(assimp_scene->mNumMaterials);
-	std::vector<material_data> material_constants(assimp_scene->mNumMaterials);
-	uint32_t texture_count = 0u;
-	for (size_t i = 0; i < assimp_scene->mNumMaterials; ++i)
+	for (size_t i = 0u; i < scene.meshes.size(); ++i)
 	{
-		if (!are_materials_used[i])
-			continue;
+		auto const &mesh = scene.meshes[i];
+		auto &object = objects[i];
 
-		auto const material_start_time = std::chrono::high_resolution_clock::now();
-		texture_bindings &bindings = materials_bindings[i];
-		material_data &constants = material_constants[i];
-		auto const material = assimp_scene->mMaterials[i];
-
-		auto const process_texture = [&bindings, &material, i, &parent_folder, &texture_count](aiTextureType type, std::string const &type_as_str, std::string const &name)
+		for (auto const &texture : mesh.textures)
 		{
-			if (material->GetTextureCount(type))
+			auto loaded_texture = loaded_textures.find(texture.path);
+			if (loaded_texture == loaded_textures.end() && texture_streamer != nullptr)
+			{
+				// Decoded in the background; see resolvePendingTextures().
+				auto const id = texture_streamer->RequestTexture2D(scene.parent_folder + texture.path);
+				utils::opengl::debug::nameObject(GL_TEXTURE, id, texture.label);
+				loaded_texture = loaded_textures.emplace(texture.path, id).first;
+			}
+			else if (loaded_texture == loaded_textures.end())
 			{
 				auto const texture_start_time = std::chrono::high_resolution_clock::now();
-
-				if (material->GetTextureCount(type) > 1)
-					LogWarning("Material \"%s\" has more than one %s texture: discarding all but the first one.", material->GetName().C_Str(), type_as_str.c_str());
-				aiString path;
-				material->GetTexture(type, 0, &path);
-				auto const id = bonobo::loadTexture2D(parent_folder + std::string(path.C_Str()));
-				if (id == 0u)
+				auto const id = bonobo::loadTexture2D(scene.parent_folder + texture.path);
+				auto const texture_end_time = std::chrono::high_resolution_clock::now();
+				textures_duration += std::chrono::duration<float>(texture_end_time - texture_start_time).count();
+				if (id != 0u)
 				{
-					LogWarning("Failed to load the %s texture for material \"%s\".", type_as_str.c_str(), material->GetName().C_Str());
-					return;
+					utils::opengl::debug::nameObject(GL_TEXTURE, id, texture.label);
+					LogTrivia("│ %s Texture \"%s\" loaded in %.3f ms",
+							  loaded_textures.empty() ? "┌" : "├", texture.path.c_str(),
+							  std::chrono::duration<float, std::milli>(texture_end_time - texture_start_time).count());
 				}
-				bindings.emplace(name, id);
-				++texture_count;
-
-				utils::opengl::debug::nameObject(GL_TEXTURE, id, std::string(material->GetName().C_Str()) + " " + type_as_str);
-
-				auto const texture_end_time = std::chrono::high_resolution_clock::now();
-				LogTrivia("│ %s Texture \"%s\" loaded in %.3f ms",
-						  bindings.size() == 1 ? "┌" : "├", path.C_Str(),
-						  std::chrono::duration<float, std::milli>(texture_end_time - texture_start_time).count());
+				else
+				{
+					LogWarning("Failed to load the texture \"%s\" of mesh \"%s\".", texture.path.c_str(), mesh.name.c_str());
+				}
+				loaded_texture = loaded_textures.emplace(texture.path, id).first;
+			}
+			if (loaded_texture->second == 0u)
+				continue;
+			if (texture_streamer != nullptr && !texture_streamer->IsResident(loaded_texture->second))
+			{
+				object.bindings.emplace(texture.sampler, bonobo::getDebugTextureID());
+				object.pending_bindings.emplace(texture.sampler, loaded_texture->second);
+			}
+			else
+			{
+				object.bindings.emplace(texture.sampler, loaded_texture->second);
 			}
-		};
-
-		aiColor3D color;
-
-		material->Get(AI_MATKEY_COLOR_DIFFUSE, color);
-		constants.diffuse = glm::vec3(color.r, color.g, color.b);
-		material->Get(AI_MATKEY_COLOR_SPECULAR, color);
-		constants.specular = glm::vec3(color.r, color.g, color.b);
-		material->Get(AI_MATKEY_COLOR_AMBIENT, color);
-		constants.ambient = glm::vec3(color.r, color.g, color.b);
-		material->Get(AI_MATKEY_COLOR_EMISSIVE, color);
-		constants.emissive = glm::vec3(color.r, color.g, color.b);
-		material->Get(AI_MATKEY_SHININESS, constants.shininess);
-		material->Get(AI_MATKEY_REFRACTI, constants.indexOfRefraction);
-		material->Get(AI_MATKEY_OPACITY, constants.opacity);
-
-		process_texture(aiTextureType_DIFFUSE, "diffuse", "diffuse_texture");
-		process_texture(aiTextureType_SPECULAR, "specular", "specular_texture");
-		process_texture(aiTextureType_NORMALS, "normals", "normals_texture");
-		process_texture(aiTextureType_OPACITY, "opacity", "opacity_texture");
-
-		auto const material_end_time = std::chrono::high_resolution_clock::now();
-		LogTrivia("│ %s Material \"%s\" loaded in %.3f ms",
-				  bindings.empty() ? "╺" : "┕", material->GetName().C_Str(),
-				  std::chrono::duration<float, std::milli>(material_end_time - material_start_time).count());
-	}
-	auto const materials_end_time = std::chrono::high_resolution_clock::now();
-
-	auto const meshes_start_time = std::chrono::high_resolution_clock::now();
-	objects.reserve(assimp_scene->mNumMeshes);
-	for (size_t j = 0; j < assimp_scene->mNumMeshes; ++j)
-	{
-		auto const mesh_start_time = std::chrono::high_resolution_clock::now();
-
-		auto const assimp_object_mesh = assimp_scene->mMeshes[j];
-
-		if (!assimp_object_mesh->HasFaces())
-		{
-			LogError("Unsupported mesh \"%s\": has no faces", assimp_object_mesh->mName.C_Str());
-			continue;
-		}
-		if ((assimp_object_mesh->mPrimitiveTypes & ~static_cast<uint32_t>(aiPrimitiveType_POINT)) != 0u && (assimp_object_mesh->mPrimitiveTypes & ~static_cast<uint32_t>(aiPrimitiveType_LINE)) != 0u && (assimp_object_mesh->mPrimitiveTypes & ~static_cast<uint32_t>(aiPrimitiveType_TRIANGLE)) != 0u)
-		{
-			LogError("Unsupported mesh \"%s\": uses multiple primitive types", assimp_object_mesh->mName.C_Str());
-			continue;
-		}
-		if ((assimp_object_mesh->mPrimitiveTypes & static_cast<uint32_t>(aiPrimitiveType_POLYGON)) == static_cast<uint32_t>(aiPrimitiveType_POLYGON))
-		{
-			LogError("Unsupported mesh \"%s\": uses polygons", assimp_object_mesh->mName.C_Str());
-			continue;
-		}
-		if (!assimp_object_mesh->HasPositions())
-		{
-			LogError("Unsupported mesh \"%s\": has no positions", assimp_object_mesh->mName.C_Str());
-			continue;
-		}
-
-		bonobo::mesh_data object;
-		if (assimp_object_mesh->mName.length != 0)
-		{
-			object.name = std::string(assimp_object_mesh->mName.C_Str());
-		}
-
-		glGenVertexArrays(1, &object.vao);
-		assert(object.vao != 0u);
-		glBindVertexArray(object.vao);
-
-		auto const vertices_offset = 0u;
-		auto const vertices_size = static_cast<GLsizeiptr>(assimp_object_mesh->mNumVertices * sizeof(glm::vec3));
-
-		auto const normals_offset = vertices_size;
-		auto const normals_size = assimp_object_mesh->HasNormals() ? vertices_size : 0u;
-
-		auto const texcoords_offset = normals_offset + normals_size;
-		auto const texcoords_size = assimp_object_mesh->HasTextureCoords(0u) ? vertices_size : 0u;
-
-		auto const tangents_offset = texcoords_offset + texcoords_size;
-		auto const tangents_size = assimp_object_mesh->HasTangentsAndBitangents() ? vertices_size : 0u;
-
-		auto const binormals_offset = tangents_offset + tangents_size;
-		auto const binormals_size = assimp_object_mesh->HasTangentsAndBitangents() ? vertices_size : 0u;
-
-		auto const bo_size = static_cast<GLsizeiptr>(vertices_size + normals_size + texcoords_size + tangents_size + binormals_size);
-		glGenBuffers(1, &object.bo);
-		assert(object.bo != 0u);
-		glBindBuffer(GL_ARRAY_BUFFER, object.bo);
-		glBufferData(GL_ARRAY_BUFFER, bo_size, nullptr, GL_STATIC_DRAW);
-
-		glBufferSubData(GL_ARRAY_BUFFER, vertices_offset, vertices_size, static_cast<GLvoid const *>(assimp_object_mesh->mVertices));
-		glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::vertices));
-		glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::vertices), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const *>(0x0));
-
-		if (assimp_object_mesh->HasNormals())
-		{
-			glBufferSubData(GL_ARRAY_BUFFER, normals_offset, normals_size, static_cast<GLvoid const *>(assimp_object_mesh->mNormals));
-			glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::normals));
-			glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::normals), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const *>(normals_offset));
-		}
-
-		if (assimp_object_mesh->HasTextureCoords(0u))
-		{
-			glBufferSubData(GL_ARRAY_BUFFER, texcoords_offset, texcoords_size, static_cast<GLvoid const *>(assimp_object_mesh->mTextureCoords[0u]));
-			glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::texcoords));
-			glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::texcoords), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const *>(texcoords_offset));
 		}
+	}
 
-		if (assimp_object_mesh->HasTangentsAndBitangents())
-		{
-			glBufferSubData(GL_ARRAY_BUFFER, tangents_offset, tangents_size, static_cast<GLvoid const *>(assimp_object_mesh->mTangents));
-			glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::tangents));
-			glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::tangents), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const *>(tangents_offset));
+	auto const upload_end_time = std::chrono::high_resolution_clock::now();
+	auto const upload_duration = std::chrono::duration<float>(upload_end_time - upload_start_time).count();
+	LogInfo("┕ Scene uploaded in %.3f s: %zu textures %s in %.3f s and %zu meshes%s in %.3f s",
+			upload_duration,
+			loaded_textures.size(), texture_streamer != nullptr ? "requested" : "loaded", textures_duration,
+			objects.size(), batches != nullptr ? (" in " + std::to_string(batches->size()) + " batches").c_str() : "",
+			upload_duration - textures_duration);
 
-			glBufferSubData(GL_ARRAY_BUFFER, binormals_offset, binormals_size, static_cast<GLvoid const *>(assimp_object_mesh->mBitangents));
-			glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::binormals));
-			glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::binormals), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const *>(binormals_offset));
-		}
-
-		glBindBuffer(GL_ARRAY_BUFFER, 0u);
+	return objects;
+}
 
-		auto const num_vertices_per_face = assimp_object_mesh->mFaces[0u].mNumIndices;
-		object.indices_nb = assimp_object_mesh->mNumFaces * num_vertices_per_face;
-		auto object_indices = std::make_unique<GLuint[]>(static_cast<size_t>(object.indices_nb));
-		std::vector<GLuint> vertex_vector;
-		std::unordered_map<Edge, GLuint> edge_adj_map;
-		std::unordered_map<aiVector3D, GLuint> vertex_map;
-		for (size_t i = 0u; i < assimp_object_mesh->mNumFaces; ++i)
+bool
+bonobo::resolvePendingTextures(std::vector<mesh_data> &objects, TextureStreamer const &texture_streamer)
+{
+	bool is_done = true;
+	for (auto &object : objects)
+	{
+		for (auto binding = object.pending_bindings.begin(); binding != object.pending_bindings.end();)
 		{
-			auto const &face = assimp_object_mesh->mFaces[i];
-			assert(face.mNumIndices <= 3);
-
-			// assume we only handle objesc with 3 indices per face
-			for (size_t j = 0u; j < 3u; ++j)
+			if (!texture_streamer.IsResident(binding->second))
 			{
-				size_t index = face.mIndices[j];
-				aiVector3D &v = assimp_object_mesh->mVertices[index];
-
-				// removing duplicate indices for the same vertex
-				if (vertex_map.find(v) == vertex_map.end())
-					vertex_map[v] = index;
-				else
-					index = vertex_map[v];
-
-				object_indices[num_vertices_per_face * i + j] = index;
+				is_done = false;
+				++binding;
+				continue;
 			}
-			size_t iv1 = object_indices[num_vertices_per_face * i + 0u];
-			size_t iv2 = object_indices[num_vertices_per_face * i + 1u];
-			size_t iv3 = object_indices[num_vertices_per_face * i + 2u];
-
-			edge_adj_map[Edge{iv1, iv2}] = iv3;
-			edge_adj_map[Edge{iv2, iv3}] = iv1;
-			edge_adj_map[Edge{iv3, iv1}] = iv2;
+			object.bindings[binding->first] = binding->second;
+			binding = object.pending_bindings.erase(binding);
 		}
+	}
+	return is_done;
+}
 
-		// filling adjacency indices using hash map
-		object.adjacency_nb = object.indices_nb * 2u;
-		auto adjacency_indices = std::make_unique<GLuint[]>(static_cast<size_t>(object.adjacency_nb));
-		for (size_t i = 0u; i < object.indices_nb; i += 3)
+void
+bonobo::releaseObjects(std::vector<mesh_data> &objects, TextureStreamer *texture_streamer)
+{
+	std::vector<GLuint> textures, buffers, vertex_arrays;
+	for (auto const &object : objects)
+	{
+		for (auto const &binding : object.pending_bindings)
 		{
-			size_t iv1 = object_indices[i + 0u];
-			size_t iv2 = object_indices[i + 1u];
-			size_t iv3 = object_indices[i + 2u];
+			if (texture_streamer != nullptr)
+				texture_streamer->Cancel(binding.second);
+			textures.push_back(binding.second);
+		}
+		for (auto const &binding : object.bindings)
+			if (binding.second != bonobo::getDebugTextureID())
+				textures.push_back(binding.second);
 
-			Edge edges[3] = {Edge{iv2, iv1},
-							 Edge{iv3, iv2},
-							 Edge{iv1, iv3}};
+		buffers.insert(buffers.end(), {object.edges_bo, object.ibo, object.bo});
+		vertex_arrays.insert(vertex_arrays.end(), {object.edges_vao, object.vao});
+	}
 
-			adjacency_indices[2u * i + 0u] = iv1;
-			adjacency_indices[2u * i + 2u] = iv2;
-			adjacency_indices[2u * i + 4u] = iv3;
+	// Textures are shared between meshes using the same material, and
+	// buffers and vertex arrays between meshes of the same batch.
+	auto const release = [](std::vector<GLuint> &names, void (*release_names)(GLsizei, GLuint const *)) {
+		std::sort(names.begin(), names.end());
+		names.erase(std::unique(names.begin(), names.end()), names.end());
+		release_names(static_cast<GLsizei>(names.size()), names.data());
+	};
+	release(textures, [](GLsizei n, GLuint const *names) {
+		auto &state = bonobo::gl::get_state_tracker();
+		for (GLsizei i = 0; i < n; ++i)
+			state.forget_texture(names[i]);
+		glDeleteTextures(n, names);
+	});
+	release(buffers, [](GLsizei n, GLuint const *names) { glDeleteBuffers(n, names); });
+	release(vertex_arrays, [](GLsizei n, GLuint const *names) { glDeleteVertexArrays(n, names); });
+
+	objects.clear();
+}
 
-			for (size_t j = 0u; j < 3u; j++)
-			{
-				size_t index;
-				// if the edge BA has no adjacent vertex, save adjacent vertex of AB
-				if (edge_adj_map.find(edges[j]) == edge_adj_map.end())
-				{
-					Edge no_adjacent = edges[j];
-					Edge opposite_edge{no_adjacent.p2, no_adjacent.p1};
-					index = edge_adj_map[opposite_edge];
-				}
-				else
-					index = edge_adj_map[edges[j]];
+void
+bonobo::releaseBatches(std::vector<mesh_batch> &batches)
+{
+	for (auto const &batch : batches)
+	{
+		glDeleteBuffers(1, &batch.visible_meshlets_nb_bo);
+		glDeleteBuffers(1, &batch.meshlet_draw_commands_bo);
+		glDeleteBuffers(1, &batch.meshlets_bo);
+		glDeleteBuffers(1, &batch.visible_draws_nb_bo);
+		glDeleteBuffers(1, &batch.culled_draw_commands_bo);
+		glDeleteBuffers(1, &batch.draws_bo);
+		glDeleteBuffers(1, &batch.draw_commands_bo);
+	}
+	batches.clear();
+}
 
-				adjacency_indices[2u * i + j * 2u + 1u] = index;
-			}
-		}
 
-		glGenBuffers(1, &object.ibo);
-		assert(object.ibo != 0u);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object.ibo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<unsigned int>(object.adjacency_nb) * sizeof(GL_UNSIGNED_INT), reinterpret_cast<GLvoid const *>(adjacency_indices.get()), GL_STATIC_DRAW);
-		object_indices.reset(nullptr);
-		adjacency_indices.reset(nullptr);
+GLuint
+bonobo::createTexture(uint32_t width, uint32_t height, GLenum target, GLint internal_format, GLenum format, GLenum type, GLvoid const *data)
+{
+	if (target != GL_TEXTURE_1D && target != GL_TEXTURE_2D)
+	{
+		LogError("Non-handled texture target: %08x.\n", target);
+		return 0u;
+	}
 
-		utils::opengl::debug::nameObject(GL_VERTEX_ARRAY, object.vao, object.name + " VAO");
-		utils::opengl::debug::nameObject(GL_BUFFER, object.bo, object.name + " VBO");
-		utils::opengl::debug::nameObject(GL_BUFFER, object.ibo, object.name + " IBO");
+	auto texture = bonobo::gl::texture::create(target, "Texture");
+	assert(texture);
+	texture.allocate(static_cast<GLenum>(internal_format), static_cast<GLsizei>(width), static_cast<GLsizei>(height), 1);
+	texture.set_parameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	texture.set_parameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	if (data != nullptr)
+		texture.upload(0, static_cast<GLsizei>(width), static_cast<GLsizei>(height), format, type, data);
 
-		glBindVertexArray(0u);
-		glBindBuffer(GL_ARRAY_BUFFER, 0u);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
+	return texture.release();
+}
 
-		auto const material_id = assimp_object_mesh->mMaterialIndex;
-		if (material_id < materials_bindings.size())
-		{
-			object.bindings = materials_bindings[material_id];
-			object.material = material_constants[material_id];
-		}
+std::string
+bonobo::findCompressedTexture(std::string const &filename)
+{
+	if (texture_container::is_container(filename))
+		return filename;
 
-		objects.push_back(object);
-
-		auto const mesh_end_time = std::chrono::high_resolution_clock::now();
-
-		std::string attributes = assimp_object_mesh->HasNormals() ? "normals" : "";
-		if (!attributes.empty())
-			attributes += " | ";
-		if (assimp_object_mesh->HasTangentsAndBitangents())
-			attributes += "tangents&bitangents";
-		if (!attributes.empty())
-			attributes += " | ";
-		if (assimp_object_mesh->HasTextureCoords(0))
-			attributes += "texture coordinates";
-		LogTrivia("│ %s Mesh \"%s\" loaded with attributes [%s] in %.3f ms",
-				  (assimp_scene->mNumMeshes == 1u) ? "╶" : (j == 0 ? "┌" : (j == assimp_scene->mNumMeshes - 1 ? "└" : "├")),
-				  assimp_object_mesh->mName.C_Str(), attributes.c_str(),
-				  std::chrono::duration<float, std::milli>(mesh_end_time - mesh_start_time).count());
-	}
-	auto const meshes_end_time = std::chrono::high_resolution_clock::now();
+	auto const extension_start = filename.find_last_of('.');
+	auto const separator = filename.find_last_of("/\\");
+	if (extension_start == std::string::npos || (separator != std::string::npos && extension_start < separator))
+		return filename;
 
-	auto const scene_end_time = std::chrono::high_resolution_clock::now();
-	LogInfo("┕ Scene loaded in %.3f s: %u textures loaded in %.3f s and %zu meshes in %.3f s",
-			std::chrono::duration<float>(scene_end_time - scene_start_time).count(),
-			texture_count,
-			std::chrono::duration<float>(materials_end_time - materials_start_time).count(),
-			objects.size(),
-			std::chrono::duration<float>(meshes_end_time - meshes_start_time).count());
+	auto const stem = filename.substr(0u, extension_start);
+	for (auto const extension : {".ktx2", ".dds"})
+	{
+		auto const candidate = stem + extension;
+		if (std::ifstream(candidate).good())
+			return candidate;
+	}
 
-	return objects;
+	return filename;
 }
 
-GLuint
-bonobo::createTexture(uint32_t width, uint32_t height, GLenum target, GLint internal_format, GLenum format, GLenum type, GLvoid const *data)
+bool
+bonobo::isCompressedFormatSupported(texture_container::format block_format, bool is_srgb)
 {
-	GLuint texture = 0u;
-	glGenTextures(1, &texture);
-	assert(texture != 0u);
-	glBindTexture(target, texture);
-	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	switch (target)
+	switch (block_format)
 	{
-	case GL_TEXTURE_1D:
-		glTexImage1D(target, 0, internal_format, static_cast<GLsizei>(width), 0, format, type, data);
-		break;
-	case GL_TEXTURE_2D:
-		glTexImage2D(target, 0, internal_format, static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, format, type, data);
-		break;
-	default:
-		glDeleteTextures(1, &texture);
-		LogError("Non-handled texture target: %08x.\n", target);
-		return 0u;
+	case texture_container::format::bc1:
+	case texture_container::format::bc3:
+		return hasExtension("GL_EXT_texture_compression_s3tc") && (!is_srgb || hasExtension("GL_EXT_texture_sRGB"));
+	case texture_container::format::bc7:
+		return GLAD_GL_VERSION_4_2 || hasExtension("GL_ARB_texture_compression_bptc");
 	}
-	glBindTexture(target, 0u);
+	return false;
+}
 
-	return texture;
+void
+bonobo::uploadCompressedTexture2D(GLuint texture, texture_container::compressed_image const &image, GLvoid const *data)
+{
+	// Only borrowed: the caller keeps owning the texture.
+	bonobo::gl::texture borrowed(texture, GL_TEXTURE_2D);
+	auto const internal_format = getCompressedInternalFormat(image);
+	auto const levels_nb = static_cast<GLint>(image.levels.size());
+	borrowed.allocate(internal_format, static_cast<GLsizei>(image.width), static_cast<GLsizei>(image.height), levels_nb);
+	for (GLint i = 0; i < levels_nb; ++i)
+	{
+		auto const &level = image.levels[i];
+		borrowed.upload_compressed(i, static_cast<GLsizei>(level.width), static_cast<GLsizei>(level.height), internal_format,
+								   static_cast<GLsizei>(level.size), static_cast<GLubyte const *>(data) + level.offset);
+	}
+	borrowed.set_parameter(GL_TEXTURE_BASE_LEVEL, 0);
+	borrowed.set_parameter(GL_TEXTURE_MAX_LEVEL, levels_nb - 1);
+	borrowed.set_parameter(GL_TEXTURE_MIN_FILTER, levels_nb > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	borrowed.set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	borrowed.release();
 }
 
 GLuint
 bonobo::loadTexture2D(std::string const &filename, bool generate_mipmap)
 {
+	auto const load_start_time = std::chrono::high_resolution_clock::now();
+	auto const compressed_filename = findCompressedTexture(filename);
+
+	texture_container::compressed_image image;
+	bool is_compressed = texture_container::is_container(compressed_filename) && texture_container::read(compressed_filename, image);
+	if (is_compressed && !isCompressedFormatSupported(image.block_format, image.is_srgb))
+	{
+		LogWarning("Ignoring texture container \"%s\": %s%s textures are not supported by this OpenGL context.",
+				   compressed_filename.c_str(), texture_container::format_name(image.block_format), image.is_srgb ? " sRGB" : "");
+		is_compressed = false;
+	}
+	if (is_compressed)
+	{
+		auto texture = bonobo::gl::texture::create(GL_TEXTURE_2D, compressed_filename);
+		assert(texture);
+		uploadCompressedTexture2D(texture.get(), image, image.data.data());
+
+		LogTrivia("Texture \"%s\" loaded in %.3f ms: %ux%u %s%s with %zu levels, using %.1f KiB.",
+				  compressed_filename.c_str(),
+				  std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - load_start_time).count(),
+				  image.width, image.height, texture_container::format_name(image.block_format), image.is_srgb ? " sRGB" : "",
+				  image.levels.size(), static_cast<float>(image.data.size()) / 1024.0f);
+
+		return texture.release();
+	}
+	if (texture_container::is_container(filename))
+		return 0u;
+
 	std::uint32_t width, height;
 	auto const data = getTextureData(filename, width, height, true);
 	if (data.empty())
 		return 0u;
 
-	GLuint texture = bonobo::createTexture(width, height, GL_TEXTURE_2D, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<GLvoid const *>(data.data()));
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, generate_mipmap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	auto const texture_width = static_cast<GLsizei>(width);
+	auto const texture_height = static_cast<GLsizei>(height);
+	auto texture = bonobo::gl::texture::create_2d(GL_RGBA8, texture_width, texture_height,
+										  generate_mipmap ? bonobo::gl::get_levels_nb(texture_width, texture_height) : 1,
+										  filename);
+	assert(texture);
+	texture.upload(0, texture_width, texture_height, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+	texture.set_parameter(GL_TEXTURE_MIN_FILTER, generate_mipmap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	texture.set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	if (generate_mipmap)
-		glGenerateMipmap(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, 0u);
+		texture.generate_mipmap();
 
-	return texture;
+	// A full mipmap chain adds about a third to the base level.
+	auto const memory_usage = static_cast<float>(data.size()) * (generate_mipmap ? 4.0f / 3.0f : 1.0f);
+	LogTrivia("Texture \"%s\" loaded in %.3f ms: %ux%u RGBA8%s, using %.1f KiB.",
+			  filename.c_str(),
+			  std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - load_start_time).count(),
+			  width, height, generate_mipmap ? " with generated levels" : "", memory_usage / 1024.0f);
+
+	return texture.release();
 }
 
 GLuint
@@ -606,54 +619,46 @@ void bonobo::displayTexture(glm::vec2 const &lower_left, glm::vec2 const &upper_
 							   viewport_origin;
 
 	glViewport(viewport_origin.x, viewport_origin.y, viewport_size.x, viewport_size.y);
-	glUseProgram(local::fullscreen_shader);
+	auto &state = bonobo::gl::get_state_tracker();
+	state.use_program(local::fullscreen_shader);
 	glBindVertexArray(local::display_vao);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glBindSampler(0, sampler);
-	glUniform1i(glGetUniformLocation(local::fullscreen_shader, "tex"), 0);
-	glUniform4iv(glGetUniformLocation(local::fullscreen_shader, "swizzle"), 1, glm::value_ptr(swizzle));
-	glUniform1i(glGetUniformLocation(local::fullscreen_shader, "linearise"), linearise);
-	glUniform1f(glGetUniformLocation(local::fullscreen_shader, "near"), nearPlane);
-	glUniform1f(glGetUniformLocation(local::fullscreen_shader, "far"), farPlane);
+	state.bind_texture(0u, GL_TEXTURE_2D, texture);
+	state.bind_sampler(0u, sampler);
+	glUniform1i(state.get_uniform_location(local::fullscreen_shader, "tex"), 0);
+	glUniform4iv(state.get_uniform_location(local::fullscreen_shader, "swizzle"), 1, glm::value_ptr(swizzle));
+	glUniform1i(state.get_uniform_location(local::fullscreen_shader, "linearise"), linearise);
+	glUniform1f(state.get_uniform_location(local::fullscreen_shader, "near"), nearPlane);
+	glUniform1f(state.get_uniform_location(local::fullscreen_shader, "far"), farPlane);
 	glDrawArrays(GL_TRIANGLES, 0, 3);
-	glBindSampler(0, 0u);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glUseProgram(0);
 }
 
 GLuint
 bonobo::createFBO(std::vector<GLuint> const &color_attachments, GLuint depth_attachment)
 {
-	auto const attach = [](GLenum attach_point, GLuint attachment)
-	{
-		glFramebufferTexture2D(GL_FRAMEBUFFER, attach_point, GL_TEXTURE_2D, attachment, 0);
-		auto const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-		if (status != GL_FRAMEBUFFER_COMPLETE)
-			LogError("Failed to attach %u at %u", attachment, attach_point);
-	};
-
-	GLuint fbo = 0u;
-	glGenFramebuffers(1, &fbo);
-	assert(fbo != 0u);
-	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	auto fbo = bonobo::gl::framebuffer::create("FBO");
+	assert(fbo);
+	std::vector<GLenum> draw_buffers;
 	for (size_t i = 0; i < color_attachments.size(); ++i)
-		attach(static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i), color_attachments[i]);
+	{
+		draw_buffers.push_back(static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i));
+		fbo.attach(draw_buffers.back(), color_attachments[i]);
+	}
 	if (depth_attachment != 0u)
-		attach(GL_DEPTH_ATTACHMENT, depth_attachment);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		fbo.attach(GL_DEPTH_ATTACHMENT, depth_attachment);
+	if (!draw_buffers.empty())
+		fbo.set_draw_buffers(draw_buffers);
+	fbo.is_complete("FBO");
 
-	return fbo;
+	return fbo.release();
 }
 
 GLuint
 bonobo::createSampler(std::function<void(GLuint)> const &setup)
 {
-	GLuint sampler = 0u;
-	glGenSamplers(1, &sampler);
-	assert(sampler != 0u);
-	setup(sampler);
-	return sampler;
+	auto sampler = bonobo::gl::sampler::create("Sampler");
+	assert(sampler);
+	setup(sampler.get());
+	return sampler.release();
 }
 
 void bonobo::drawFullscreen()
@@ -674,7 +679,7 @@ void bonobo::renderBasis(float thickness_scale, float length_scale, glm::mat4 co
 	if (basis.shader == 0u)
 		return;
 
-	glUseProgram(basis.shader);
+	bonobo::gl::get_state_tracker().use_program(basis.shader);
 	glBindVertexArray(basis.vao);
 	glUniformMatrix4fv(basis.shader_locations.world, 1, GL_FALSE, glm::value_ptr(world));
 	glUniformMatrix4fv(basis.shader_locations.view_proj, 1, GL_FALSE, glm::value_ptr(view_projection));
@@ -682,7 +687,6 @@ void bonobo::renderBasis(float thickness_scale, float length_scale, glm::mat4 co
 	glUniform1f(basis.shader_locations.length_scale, length_scale);
 	glDrawElementsInstanced(GL_TRIANGLES, basis.index_count, GL_UNSIGNED_BYTE, nullptr, 3);
 	glBindVertexArray(0u);
-	glUseProgram(0u);
 }
 
 bool bonobo::uiSelectCullMode(std::string const &label, enum cull_mode_t &cull_mode) noexcept
@@ -845,13 +849,293 @@ namespace
 		const GLsizei debug_texture_height = 16;
 		std::array<std::uint32_t, debug_texture_width * debug_texture_height> debug_texture_content;
 		debug_texture_content.fill(0xFFE935DAu);
-		glGenTextures(1, &debug_texture_id);
-		glBindTexture(GL_TEXTURE_2D, debug_texture_id);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, debug_texture_width, debug_texture_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, debug_texture_content.data());
-		glBindTexture(GL_TEXTURE_2D, 0u);
-
-		utils::opengl::debug::nameObject(GL_TEXTURE, debug_texture_id, "Debug texture");
+		auto texture = bonobo::gl::texture::create_2d(GL_RGBA8, debug_texture_width, debug_texture_height, 1, "Debug texture");
+		texture.set_parameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		texture.set_parameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		texture.upload(0, debug_texture_width, debug_texture_height, GL_RGBA, GL_UNSIGNED_BYTE, debug_texture_content.data());
+		debug_texture_id = texture.release();
+	}
+
+	bonobo::mesh_data uploadMesh(bonobo::mesh_view const &mesh)
+	{
+		bonobo::mesh_data object;
+		object.name = mesh.name;
+		object.vertices_nb = static_cast<GLsizei>(mesh.vertices_nb);
+		object.indices_nb = static_cast<GLsizei>(mesh.indices_nb);
+		object.adjacency_nb = static_cast<GLsizei>(mesh.adjacency_nb);
+		object.material = mesh.material;
+
+		// Owned by |object| from now on, see `releaseObjects()`.
+		object.vao = bonobo::gl::vertex_array::create(object.name + " VAO").release();
+		assert(object.vao != 0u);
+		glBindVertexArray(object.vao);
+
+		object.bo = bonobo::gl::buffer::create(static_cast<GLsizeiptr>(mesh.vertex_data_size), mesh.vertex_data, 0u, object.name + " VBO").release();
+		assert(object.bo != 0u);
+		glBindBuffer(GL_ARRAY_BUFFER, object.bo);
+
+		setupVertexAttributes(mesh.attributes, mesh.name, {bonobo::shader_bindings::vertices, bonobo::shader_bindings::normals,
+		                                                   bonobo::shader_bindings::texcoords, bonobo::shader_bindings::tangents,
+		                                                   bonobo::shader_bindings::binormals});
+		object.are_directions_octahedral = mesh.attributes[static_cast<size_t>(bonobo::shader_bindings::normals)].type == bonobo::vertex_layout::format::octahedral_snorm16;
+
+		object.ibo = bonobo::gl::buffer::create(static_cast<GLsizeiptr>(mesh.adjacency_nb * sizeof(GLuint)), mesh.adjacency_indices, 0u, object.name + " IBO").release();
+		assert(object.ibo != 0u);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object.ibo);
+
+		// The edge-based silhouette passes walk over each edge once: the
+		// compute one reads the positions stream straight from the vertex
+		// buffer, while the geometry shader one draws the edges as
+		// GL_LINES_ADJACENCY through their own VAO, which only fetches
+		// what `NPR/silhouette.vert` reads.
+		object.positions_offset = static_cast<GLintptr>(std::max<std::int64_t>(mesh.attributes[static_cast<size_t>(bonobo::shader_bindings::vertices)].offset, 0));
+		if (mesh.edge_indices != nullptr && mesh.edges_nb != 0u)
+		{
+			object.edges_nb = static_cast<GLsizei>(mesh.edges_nb);
+
+			object.edges_vao = bonobo::gl::vertex_array::create(object.name + " edges VAO").release();
+			assert(object.edges_vao != 0u);
+			glBindVertexArray(object.edges_vao);
+			glBindBuffer(GL_ARRAY_BUFFER, object.bo);
+			setupVertexAttributes(mesh.attributes, mesh.name, {bonobo::shader_bindings::vertices, bonobo::shader_bindings::texcoords});
+
+			object.edges_bo = bonobo::gl::buffer::create(static_cast<GLsizeiptr>(mesh.edges_nb * 4u * sizeof(GLuint)), mesh.edge_indices, 0u, object.name + " edges").release();
+			assert(object.edges_bo != 0u);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object.edges_bo);
+		}
+
+		glBindVertexArray(0u);
+		glBindBuffer(GL_ARRAY_BUFFER, 0u);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
+
+		return object;
+	}
+	// Same layout as expected by glMultiDrawElementsIndirect().
+	struct DrawElementsIndirectCommand
+	{
+		GLuint count;
+		GLuint instance_count;
+		GLuint first_index;
+		GLint base_vertex;
+		GLuint base_instance;
+	};
+	static_assert(sizeof(DrawElementsIndirectCommand) == 5u * sizeof(GLuint), "DrawElementsIndirectCommand has to be tightly packed");
+
+	// Meshes can share a batch if their attributes only differ by how
+	// many vertices precede them: for each attribute, its format, its
+	// stride and its offset within its own stream.
+	using LayoutKey = std::array<std::int64_t, 15>;
+
+	LayoutKey getLayoutKey(bonobo::mesh_view const &mesh)
+	{
+		auto const positions_size = static_cast<std::int64_t>(mesh.vertices_nb) * mesh.attributes[0].stride;
+		LayoutKey key;
+		for (size_t a = 0u; a < mesh.attributes.size(); ++a)
+		{
+			auto const &attribute = mesh.attributes[a];
+			auto const is_present = attribute.offset >= 0;
+			key[3u * a] = is_present ? static_cast<std::int64_t>(attribute.type) : -1;
+			key[3u * a + 1u] = is_present ? attribute.stride : 0;
+			key[3u * a + 2u] = is_present ? attribute.offset - (a == 0u ? 0 : positions_size) : 0;
+		}
+		return key;
+	}
+
+	std::vector<bonobo::mesh_data> uploadBatches(std::vector<bonobo::mesh_view> const &meshes, std::vector<bonobo::mesh_batch> &batches)
+	{
+		std::vector<LayoutKey> keys;
+		std::vector<std::vector<size_t>> batches_meshes;
+		for (size_t i = 0u; i < meshes.size(); ++i)
+		{
+			auto const key = getLayoutKey(meshes[i]);
+			auto const match = std::find(keys.begin(), keys.end(), key);
+			if (match != keys.end())
+			{
+				batches_meshes[static_cast<size_t>(match - keys.begin())].push_back(i);
+				continue;
+			}
+			keys.push_back(key);
+			batches_meshes.push_back({i});
+		}
+
+		std::vector<bonobo::mesh_data> objects(meshes.size());
+		for (size_t b = 0u; b < batches_meshes.size(); ++b)
+		{
+			auto const &batch_meshes = batches_meshes[b];
+
+			// Vertex data of each mesh is its positions stream followed by
+			// its interleaved one, see `vertex_layout::build()`; the batch
+			// stores all positions streams, then all interleaved ones.
+			auto const &layout = meshes[batch_meshes.front()].attributes;
+			auto const positions_stride = static_cast<GLsizeiptr>(layout[0].stride);
+			GLsizeiptr interleaved_stride = 0;
+			for (size_t a = 1u; a < layout.size(); ++a)
+				if (layout[a].offset >= 0)
+					interleaved_stride = static_cast<GLsizeiptr>(layout[a].stride);
+
+			GLsizeiptr vertices_nb = 0, adjacency_nb = 0, edges_nb = 0;
+			for (auto const i : batch_meshes)
+			{
+				assert(layout[0].offset == 0 && meshes[i].vertex_data_size == meshes[i].vertices_nb * static_cast<size_t>(positions_stride + interleaved_stride));
+				vertices_nb += static_cast<GLsizeiptr>(meshes[i].vertices_nb);
+				adjacency_nb += static_cast<GLsizeiptr>(meshes[i].adjacency_nb);
+				if (meshes[i].edge_indices != nullptr)
+					edges_nb += static_cast<GLsizeiptr>(meshes[i].edges_nb);
+			}
+			auto const interleaved_start = vertices_nb * positions_stride;
+
+			bonobo::mesh_batch batch;
+			batch.name = "Batch " + std::to_string(b) + " (" + std::to_string(batch_meshes.size()) + " meshes)";
+			batch.draws_nb = static_cast<GLsizei>(batch_meshes.size());
+			auto const &normals = layout[static_cast<size_t>(bonobo::shader_bindings::normals)];
+			batch.are_directions_octahedral = normals.offset >= 0 && normals.type == bonobo::vertex_layout::format::octahedral_snorm16;
+
+			// The shared streams get filled mesh by mesh, hence their
+			// dynamic storage; all other buffers get their whole content
+			// at creation. Their ownership then goes to the batch, see
+			// `releaseBatches()`.
+			auto vertices = bonobo::gl::buffer::create(vertices_nb * (positions_stride + interleaved_stride), nullptr, GL_DYNAMIC_STORAGE_BIT, batch.name + " VBO");
+			GLint base_vertex = 0;
+			for (auto const i : batch_meshes)
+			{
+				auto const &mesh = meshes[i];
+				auto const positions_size = static_cast<GLsizeiptr>(mesh.vertices_nb) * positions_stride;
+				vertices.upload(base_vertex * positions_stride, positions_size, mesh.vertex_data);
+				if (interleaved_stride != 0)
+					vertices.upload(interleaved_start + base_vertex * interleaved_stride,
+									static_cast<GLsizeiptr>(mesh.vertices_nb) * interleaved_stride, mesh.vertex_data + positions_size);
+				base_vertex += static_cast<GLint>(mesh.vertices_nb);
+			}
+			batch.bo = vertices.release();
+
+			auto indices = bonobo::gl::buffer::create(adjacency_nb * static_cast<GLsizeiptr>(sizeof(GLuint)), nullptr, GL_DYNAMIC_STORAGE_BIT, batch.name + " IBO");
+			batch.ibo = indices.get();
+			bonobo::gl::buffer edges;
+			if (edges_nb != 0)
+			{
+				edges = bonobo::gl::buffer::create(edges_nb * 4 * static_cast<GLsizeiptr>(sizeof(GLuint)), nullptr, GL_DYNAMIC_STORAGE_BIT, batch.name + " edges");
+				batch.edges_bo = edges.get();
+			}
+
+			std::vector<DrawElementsIndirectCommand> commands(2u * batch_meshes.size());
+			std::vector<bonobo::draw_data> draws(batch_meshes.size());
+			std::vector<bonobo::meshlet_data> meshlets;
+			std::vector<DrawElementsIndirectCommand> meshlet_commands;
+			base_vertex = 0;
+			GLuint first_index = 0u, first_edge = 0u;
+			for (size_t d = 0u; d < batch_meshes.size(); ++d)
+			{
+				auto const &mesh = meshes[batch_meshes[d]];
+				auto const mesh_edges_nb = mesh.edge_indices != nullptr ? mesh.edges_nb : 0u;
+				indices.upload(static_cast<GLintptr>(first_index) * static_cast<GLintptr>(sizeof(GLuint)),
+							   static_cast<GLsizeiptr>(mesh.adjacency_nb * sizeof(GLuint)), mesh.adjacency_indices);
+				if (mesh_edges_nb != 0u)
+					edges.upload(static_cast<GLintptr>(first_edge) * 4 * static_cast<GLintptr>(sizeof(GLuint)),
+								 static_cast<GLsizeiptr>(mesh_edges_nb * 4u * sizeof(GLuint)), mesh.edge_indices);
+
+				auto const draw_index = static_cast<GLuint>(d);
+				commands[d] = {mesh.adjacency_nb, 1u, first_index, base_vertex, draw_index};
+				commands[batch_meshes.size() + d] = {mesh_edges_nb * 4u, 1u, first_edge * 4u, base_vertex, draw_index};
+				draws[d].diffuse_color = glm::vec4(mesh.material.diffuse, 1.0f);
+				draws[d].bounds_min = glm::vec4(mesh.bounds_min, 0.0f);
+				draws[d].bounds_max = glm::vec4(mesh.bounds_max, 0.0f);
+				for (std::uint32_t m = 0u; m < mesh.meshlets_nb; ++m)
+				{
+					auto const &meshlet = mesh.meshlets[m];
+					bonobo::meshlet_data data;
+					data.sphere = glm::vec4(meshlet.center, meshlet.radius);
+					data.cone = glm::vec4(meshlet.cone_axis, meshlet.cone_cutoff);
+					data.first_index = first_index + 6u * meshlet.first_triangle;
+					data.indices_nb = 6u * meshlet.triangles_nb;
+					data.base_vertex = base_vertex;
+					data.draw_index = draw_index;
+					meshlets.push_back(data);
+					meshlet_commands.push_back({data.indices_nb, 1u, data.first_index, base_vertex, draw_index});
+				}
+
+				auto &object = objects[batch_meshes[d]];
+				object.name = mesh.name;
+				object.vertices_nb = static_cast<GLsizei>(mesh.vertices_nb);
+				object.indices_nb = static_cast<GLsizei>(mesh.indices_nb);
+				object.adjacency_nb = static_cast<GLsizei>(mesh.adjacency_nb);
+				object.edges_nb = static_cast<GLsizei>(mesh_edges_nb);
+				object.material = mesh.material;
+				object.bo = batch.bo;
+				object.ibo = batch.ibo;
+				object.edges_bo = batch.edges_bo;
+				object.positions_offset = static_cast<GLintptr>(base_vertex) * positions_stride;
+				object.are_directions_octahedral = batch.are_directions_octahedral;
+				object.base_vertex = base_vertex;
+				object.first_index = first_index;
+				object.first_edge = first_edge;
+
+				base_vertex += static_cast<GLint>(mesh.vertices_nb);
+				first_index += mesh.adjacency_nb;
+				first_edge += mesh_edges_nb;
+			}
+
+			indices.release();
+			edges.release();
+
+			auto const commands_size = static_cast<GLsizeiptr>(commands.size() * sizeof(DrawElementsIndirectCommand));
+			batch.draw_commands_bo = bonobo::gl::buffer::create(commands_size, commands.data(), 0u, batch.name + " draw commands").release();
+			batch.draws_bo = bonobo::gl::buffer::create(static_cast<GLsizeiptr>(draws.size() * sizeof(bonobo::draw_data)), draws.data(), 0u, batch.name + " draws").release();
+			// Rewritten every frame by the culling pass; until then,
+			// everything is visible.
+			batch.culled_draw_commands_bo = bonobo::gl::buffer::create(commands_size, commands.data(), 0u, batch.name + " culled draw commands").release();
+			auto const visible_draws_nb = static_cast<GLuint>(batch.draws_nb);
+			batch.visible_draws_nb_bo = bonobo::gl::buffer::create(sizeof(GLuint), &visible_draws_nb, 0u, batch.name + " visible draws count").release();
+			// Same for the meshlets: until the meshlet culling pass runs,
+			// all of them get drawn.
+			batch.meshlets_nb = static_cast<GLsizei>(meshlets.size());
+			if (!meshlets.empty())
+			{
+				batch.meshlets_bo = bonobo::gl::buffer::create(static_cast<GLsizeiptr>(meshlets.size() * sizeof(bonobo::meshlet_data)), meshlets.data(), 0u,
+													   batch.name + " meshlets").release();
+				batch.meshlet_draw_commands_bo = bonobo::gl::buffer::create(static_cast<GLsizeiptr>(meshlet_commands.size() * sizeof(DrawElementsIndirectCommand)), meshlet_commands.data(), 0u,
+																	batch.name + " meshlet draw commands").release();
+				auto const visible_meshlets_nb = static_cast<GLuint>(batch.meshlets_nb);
+				batch.visible_meshlets_nb_bo = bonobo::gl::buffer::create(sizeof(GLuint), &visible_meshlets_nb, 0u, batch.name + " visible meshlets count").release();
+			}
+
+			// Both vertex arrays point at the start of the shared streams,
+			// each draw command then offsetting them by its base vertex.
+			auto batch_attributes = layout;
+			for (size_t a = 1u; a < batch_attributes.size(); ++a)
+				if (batch_attributes[a].offset >= 0)
+					batch_attributes[a].offset = interleaved_start + static_cast<std::int64_t>(keys[b][3u * a + 2u]);
+
+			batch.vao = bonobo::gl::vertex_array::create(batch.name + " VAO").release();
+			glBindVertexArray(batch.vao);
+			glBindBuffer(GL_ARRAY_BUFFER, batch.bo);
+			setupVertexAttributes(batch_attributes, batch.name, {bonobo::shader_bindings::vertices, bonobo::shader_bindings::normals,
+																 bonobo::shader_bindings::texcoords, bonobo::shader_bindings::tangents,
+																 bonobo::shader_bindings::binormals});
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch.ibo);
+			if (batch.edges_bo != 0u)
+			{
+				batch.edges_vao = bonobo::gl::vertex_array::create(batch.name + " edges VAO").release();
+				glBindVertexArray(batch.edges_vao);
+				setupVertexAttributes(batch_attributes, batch.name, {bonobo::shader_bindings::vertices, bonobo::shader_bindings::texcoords});
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch.edges_bo);
+			}
+			glBindVertexArray(0u);
+			glBindBuffer(GL_ARRAY_BUFFER, 0u);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
+
+			for (auto const i : batch_meshes)
+			{
+				objects[i].vao = batch.vao;
+				objects[i].edges_vao = batch.edges_vao;
+			}
+
+			LogTrivia("│ %s: %.2f MiB of vertices, %.2f MiB of indices, %d meshlets", batch.name.c_str(),
+					  static_cast<float>(vertices_nb * (positions_stride + interleaved_stride)) / static_cast<float>(1u << 20u),
+					  static_cast<float>((adjacency_nb + 4 * edges_nb) * static_cast<GLsizeiptr>(sizeof(GLuint))) / static_cast<float>(1u << 20u),
+					  batch.meshlets_nb);
+			batches.push_back(batch);
+		}
+
+		return objects;
 	}
 }
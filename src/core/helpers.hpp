@@ -5,12 +5,18 @@
 #include <glm/glm.hpp>
 
 #include "core/FPSCamera.h" // As it includes OpenGL headers, import it after glad
+#include "core/mesh_processing.hpp"
+#include "core/scene_data.hpp"
+#include "core/texture_container.hpp"
+#include "core/welding.hpp"
 
 #include <functional>
 #include <string>
 #include <vector>
 #include <unordered_map>
 
+class TextureStreamer;
+
 //! \brief Namespace containing a few helpers for the LUGG computer graphics labs.
 namespace bonobo
 {
@@ -30,17 +36,6 @@ namespace bonobo
 	using texture_bindings = std::unordered_map<std::string, GLuint>;
 	// using edge_map = std::unordered_map<Edge, GLuint>;
 
-	struct material_data
-	{
-		glm::vec3 diffuse{0.0f};
-		glm::vec3 specular{0.0f};
-		glm::vec3 ambient{0.0f};
-		glm::vec3 emissive{0.0f};
-		float shininess{0.0f};
-		float indexOfRefraction{1.0f};
-		float opacity{1.0f};
-	};
-
 	//! \brief Contains the data for a mesh in OpenGL.
 	struct mesh_data
 	{
@@ -50,12 +45,83 @@ namespace bonobo
 		GLsizei vertices_nb{0};			   //!< number of vertices stored in bo
 		GLsizei indices_nb{0};			   //!< number of indices stored in ibo
 		GLsizei adjacency_nb{0};		   //!< adjacencies for the mesh
+		GLuint edges_vao{0u};			   //!< OpenGL name of the Vertex Array Object drawing edges_bo as GL_LINES_ADJACENCY
+		GLuint edges_bo{0u};			   //!< OpenGL name of the Buffer Object listing each edge once, see `adjacency::extract_edges()`
+		GLsizei edges_nb{0};			   //!< number of edges stored in edges_bo; 0 if loaded without edges
+		GLintptr positions_offset{0};	   //!< offset in bytes of the vertex positions within bo
+		bool are_directions_octahedral{false}; //!< whether normals, tangents and binormals are octahedral-encoded, see `vertex_layout`
+		GLint base_vertex{0};			   //!< index of the first vertex of the mesh within bo; non-zero for meshes of a `mesh_batch`
+		GLuint first_index{0u};			   //!< index of the first adjacency index of the mesh within ibo
+		GLuint first_edge{0u};			   //!< index of the first edge of the mesh within edges_bo
 		texture_bindings bindings{};	   //!< texture bindings for this mesh
+		texture_bindings pending_bindings{}; //!< textures still being streamed in, bound to the debug texture in |bindings| meanwhile
 		material_data material{};		   //!< constant values for the material of this mesh
 		GLenum drawing_mode{GL_TRIANGLES}; //!< OpenGL drawing mode, i.e. GL_TRIANGLES, GL_LINES, etc.
 		std::string name{"un-named mesh"}; //!< Name of the mesh; used for debugging purposes.
 	};
 
+	//! \brief Per-draw data of a mesh in a `mesh_batch`, as read by the
+	//!        shaders through the base instance of its draw command; laid
+	//!        out as in std430.
+	struct draw_data
+	{
+		glm::mat4 vertex_model_to_world{1.0f};
+		glm::mat4 normal_model_to_world{1.0f};
+		glm::vec4 diffuse_color{0.0f};
+		glm::vec4 bounds_min{0.0f}; //!< model-space bounding box of the mesh, used for culling; w is unused
+		glm::vec4 bounds_max{0.0f};
+	};
+
+	//! \brief SSBO binding point `draw_data` are read from.
+	constexpr GLuint draw_data_binding = 4u;
+
+	//! \brief A meshlet of a mesh in a `mesh_batch`, as read by the
+	//!        meshlet culling pass; laid out as in std430.
+	struct meshlet_data
+	{
+		glm::vec4 sphere{0.0f};	//!< model-space centre of the bounding sphere, and its radius in w
+		glm::vec4 cone{0.0f};	//!< axis of the normal cone, and the sine of its half-angle in w; see `meshlets::meshlet`
+		GLuint first_index{0u}; //!< index of the first adjacency index of the meshlet within the batch's ibo
+		GLuint indices_nb{0u};
+		GLint base_vertex{0};	//!< of the mesh the meshlet belongs to
+		GLuint draw_index{0u};	//!< index of the `draw_data` of that mesh
+	};
+
+	//! \brief Meshes sharing a vertex layout, whose vertices and indices
+	//!        are stored in shared buffers, so that each pass draws all of
+	//!        them with a single glMultiDrawElementsIndirect().
+	//!
+	//! The `mesh_data` of the meshes in a batch reference its vertex
+	//! array objects and buffers, offsetting into them through
+	//! `base_vertex`, `first_index` and `first_edge`; the i-th command of
+	//! |draw_commands_bo| draws the i-th mesh, and has i as its base
+	//! instance, which the shaders use to look up its `draw_data` in
+	//! |draws_bo|. Going through the base instance rather than
+	//! `gl_DrawID` keeps that lookup valid once culling compacted the
+	//! commands of the visible meshes into |culled_draw_commands_bo|.
+	struct mesh_batch
+	{
+		GLuint vao{0u};				  //!< OpenGL name of the Vertex Array Object drawing the adjacency indices
+		GLuint edges_vao{0u};		  //!< OpenGL name of the Vertex Array Object drawing the edges as GL_LINES_ADJACENCY
+		GLuint bo{0u};				  //!< shared vertex buffer: every positions stream, then every interleaved stream
+		GLuint ibo{0u};				  //!< shared adjacency index buffer
+		GLuint edges_bo{0u};		  //!< shared edge index buffer; 0 if loaded without edges
+		GLuint draw_commands_bo{0u};  //!< |draws_nb| DrawElementsIndirectCommands for the adjacency indices, then as many for the edges
+		GLuint draws_bo{0u};		  //!< one `draw_data` per mesh
+		GLuint culled_draw_commands_bo{0u}; //!< same layout as |draw_commands_bo|, filled by the culling pass with the commands of visible meshes first, then zeroes
+		GLuint visible_draws_nb_bo{0u};	  //!< a single GLuint, number of visible meshes written by the culling pass
+		GLuint meshlets_bo{0u};		  //!< one `meshlet_data` per meshlet of every mesh
+		GLuint meshlet_draw_commands_bo{0u}; //!< |meshlets_nb| DrawElementsIndirectCommands for the adjacency indices, filled by the meshlet culling pass with the meshlets which may hold silhouette edges first, then zeroes
+		GLuint visible_meshlets_nb_bo{0u};   //!< a single GLuint, number of meshlets kept by the meshlet culling pass
+		GLsizei draws_nb{0};		  //!< number of meshes in the batch
+		GLsizei meshlets_nb{0};		  //!< number of meshlets of all meshes in the batch
+		bool are_directions_octahedral{false};
+		std::string name{"un-named batch"};
+
+		//! \brief Byte offset of the edge commands in |draw_commands_bo|.
+		GLintptr edge_commands_offset() const { return static_cast<GLintptr>(draws_nb) * 5 * static_cast<GLintptr>(sizeof(GLuint)); }
+	};
+
 	enum class cull_mode_t : unsigned int
 	{
 		disabled = 0u,
@@ -79,22 +145,78 @@ namespace bonobo
 	//! \brief Load objects found in an object/scene file, using assimp.
 	//!
 	//! @param [in] filename of the object/scene file to load.
+	//! @param [in] weld_config how to merge vertices sharing a position
+	//!             before looking for adjacent triangles
+	//! @param [in] with_edges whether to also list each edge once, in
+	//!             `edges_bo`, for the edge-based silhouette passes
+	//! @param [in] layout_config how to encode the vertex attributes
+	//! @param [in] cache_config whether and how to reorder triangles and
+	//!             vertices for the vertex cache
 	//! @return a vector of filled in `mesh_data` structures, one per
 	//!         object found in the input file
-	std::vector<mesh_data> loadObjects(std::string const &filename);
+	std::vector<mesh_data> loadObjects(std::string const &filename,
+									   welding::config const &weld_config = welding::config{},
+									   bool with_edges = true,
+									   vertex_layout::config const &layout_config = vertex_layout::config{},
+									   vertex_cache::config const &cache_config = vertex_cache::config{});
+
+	//! \brief Create the OpenGL objects for a scene processed by
+	//!        `loadSceneData()`, loading its textures along the way.
+	//!
+	//! @param [in] scene the processed scene
+	//! @param [in] texture_streamer if set, textures are requested from it
+	//!             rather than loaded right away, and meshes list them in
+	//!             `pending_bindings` until `resolvePendingTextures()`
+	//!             finds them resident
+	//! @param [out] batches if set, meshes are grouped by vertex layout
+	//!              into `mesh_batch`es appended to it, rather than
+	//!              getting buffers of their own; release them with
+	//!              `releaseBatches()`
+	//! @return a vector of filled in `mesh_data` structures, one per
+	//!         mesh of the scene
+	std::vector<mesh_data> uploadSceneData(scene_data const &scene,
+										   TextureStreamer *texture_streamer = nullptr,
+										   std::vector<mesh_batch> *batches = nullptr);
+
+	//! \brief Swap the placeholders of streamed textures which became
+	//!        resident for the actual textures.
+	//!
+	//! @return true once no mesh has pending textures left
+	bool resolvePendingTextures(std::vector<mesh_data> &objects,
+								TextureStreamer const &texture_streamer);
+
+	//! \brief Delete the OpenGL objects of meshes returned by
+	//!        `loadObjects()` or `uploadSceneData()`, including their
+	//!        textures, and clear |objects|.
+	//!
+	//! @param [in] texture_streamer the streamer the textures were
+	//!             requested from, if any, to cancel pending ones
+	void releaseObjects(std::vector<mesh_data> &objects,
+						TextureStreamer *texture_streamer = nullptr);
 
-	//! \brief Creates an OpenGL texture without any content nor parameters.
+	//! \brief Delete the draw commands and per-draw data of batches
+	//!        filled by `uploadSceneData()`, and clear |batches|; their
+	//!        vertex arrays and buffers are shared with, and released
+	//!        along, their meshes by `releaseObjects()`.
+	void releaseBatches(std::vector<mesh_batch> &batches);
+
+	//! \brief Creates an OpenGL texture with immutable storage for a
+	//!        single level, and nearest filtering.
+	//!
+	//! See `gl::texture` for finer control over the levels and
+	//! parameters, and for a texture deleted along with its owner.
 	//!
 	//! @param [in] width width of the texture to create
 	//! @param [in] height height of the texture to create
 	//! @param [in] target OpenGL texture target to create, i.e.
 	//!             GL_TEXTURE_2D & co.
 	//! @param [in] internal_format formatting of the texture, i.e. how many
-	//!             channels
+	//!             channels; unsized formats like GL_RGBA get 8 bits per
+	//!             channel
 	//! @param [in] format formatting of the pixel data, i.e. in which
 	//!             layout are the channels stored
 	//! @param [in] type data type of the pixel data
-	//! @param [in] data what to put in the texture
+	//! @param [in] data what to put in the texture, if not null
 	GLuint createTexture(uint32_t width, uint32_t height,
 						 GLenum target = GL_TEXTURE_2D,
 						 GLint internal_format = GL_RGBA,
@@ -102,10 +224,76 @@ namespace bonobo
 						 GLenum type = GL_UNSIGNED_BYTE,
 						 GLvoid const *data = nullptr);
 
+	//! \brief Decode an image file into RGBA8 texels, without touching
+	//!        OpenGL; safe to call from any thread.
+	//!
+	//! If the image can not be loaded, a blank 16×16 image is returned
+	//! instead.
+	//!
+	//! @param [in] filename of the image.
+	//! @param [out] width width of the decoded image
+	//! @param [out] height height of the decoded image
+	//! @param [in] flip whether to flip the image vertically
+	//! @return the texels, row by row
+	std::vector<std::uint8_t> getTextureData(std::string const &filename,
+											 std::uint32_t &width, std::uint32_t &height,
+											 bool flip);
+
+	//! \brief Encode RGBA8 texels into a PNG file, without touching
+	//!        OpenGL; safe to call from any thread.
+	//!
+	//! @param [in] filename of the PNG file to write
+	//! @param [in] width width of the image
+	//! @param [in] height height of the image
+	//! @param [in] texels the texels, row by row, bottom row first as
+	//!             returned by `glReadPixels()`
+	//! @return false if the file could not be written
+	bool writePNG(std::string const &filename,
+				  std::uint32_t width, std::uint32_t height,
+				  std::uint8_t const *texels);
+
+	//! \brief Find the block-compressed version of an image, produced by
+	//!        the `texture_transcoder` tool.
+	//!
+	//! @param [in] filename of the image.
+	//! @return the `.ktx2` or `.dds` file sitting next to |filename| with
+	//!         the same stem, if any, or |filename| otherwise
+	std::string findCompressedTexture(std::string const &filename);
+
+	//! \brief Whether the current OpenGL context can sample textures of a
+	//!        block-compressed format.
+	//!
+	//! BC1 and BC3 need GL_EXT_texture_compression_s3tc, along with
+	//! GL_EXT_texture_sRGB for their sRGB variants, while BC7 is core since
+	//! OpenGL 4.2. Must be called from the thread owning the OpenGL
+	//! context.
+	bool isCompressedFormatSupported(texture_container::format block_format, bool is_srgb);
+
+	//! \brief Give a 2D-texture immutable storage for all the levels of a
+	//!        block-compressed image, and fill them.
+	//!
+	//! @param [in] texture a 2D-texture without any storage yet, which
+	//!             does not need to be bound
+	//! @param [in] image the block-compressed image.
+	//! @param [in] data where the blocks of |image| start: a pointer to
+	//!             `image.data`, or an offset into the buffer currently
+	//!             bound to GL_PIXEL_UNPACK_BUFFER
+	void uploadCompressedTexture2D(GLuint texture,
+								   texture_container::compressed_image const &image,
+								   GLvoid const *data);
+
 	//! \brief Load an image into an OpenGL 2D-texture.
 	//!
+	//! Block-compressed DDS and KTX2 containers are uploaded as is, with
+	//! their own mipmap chain. For other images, a container produced by
+	//! `texture_transcoder` is picked instead when there is one, see
+	//! `findCompressedTexture()`, unless the OpenGL context does not
+	//! support its format.
+	//!
 	//! @param [in] filename of the image.
-	//! @param [in] generate_mipmap whether or not to generate a mipmap hierarchy
+	//! @param [in] generate_mipmap whether or not to generate a mipmap
+	//!             hierarchy; ignored for block-compressed images, which
+	//!             only use the levels they come with
 	//! @return the name of the OpenGL 2D-texture
 	GLuint loadTexture2D(std::string const &filename,
 						 bool generate_mipmap = true);
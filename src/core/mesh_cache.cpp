@@ -0,0 +1,450 @@
+#include "mesh_cache.hpp"
+
+#include "core/Log.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <utility>
+
+namespace
+{
+	// Bump whenever the layout below, or the way `loadObjects()` bakes
+	// meshes, changes: older caches will then be rebuilt.
+	constexpr std::uint32_t format_version = 7u;
+	constexpr char format_magic[8] = {'N', 'P', 'R', 'M', 'E', 'S', 'H', '\0'};
+
+	// Blobs are aligned so that they can be read in place from the
+	// mapping, which itself starts on a page boundary.
+	constexpr std::uint64_t blob_alignment = 16u;
+
+	constexpr std::size_t material_floats_nb = 15u;
+
+	struct string_ref
+	{
+		std::uint32_t offset;
+		std::uint32_t length;
+	};
+
+	struct file_header
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t importer_flags;
+		std::uint64_t source_hash;
+		std::uint64_t source_size;
+		std::uint32_t weld_mode;
+		float weld_epsilon;
+		std::uint32_t meshes_nb;
+		std::uint32_t textures_nb;
+		std::uint32_t with_edges;
+		std::uint32_t directions_format;
+		std::uint32_t texcoords_format;
+		std::uint32_t vertex_cache_size; // 0 if triangles and vertices were not reordered
+		std::uint32_t dependencies_nb;
+		std::uint32_t padding;
+		std::uint64_t strings_offset;
+		std::uint64_t strings_size;
+		std::uint64_t file_size;
+	};
+
+	struct mesh_record
+	{
+		string_ref name;
+		std::uint32_t vertices_nb;
+		std::uint32_t indices_nb;
+		std::uint32_t adjacency_nb;
+		std::uint32_t first_texture;
+		std::uint32_t textures_nb;
+		std::uint32_t edges_nb;
+		std::uint64_t vertex_data_offset;
+		std::uint64_t vertex_data_size;
+		std::uint64_t adjacency_offset;
+		std::uint64_t edges_offset;
+		std::uint64_t meshlets_offset;
+		std::int64_t attribute_offsets[5];
+		std::uint32_t attribute_strides[5];
+		std::uint32_t attribute_formats[5];
+		float material[material_floats_nb];
+		float bounds[6]; // minimum then maximum corner
+		std::uint32_t meshlets_nb;
+	};
+
+	struct texture_record
+	{
+		string_ref sampler;
+		string_ref path;
+		string_ref label;
+	};
+
+	struct dependency_record
+	{
+		string_ref path;
+		std::uint32_t exists;
+		std::uint32_t padding;
+		std::uint64_t hash;
+		std::uint64_t size;
+	};
+
+	static_assert(std::is_trivially_copyable<file_header>::value && sizeof(file_header) == 96u, "file_header layout changed");
+	static_assert(std::is_trivially_copyable<mesh_record>::value && sizeof(mesh_record) == 240u, "mesh_record layout changed");
+	static_assert(sizeof(texture_record) == 24u, "texture_record layout changed");
+	static_assert(std::is_trivially_copyable<dependency_record>::value && sizeof(dependency_record) == 32u, "dependency_record layout changed");
+	static_assert(std::is_trivially_copyable<bonobo::meshlets::meshlet>::value && sizeof(bonobo::meshlets::meshlet) == 40u, "meshlet layout changed");
+
+	std::uint64_t alignUp(std::uint64_t value)
+	{
+		return (value + blob_alignment - 1u) & ~(blob_alignment - 1u);
+	}
+
+	void packMaterial(bonobo::material_data const& material, float* floats)
+	{
+		std::size_t i = 0u;
+		for (auto const& color : {material.diffuse, material.specular, material.ambient, material.emissive})
+			for (int c = 0; c < 3; ++c)
+				floats[i++] = color[c];
+		floats[i++] = material.shininess;
+		floats[i++] = material.indexOfRefraction;
+		floats[i++] = material.opacity;
+	}
+
+	bonobo::material_data unpackMaterial(float const* floats)
+	{
+		bonobo::material_data material;
+		material.diffuse = glm::vec3(floats[0], floats[1], floats[2]);
+		material.specular = glm::vec3(floats[3], floats[4], floats[5]);
+		material.ambient = glm::vec3(floats[6], floats[7], floats[8]);
+		material.emissive = glm::vec3(floats[9], floats[10], floats[11]);
+		material.shininess = floats[12];
+		material.indexOfRefraction = floats[13];
+		material.opacity = floats[14];
+		return material;
+	}
+
+	bool isInFile(std::uint64_t offset, std::uint64_t size, std::uint64_t file_size)
+	{
+		return offset <= file_size && size <= file_size - offset;
+	}
+
+	bonobo::mesh_cache::dependency readDependency(std::string const& path)
+	{
+		bonobo::mesh_cache::dependency result;
+		result.path = path;
+		utils::MappedFile const file(path);
+		if (file.is_open()) {
+			result.exists = true;
+			result.hash = utils::hash_bytes(file.data(), file.size());
+			result.size = file.size();
+		}
+		return result;
+	}
+
+	//! \brief Check |file| is a cache matching |expected_key|, and fill
+	//!        in |meshes| with views into it.
+	//!
+	//! @return nullptr on success, or why the cache was rejected
+	char const* parseCache(utils::MappedFile const& file, bonobo::mesh_cache::key const& expected_key,
+	                       std::vector<bonobo::mesh_view>& meshes)
+	{
+		auto const* const base = file.data();
+		auto const file_size = static_cast<std::uint64_t>(file.size());
+
+		if (file_size < sizeof(file_header))
+			return "file is truncated";
+
+		file_header header;
+		std::memcpy(&header, base, sizeof(header));
+		if (std::memcmp(header.magic, format_magic, sizeof(format_magic)) != 0)
+			return "not a mesh cache";
+		if (header.version != format_version)
+			return "it was written by another version";
+		if (header.file_size != file_size)
+			return "file is truncated";
+		if (header.source_hash != expected_key.source_hash
+		 || header.source_size != expected_key.source_size)
+			return "the scene file changed since it was written";
+		if (header.importer_flags != expected_key.importer_flags
+		 || header.weld_mode != static_cast<std::uint32_t>(expected_key.weld_config.mode)
+		 || header.weld_epsilon != expected_key.weld_config.epsilon
+		 || header.with_edges != (expected_key.with_edges ? 1u : 0u)
+		 || header.directions_format != static_cast<std::uint32_t>(expected_key.layout_config.directions)
+		 || header.texcoords_format != static_cast<std::uint32_t>(expected_key.layout_config.texcoords)
+		 || header.vertex_cache_size != (expected_key.cache_config.is_enabled ? expected_key.cache_config.cache_size : 0u))
+			return "it was baked with different import settings";
+
+		auto const meshes_offset = static_cast<std::uint64_t>(sizeof(file_header));
+		auto const textures_offset = meshes_offset + header.meshes_nb * static_cast<std::uint64_t>(sizeof(mesh_record));
+		auto const dependencies_offset = textures_offset + header.textures_nb * static_cast<std::uint64_t>(sizeof(texture_record));
+		if (!isInFile(meshes_offset, header.meshes_nb * static_cast<std::uint64_t>(sizeof(mesh_record)), file_size)
+		 || !isInFile(textures_offset, header.textures_nb * static_cast<std::uint64_t>(sizeof(texture_record)), file_size)
+		 || !isInFile(dependencies_offset, header.dependencies_nb * static_cast<std::uint64_t>(sizeof(dependency_record)), file_size)
+		 || !isInFile(header.strings_offset, header.strings_size, file_size))
+			return "file is corrupted";
+
+		auto const* const strings = reinterpret_cast<char const*>(base + header.strings_offset);
+		bool strings_valid = true;
+		auto const readString = [strings, &header, &strings_valid](string_ref const& ref) {
+			if (!isInFile(ref.offset, ref.length, header.strings_size)) {
+				strings_valid = false;
+				return std::string();
+			}
+			return std::string(strings + ref.offset, ref.length);
+		};
+
+		for (std::uint32_t i = 0u; i < header.dependencies_nb; ++i) {
+			dependency_record record;
+			std::memcpy(&record, base + dependencies_offset + i * sizeof(dependency_record), sizeof(record));
+			auto const path = readString(record.path);
+			if (!strings_valid)
+				return "file is corrupted";
+			auto const current = readDependency(path);
+			if (current.exists != (record.exists != 0u) || current.size != record.size || current.hash != record.hash)
+				return "a file the scene depends on changed since it was written";
+		}
+
+		meshes.resize(header.meshes_nb);
+		for (std::uint32_t i = 0u; i < header.meshes_nb; ++i) {
+			mesh_record record;
+			std::memcpy(&record, base + meshes_offset + i * sizeof(mesh_record), sizeof(record));
+
+			if (!isInFile(record.vertex_data_offset, record.vertex_data_size, file_size)
+			 || !isInFile(record.adjacency_offset, record.adjacency_nb * static_cast<std::uint64_t>(sizeof(std::uint32_t)), file_size)
+			 || record.adjacency_offset % alignof(std::uint32_t) != 0u
+			 || !isInFile(record.edges_offset, record.edges_nb * 4u * static_cast<std::uint64_t>(sizeof(std::uint32_t)), file_size)
+			 || record.edges_offset % alignof(std::uint32_t) != 0u
+			 || !isInFile(record.meshlets_offset, record.meshlets_nb * static_cast<std::uint64_t>(sizeof(bonobo::meshlets::meshlet)), file_size)
+			 || record.meshlets_offset % alignof(bonobo::meshlets::meshlet) != 0u
+			 || record.first_texture > header.textures_nb
+			 || record.textures_nb > header.textures_nb - record.first_texture)
+				return "file is corrupted";
+			bonobo::vertex_layout::attributes attributes;
+			for (std::size_t a = 0u; a < attributes.size(); ++a) {
+				attributes[a].offset = record.attribute_offsets[a];
+				attributes[a].stride = record.attribute_strides[a];
+				attributes[a].type = static_cast<bonobo::vertex_layout::format>(record.attribute_formats[a]);
+				if (!bonobo::vertex_layout::fits(attributes[a], record.vertices_nb, record.vertex_data_size))
+					return "file is corrupted";
+			}
+
+			auto& mesh = meshes[i];
+			mesh.name = readString(record.name);
+			mesh.vertex_data = base + record.vertex_data_offset;
+			mesh.vertex_data_size = static_cast<std::size_t>(record.vertex_data_size);
+			mesh.vertices_nb = record.vertices_nb;
+			mesh.indices_nb = record.indices_nb;
+			mesh.adjacency_indices = reinterpret_cast<std::uint32_t const*>(base + record.adjacency_offset);
+			mesh.adjacency_nb = record.adjacency_nb;
+			mesh.edge_indices = record.edges_nb != 0u ? reinterpret_cast<std::uint32_t const*>(base + record.edges_offset) : nullptr;
+			mesh.edges_nb = record.edges_nb;
+			mesh.meshlets = record.meshlets_nb != 0u ? reinterpret_cast<bonobo::meshlets::meshlet const*>(base + record.meshlets_offset) : nullptr;
+			mesh.meshlets_nb = record.meshlets_nb;
+			mesh.attributes = attributes;
+			mesh.bounds_min = glm::vec3(record.bounds[0], record.bounds[1], record.bounds[2]);
+			mesh.bounds_max = glm::vec3(record.bounds[3], record.bounds[4], record.bounds[5]);
+			mesh.material = unpackMaterial(record.material);
+
+			mesh.textures.reserve(record.textures_nb);
+			for (std::uint32_t t = record.first_texture; t < record.first_texture + record.textures_nb; ++t) {
+				texture_record texture;
+				std::memcpy(&texture, base + textures_offset + t * sizeof(texture_record), sizeof(texture));
+				mesh.textures.push_back({readString(texture.sampler), readString(texture.path), readString(texture.label)});
+			}
+		}
+
+		if (!strings_valid)
+			return "file is corrupted";
+
+		return nullptr;
+	}
+}
+
+std::string
+bonobo::mesh_cache::path_for(std::string const& filename)
+{
+	return filename + ".nprmesh";
+}
+
+bool
+bonobo::mesh_cache::make_key(std::string const& filename, std::uint32_t importer_flags,
+                             welding::config const& weld_config, bool with_edges,
+                             vertex_layout::config const& layout_config,
+                             vertex_cache::config const& cache_config, key& cache_key)
+{
+	utils::MappedFile const source(filename);
+	if (!source.is_open())
+		return false;
+
+	cache_key.source_hash = utils::hash_bytes(source.data(), source.size());
+	cache_key.source_size = source.size();
+	cache_key.importer_flags = importer_flags;
+	cache_key.weld_config = weld_config;
+	cache_key.with_edges = with_edges;
+	cache_key.layout_config = layout_config;
+	cache_key.cache_config = cache_config;
+	cache_key.dependencies.clear();
+	return true;
+}
+
+void
+bonobo::mesh_cache::add_dependencies(std::string const& filename, std::vector<std::string> const& paths, key& cache_key)
+{
+	for (auto const& path : paths) {
+		auto const is_listed = std::any_of(cache_key.dependencies.begin(), cache_key.dependencies.end(),
+		                                   [&path](dependency const& listed) { return listed.path == path; });
+		if (path != filename && !is_listed)
+			cache_key.dependencies.push_back(readDependency(path));
+	}
+}
+
+bool
+bonobo::mesh_cache::read(std::string const& path, key const& expected_key, scene_data& scene)
+{
+	utils::MappedFile file(path);
+	if (!file.is_open())
+		return false;
+
+	std::vector<mesh_view> meshes;
+	auto const reason = parseCache(file, expected_key, meshes);
+	if (reason != nullptr) {
+		LogWarning("Ignoring mesh cache \"%s\": %s.", path.c_str(), reason);
+		return false;
+	}
+
+	scene.meshes = std::move(meshes);
+	scene.cache_file = std::move(file);
+	return true;
+}
+
+bool
+bonobo::mesh_cache::write(std::string const& path, key const& cache_key, std::vector<mesh_view> const& meshes)
+{
+	std::string strings;
+	auto const addString = [&strings](std::string const& value) {
+		auto const ref = string_ref{static_cast<std::uint32_t>(strings.size()), static_cast<std::uint32_t>(value.size())};
+		strings += value;
+		return ref;
+	};
+
+	std::vector<mesh_record> mesh_records(meshes.size());
+	std::vector<texture_record> texture_records;
+	for (std::size_t i = 0u; i < meshes.size(); ++i) {
+		auto const& mesh = meshes[i];
+		auto& record = mesh_records[i];
+		std::memset(&record, 0, sizeof(record));
+		record.name = addString(mesh.name);
+		record.vertices_nb = mesh.vertices_nb;
+		record.indices_nb = mesh.indices_nb;
+		record.adjacency_nb = mesh.adjacency_nb;
+		record.edges_nb = mesh.edge_indices != nullptr ? mesh.edges_nb : 0u;
+		record.meshlets_nb = mesh.meshlets != nullptr ? mesh.meshlets_nb : 0u;
+		record.first_texture = static_cast<std::uint32_t>(texture_records.size());
+		record.textures_nb = static_cast<std::uint32_t>(mesh.textures.size());
+		record.vertex_data_size = mesh.vertex_data_size;
+		for (std::size_t a = 0u; a < mesh.attributes.size(); ++a) {
+			record.attribute_offsets[a] = mesh.attributes[a].offset;
+			record.attribute_strides[a] = mesh.attributes[a].stride;
+			record.attribute_formats[a] = static_cast<std::uint32_t>(mesh.attributes[a].type);
+		}
+		packMaterial(mesh.material, record.material);
+		for (int c = 0; c < 3; ++c) {
+			record.bounds[c] = mesh.bounds_min[c];
+			record.bounds[3 + c] = mesh.bounds_max[c];
+		}
+
+		for (auto const& texture : mesh.textures)
+			texture_records.push_back({addString(texture.sampler), addString(texture.path), addString(texture.label)});
+	}
+
+	std::vector<dependency_record> dependency_records;
+	dependency_records.reserve(cache_key.dependencies.size());
+	for (auto const& dependency : cache_key.dependencies)
+		dependency_records.push_back({addString(dependency.path), dependency.exists ? 1u : 0u, 0u, dependency.hash, dependency.size});
+
+	file_header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, format_magic, sizeof(format_magic));
+	header.version = format_version;
+	header.importer_flags = cache_key.importer_flags;
+	header.source_hash = cache_key.source_hash;
+	header.source_size = cache_key.source_size;
+	header.weld_mode = static_cast<std::uint32_t>(cache_key.weld_config.mode);
+	header.weld_epsilon = cache_key.weld_config.epsilon;
+	header.with_edges = cache_key.with_edges ? 1u : 0u;
+	header.directions_format = static_cast<std::uint32_t>(cache_key.layout_config.directions);
+	header.texcoords_format = static_cast<std::uint32_t>(cache_key.layout_config.texcoords);
+	header.vertex_cache_size = cache_key.cache_config.is_enabled ? cache_key.cache_config.cache_size : 0u;
+	header.meshes_nb = static_cast<std::uint32_t>(mesh_records.size());
+	header.textures_nb = static_cast<std::uint32_t>(texture_records.size());
+	header.dependencies_nb = static_cast<std::uint32_t>(dependency_records.size());
+	header.strings_offset = sizeof(file_header) + mesh_records.size() * sizeof(mesh_record) + texture_records.size() * sizeof(texture_record)
+	                      + dependency_records.size() * sizeof(dependency_record);
+	header.strings_size = strings.size();
+
+	// Lay the blobs out after the string table.
+	auto offset = alignUp(header.strings_offset + header.strings_size);
+	for (std::size_t i = 0u; i < meshes.size(); ++i) {
+		mesh_records[i].vertex_data_offset = offset;
+		offset = alignUp(offset + meshes[i].vertex_data_size);
+		mesh_records[i].adjacency_offset = offset;
+		offset = alignUp(offset + meshes[i].adjacency_nb * static_cast<std::uint64_t>(sizeof(std::uint32_t)));
+		mesh_records[i].edges_offset = offset;
+		offset = alignUp(offset + mesh_records[i].edges_nb * 4u * static_cast<std::uint64_t>(sizeof(std::uint32_t)));
+		mesh_records[i].meshlets_offset = offset;
+		offset = alignUp(offset + mesh_records[i].meshlets_nb * static_cast<std::uint64_t>(sizeof(meshlets::meshlet)));
+	}
+	header.file_size = offset;
+
+	auto const temporary_path = path + ".tmp";
+	{
+		std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			LogWarning("Failed to create mesh cache \"%s\".", temporary_path.c_str());
+			return false;
+		}
+
+		static char const padding[blob_alignment] = {};
+		auto const padTo = [&file](std::uint64_t position) {
+			auto const current = static_cast<std::uint64_t>(file.tellp());
+			file.write(padding, static_cast<std::streamsize>(position - current));
+		};
+
+		file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+		file.write(reinterpret_cast<char const*>(mesh_records.data()), static_cast<std::streamsize>(mesh_records.size() * sizeof(mesh_record)));
+		file.write(reinterpret_cast<char const*>(texture_records.data()), static_cast<std::streamsize>(texture_records.size() * sizeof(texture_record)));
+		file.write(reinterpret_cast<char const*>(dependency_records.data()), static_cast<std::streamsize>(dependency_records.size() * sizeof(dependency_record)));
+		file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+		for (std::size_t i = 0u; i < meshes.size() && file.good(); ++i) {
+			padTo(mesh_records[i].vertex_data_offset);
+			file.write(reinterpret_cast<char const*>(meshes[i].vertex_data), static_cast<std::streamsize>(meshes[i].vertex_data_size));
+			padTo(mesh_records[i].adjacency_offset);
+			file.write(reinterpret_cast<char const*>(meshes[i].adjacency_indices), static_cast<std::streamsize>(meshes[i].adjacency_nb * sizeof(std::uint32_t)));
+			padTo(mesh_records[i].edges_offset);
+			if (mesh_records[i].edges_nb != 0u)
+				file.write(reinterpret_cast<char const*>(meshes[i].edge_indices), static_cast<std::streamsize>(mesh_records[i].edges_nb * 4u * sizeof(std::uint32_t)));
+			padTo(mesh_records[i].meshlets_offset);
+			if (mesh_records[i].meshlets_nb != 0u)
+				file.write(reinterpret_cast<char const*>(meshes[i].meshlets), static_cast<std::streamsize>(mesh_records[i].meshlets_nb * sizeof(meshlets::meshlet)));
+		}
+		if (file.good())
+			padTo(header.file_size);
+
+		file.close();
+		if (!file.good()) {
+			LogWarning("Failed to write mesh cache \"%s\".", temporary_path.c_str());
+			std::remove(temporary_path.c_str());
+			return false;
+		}
+	}
+
+	// std::rename() does not replace existing files on all platforms.
+	std::remove(path.c_str());
+	if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+		LogWarning("Failed to move mesh cache \"%s\" in place.", path.c_str());
+		std::remove(temporary_path.c_str());
+		return false;
+	}
+
+	return true;
+}
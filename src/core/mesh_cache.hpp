@@ -0,0 +1,94 @@
+#pragma once
+
+#include "core/scene_data.hpp"
+#include "core/vertex_cache.hpp"
+#include "core/vertex_layout.hpp"
+#include "core/welding.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief On-disk cache of the meshes produced by `loadObjects()`.
+	//!
+	//! A `.nprmesh` file sits next to the scene it was baked from, and
+	//! stores for each mesh its vertex buffer, adjacency index buffer,
+	//! optional edge list and meshlets exactly as they are uploaded to the
+	//! GPU, along with its material constants and the paths of its
+	//! textures. Loading maps the file in memory and hands pointers into
+	//! it straight to `glBufferData()`.
+	//!
+	//! Each cache records the hash of the scene file along with the
+	//! importer flags, welding settings, edge extraction, vertex layout
+	//! and vertex cache settings it was baked with; a cache whose key
+	//! does not match is considered stale. It also records the size and
+	//! hash of every other file Assimp opened during the import, such as
+	//! OBJ material libraries, and is stale as soon as one of them
+	//! changes, appears or disappears.
+	namespace mesh_cache
+	{
+		//! \brief A file read while importing the scene, besides the
+		//!        scene file itself.
+		struct dependency
+		{
+			std::string path;        //!< as opened by Assimp
+			bool exists{false};      //!< whether the file could be read
+			std::uint64_t hash{0u};  //!< hash of the file content
+			std::uint64_t size{0u};  //!< size in bytes of the file
+		};
+
+		//! \brief Everything a cache depends on besides its own format.
+		struct key
+		{
+			std::uint64_t source_hash{0u};         //!< hash of the scene file content
+			std::uint64_t source_size{0u};         //!< size in bytes of the scene file
+			std::uint32_t importer_flags{0u};      //!< Assimp post-processing flags used for the import
+			welding::config weld_config{};         //!< how vertices were welded
+			bool with_edges{true};                 //!< whether edges were extracted
+			vertex_layout::config layout_config{}; //!< how vertex attributes were encoded
+			vertex_cache::config cache_config{};   //!< how triangles and vertices were reordered
+			std::vector<dependency> dependencies;  //!< only known once the scene has been imported, see `add_dependencies()`
+		};
+
+		//! \brief Path of the cache associated to a scene file.
+		std::string path_for(std::string const& filename);
+
+		//! \brief Compute the key a cache for |filename| should have.
+		//!
+		//! @return false if |filename| could not be read
+		bool make_key(std::string const& filename, std::uint32_t importer_flags,
+		              welding::config const& weld_config, bool with_edges,
+		              vertex_layout::config const& layout_config,
+		              vertex_cache::config const& cache_config, key& cache_key);
+
+		//! \brief Add the files at |paths| to the dependencies of
+		//!        |cache_key|, skipping |filename| and files already
+		//!        listed.
+		void add_dependencies(std::string const& filename, std::vector<std::string> const& paths, key& cache_key);
+
+		//! \brief Map the cache at |path| into |scene|, if it matches
+		//!        |expected_key|.
+		//!
+		//! The dependencies of |expected_key| are ignored: those recorded
+		//! in the cache are checked against the files on disk instead.
+		//!
+		//! On success, the meshes of |scene| point into its
+		//! `cache_file`. Missing caches are silently ignored, while stale
+		//! or malformed ones get reported.
+		//!
+		//! @return false if the scene has to be imported again
+		bool read(std::string const& path, key const& expected_key, scene_data& scene);
+
+		//! \brief Write |meshes| to |path|.
+		//!
+		//! The cache is written to a temporary file first and then moved
+		//! in place, so that an interrupted write never leaves a
+		//! truncated cache behind.
+		//!
+		//! @return false if the cache could not be written
+		bool write(std::string const& path, key const& cache_key,
+		           std::vector<mesh_view> const& meshes);
+	}
+}
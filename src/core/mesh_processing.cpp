@@ -0,0 +1,440 @@
+#include "mesh_processing.hpp"
+
+#include "core/adjacency.hpp"
+#include "core/Log.h"
+#include "core/mesh_cache.hpp"
+#include "core/meshlets.hpp"
+#include "core/parallel.hpp"
+#include "core/vertex_cache.hpp"
+
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+	// Changing these requires bumping the mesh cache format version, as
+	// they are part of the cache key.
+	constexpr std::uint32_t importer_flags = aiProcess_Triangulate | aiProcess_SortByPType | aiProcess_CalcTangentSpace;
+
+	// Assimp's file system, remembering every file it was asked to open so
+	// that the mesh cache can depend on them, OBJ material libraries
+	// being the usual suspects.
+	class recording_io_system : public Assimp::DefaultIOSystem
+	{
+	public:
+		using Assimp::DefaultIOSystem::Open;
+
+		Assimp::IOStream* Open(char const* file, char const* mode) override
+		{
+			opened_files.emplace_back(file);
+			return Assimp::DefaultIOSystem::Open(file, mode);
+		}
+
+		std::vector<std::string> opened_files;
+	};
+}
+
+bool
+bonobo::mesh_processing::process(aiMesh const &mesh, welding::config const &weld_config, bool with_edges,
+                                 vertex_layout::config const &layout_config, vertex_cache::config const &cache_config,
+                                 mesh_blob &blob, mesh_view &view, statistics &mesh_statistics)
+{
+	auto const mesh_start_time = std::chrono::high_resolution_clock::now();
+
+	if (!mesh.HasFaces())
+	{
+		LogError("Unsupported mesh \"%s\": has no faces", mesh.mName.C_Str());
+		return false;
+	}
+	if ((mesh.mPrimitiveTypes & ~static_cast<uint32_t>(aiPrimitiveType_POINT)) != 0u && (mesh.mPrimitiveTypes & ~static_cast<uint32_t>(aiPrimitiveType_LINE)) != 0u && (mesh.mPrimitiveTypes & ~static_cast<uint32_t>(aiPrimitiveType_TRIANGLE)) != 0u)
+	{
+		LogError("Unsupported mesh \"%s\": uses multiple primitive types", mesh.mName.C_Str());
+		return false;
+	}
+	if ((mesh.mPrimitiveTypes & static_cast<uint32_t>(aiPrimitiveType_POLYGON)) == static_cast<uint32_t>(aiPrimitiveType_POLYGON))
+	{
+		LogError("Unsupported mesh \"%s\": uses polygons", mesh.mName.C_Str());
+		return false;
+	}
+	if (!mesh.HasPositions())
+	{
+		LogError("Unsupported mesh \"%s\": has no positions", mesh.mName.C_Str());
+		return false;
+	}
+
+	view = mesh_view();
+	if (mesh.mName.length != 0)
+	{
+		view.name = std::string(mesh.mName.C_Str());
+	}
+	view.vertices_nb = mesh.mNumVertices;
+
+	auto const num_vertices_per_face = mesh.mFaces[0u].mNumIndices;
+	view.indices_nb = mesh.mNumFaces * num_vertices_per_face;
+	auto object_indices = std::make_unique<std::uint32_t[]>(static_cast<size_t>(view.indices_nb));
+
+	// removing duplicate indices for the same position, so that
+	// neighbouring triangles can be found
+	auto const welding_start_time = std::chrono::high_resolution_clock::now();
+	static_assert(sizeof(aiVector3D) == 3u * sizeof(float), "aiVector3D is expected to be three tightly-packed floats");
+	auto const welded = bonobo::welding::weld(reinterpret_cast<float const *>(mesh.mVertices), mesh.mNumVertices, weld_config);
+	for (size_t i = 0u; i < mesh.mNumFaces; ++i)
+	{
+		auto const &face = mesh.mFaces[i];
+		assert(face.mNumIndices <= 3);
+
+		// assume we only handle objesc with 3 indices per face
+		for (size_t j = 0u; j < 3u; ++j)
+			object_indices[num_vertices_per_face * i + j] = welded.remap[face.mIndices[j]];
+	}
+	auto const welding_end_time = std::chrono::high_resolution_clock::now();
+
+	// Whole triangles get reordered for the post-transform cache before
+	// their adjacency is built, which keeps it valid.
+	std::vector<std::uint32_t> triangle_order;
+	if (cache_config.is_enabled)
+	{
+		triangle_order = vertex_cache::order_triangles(object_indices.get(), mesh.mNumFaces, mesh.mNumVertices, cache_config.cache_size);
+		auto reordered_indices = std::make_unique<std::uint32_t[]>(static_cast<size_t>(view.indices_nb));
+		for (size_t i = 0u; i < triangle_order.size(); ++i)
+			std::copy_n(object_indices.get() + 3u * triangle_order[i], 3u, reordered_indices.get() + 3u * i);
+		object_indices = std::move(reordered_indices);
+	}
+	auto const triangle_order_end_time = std::chrono::high_resolution_clock::now();
+
+	// filling adjacency indices from the welded triangles
+	blob.adjacency_indices = bonobo::adjacency::build(object_indices.get(), mesh.mNumFaces, mesh.mNumVertices);
+	view.adjacency_indices = blob.adjacency_indices.data();
+	view.adjacency_nb = static_cast<std::uint32_t>(blob.adjacency_indices.size());
+	auto const adjacency_end_time = std::chrono::high_resolution_clock::now();
+	object_indices.reset(nullptr);
+
+	// All six indices of each GL_TRIANGLES_ADJACENCY primitive go through
+	// the vertex shader; the original order is replayed by walking the
+	// reordered primitives through the inverse permutation.
+	auto const cache_size = cache_config.cache_size;
+	if (cache_config.is_enabled)
+	{
+		std::vector<std::uint32_t> original_order(triangle_order.size());
+		for (size_t i = 0u; i < triangle_order.size(); ++i)
+			original_order[triangle_order[i]] = static_cast<std::uint32_t>(i);
+		mesh_statistics.acmr_before = vertex_cache::acmr(view.adjacency_indices, mesh.mNumFaces, 6u, mesh.mNumVertices, cache_size, original_order.data());
+	}
+	mesh_statistics.acmr_after = vertex_cache::acmr(view.adjacency_indices, mesh.mNumFaces, 6u, mesh.mNumVertices, cache_size);
+	if (!cache_config.is_enabled)
+		mesh_statistics.acmr_before = mesh_statistics.acmr_after;
+
+	// Positions get a stream of their own, followed by the other
+	// attributes interleaved and quantised; this is what gets uploaded
+	// and cached.
+	std::array<float const *, 5> attributes_data{
+		reinterpret_cast<float const *>(mesh.mVertices),
+		mesh.HasNormals() ? reinterpret_cast<float const *>(mesh.mNormals) : nullptr,
+		mesh.HasTextureCoords(0u) ? reinterpret_cast<float const *>(mesh.mTextureCoords[0u]) : nullptr,
+		mesh.HasTangentsAndBitangents() ? reinterpret_cast<float const *>(mesh.mTangents) : nullptr,
+		mesh.HasTangentsAndBitangents() ? reinterpret_cast<float const *>(mesh.mBitangents) : nullptr};
+
+	// Vertices are then renumbered in the order they are first drawn,
+	// dropping the ones welding merged away.
+	std::array<std::vector<float>, 5> reordered_attributes;
+	if (cache_config.is_enabled)
+	{
+		std::uint32_t used_vertices_nb = 0u;
+		auto const remap = vertex_cache::order_vertices(view.adjacency_indices, view.adjacency_nb, mesh.mNumVertices, used_vertices_nb);
+		for (auto &index : blob.adjacency_indices)
+			index = remap[index];
+		for (size_t a = 0u; a < attributes_data.size(); ++a)
+		{
+			if (attributes_data[a] == nullptr)
+				continue;
+			reordered_attributes[a].resize(static_cast<size_t>(used_vertices_nb) * 3u);
+			for (std::uint32_t v = 0u; v < mesh.mNumVertices; ++v)
+				if (remap[v] < used_vertices_nb)
+					std::copy_n(attributes_data[a] + 3u * v, 3u, reordered_attributes[a].data() + 3u * remap[v]);
+			attributes_data[a] = reordered_attributes[a].data();
+		}
+		view.vertices_nb = used_vertices_nb;
+	}
+	auto const vertex_cache_end_time = std::chrono::high_resolution_clock::now();
+
+	// Used by the renderer to cull whole meshes.
+	if (view.vertices_nb != 0u)
+	{
+		view.bounds_min = view.bounds_max = glm::make_vec3(attributes_data[0]);
+		for (std::uint32_t v = 1u; v < view.vertices_nb; ++v)
+		{
+			auto const position = glm::make_vec3(attributes_data[0] + 3u * v);
+			view.bounds_min = glm::min(view.bounds_min, position);
+			view.bounds_max = glm::max(view.bounds_max, position);
+		}
+	}
+
+	// Used by the renderer to skip clusters of triangles which cannot
+	// contribute to the silhouette.
+	blob.meshlets = meshlets::build(view.adjacency_indices, view.adjacency_nb / 6u, attributes_data[0], view.vertices_nb);
+	view.meshlets = blob.meshlets.data();
+	view.meshlets_nb = static_cast<std::uint32_t>(blob.meshlets.size());
+	auto const meshlets_end_time = std::chrono::high_resolution_clock::now();
+
+	vertex_layout::build(layout_config, view.vertices_nb, attributes_data, blob.vertex_data, view.attributes);
+	view.vertex_data = blob.vertex_data.data();
+	view.vertex_data_size = blob.vertex_data.size();
+	auto const layout_end_time = std::chrono::high_resolution_clock::now();
+
+	if (with_edges)
+	{
+		blob.edge_indices = bonobo::adjacency::extract_edges(view.adjacency_indices, view.adjacency_nb / 6u);
+		view.edge_indices = blob.edge_indices.data();
+		view.edges_nb = static_cast<std::uint32_t>(blob.edge_indices.size() / 4u);
+	}
+	auto const edges_end_time = std::chrono::high_resolution_clock::now();
+
+	mesh_statistics.unique_vertices_nb = welded.unique_vertices_nb;
+	mesh_statistics.welding_duration = std::chrono::duration<float, std::milli>(welding_end_time - welding_start_time).count();
+	mesh_statistics.vertex_cache_duration = std::chrono::duration<float, std::milli>((triangle_order_end_time - welding_end_time) + (vertex_cache_end_time - adjacency_end_time)).count();
+	mesh_statistics.adjacency_duration = std::chrono::duration<float, std::milli>(adjacency_end_time - triangle_order_end_time).count();
+	mesh_statistics.meshlets_duration = std::chrono::duration<float, std::milli>(meshlets_end_time - vertex_cache_end_time).count();
+	mesh_statistics.edges_duration = std::chrono::duration<float, std::milli>(edges_end_time - layout_end_time).count();
+	mesh_statistics.total_duration = std::chrono::duration<float, std::milli>(edges_end_time - mesh_start_time).count();
+
+	return true;
+}
+
+bool
+bonobo::loadSceneData(std::string const &filename, scene_data &scene, welding::config const &weld_config, bool with_edges, vertex_layout::config const &layout_config, vertex_cache::config const &cache_config, std::function<void(float)> const &report_progress)
+{
+	auto const scene_start_time = std::chrono::high_resolution_clock::now();
+
+	auto const end_of_basedir = filename.rfind("/");
+	scene = scene_data();
+	scene.filename = filename;
+	scene.parent_folder = (end_of_basedir != std::string::npos ? filename.substr(0, end_of_basedir) : ".") + "/";
+
+	auto const cache_path = mesh_cache::path_for(filename);
+	mesh_cache::key cache_key;
+	auto const has_cache_key = mesh_cache::make_key(filename, importer_flags, weld_config, with_edges, layout_config, cache_config, cache_key);
+	if (has_cache_key && mesh_cache::read(cache_path, cache_key, scene))
+	{
+		LogInfo("┭ Loading \"%s\"…", filename.c_str());
+		LogInfo("│ %zu meshes mapped from \"%s\" in %.3f ms", scene.meshes.size(), cache_path.c_str(),
+				std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - scene_start_time).count());
+		if (report_progress)
+			report_progress(1.0f);
+		return true;
+	}
+
+	Assimp::Importer importer;
+	auto io_system = std::make_unique<recording_io_system>();
+	auto const &opened_files = io_system->opened_files;
+	importer.SetIOHandler(io_system.release()); // the importer takes ownership
+	auto const assimp_scene = importer.ReadFile(filename, importer_flags);
+	if (assimp_scene == nullptr || assimp_scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || assimp_scene->mRootNode == nullptr)
+	{
+		LogError("Assimp failed to load \"%s\": %s", filename.c_str(), importer.GetErrorString());
+		return false;
+	}
+	if (has_cache_key)
+		mesh_cache::add_dependencies(filename, opened_files, cache_key);
+
+	if (assimp_scene->mNumMeshes == 0u)
+	{
+		LogError("No mesh available; loading \"%s\" must have had issues", filename.c_str());
+		return false;
+	}
+
+	LogInfo("┭ Loading \"%s\"…", filename.c_str());
+
+	std::vector<bool> are_materials_used(assimp_scene->mNumMaterials, false);
+	for (size_t j = 0; j < assimp_scene->mNumMeshes; ++j)
+	{
+		auto const assimp_object_mesh = assimp_scene->mMeshes[j];
+		auto const material_id = assimp_object_mesh->mMaterialIndex;
+		if (material_id >= assimp_scene->mNumMaterials)
+			LogError("Mesh \"%s\" has a material index of %u, but only %u materials are present.", assimp_object_mesh->mName.C_Str(), material_id, assimp_scene->mNumMaterials);
+		else
+			are_materials_used[material_id] = true;
+	}
+
+	std::vector<material_data> material_constants(assimp_scene->mNumMaterials);
+	std::vector<std::vector<texture_reference>> materials_textures(assimp_scene->mNumMaterials);
+	for (size_t i = 0; i < assimp_scene->mNumMaterials; ++i)
+	{
+		if (!are_materials_used[i])
+			continue;
+
+		auto const material_start_time = std::chrono::high_resolution_clock::now();
+		material_data &constants = material_constants[i];
+		auto &textures = materials_textures[i];
+		auto const material = assimp_scene->mMaterials[i];
+
+		// Textures are only recorded here; they get loaded once the
+		// scene is uploaded.
+		auto const process_texture = [&textures, &material](aiTextureType type, std::string const &type_as_str, std::string const &name)
+		{
+			if (material->GetTextureCount(type))
+			{
+				if (material->GetTextureCount(type) > 1)
+					LogWarning("Material \"%s\" has more than one %s texture: discarding all but the first one.", material->GetName().C_Str(), type_as_str.c_str());
+				aiString path;
+				material->GetTexture(type, 0, &path);
+				textures.push_back({name, std::string(path.C_Str()), std::string(material->GetName().C_Str()) + " " + type_as_str});
+			}
+		};
+
+		aiColor3D color;
+
+		material->Get(AI_MATKEY_COLOR_DIFFUSE, color);
+		constants.diffuse = glm::vec3(color.r, color.g, color.b);
+		material->Get(AI_MATKEY_COLOR_SPECULAR, color);
+		constants.specular = glm::vec3(color.r, color.g, color.b);
+		material->Get(AI_MATKEY_COLOR_AMBIENT, color);
+		constants.ambient = glm::vec3(color.r, color.g, color.b);
+		material->Get(AI_MATKEY_COLOR_EMISSIVE, color);
+		constants.emissive = glm::vec3(color.r, color.g, color.b);
+		material->Get(AI_MATKEY_SHININESS, constants.shininess);
+		material->Get(AI_MATKEY_REFRACTI, constants.indexOfRefraction);
+		material->Get(AI_MATKEY_OPACITY, constants.opacity);
+
+		process_texture(aiTextureType_DIFFUSE, "diffuse", "diffuse_texture");
+		process_texture(aiTextureType_SPECULAR, "specular", "specular_texture");
+		process_texture(aiTextureType_NORMALS, "normals", "normals_texture");
+		process_texture(aiTextureType_OPACITY, "opacity", "opacity_texture");
+
+		auto const material_end_time = std::chrono::high_resolution_clock::now();
+		LogTrivia("│ ╺ Material \"%s\" with %zu textures read in %.3f ms",
+				  material->GetName().C_Str(), textures.size(),
+				  std::chrono::duration<float, std::milli>(material_end_time - material_start_time).count());
+	}
+
+	// Meshes are independent from each other, so they are processed
+	// concurrently; each worker picks the next mesh left, as their sizes
+	// vary wildly within a scene. The parallel loops of the adjacency
+	// build run on the same pool, so they only use workers left idle by
+	// this one, and an exception thrown while processing a mesh reaches
+	// this thread.
+	auto const meshes_start_time = std::chrono::high_resolution_clock::now();
+	auto const meshes_nb = static_cast<std::size_t>(assimp_scene->mNumMeshes);
+	std::vector<mesh_view> views(meshes_nb);
+	std::vector<mesh_blob> blobs(meshes_nb);
+	std::vector<mesh_processing::statistics> meshes_statistics(meshes_nb);
+	std::vector<char> are_meshes_valid(meshes_nb, 0);
+	std::atomic<std::size_t> processed_meshes_nb{0u};
+	utils::parallel::for_each_index(meshes_nb, [&](std::size_t j)
+	{
+		auto const &assimp_object_mesh = *assimp_scene->mMeshes[j];
+		are_meshes_valid[j] = mesh_processing::process(assimp_object_mesh, weld_config, with_edges, layout_config, cache_config, blobs[j], views[j], meshes_statistics[j]);
+
+		auto const material_id = assimp_object_mesh.mMaterialIndex;
+		if (are_meshes_valid[j] && material_id < material_constants.size())
+		{
+			views[j].material = material_constants[material_id];
+			views[j].textures = materials_textures[material_id];
+		}
+
+		auto const processed_nb = ++processed_meshes_nb;
+		if (report_progress)
+			report_progress(static_cast<float>(processed_nb) / static_cast<float>(meshes_nb));
+	});
+	auto const meshes_end_time = std::chrono::high_resolution_clock::now();
+
+	// Keep the valid meshes in their original order; moving the blobs
+	// keeps the views pointing at their buffers.
+	scene.meshes.reserve(meshes_nb);
+	scene.blobs.reserve(meshes_nb);
+	for (size_t j = 0; j < meshes_nb; ++j)
+	{
+		if (!are_meshes_valid[j])
+			continue;
+		scene.meshes.push_back(std::move(views[j]));
+		scene.blobs.push_back(std::move(blobs[j]));
+
+		auto const assimp_object_mesh = assimp_scene->mMeshes[j];
+		auto const &mesh_statistics = meshes_statistics[j];
+		std::string attributes = assimp_object_mesh->HasNormals() ? "normals" : "";
+		if (!attributes.empty())
+			attributes += " | ";
+		if (assimp_object_mesh->HasTangentsAndBitangents())
+			attributes += "tangents&bitangents";
+		if (!attributes.empty())
+			attributes += " | ";
+		if (assimp_object_mesh->HasTextureCoords(0))
+			attributes += "texture coordinates";
+		LogTrivia("│ %s Mesh \"%s\" processed with attributes [%s] in %.3f ms (welding: %u/%u vertices kept (%.1f%%) in %.3f ms, vertex cache: ACMR %.3f → %.3f in %.3f ms, adjacency: %.3f ms, meshlets: %u in %.3f ms, edges: %u in %.3f ms)",
+				  (meshes_nb == 1u) ? "╶" : (j == 0 ? "┌" : (j == meshes_nb - 1 ? "└" : "├")),
+				  assimp_object_mesh->mName.C_Str(), attributes.c_str(),
+				  mesh_statistics.total_duration,
+				  mesh_statistics.unique_vertices_nb, assimp_object_mesh->mNumVertices,
+				  100.0f * static_cast<float>(mesh_statistics.unique_vertices_nb) / static_cast<float>(std::max(assimp_object_mesh->mNumVertices, 1u)),
+				  mesh_statistics.welding_duration,
+				  mesh_statistics.acmr_before, mesh_statistics.acmr_after,
+				  mesh_statistics.vertex_cache_duration,
+				  mesh_statistics.adjacency_duration,
+				  scene.meshes.back().meshlets_nb,
+				  mesh_statistics.meshlets_duration,
+				  scene.meshes.back().edges_nb,
+				  mesh_statistics.edges_duration);
+	}
+
+	if (cache_config.is_enabled)
+	{
+		double transformed_before = 0.0;
+		double transformed_after = 0.0;
+		std::size_t primitives_nb = 0u;
+		for (size_t j = 0; j < meshes_nb; ++j)
+		{
+			if (!are_meshes_valid[j])
+				continue;
+			auto const mesh_primitives_nb = static_cast<std::size_t>(assimp_scene->mMeshes[j]->mNumFaces);
+			transformed_before += static_cast<double>(meshes_statistics[j].acmr_before) * static_cast<double>(mesh_primitives_nb);
+			transformed_after += static_cast<double>(meshes_statistics[j].acmr_after) * static_cast<double>(mesh_primitives_nb);
+			primitives_nb += mesh_primitives_nb;
+		}
+		LogInfo("│ Vertex cache reordering brought the ACMR of adjacency draws from %.3f down to %.3f, with %u cache entries",
+				transformed_before / static_cast<double>(std::max<std::size_t>(primitives_nb, 1u)),
+				transformed_after / static_cast<double>(std::max<std::size_t>(primitives_nb, 1u)),
+				cache_config.cache_size);
+	}
+
+	// Compare against every attribute stored as three floats, which is
+	// what vertex buffers looked like before `vertex_layout`.
+	std::size_t vertex_data_size = 0u;
+	std::size_t planar_vertex_data_size = 0u;
+	for (auto const &view : scene.meshes)
+	{
+		vertex_data_size += view.vertex_data_size;
+		for (auto const &attribute : view.attributes)
+			if (attribute.offset >= 0)
+				planar_vertex_data_size += static_cast<std::size_t>(view.vertices_nb) * 3u * sizeof(float);
+	}
+	LogInfo("│ Vertex data takes %.2f MiB, %.0f%% of what three floats per attribute would take",
+			static_cast<float>(vertex_data_size) / static_cast<float>(1u << 20u),
+			100.0f * static_cast<float>(vertex_data_size) / static_cast<float>(std::max<std::size_t>(planar_vertex_data_size, 1u)));
+
+	if (has_cache_key && !scene.meshes.empty())
+	{
+		auto const cache_start_time = std::chrono::high_resolution_clock::now();
+		if (mesh_cache::write(cache_path, cache_key, scene.meshes))
+			LogTrivia("│ Mesh cache \"%s\" written in %.3f ms", cache_path.c_str(),
+					  std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - cache_start_time).count());
+	}
+
+	auto const scene_end_time = std::chrono::high_resolution_clock::now();
+	LogInfo("│ Scene processed in %.3f s, of which %zu meshes in %.3f s on up to %zu threads",
+			std::chrono::duration<float>(scene_end_time - scene_start_time).count(),
+			scene.meshes.size(),
+			std::chrono::duration<float>(meshes_end_time - meshes_start_time).count(),
+			std::min(utils::parallel::worker_count(), meshes_nb));
+
+	return !scene.meshes.empty();
+}
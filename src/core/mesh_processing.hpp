@@ -0,0 +1,93 @@
+#pragma once
+
+#include "core/scene_data.hpp"
+#include "core/vertex_cache.hpp"
+#include "core/vertex_layout.hpp"
+#include "core/welding.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+struct aiMesh;
+
+namespace bonobo
+{
+	//! \brief Turn meshes imported by Assimp into `mesh_blob`s ready to be
+	//!        uploaded.
+	//!
+	//! Nothing in here touches OpenGL, so all of it can run on worker
+	//! threads; `uploadSceneData()` is the only part of loading a scene
+	//! which needs the OpenGL context.
+	namespace mesh_processing
+	{
+		//! \brief What `process()` did to a mesh, for logging purposes;
+		//!        durations are in milliseconds.
+		struct statistics
+		{
+			std::uint32_t unique_vertices_nb{0u};
+			float welding_duration{0.0f};
+			float vertex_cache_duration{0.0f};
+			float adjacency_duration{0.0f};
+			float meshlets_duration{0.0f};
+			float edges_duration{0.0f};
+			float total_duration{0.0f};
+			float acmr_before{0.0f}; //!< vertices transformed per GL_TRIANGLES_ADJACENCY primitive, in the imported order
+			float acmr_after{0.0f};  //!< same, once reordered; equal to |acmr_before| if reordering is disabled
+		};
+
+		//! \brief Merge the vertices of a mesh sharing a position, order
+		//!        its triangles and vertices for the vertex cache, build
+		//!        its adjacency indices and meshlets, and encode its vertex
+		//!        attributes.
+		//!
+		//! Different meshes can be processed concurrently.
+		//!
+		//! @param [in] mesh triangulated mesh, as imported by Assimp
+		//! @param [in] weld_config how to merge vertices sharing a
+		//!             position before looking for adjacent triangles
+		//! @param [in] with_edges whether to also extract the edges of
+		//!             the mesh, see `adjacency::extract_edges()`
+		//! @param [in] layout_config how to encode the vertex attributes
+		//! @param [in] cache_config whether and how to reorder triangles
+		//!             and vertices, see `vertex_cache`
+		//! @param [out] blob where the processed buffers are stored
+		//! @param [out] view layout of |blob| and name of the mesh; the
+		//!              material and textures are left to the caller
+		//! @param [out] mesh_statistics what was done to the mesh
+		//! @return false if the mesh is not supported, which gets logged
+		bool process(aiMesh const& mesh, welding::config const& weld_config, bool with_edges,
+		             vertex_layout::config const& layout_config,
+		             vertex_cache::config const& cache_config,
+		             mesh_blob& blob, mesh_view& view, statistics& mesh_statistics);
+	}
+
+	//! \brief Import and process the objects of a scene file, without
+	//!        touching OpenGL.
+	//!
+	//! This is the first half of `loadObjects()`; as it does not need
+	//! an OpenGL context, it can run on any thread. Once Assimp is done,
+	//! meshes are processed by `mesh_processing::process()` on a pool of
+	//! worker threads. Processed meshes are cached next to the scene file,
+	//! and read back from there on later calls.
+	//!
+	//! @param [in] filename of the object/scene file to load.
+	//! @param [out] scene where to store the processed meshes
+	//! @param [in] weld_config how to merge vertices sharing a position
+	//!             before looking for adjacent triangles
+	//! @param [in] with_edges whether to also extract the edges of each
+	//!             mesh, see `adjacency::extract_edges()`
+	//! @param [in] layout_config how to encode the vertex attributes
+	//! @param [in] cache_config whether and how to reorder triangles and
+	//!             vertices for the vertex cache
+	//! @param [in] report_progress if set, called with the fraction of
+	//!             meshes processed so far, from any of the threads
+	//!             processing them
+	//! @return false if no mesh could be loaded
+	bool loadSceneData(std::string const &filename, scene_data &scene,
+	                   welding::config const &weld_config = welding::config{},
+	                   bool with_edges = true,
+	                   vertex_layout::config const &layout_config = vertex_layout::config{},
+	                   vertex_cache::config const &cache_config = vertex_cache::config{},
+	                   std::function<void(float)> const &report_progress = nullptr);
+}
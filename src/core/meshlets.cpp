@@ -0,0 +1,110 @@
+#include "meshlets.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	// Corners of the triangles `NPR/silhouette.geom` computes normals
+	// for, out of the six indices of an adjacency primitive: the
+	// primitive's own triangle followed by its three neighbours.
+	constexpr std::array<std::array<std::uint32_t, 3>, 4> primitive_triangles{{
+		{{0u, 2u, 4u}}, {{0u, 1u, 2u}}, {{2u, 3u, 4u}}, {{0u, 4u, 5u}}
+	}};
+}
+
+std::vector<bonobo::meshlets::meshlet>
+bonobo::meshlets::build(std::uint32_t const* adjacency_indices, std::size_t triangles_nb,
+                        float const* positions, std::uint32_t vertices_nb)
+{
+	std::vector<meshlet> clusters;
+	clusters.reserve((triangles_nb + max_triangles - 1u) / max_triangles);
+
+	std::vector<glm::vec3> normals;
+	normals.reserve(max_triangles * primitive_triangles.size());
+	for (std::size_t first = 0u; first < triangles_nb; first += max_triangles) {
+		meshlet cluster;
+		cluster.first_triangle = static_cast<std::uint32_t>(first);
+		cluster.triangles_nb = static_cast<std::uint32_t>(std::min<std::size_t>(max_triangles, triangles_nb - first));
+
+		auto const* const indices = adjacency_indices + 6u * first;
+		auto const indices_nb = 6u * static_cast<std::size_t>(cluster.triangles_nb);
+		auto const position = [positions, vertices_nb](std::uint32_t index) {
+			assert(index < vertices_nb);
+			(void) vertices_nb;
+			return glm::make_vec3(positions + 3u * index);
+		};
+
+		// The sphere around the bounding box is not the tightest one, but
+		// it is close enough for clusters this small.
+		auto lower = position(indices[0]);
+		auto upper = lower;
+		for (std::size_t i = 1u; i < indices_nb; ++i) {
+			lower = glm::min(lower, position(indices[i]));
+			upper = glm::max(upper, position(indices[i]));
+		}
+		cluster.center = 0.5f * (lower + upper);
+		for (std::size_t i = 0u; i < indices_nb; ++i)
+			cluster.radius = std::max(cluster.radius, glm::distance(cluster.center, position(indices[i])));
+
+		normals.clear();
+		bool is_degenerate = false;
+		for (std::size_t i = 0u; i < indices_nb && !is_degenerate; i += 6u) {
+			for (auto const& corners : primitive_triangles) {
+				auto const origin = position(indices[i + corners[0]]);
+				auto const normal = glm::cross(position(indices[i + corners[1]]) - origin,
+				                               position(indices[i + corners[2]]) - origin);
+				auto const length = glm::length(normal);
+				if (!(length > std::numeric_limits<float>::min())) {
+					is_degenerate = true;
+					break;
+				}
+				normals.push_back(normal / length);
+			}
+		}
+
+		if (!is_degenerate) {
+			auto axis = glm::vec3(0.0f);
+			for (auto const& normal : normals)
+				axis += normal;
+			auto const axis_length = glm::length(axis);
+			if (axis_length > std::numeric_limits<float>::min()) {
+				axis /= axis_length;
+				auto min_dot = 1.0f;
+				for (auto const& normal : normals)
+					min_dot = std::min(min_dot, glm::dot(axis, normal));
+				// Cones of 90° or wider always contain a silhouette
+				// candidate, whatever the point of view.
+				if (min_dot > 0.0f) {
+					cluster.cone_axis = axis;
+					cluster.cone_cutoff = std::sqrt(std::max(1.0f - min_dot * min_dot, 0.0f));
+				}
+			}
+		}
+
+		clusters.push_back(cluster);
+	}
+
+	return clusters;
+}
+
+bool
+bonobo::meshlets::is_silhouette_free(meshlet const& cluster, glm::vec3 const& eye)
+{
+	if (cluster.cone_cutoff >= 1.0f)
+		return false;
+
+	// For every point p of the bounding sphere and every normal n of the
+	// cone, dot(n, p - eye) keeps the sign of dot(axis, center - eye) as
+	// long as the latter exceeds the margin below: moving from the
+	// centre to p changes it by at most (1 + cone_cutoff) * radius.
+	auto const to_center = cluster.center - eye;
+	auto const threshold = cluster.cone_cutoff * glm::length(to_center) + (1.0f + cluster.cone_cutoff) * cluster.radius;
+	auto const alignment = glm::dot(to_center, cluster.cone_axis);
+	return alignment >= threshold || -alignment > threshold;
+}
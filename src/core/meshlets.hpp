@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Helpers for splitting meshes into small clusters of
+	//!        triangles, which the renderer can skip as a whole when none
+	//!        of their edges can be on a silhouette.
+	namespace meshlets
+	{
+		//! \brief Number of triangles per meshlet, except for the last one
+		//!        of each mesh; changing it requires bumping the mesh cache
+		//!        format version.
+		constexpr std::uint32_t max_triangles = 64u;
+
+		//! \brief Consecutive triangles of a mesh, along with bounds on
+		//!        where they lie and which way they face.
+		struct meshlet
+		{
+			glm::vec3 center{0.0f};    //!< centre of a sphere enclosing all vertices of the meshlet's adjacency primitives
+			float radius{0.0f};        //!< radius of that sphere
+			glm::vec3 cone_axis{0.0f}; //!< unit vector all normals of the meshlet are close to
+			//! Sine of the half-angle of the normal cone around
+			//! |cone_axis|; 1 or more if the meshlet cannot be culled.
+			float cone_cutoff{1.0f};
+			std::uint32_t first_triangle{0u};
+			std::uint32_t triangles_nb{0u};
+		};
+
+		//! \brief Split an adjacency index buffer into meshlets.
+		//!
+		//! Meshlets are runs of |max_triangles| consecutive triangles, so
+		//! each one can be drawn as a sub-range of the index buffer; once
+		//! ordered by `vertex_cache::order_triangles()`, those runs are
+		//! made of neighbouring fans and stay compact.
+		//!
+		//! The normal cone of a meshlet also covers the triangles adjacent
+		//! to it, as `NPR/silhouette.geom` emits an edge of a
+		//! light-facing triangle whenever its neighbour faces away: a
+		//! meshlet whose own triangles all face the light can still output
+		//! lines along its border. Meshlets with degenerate triangles or
+		//! open edges, which always produce lines, never get culled.
+		//!
+		//! @param [in] adjacency_indices six indices per triangle, see
+		//!             `adjacency::build()`
+		//! @param [in] triangles_nb number of triangles in
+		//!             |adjacency_indices|
+		//! @param [in] positions three floats per vertex
+		//! @param [in] vertices_nb all indices have to be strictly less
+		//!             than this value
+		std::vector<meshlet> build(std::uint32_t const* adjacency_indices,
+		                           std::size_t triangles_nb,
+		                           float const* positions,
+		                           std::uint32_t vertices_nb);
+
+		//! \brief Check whether every triangle of |cluster| and its
+		//!        neighbours faces |eye|, or every one faces away from it,
+		//!        in which case none of its edges is a silhouette; this is
+		//!        the test run by `NPR/cull_meshlets.comp`.
+		bool is_silhouette_free(meshlet const& cluster, glm::vec3 const& eye);
+	}
+}
@@ -1,6 +1,7 @@
 #include "node.hpp"
 #include "helpers.hpp"
 
+#include "core/gl_state.hpp"
 #include "core/Log.h"
 #include "core/opengl.hpp"
 
@@ -32,33 +33,33 @@ Node::render(glm::mat4 const& view_projection, glm::mat4 const& world, GLuint pr
 
 	utils::opengl::debug::beginDebugGroup(_name);
 
-	glUseProgram(program);
+	// Bindings get left as they are once done, so that nodes sharing a
+	// program or textures do not bind them again.
+	auto& state = bonobo::gl::get_state_tracker();
+	state.use_program(program);
 
 	auto const normal_model_to_world = glm::transpose(glm::inverse(world));
 
 	set_uniforms(program);
 
-	glUniformMatrix4fv(glGetUniformLocation(program, "vertex_model_to_world"), 1, GL_FALSE, glm::value_ptr(world));
-	glUniformMatrix4fv(glGetUniformLocation(program, "normal_model_to_world"), 1, GL_FALSE, glm::value_ptr(normal_model_to_world));
-	glUniformMatrix4fv(glGetUniformLocation(program, "vertex_world_to_clip"), 1, GL_FALSE, glm::value_ptr(view_projection));
+	glUniformMatrix4fv(state.get_uniform_location(program, "vertex_model_to_world"), 1, GL_FALSE, glm::value_ptr(world));
+	glUniformMatrix4fv(state.get_uniform_location(program, "normal_model_to_world"), 1, GL_FALSE, glm::value_ptr(normal_model_to_world));
+	glUniformMatrix4fv(state.get_uniform_location(program, "vertex_world_to_clip"), 1, GL_FALSE, glm::value_ptr(view_projection));
 
 	for (size_t i = 0u; i < _textures.size(); ++i) {
 		auto const& texture = _textures[i];
-		glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(i));
-		glBindTexture(std::get<2>(texture), std::get<1>(texture));
-		glUniform1i(glGetUniformLocation(program, std::get<0>(texture).c_str()), static_cast<GLint>(i));
-
-		std::string texture_presence_var_name = "has_" + std::get<0>(texture);
-		glUniform1i(glGetUniformLocation(program, texture_presence_var_name.c_str()), 1);
+		state.bind_texture(static_cast<GLuint>(i), std::get<2>(texture), std::get<1>(texture));
+		glUniform1i(state.get_uniform_location(program, std::get<0>(texture).c_str()), static_cast<GLint>(i));
+		glUniform1i(state.get_uniform_location(program, std::get<3>(texture).c_str()), 1);
 	}
 
-	glUniform3fv(glGetUniformLocation(program, "diffuse_colour"), 1, glm::value_ptr(_constants.diffuse));
-	glUniform3fv(glGetUniformLocation(program, "specular_colour"), 1, glm::value_ptr(_constants.specular));
-	glUniform3fv(glGetUniformLocation(program, "ambient_colour"), 1, glm::value_ptr(_constants.ambient));
-	glUniform3fv(glGetUniformLocation(program, "emissive_colour"), 1, glm::value_ptr(_constants.emissive));
-	glUniform1f(glGetUniformLocation(program, "shininess_value"), _constants.shininess);
-	glUniform1f(glGetUniformLocation(program, "index_of_refraction_value"), _constants.indexOfRefraction);
-	glUniform1f(glGetUniformLocation(program, "opacity_value"), _constants.opacity);
+	glUniform3fv(state.get_uniform_location(program, "diffuse_colour"), 1, glm::value_ptr(_constants.diffuse));
+	glUniform3fv(state.get_uniform_location(program, "specular_colour"), 1, glm::value_ptr(_constants.specular));
+	glUniform3fv(state.get_uniform_location(program, "ambient_colour"), 1, glm::value_ptr(_constants.ambient));
+	glUniform3fv(state.get_uniform_location(program, "emissive_colour"), 1, glm::value_ptr(_constants.emissive));
+	glUniform1f(state.get_uniform_location(program, "shininess_value"), _constants.shininess);
+	glUniform1f(state.get_uniform_location(program, "index_of_refraction_value"), _constants.indexOfRefraction);
+	glUniform1f(state.get_uniform_location(program, "opacity_value"), _constants.opacity);
 
 	glBindVertexArray(_vao);
 	if (_has_indices)
@@ -67,15 +68,9 @@ Node::render(glm::mat4 const& view_projection, glm::mat4 const& world, GLuint pr
 		glDrawArrays(_drawing_mode, 0, _vertices_nb);
 	glBindVertexArray(0u);
 
-	for (auto const& texture : _textures) {
-		glBindTexture(std::get<2>(texture), 0);
-		glUniform1i(glGetUniformLocation(program, std::get<0>(texture).c_str()), 0);
-
-		std::string texture_presence_var_name = "has_" + std::get<0>(texture);
-		glUniform1i(glGetUniformLocation(program, texture_presence_var_name.c_str()), 0);
-	}
-
-	glUseProgram(0u);
+	// The next node using the same program may not have those textures.
+	for (auto const& texture : _textures)
+		glUniform1i(state.get_uniform_location(program, std::get<3>(texture).c_str()), 0);
 
 	utils::opengl::debug::endDebugGroup();
 }
@@ -159,7 +154,7 @@ Node::add_texture(std::string const& name, GLuint tex_id, GLenum type)
 		return;
 	}
 
-	_textures.emplace_back(name, tex_id, type);
+	_textures.emplace_back(name, tex_id, type, "has_" + name);
 }
 
 void
@@ -142,8 +142,9 @@ private:
 	GLuint const* _program{ nullptr };
 	std::function<void (GLuint)> _set_uniforms;
 
-	// Material data
-	std::vector<std::tuple<std::string, GLuint, GLenum>> _textures;
+	// Material data, with each texture followed by the name of the
+	// uniform flagging its presence
+	std::vector<std::tuple<std::string, GLuint, GLenum, std::string>> _textures;
 	bonobo::material_data _constants;
 
 	// Transformation data
@@ -1,5 +1,6 @@
 #include "Log.h"
 #include "opengl.hpp"
+#include "Profiler.h"
 #include "various.hpp"
 
 #include <cassert>
@@ -96,6 +97,10 @@ getStringForSeverity( GLenum severity )
 void
 beginDebugGroup(std::string const& message, GLuint id)
 {
+#if defined ENABLE_PROFILING && ENABLE_PROFILING != 0
+	Profiler::BeginGPUScope(message);
+#endif
+
 	if (!isSupported())
 		return;
 
@@ -105,10 +110,12 @@ beginDebugGroup(std::string const& message, GLuint id)
 void
 endDebugGroup()
 {
-	if (!isSupported())
-		return;
+	if (isSupported())
+		glPopDebugGroup();
 
-	glPopDebugGroup();
+#if defined ENABLE_PROFILING && ENABLE_PROFILING != 0
+	Profiler::EndGPUScope();
+#endif
 }
 
 void
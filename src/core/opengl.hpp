@@ -28,6 +28,8 @@ std::string getStringForSeverity(GLenum severity);
 //! under the specified name/ message.
 //!
 //! The call will be ignored if OpenGL debug facilities are not available.
+//! Regardless, the group is also a profiling scope timed on the CPU and
+//! the GPU, see `Profiler::BeginGPUScope()`.
 //!
 //! \param [in] message message or name for the new group to create
 //! \param [in] id An ID for the current message, which could be used for
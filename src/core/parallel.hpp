@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils
+{
+
+namespace parallel
+{
+
+//! \brief Number of worker threads to use for CPU-side parallel work.
+//!
+//! @return the number of hardware threads, or 1 if it can not be queried
+inline std::size_t worker_count()
+{
+	auto const hardware_threads = std::thread::hardware_concurrency();
+	return hardware_threads != 0u ? static_cast<std::size_t>(hardware_threads) : 1u;
+}
+
+//! \brief Threads kept around to run the tasks of parallel loops, so that
+//!        successive loops do not pay for creating and joining threads.
+//!
+//! The thread calling `run()` takes part in the work as well, so a pool
+//! for N-way parallelism only needs N - 1 threads. Loops nested inside a
+//! task, such as building the adjacency of each mesh of a scene, share
+//! those same threads rather than creating more of them: the thread
+//! running the task always makes progress on the nested loop itself.
+class thread_pool
+{
+public:
+	explicit thread_pool(std::size_t threads_nb)
+	{
+		_threads.reserve(threads_nb);
+		for (std::size_t i = 0u; i < threads_nb; ++i)
+			_threads.emplace_back([this]() { work(); });
+	}
+
+	~thread_pool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_is_stopping = true;
+		}
+		_wake_up.notify_all();
+		for (auto& thread : _threads)
+			thread.join();
+	}
+
+	thread_pool(thread_pool const&) = delete;
+	thread_pool& operator=(thread_pool const&) = delete;
+
+	//! \brief Run |task| once for each index of [0, tasks_nb), on at most
+	//!        |max_threads_nb| threads including the calling one, and only
+	//!        return once all of them are done.
+	//!
+	//! If a task throws, the tasks not started yet are skipped and the
+	//! first exception is rethrown on the calling thread, once no other
+	//! thread is still running one of the tasks.
+	void run(std::size_t tasks_nb, std::size_t max_threads_nb, std::function<void (std::size_t)> const& task)
+	{
+		if (tasks_nb == 0u)
+			return;
+		if (tasks_nb == 1u || max_threads_nb <= 1u || _threads.empty()) {
+			for (std::size_t i = 0u; i < tasks_nb; ++i)
+				task(i);
+			return;
+		}
+
+		auto const current_job = std::make_shared<job>(task, tasks_nb, max_threads_nb);
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_jobs.push_back(current_job);
+		}
+		_wake_up.notify_all();
+
+		current_job->work();
+
+		std::unique_lock<std::mutex> lock(current_job->mutex);
+		current_job->finished.wait(lock, [&current_job]() { return current_job->done_nb == current_job->tasks_nb; });
+		if (current_job->error)
+			std::rethrow_exception(current_job->error);
+	}
+
+private:
+	struct job
+	{
+		job(std::function<void (std::size_t)> const& task, std::size_t tasks_nb, std::size_t max_threads_nb)
+			: task(task), tasks_nb(tasks_nb), max_threads_nb(max_threads_nb) {}
+
+		// Claim the tasks left one at a time, until there are none. An
+		// exception escaping a worker thread would terminate the process,
+		// so it is kept for |run()| to rethrow instead.
+		void work()
+		{
+			for (auto i = next_task++; i < tasks_nb; i = next_task++) {
+				if (!has_failed) {
+					try {
+						task(i);
+					} catch (...) {
+						std::lock_guard<std::mutex> lock(mutex);
+						if (!error)
+							error = std::current_exception();
+						has_failed = true;
+					}
+				}
+				if (++done_nb == tasks_nb) {
+					std::lock_guard<std::mutex> lock(mutex);
+					finished.notify_all();
+				}
+			}
+		}
+
+		bool is_open() const
+		{
+			return next_task < tasks_nb && threads_nb < max_threads_nb;
+		}
+
+		std::function<void (std::size_t)> const& task;
+		std::size_t const tasks_nb;
+		std::size_t const max_threads_nb;
+		std::atomic<std::size_t> next_task{0u};
+		std::atomic<std::size_t> done_nb{0u};
+		std::atomic<std::size_t> threads_nb{1u}; // the calling one
+		std::atomic<bool> has_failed{false};
+		std::exception_ptr error;
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+
+	void work()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		for (;;) {
+			_wake_up.wait(lock, [this]() { return _is_stopping || !_jobs.empty(); });
+			if (_is_stopping)
+				return;
+
+			// Jobs whose tasks are all claimed, or which have as many
+			// threads as they asked for, are of no use anymore.
+			auto const current_job = _jobs.front();
+			_jobs.pop_front();
+			if (!current_job->is_open())
+				continue;
+			if (++current_job->threads_nb < current_job->max_threads_nb)
+				_jobs.push_front(current_job);
+
+			lock.unlock();
+			current_job->work();
+			lock.lock();
+		}
+	}
+
+	std::vector<std::thread> _threads;
+	std::deque<std::shared_ptr<job>> _jobs;
+	std::mutex _mutex;
+	std::condition_variable _wake_up;
+	bool _is_stopping{false};
+};
+
+//! \brief Pool shared by all parallel loops, with one thread less than
+//!        |worker_count()|.
+inline thread_pool& default_pool()
+{
+	static thread_pool pool(worker_count() - 1u);
+	return pool;
+}
+
+//! \brief Number of chunks |for_each_chunk()| will split a range into.
+//!
+//! The split only depends on its arguments, so that several successive
+//! calls over the same range see the exact same chunks; this is needed by
+//! algorithms like radix sort which keep per-chunk state between passes.
+//!
+//! @param [in] count number of elements in the range
+//! @param [in] min_chunk_size minimum number of elements per chunk, to
+//!             avoid splitting tiny amounts of work
+//! @param [in] workers_nb maximum number of threads to spread the work
+//!             over
+//! @return the number of chunks, at least 1
+inline std::size_t chunk_count(std::size_t count, std::size_t min_chunk_size, std::size_t workers_nb = worker_count())
+{
+	auto const max_chunks = (count + min_chunk_size - 1u) / std::max<std::size_t>(min_chunk_size, 1u);
+	return std::max<std::size_t>(std::min(workers_nb, max_chunks), 1u);
+}
+
+//! \brief Split [0, count) into contiguous chunks and process them
+//!        concurrently.
+//!
+//! Chunks run on the threads of |default_pool()| as well as on the
+//! calling one, and the call only returns once all chunks have been
+//! processed.
+//!
+//! @param [in] count number of elements in the range
+//! @param [in] min_chunk_size see |chunk_count()|
+//! @param [in] func callable with the signature
+//!             `void (std::size_t begin, std::size_t end, std::size_t chunk)`
+//! @param [in] workers_nb see |chunk_count()|
+template<typename F>
+void for_each_chunk(std::size_t count, std::size_t min_chunk_size, F const& func, std::size_t workers_nb = worker_count())
+{
+	auto const chunks_nb = chunk_count(count, min_chunk_size, workers_nb);
+	auto const chunk_begin = [count, chunks_nb](std::size_t chunk) {
+		return count * chunk / chunks_nb;
+	};
+
+	default_pool().run(chunks_nb, chunks_nb, [&func, &chunk_begin](std::size_t chunk) {
+		func(chunk_begin(chunk), chunk_begin(chunk + 1u), chunk);
+	});
+}
+
+//! \brief Process each index of [0, count) concurrently, each worker
+//!        picking the next index left once done with its previous one.
+//!
+//! Unlike |for_each_chunk()|, this balances the work when elements take
+//! very different times to process, such as the meshes of a scene. The
+//! calling thread is one of the workers, and the call only returns once
+//! all indices have been processed.
+//!
+//! @param [in] count number of elements in the range
+//! @param [in] func callable with the signature `void (std::size_t index)`
+//! @param [in] workers_nb maximum number of threads to spread the work
+//!             over
+template<typename F>
+void for_each_index(std::size_t count, F const& func, std::size_t workers_nb = worker_count())
+{
+	default_pool().run(count, workers_nb, [&func](std::size_t index) {
+		func(index);
+	});
+}
+
+} // end of namespace parallel
+
+} // end of namespace utils
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "core/meshlets.hpp"
+#include "core/various.hpp"
+#include "core/vertex_layout.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bonobo
+{
+	struct material_data
+	{
+		glm::vec3 diffuse{0.0f};
+		glm::vec3 specular{0.0f};
+		glm::vec3 ambient{0.0f};
+		glm::vec3 emissive{0.0f};
+		float shininess{0.0f};
+		float indexOfRefraction{1.0f};
+		float opacity{1.0f};
+	};
+
+	//! \brief Texture used by a mesh.
+	struct texture_reference
+	{
+		std::string sampler; //!< name of the GLSL sampler, i.e. "diffuse_texture"
+		std::string path;    //!< path to the image, relative to the scene folder
+		std::string label;   //!< debug label given to the texture object
+	};
+
+	//! \brief Non-owning view of the data needed to create a
+	//!        `mesh_data`.
+	struct mesh_view
+	{
+		std::string name{"un-named mesh"};
+		std::uint8_t const* vertex_data{nullptr};   //!< content of the vertex buffer
+		std::size_t vertex_data_size{0u};           //!< size in bytes of |vertex_data|
+		std::uint32_t vertices_nb{0u};
+		std::uint32_t indices_nb{0u};
+		std::uint32_t const* adjacency_indices{nullptr};
+		std::uint32_t adjacency_nb{0u};
+		//! Four indices per edge, see `adjacency::extract_edges()`; only
+		//! present if the scene was loaded with edges.
+		std::uint32_t const* edge_indices{nullptr};
+		std::uint32_t edges_nb{0u};
+		//! Where and how each attribute is stored in |vertex_data|,
+		//! indexed by `shader_bindings`; see `vertex_layout`.
+		vertex_layout::attributes attributes{};
+		glm::vec3 bounds_min{0.0f}; //!< corner of the model-space bounding box of the vertices
+		glm::vec3 bounds_max{0.0f}; //!< opposite corner of that box
+		//! Clusters of consecutive triangles of |adjacency_indices|, see
+		//! `meshlets::build()`.
+		meshlets::meshlet const* meshlets{nullptr};
+		std::uint32_t meshlets_nb{0u};
+		material_data material{};
+		std::vector<texture_reference> textures;
+	};
+
+	//! \brief Buffers produced by processing a mesh on the CPU, see
+	//!        `mesh_processing::process()`; a `mesh_view` describes their
+	//!        layout, along with the material of the mesh.
+	struct mesh_blob
+	{
+		std::vector<std::uint8_t> vertex_data;
+		std::vector<std::uint32_t> adjacency_indices;
+		std::vector<std::uint32_t> edge_indices; //!< empty if processed without edges
+		std::vector<meshlets::meshlet> meshlets;
+	};
+
+	//! \brief Meshes of a scene once processed on the CPU, but before
+	//!        anything got uploaded to the GPU.
+	//!
+	//! The views in |meshes| point either into |cache_file|, when the
+	//! scene came from its mesh cache, or into |blobs| otherwise. Moving
+	//! a `scene_data` around keeps those pointers valid.
+	struct scene_data
+	{
+		std::string filename;
+		std::string parent_folder; //!< folder texture paths are relative to, ending with a '/'
+		std::vector<mesh_view> meshes;
+
+		utils::MappedFile cache_file;
+		std::vector<mesh_blob> blobs; //!< one per mesh, unless read from the mesh cache
+	};
+}
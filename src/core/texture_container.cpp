@@ -0,0 +1,511 @@
+#include "texture_container.hpp"
+
+#include "core/Log.h"
+#include "core/various.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+	using bonobo::texture_container::compressed_image;
+	using bonobo::texture_container::format;
+
+	// DDS, as documented at
+	// https://docs.microsoft.com/windows/win32/direct3ddds/dds-header
+	constexpr std::uint32_t dds_magic = 0x20534444u; // "DDS "
+	constexpr std::uint32_t dds_header_size = 124u;
+	constexpr std::uint32_t dds_pixel_format_size = 32u;
+	constexpr std::uint32_t dds_dx10_header_size = 20u;
+	constexpr std::uint32_t ddsd_caps = 0x1u;
+	constexpr std::uint32_t ddsd_height = 0x2u;
+	constexpr std::uint32_t ddsd_width = 0x4u;
+	constexpr std::uint32_t ddsd_pixel_format = 0x1000u;
+	constexpr std::uint32_t ddsd_mipmap_count = 0x20000u;
+	constexpr std::uint32_t ddsd_linear_size = 0x80000u;
+	constexpr std::uint32_t ddpf_fourcc = 0x4u;
+	constexpr std::uint32_t ddscaps_complex = 0x8u;
+	constexpr std::uint32_t ddscaps_texture = 0x1000u;
+	constexpr std::uint32_t ddscaps_mipmap = 0x400000u;
+	constexpr std::uint32_t ddscaps2_cubemap = 0x200u;
+	constexpr std::uint32_t ddscaps2_volume = 0x200000u;
+	constexpr std::uint32_t d3d10_resource_dimension_texture2d = 3u;
+
+	// Largest extent OpenGL 4.x implementations have to support; anything
+	// bigger is more likely a corrupted header than an actual texture.
+	constexpr std::uint32_t max_extent = 16384u;
+
+	constexpr std::uint32_t makeFourCC(char a, char b, char c, char d)
+	{
+		return static_cast<std::uint32_t>(static_cast<std::uint8_t>(a))
+		     | (static_cast<std::uint32_t>(static_cast<std::uint8_t>(b)) << 8u)
+		     | (static_cast<std::uint32_t>(static_cast<std::uint8_t>(c)) << 16u)
+		     | (static_cast<std::uint32_t>(static_cast<std::uint8_t>(d)) << 24u);
+	}
+
+	// KTX2, as documented at
+	// https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+	constexpr std::uint8_t ktx2_identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+	constexpr std::size_t ktx2_header_size = 80u;
+	constexpr std::size_t ktx2_level_index_entry_size = 24u;
+
+	// Khronos Data Format descriptor values used for the basic descriptor
+	// block of block-compressed formats.
+	constexpr std::uint8_t khr_df_model_bc1a = 128u;
+	constexpr std::uint8_t khr_df_model_bc3 = 130u;
+	constexpr std::uint8_t khr_df_model_bc7 = 136u;
+	constexpr std::uint8_t khr_df_channel_color = 0u;
+	constexpr std::uint8_t khr_df_channel_bc1a_alpha_present = 1u;
+	constexpr std::uint8_t khr_df_channel_bc3_alpha = 15u;
+	constexpr std::uint8_t khr_df_primaries_bt709 = 1u;
+	constexpr std::uint8_t khr_df_transfer_linear = 1u;
+	constexpr std::uint8_t khr_df_transfer_srgb = 2u;
+
+	struct format_codes
+	{
+		format block_format;
+		bool is_srgb;
+		std::uint32_t dxgi_format;
+		std::uint32_t vk_format;
+	};
+
+	constexpr format_codes known_formats[] = {
+		{format::bc1, false, 71u, 133u},
+		{format::bc1, true,  72u, 134u},
+		{format::bc3, false, 77u, 137u},
+		{format::bc3, true,  78u, 138u},
+		{format::bc7, false, 98u, 145u},
+		{format::bc7, true,  99u, 146u},
+	};
+
+	format_codes const* findCodes(format block_format, bool is_srgb)
+	{
+		for (auto const& codes : known_formats)
+			if (codes.block_format == block_format && codes.is_srgb == is_srgb)
+				return &codes;
+		return nullptr;
+	}
+
+	std::uint32_t readU32(std::uint8_t const* data)
+	{
+		std::uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	std::uint64_t readU64(std::uint8_t const* data)
+	{
+		std::uint64_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	void appendU8(std::vector<std::uint8_t>& buffer, std::uint8_t value)
+	{
+		buffer.push_back(value);
+	}
+
+	void appendU32(std::vector<std::uint8_t>& buffer, std::uint32_t value)
+	{
+		for (std::uint32_t i = 0u; i < 4u; ++i)
+			buffer.push_back(static_cast<std::uint8_t>(value >> (8u * i)));
+	}
+
+	void appendU64(std::vector<std::uint8_t>& buffer, std::uint64_t value)
+	{
+		for (std::uint32_t i = 0u; i < 8u; ++i)
+			buffer.push_back(static_cast<std::uint8_t>(value >> (8u * i)));
+	}
+
+	void padTo(std::vector<std::uint8_t>& buffer, std::size_t alignment)
+	{
+		buffer.resize((buffer.size() + alignment - 1u) / alignment * alignment, 0u);
+	}
+
+	bool hasExtension(std::string const& filename, char const* extension)
+	{
+		auto const length = std::strlen(extension);
+		if (filename.size() < length)
+			return false;
+		return std::equal(filename.end() - static_cast<std::ptrdiff_t>(length), filename.end(), extension,
+		                  [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == b; });
+	}
+
+	// Lay out the levels of a |width|×|height| image one after the other,
+	// largest first, as long as they fit in |available| bytes.
+	char const* layOutLevels(compressed_image& image, std::uint32_t levels_nb, std::size_t available)
+	{
+		if (image.width == 0u || image.height == 0u)
+			return "its size is zero";
+		if (image.width > max_extent || image.height > max_extent)
+			return "it is larger than 16384×16384";
+		auto max_levels_nb = 1u;
+		for (auto extent = std::max(image.width, image.height); extent > 1u; extent >>= 1u)
+			++max_levels_nb;
+		if (levels_nb > max_levels_nb)
+			return "it has more mipmap levels than its size allows";
+
+		image.levels.resize(levels_nb);
+		std::size_t offset = 0u;
+		for (std::uint32_t i = 0u; i < levels_nb; ++i) {
+			auto& level = image.levels[i];
+			level.width = std::max(image.width >> i, 1u);
+			level.height = std::max(image.height >> i, 1u);
+			level.offset = offset;
+			level.size = bonobo::texture_container::level_size(image.block_format, level.width, level.height);
+			offset += level.size;
+		}
+		if (offset > available)
+			return "it is truncated";
+
+		return nullptr;
+	}
+
+	char const* parseDDS(std::uint8_t const* data, std::size_t size, compressed_image& image)
+	{
+		if (size < 4u + dds_header_size || readU32(data) != dds_magic)
+			return "it is not a DDS file";
+
+		auto const* const header = data + 4u;
+		auto const* const pixel_format = header + 72u;
+		if (readU32(header) != dds_header_size || readU32(pixel_format) != dds_pixel_format_size)
+			return "its header is malformed";
+		if ((readU32(pixel_format + 4u) & ddpf_fourcc) == 0u)
+			return "it is not block-compressed";
+		if ((readU32(header + 108u) & (ddscaps2_cubemap | ddscaps2_volume)) != 0u)
+			return "cube maps and volume textures are not supported";
+
+		auto data_offset = std::size_t(4u) + dds_header_size;
+		auto const fourcc = readU32(pixel_format + 8u);
+		if (fourcc == makeFourCC('D', 'X', 'T', '1')) {
+			image.block_format = format::bc1;
+		} else if (fourcc == makeFourCC('D', 'X', 'T', '5')) {
+			image.block_format = format::bc3;
+		} else if (fourcc == makeFourCC('D', 'X', '1', '0')) {
+			if (size < data_offset + dds_dx10_header_size)
+				return "it is truncated";
+			auto const* const dx10_header = data + data_offset;
+			data_offset += dds_dx10_header_size;
+			if (readU32(dx10_header + 4u) != d3d10_resource_dimension_texture2d || readU32(dx10_header + 12u) > 1u)
+				return "only single 2D-textures are supported";
+
+			auto const dxgi_format = readU32(dx10_header);
+			auto const codes = std::find_if(std::begin(known_formats), std::end(known_formats),
+			                                [dxgi_format](format_codes const& codes) { return codes.dxgi_format == dxgi_format; });
+			if (codes == std::end(known_formats))
+				return "its DXGI format is not BC1, BC3 nor BC7";
+			image.block_format = codes->block_format;
+			image.is_srgb = codes->is_srgb;
+		} else {
+			return "its FourCC is not DXT1, DXT5 nor DX10";
+		}
+
+		image.height = readU32(header + 8u);
+		image.width = readU32(header + 12u);
+		auto const levels_nb = (readU32(header + 4u) & ddsd_mipmap_count) != 0u ? std::max(readU32(header + 24u), 1u) : 1u;
+		if (auto const reason = layOutLevels(image, levels_nb, size - data_offset))
+			return reason;
+
+		auto const data_size = image.levels.back().offset + image.levels.back().size;
+		image.data.assign(data + data_offset, data + data_offset + data_size);
+
+		return nullptr;
+	}
+
+	char const* parseKTX2(std::uint8_t const* data, std::size_t size, compressed_image& image)
+	{
+		if (size < ktx2_header_size || std::memcmp(data, ktx2_identifier, sizeof(ktx2_identifier)) != 0)
+			return "it is not a KTX2 file";
+
+		auto const vk_format = readU32(data + 12u);
+		image.width = readU32(data + 20u);
+		image.height = readU32(data + 24u);
+		auto const depth = readU32(data + 28u);
+		auto const layers_nb = readU32(data + 32u);
+		auto const faces_nb = readU32(data + 36u);
+		auto const levels_nb = std::max(readU32(data + 40u), 1u);
+		auto const supercompression_scheme = readU32(data + 44u);
+
+		auto const codes = std::find_if(std::begin(known_formats), std::end(known_formats),
+		                                [vk_format](format_codes const& codes) { return codes.vk_format == vk_format; });
+		// The RGB-only BC1 formats share their blocks with the RGBA ones.
+		if (vk_format == 131u || vk_format == 132u) {
+			image.block_format = format::bc1;
+			image.is_srgb = vk_format == 132u;
+		} else if (codes != std::end(known_formats)) {
+			image.block_format = codes->block_format;
+			image.is_srgb = codes->is_srgb;
+		} else {
+			return "its Vulkan format is not BC1, BC3 nor BC7";
+		}
+		if (depth > 1u || layers_nb > 1u || faces_nb != 1u)
+			return "only single 2D-textures are supported";
+		if (supercompression_scheme != 0u)
+			return "supercompressed files are not supported";
+		if (size < ktx2_header_size + levels_nb * ktx2_level_index_entry_size)
+			return "it is truncated";
+
+		// Levels can be anywhere after the level index, but can not
+		// overlap, so all of them have to fit in what is left of the file.
+		auto const data_offset = ktx2_header_size + levels_nb * ktx2_level_index_entry_size;
+		if (auto const reason = layOutLevels(image, levels_nb, size - data_offset))
+			return reason;
+
+		// Check every level against the file before allocating anything.
+		for (std::uint32_t i = 0u; i < levels_nb; ++i) {
+			auto const* const entry = data + ktx2_header_size + i * ktx2_level_index_entry_size;
+			auto const level_offset = readU64(entry);
+			auto const level_size = readU64(entry + 8u);
+			if (level_size != image.levels[i].size)
+				return "the size of one of its levels does not match its format";
+			if (level_offset < data_offset)
+				return "one of its levels overlaps its header";
+			if (level_offset > size || level_size > size - level_offset)
+				return "it is truncated";
+		}
+
+		image.data.resize(image.levels.back().offset + image.levels.back().size);
+		for (std::uint32_t i = 0u; i < levels_nb; ++i) {
+			auto const level_offset = readU64(data + ktx2_header_size + i * ktx2_level_index_entry_size);
+			auto const& level = image.levels[i];
+			std::memcpy(image.data.data() + level.offset, data + level_offset, level.size);
+		}
+
+		return nullptr;
+	}
+
+	std::vector<std::uint8_t> serializeDDS(compressed_image const& image, format_codes const& codes)
+	{
+		// Plain DXT1 and DXT5 files are the most widely understood; the
+		// extended header is only needed for BC7 and for sRGB.
+		bool const needs_dx10_header = image.block_format == format::bc7 || image.is_srgb;
+		bool const has_mipmaps = image.levels.size() > 1u;
+
+		std::vector<std::uint8_t> buffer;
+		buffer.reserve(4u + dds_header_size + dds_dx10_header_size + image.data.size());
+		appendU32(buffer, dds_magic);
+		appendU32(buffer, dds_header_size);
+		appendU32(buffer, ddsd_caps | ddsd_height | ddsd_width | ddsd_pixel_format | ddsd_linear_size
+		                  | (has_mipmaps ? ddsd_mipmap_count : 0u));
+		appendU32(buffer, image.height);
+		appendU32(buffer, image.width);
+		appendU32(buffer, static_cast<std::uint32_t>(image.levels.front().size));
+		appendU32(buffer, 0u); // depth
+		appendU32(buffer, static_cast<std::uint32_t>(image.levels.size()));
+		for (std::uint32_t i = 0u; i < 11u; ++i)
+			appendU32(buffer, 0u);
+
+		appendU32(buffer, dds_pixel_format_size);
+		appendU32(buffer, ddpf_fourcc);
+		if (needs_dx10_header)
+			appendU32(buffer, makeFourCC('D', 'X', '1', '0'));
+		else
+			appendU32(buffer, image.block_format == format::bc1 ? makeFourCC('D', 'X', 'T', '1') : makeFourCC('D', 'X', 'T', '5'));
+		for (std::uint32_t i = 0u; i < 5u; ++i)
+			appendU32(buffer, 0u);
+
+		appendU32(buffer, ddscaps_texture | (has_mipmaps ? ddscaps_complex | ddscaps_mipmap : 0u));
+		for (std::uint32_t i = 0u; i < 4u; ++i)
+			appendU32(buffer, 0u);
+
+		if (needs_dx10_header) {
+			appendU32(buffer, codes.dxgi_format);
+			appendU32(buffer, d3d10_resource_dimension_texture2d);
+			appendU32(buffer, 0u); // misc flags
+			appendU32(buffer, 1u); // array size
+			appendU32(buffer, 0u); // alpha mode: unknown
+		}
+
+		buffer.insert(buffer.end(), image.data.begin(), image.data.end());
+		return buffer;
+	}
+
+	std::vector<std::uint8_t> serializeKTX2(compressed_image const& image, format_codes const& codes)
+	{
+		auto const block_size = bonobo::texture_container::block_size(image.block_format);
+
+		struct sample
+		{
+			std::uint16_t bit_offset;
+			std::uint8_t bit_length;
+			std::uint8_t channel;
+		};
+		std::vector<sample> samples;
+		std::uint8_t color_model = 0u;
+		switch (image.block_format) {
+		case format::bc1:
+			color_model = khr_df_model_bc1a;
+			samples.push_back({0u, 64u, khr_df_channel_bc1a_alpha_present});
+			break;
+		case format::bc3:
+			color_model = khr_df_model_bc3;
+			samples.push_back({0u, 64u, khr_df_channel_bc3_alpha});
+			samples.push_back({64u, 64u, khr_df_channel_color});
+			break;
+		case format::bc7:
+			color_model = khr_df_model_bc7;
+			samples.push_back({0u, 128u, khr_df_channel_color});
+			break;
+		}
+
+		std::vector<std::uint8_t> dfd;
+		auto const descriptor_block_size = static_cast<std::uint32_t>(24u + 16u * samples.size());
+		appendU32(dfd, 4u + descriptor_block_size);
+		appendU32(dfd, 0u); // Khronos vendor, basic descriptor block
+		appendU32(dfd, 2u | (descriptor_block_size << 16u));
+		appendU8(dfd, color_model);
+		appendU8(dfd, khr_df_primaries_bt709);
+		appendU8(dfd, image.is_srgb ? khr_df_transfer_srgb : khr_df_transfer_linear);
+		appendU8(dfd, 0u); // straight alpha
+		appendU32(dfd, 3u | (3u << 8u)); // 4×4×1×1 texel blocks
+		appendU32(dfd, static_cast<std::uint32_t>(block_size));
+		appendU32(dfd, 0u);
+		for (auto const& s : samples) {
+			appendU32(dfd, s.bit_offset | (static_cast<std::uint32_t>(s.bit_length - 1u) << 16u)
+			               | (static_cast<std::uint32_t>(s.channel) << 24u));
+			appendU32(dfd, 0u); // sample position
+			appendU32(dfd, 0u);
+			appendU32(dfd, 0xFFFFFFFFu);
+		}
+
+		std::vector<std::uint8_t> kvd;
+		auto const appendKeyValue = [&kvd](std::string const& key, std::string const& value) {
+			appendU32(kvd, static_cast<std::uint32_t>(key.size() + value.size() + 2u));
+			kvd.insert(kvd.end(), key.begin(), key.end());
+			kvd.push_back(0u);
+			kvd.insert(kvd.end(), value.begin(), value.end());
+			kvd.push_back(0u);
+			padTo(kvd, 4u);
+		};
+		// Keys have to be sorted.
+		appendKeyValue("KTXorientation", "ru");
+		appendKeyValue("KTXwriter", "NPRR texture_transcoder");
+
+		auto const levels_nb = image.levels.size();
+		auto const dfd_offset = ktx2_header_size + levels_nb * ktx2_level_index_entry_size;
+		auto const kvd_offset = dfd_offset + dfd.size();
+
+		// Levels are stored smallest first, each aligned on a block.
+		std::vector<std::uint64_t> level_offsets(levels_nb);
+		auto offset = kvd_offset + kvd.size();
+		for (std::size_t i = levels_nb; i-- > 0u;) {
+			offset = (offset + block_size - 1u) / block_size * block_size;
+			level_offsets[i] = offset;
+			offset += image.levels[i].size;
+		}
+
+		std::vector<std::uint8_t> buffer;
+		buffer.reserve(offset);
+		buffer.insert(buffer.end(), std::begin(ktx2_identifier), std::end(ktx2_identifier));
+		appendU32(buffer, codes.vk_format);
+		appendU32(buffer, 1u); // type size
+		appendU32(buffer, image.width);
+		appendU32(buffer, image.height);
+		appendU32(buffer, 0u); // depth
+		appendU32(buffer, 0u); // layers
+		appendU32(buffer, 1u); // faces
+		appendU32(buffer, static_cast<std::uint32_t>(levels_nb));
+		appendU32(buffer, 0u); // no supercompression
+		appendU32(buffer, static_cast<std::uint32_t>(dfd_offset));
+		appendU32(buffer, static_cast<std::uint32_t>(dfd.size()));
+		appendU32(buffer, static_cast<std::uint32_t>(kvd_offset));
+		appendU32(buffer, static_cast<std::uint32_t>(kvd.size()));
+		appendU64(buffer, 0u);
+		appendU64(buffer, 0u);
+		for (std::size_t i = 0u; i < levels_nb; ++i) {
+			appendU64(buffer, level_offsets[i]);
+			appendU64(buffer, image.levels[i].size);
+			appendU64(buffer, image.levels[i].size);
+		}
+		buffer.insert(buffer.end(), dfd.begin(), dfd.end());
+		buffer.insert(buffer.end(), kvd.begin(), kvd.end());
+		for (std::size_t i = levels_nb; i-- > 0u;) {
+			buffer.resize(level_offsets[i], 0u);
+			auto const level_data = image.data.begin() + static_cast<std::ptrdiff_t>(image.levels[i].offset);
+			buffer.insert(buffer.end(), level_data, level_data + static_cast<std::ptrdiff_t>(image.levels[i].size));
+		}
+
+		return buffer;
+	}
+}
+
+std::size_t
+bonobo::texture_container::block_size(format const block_format)
+{
+	return block_format == format::bc1 ? 8u : 16u;
+}
+
+std::size_t
+bonobo::texture_container::level_size(format const block_format, std::uint32_t const width, std::uint32_t const height)
+{
+	// Rounding up as (width + 3) / 4 would wrap for the largest widths.
+	auto const blocks_per_row = static_cast<std::size_t>(width / 4u + (width % 4u != 0u ? 1u : 0u));
+	auto const blocks_per_column = static_cast<std::size_t>(height / 4u + (height % 4u != 0u ? 1u : 0u));
+	return blocks_per_row * blocks_per_column * block_size(block_format);
+}
+
+char const*
+bonobo::texture_container::format_name(format const block_format)
+{
+	switch (block_format) {
+	case format::bc1: return "BC1";
+	case format::bc3: return "BC3";
+	case format::bc7: return "BC7";
+	}
+	return "unknown";
+}
+
+bool
+bonobo::texture_container::is_container(std::string const& filename)
+{
+	return hasExtension(filename, ".dds") || hasExtension(filename, ".ktx2");
+}
+
+bool
+bonobo::texture_container::read(std::string const& filename, compressed_image& image)
+{
+	utils::MappedFile const file(filename);
+	if (!file.is_open()) {
+		LogWarning("Couldn't open texture container \"%s\".", filename.c_str());
+		return false;
+	}
+
+	image = compressed_image{};
+	auto const reason = hasExtension(filename, ".ktx2") ? parseKTX2(file.data(), file.size(), image)
+	                                                    : parseDDS(file.data(), file.size(), image);
+	if (reason != nullptr) {
+		LogWarning("Ignoring texture container \"%s\": %s.", filename.c_str(), reason);
+		image = compressed_image{};
+		return false;
+	}
+
+	return true;
+}
+
+bool
+bonobo::texture_container::write(std::string const& filename, compressed_image const& image)
+{
+	auto const* const codes = findCodes(image.block_format, image.is_srgb);
+	if (codes == nullptr || image.levels.empty()) {
+		LogError("Can not write an empty image to \"%s\".", filename.c_str());
+		return false;
+	}
+
+	auto const buffer = hasExtension(filename, ".ktx2") ? serializeKTX2(image, *codes) : serializeDDS(image, *codes);
+
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		LogError("Failed to create texture container \"%s\".", filename.c_str());
+		return false;
+	}
+	file.write(reinterpret_cast<char const*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+	if (!file.good()) {
+		LogError("Failed to write texture container \"%s\".", filename.c_str());
+		return false;
+	}
+
+	return true;
+}
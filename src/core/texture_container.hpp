@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Block-compressed 2D-images stored in DDS or KTX2 containers,
+	//!        along with their precomputed mipmap chain.
+	//!
+	//! Only the BC1, BC3 and BC7 formats are handled, without
+	//! supercompression, array layers, cube faces nor depth. Nothing in
+	//! here touches OpenGL, so containers can be read from any thread.
+	//!
+	//! Blocks are expected to be stored bottom row first, which is what
+	//! `loadTexture2D()` gets after flipping regular images; KTX2 files
+	//! written here advertise it through their `KTXorientation` key.
+	namespace texture_container
+	{
+		enum class format : std::uint32_t {
+			bc1 = 0u, //!< RGB and 1-bit alpha, 8 bytes per 4×4 block
+			bc3,      //!< RGBA, 16 bytes per 4×4 block
+			bc7       //!< RGBA, 16 bytes per 4×4 block
+		};
+
+		struct level
+		{
+			std::uint32_t width{0u};
+			std::uint32_t height{0u};
+			std::size_t offset{0u}; //!< in bytes, from the start of the image data
+			std::size_t size{0u};   //!< in bytes
+		};
+
+		struct compressed_image
+		{
+			format block_format{format::bc1};
+			bool is_srgb{false};
+			std::uint32_t width{0u};
+			std::uint32_t height{0u};
+			std::vector<level> levels;       //!< largest first
+			std::vector<std::uint8_t> data;  //!< blocks of all levels, one after the other
+		};
+
+		//! \brief Size in bytes of a 4×4 block.
+		std::size_t block_size(format block_format);
+
+		//! \brief Size in bytes of a |width|×|height| level.
+		std::size_t level_size(format block_format, std::uint32_t width, std::uint32_t height);
+
+		char const* format_name(format block_format);
+
+		//! \brief Whether |filename| has a `.dds` or `.ktx2` extension.
+		bool is_container(std::string const& filename);
+
+		//! \brief Read the DDS or KTX2 container at |filename|, based on
+		//!        its extension.
+		//!
+		//! @return false if the file is missing, malformed, or uses
+		//!         features not handled here; the reason is logged
+		bool read(std::string const& filename, compressed_image& image);
+
+		//! \brief Write |image| as a DDS or KTX2 container, based on the
+		//!        extension of |filename|.
+		//!
+		//! @return false if the file could not be written
+		bool write(std::string const& filename, compressed_image const& image);
+	}
+}
@@ -6,8 +6,14 @@
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <utility>
 #if defined(_WIN32)
 #include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 #if defined(_WIN32)
@@ -88,3 +94,120 @@ utils::slurp_file(std::string const& path)
 
   return std::string(content.get());
 }
+
+utils::MappedFile::MappedFile(std::string const& path)
+{
+#if defined(_WIN32)
+  HANDLE const file = ::CreateFileW(utils::widen(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return;
+
+  LARGE_INTEGER file_size;
+  if (!::GetFileSizeEx(file, &file_size)) {
+    ::CloseHandle(file);
+    return;
+  }
+  _file = file;
+  _size = static_cast<std::size_t>(file_size.QuadPart);
+  _is_open = true;
+  if (_size == 0u)
+    return;
+
+  _mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (_mapping == nullptr) {
+    LogError("Failed to map \"%s\"; CreateFileMapping generated the error code %d.", path.c_str(), ::GetLastError());
+    release();
+    return;
+  }
+  _data = static_cast<std::uint8_t const*>(::MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+  if (_data == nullptr) {
+    LogError("Failed to map \"%s\"; MapViewOfFile generated the error code %d.", path.c_str(), ::GetLastError());
+    release();
+  }
+#else
+  int const file = ::open(path.c_str(), O_RDONLY);
+  if (file < 0)
+    return;
+
+  struct stat file_stat;
+  if (::fstat(file, &file_stat) != 0) {
+    ::close(file);
+    return;
+  }
+  _size = static_cast<std::size_t>(file_stat.st_size);
+  _is_open = true;
+  if (_size != 0u) {
+    void* const mapping = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (mapping == MAP_FAILED) {
+      LogError("Failed to map \"%s\".", path.c_str());
+      _size = 0u;
+      _is_open = false;
+    } else {
+      _data = static_cast<std::uint8_t const*>(mapping);
+    }
+  }
+
+  // The mapping stays valid after the file descriptor is closed.
+  ::close(file);
+#endif
+}
+
+utils::MappedFile::~MappedFile()
+{
+  release();
+}
+
+utils::MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+  *this = std::move(other);
+}
+
+utils::MappedFile&
+utils::MappedFile::operator=(MappedFile&& other) noexcept
+{
+  if (this == &other)
+    return *this;
+
+  release();
+  std::swap(_data, other._data);
+  std::swap(_size, other._size);
+  std::swap(_is_open, other._is_open);
+#if defined(_WIN32)
+  std::swap(_file, other._file);
+  std::swap(_mapping, other._mapping);
+#endif
+  return *this;
+}
+
+void
+utils::MappedFile::release() noexcept
+{
+#if defined(_WIN32)
+  if (_data != nullptr)
+    ::UnmapViewOfFile(_data);
+  if (_mapping != nullptr)
+    ::CloseHandle(static_cast<HANDLE>(_mapping));
+  if (_file != nullptr)
+    ::CloseHandle(static_cast<HANDLE>(_file));
+  _file = nullptr;
+  _mapping = nullptr;
+#else
+  if (_data != nullptr)
+    ::munmap(const_cast<std::uint8_t*>(_data), _size);
+#endif
+  _data = nullptr;
+  _size = 0u;
+  _is_open = false;
+}
+
+std::uint64_t
+utils::hash_bytes(void const* data, std::size_t size, std::uint64_t seed)
+{
+  auto const* bytes = static_cast<std::uint8_t const*>(data);
+  std::uint64_t hash = seed;
+  for (std::size_t i = 0u; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 0x100000001B3ULL;
+  }
+  return hash;
+}
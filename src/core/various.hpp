@@ -1,6 +1,8 @@
 #pragma once
 
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 
@@ -17,4 +19,44 @@ inline std::string const& widen(std::string const& utf8) { return utf8; }
 
 std::string slurp_file(std::string const& path);
 
+//! \brief Read-only view of a whole file, mapped into memory.
+//!
+//! The mapping is released when the object is destroyed; pointers
+//! obtained through |data()| must not outlive it.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	explicit MappedFile(std::string const& path);
+	~MappedFile();
+
+	MappedFile(MappedFile const&) = delete;
+	MappedFile& operator=(MappedFile const&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	bool is_open() const noexcept { return _is_open; }
+	std::uint8_t const* data() const noexcept { return _data; }
+	std::size_t size() const noexcept { return _size; }
+
+private:
+	void release() noexcept;
+
+	std::uint8_t const* _data{nullptr};
+	std::size_t _size{0u};
+	bool _is_open{false};
+#if defined(_WIN32)
+	void* _file{nullptr};
+	void* _mapping{nullptr};
+#endif
+};
+
+//! \brief Compute the 64-bit FNV-1a hash of a sequence of bytes.
+//!
+//! @param [in] data bytes to hash
+//! @param [in] size number of bytes to hash
+//! @param [in] seed hash to continue from, for hashing several sequences
+//! @return the hash of the bytes
+std::uint64_t hash_bytes(void const* data, std::size_t size, std::uint64_t seed = 0xCBF29CE484222325ULL);
+
 } // end of namespace
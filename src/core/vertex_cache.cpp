@@ -0,0 +1,137 @@
+#include "vertex_cache.hpp"
+
+#include <cassert>
+#include <limits>
+
+namespace
+{
+	constexpr std::uint32_t invalid_index = std::numeric_limits<std::uint32_t>::max();
+}
+
+float
+bonobo::vertex_cache::acmr(std::uint32_t const* indices, std::size_t primitives_nb,
+                           std::uint32_t indices_per_primitive, std::uint32_t vertices_nb,
+                           std::uint32_t cache_size, std::uint32_t const* primitive_order)
+{
+	if (primitives_nb == 0u)
+		return 0.0f;
+
+	// A vertex is in the FIFO cache if fewer than |cache_size| misses
+	// happened since it was last loaded in it.
+	std::vector<std::uint64_t> loaded_at(vertices_nb, 0u);
+	std::uint64_t misses_nb = 0u;
+	auto time = static_cast<std::uint64_t>(cache_size) + 1u;
+	for (std::size_t p = 0u; p < primitives_nb; ++p) {
+		auto const primitive = primitive_order != nullptr ? primitive_order[p] : p;
+		for (std::uint32_t i = 0u; i < indices_per_primitive; ++i) {
+			auto const vertex = indices[primitive * indices_per_primitive + i];
+			assert(vertex < vertices_nb);
+			if (time - loaded_at[vertex] > cache_size) {
+				loaded_at[vertex] = time++;
+				++misses_nb;
+			}
+		}
+	}
+
+	return static_cast<float>(misses_nb) / static_cast<float>(primitives_nb);
+}
+
+std::vector<std::uint32_t>
+bonobo::vertex_cache::order_triangles(std::uint32_t const* indices, std::size_t triangles_nb,
+                                      std::uint32_t vertices_nb, std::uint32_t cache_size)
+{
+	// Triangles referencing each vertex, in a compressed sparse row
+	// layout; |live_triangles_nb| counts those not emitted yet.
+	std::vector<std::uint32_t> live_triangles_nb(vertices_nb, 0u);
+	for (std::size_t i = 0u; i < triangles_nb * 3u; ++i) {
+		assert(indices[i] < vertices_nb);
+		++live_triangles_nb[indices[i]];
+	}
+	std::vector<std::uint32_t> first_triangle(static_cast<std::size_t>(vertices_nb) + 1u, 0u);
+	for (std::uint32_t v = 0u; v < vertices_nb; ++v)
+		first_triangle[v + 1u] = first_triangle[v] + live_triangles_nb[v];
+	std::vector<std::uint32_t> vertex_triangles(triangles_nb * 3u);
+	{
+		auto fill_position = first_triangle;
+		for (std::size_t i = 0u; i < triangles_nb * 3u; ++i)
+			vertex_triangles[fill_position[indices[i]]++] = static_cast<std::uint32_t>(i / 3u);
+	}
+
+	std::vector<std::uint64_t> loaded_at(vertices_nb, 0u);
+	auto time = static_cast<std::uint64_t>(cache_size) + 1u;
+	std::vector<bool> is_emitted(triangles_nb, false);
+	std::vector<std::uint32_t> dead_end_stack;
+	std::vector<std::uint32_t> candidates;
+	dead_end_stack.reserve(triangles_nb * 3u);
+	std::uint32_t next_unvisited = 0u;
+
+	std::vector<std::uint32_t> order;
+	order.reserve(triangles_nb);
+	auto fanning_vertex = vertices_nb != 0u ? 0u : invalid_index;
+	while (fanning_vertex != invalid_index) {
+		candidates.clear();
+		for (auto t = first_triangle[fanning_vertex]; t < first_triangle[fanning_vertex + 1u]; ++t) {
+			auto const triangle = vertex_triangles[t];
+			if (is_emitted[triangle])
+				continue;
+
+			for (std::uint32_t c = 0u; c < 3u; ++c) {
+				auto const vertex = indices[3u * triangle + c];
+				dead_end_stack.push_back(vertex);
+				candidates.push_back(vertex);
+				--live_triangles_nb[vertex];
+				if (time - loaded_at[vertex] > cache_size)
+					loaded_at[vertex] = time++;
+			}
+			is_emitted[triangle] = true;
+			order.push_back(triangle);
+		}
+
+		// Prefer the candidate which entered the cache the earliest,
+		// provided it will still be there once its remaining triangles
+		// are emitted.
+		fanning_vertex = invalid_index;
+		std::int64_t best_priority = -1;
+		for (auto const vertex : candidates) {
+			if (live_triangles_nb[vertex] == 0u)
+				continue;
+			std::int64_t priority = 0;
+			auto const age = static_cast<std::int64_t>(time - loaded_at[vertex]);
+			if (age + 2 * static_cast<std::int64_t>(live_triangles_nb[vertex]) <= static_cast<std::int64_t>(cache_size))
+				priority = age;
+			if (priority > best_priority) {
+				best_priority = priority;
+				fanning_vertex = vertex;
+			}
+		}
+
+		// Dead end: go back to recently used vertices, and then to any
+		// vertex with triangles left.
+		while (fanning_vertex == invalid_index && !dead_end_stack.empty()) {
+			auto const vertex = dead_end_stack.back();
+			dead_end_stack.pop_back();
+			if (live_triangles_nb[vertex] != 0u)
+				fanning_vertex = vertex;
+		}
+		for (; fanning_vertex == invalid_index && next_unvisited < vertices_nb; ++next_unvisited)
+			if (live_triangles_nb[next_unvisited] != 0u)
+				fanning_vertex = next_unvisited;
+	}
+
+	assert(order.size() == triangles_nb);
+	return order;
+}
+
+std::vector<std::uint32_t>
+bonobo::vertex_cache::order_vertices(std::uint32_t const* indices, std::size_t indices_nb,
+                                     std::uint32_t vertices_nb, std::uint32_t& used_vertices_nb)
+{
+	std::vector<std::uint32_t> remap(vertices_nb, invalid_index);
+	used_vertices_nb = 0u;
+	for (std::size_t i = 0u; i < indices_nb; ++i) {
+		assert(indices[i] < vertices_nb);
+		if (remap[indices[i]] == invalid_index)
+			remap[indices[i]] = used_vertices_nb++;
+	}
+	return remap;
+}
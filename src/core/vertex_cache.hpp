@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Helpers for ordering triangles and vertices so that the
+	//!        post-transform vertex cache and vertex fetches are used
+	//!        efficiently.
+	namespace vertex_cache
+	{
+		struct config
+		{
+			bool is_enabled{true};         //!< whether meshes get reordered at all
+			std::uint32_t cache_size{16u}; //!< number of entries of the FIFO cache being optimised for
+		};
+
+		//! \brief Average number of vertices transformed per primitive
+		//!        (ACMR), simulating a FIFO cache of |cache_size| entries.
+		//!
+		//! @param [in] indices |indices_per_primitive| indices per
+		//!             primitive; all of them go through the cache, as
+		//!             adjacent vertices also get transformed by
+		//!             GL_TRIANGLES_ADJACENCY draws
+		//! @param [in] primitives_nb number of primitives in |indices|
+		//! @param [in] indices_per_primitive i.e. 3 for GL_TRIANGLES,
+		//!             6 for GL_TRIANGLES_ADJACENCY
+		//! @param [in] vertices_nb all indices have to be strictly less
+		//!             than this value
+		//! @param [in] cache_size number of entries of the cache
+		//! @param [in] primitive_order if set, primitives are drawn in
+		//!             that order rather than the one of |indices|
+		float acmr(std::uint32_t const* indices, std::size_t primitives_nb,
+		           std::uint32_t indices_per_primitive, std::uint32_t vertices_nb,
+		           std::uint32_t cache_size, std::uint32_t const* primitive_order = nullptr);
+
+		//! \brief Order triangles to maximise vertex cache hits, following
+		//!        Sander et al.'s Tipsify.
+		//!
+		//! Triangles are emitted in fans around one vertex at a time; the
+		//! next vertex is picked among the ones just referenced, favouring
+		//! those still in the cache which have few triangles left, and
+		//! falling back to recently used vertices when all of them are
+		//! done. This runs in linear time, unlike Forsyth's score-based
+		//! approach, for a similar cache hit rate.
+		//!
+		//! Only the order of whole triangles changes, and each triangle
+		//! keeps its own winding, so adjacency indices built from the
+		//! reordered triangles stay valid.
+		//!
+		//! @param [in] indices three indices per triangle
+		//! @param [in] triangles_nb number of triangles in |indices|
+		//! @param [in] vertices_nb all indices have to be strictly less
+		//!             than this value
+		//! @param [in] cache_size number of entries of the cache
+		//! @return for each position in the new order, the index of the
+		//!         triangle to be drawn there
+		std::vector<std::uint32_t> order_triangles(std::uint32_t const* indices,
+		                                           std::size_t triangles_nb,
+		                                           std::uint32_t vertices_nb,
+		                                           std::uint32_t cache_size);
+
+		//! \brief Number vertices in the order they are first referenced,
+		//!        so that vertex fetches walk through memory linearly.
+		//!
+		//! @param [in] indices index buffer, in drawing order
+		//! @param [in] indices_nb number of indices in |indices|
+		//! @param [in] vertices_nb all indices have to be strictly less
+		//!             than this value
+		//! @param [out] used_vertices_nb number of vertices referenced by
+		//!              |indices|, which get numbered from 0 onwards
+		//! @return for each vertex, its new index, or UINT32_MAX if it is
+		//!         never referenced and can be dropped
+		std::vector<std::uint32_t> order_vertices(std::uint32_t const* indices,
+		                                          std::size_t indices_nb,
+		                                          std::uint32_t vertices_nb,
+		                                          std::uint32_t& used_vertices_nb);
+	}
+}
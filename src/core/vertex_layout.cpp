@@ -0,0 +1,151 @@
+#include "vertex_layout.hpp"
+
+#include <glm/gtc/packing.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	// Texture coordinates come first, as the silhouette passes read them
+	// on top of the positions stream, followed by the directions.
+	constexpr std::array<std::size_t, 4> interleaved_order{{2u, 1u, 3u, 4u}};
+
+	float signNotZero(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	//! \brief Write the three floats at |source| as |type| to |destination|.
+	void encode(bonobo::vertex_layout::format type, float const* source, std::uint8_t* destination)
+	{
+		using bonobo::vertex_layout::format;
+
+		switch (type) {
+		case format::float3:
+			std::memcpy(destination, source, 3u * sizeof(float));
+			break;
+		case format::snorm_10_10_10_2:
+		{
+			auto const packed = glm::packSnorm3x10_1x2(glm::vec4(source[0], source[1], source[2], 0.0f));
+			std::memcpy(destination, &packed, sizeof(packed));
+			break;
+		}
+		case format::octahedral_snorm16:
+		{
+			auto const packed = static_cast<std::uint32_t>(glm::packSnorm2x16(bonobo::vertex_layout::encode_octahedral(glm::vec3(source[0], source[1], source[2]))));
+			std::memcpy(destination, &packed, sizeof(packed));
+			break;
+		}
+		case format::half2:
+		{
+			auto const packed = static_cast<std::uint32_t>(glm::packHalf2x16(glm::vec2(source[0], source[1])));
+			std::memcpy(destination, &packed, sizeof(packed));
+			break;
+		}
+		default:
+			assert(false);
+		}
+	}
+}
+
+std::uint32_t
+bonobo::vertex_layout::size_of(format type)
+{
+	switch (type) {
+	case format::float3:
+		return 3u * sizeof(float);
+	case format::snorm_10_10_10_2:
+	case format::octahedral_snorm16:
+	case format::half2:
+		return 4u;
+	default:
+		return 0u;
+	}
+}
+
+bool
+bonobo::vertex_layout::fits(attribute const& attribute, std::uint32_t vertices_nb, std::uint64_t data_size)
+{
+	if (attribute.offset < 0)
+		return true;
+	if (attribute.type >= format::count || attribute.offset % 4 != 0 || attribute.stride % 4u != 0u)
+		return false;
+	if (vertices_nb == 0u)
+		return static_cast<std::uint64_t>(attribute.offset) <= data_size;
+
+	auto const last = static_cast<std::uint64_t>(attribute.offset) + (vertices_nb - 1u) * static_cast<std::uint64_t>(attribute.stride);
+	return last <= data_size && size_of(attribute.type) <= data_size - last;
+}
+
+glm::vec2
+bonobo::vertex_layout::encode_octahedral(glm::vec3 const& direction)
+{
+	auto const l1_norm = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+	if (l1_norm == 0.0f)
+		return glm::vec2(0.0f, 0.0f);
+
+	auto u = direction.x / l1_norm;
+	auto v = direction.y / l1_norm;
+	if (direction.z < 0.0f) {
+		auto const folded_u = (1.0f - std::abs(v)) * signNotZero(u);
+		v = (1.0f - std::abs(u)) * signNotZero(v);
+		u = folded_u;
+	}
+	return glm::vec2(u, v);
+}
+
+glm::vec3
+bonobo::vertex_layout::decode_octahedral(glm::vec2 const& encoded)
+{
+	auto x = encoded.x;
+	auto y = encoded.y;
+	auto const z = 1.0f - std::abs(x) - std::abs(y);
+	if (z < 0.0f) {
+		auto const unfolded_x = (1.0f - std::abs(y)) * signNotZero(x);
+		y = (1.0f - std::abs(x)) * signNotZero(y);
+		x = unfolded_x;
+	}
+	auto const length = std::sqrt(x * x + y * y + z * z);
+	return glm::vec3(x / length, y / length, z / length);
+}
+
+void
+bonobo::vertex_layout::build(config const& layout_config, std::uint32_t vertices_nb,
+                             std::array<float const*, 5> const& sources,
+                             std::vector<std::uint8_t>& vertex_data, attributes& layout)
+{
+	assert(sources[0] != nullptr);
+	assert(layout_config.directions == format::float3 || layout_config.directions == format::snorm_10_10_10_2 || layout_config.directions == format::octahedral_snorm16);
+	assert(layout_config.texcoords == format::float3 || layout_config.texcoords == format::half2);
+
+	layout = attributes();
+	layout[0].offset = 0;
+	layout[0].stride = size_of(format::float3);
+	layout[0].type = format::float3;
+
+	std::uint32_t interleaved_stride = 0u;
+	for (auto const a : interleaved_order) {
+		if (sources[a] == nullptr)
+			continue;
+		layout[a].type = (a == 2u) ? layout_config.texcoords : layout_config.directions;
+		layout[a].offset = interleaved_stride;
+		interleaved_stride += size_of(layout[a].type);
+	}
+
+	auto const positions_size = static_cast<std::size_t>(vertices_nb) * layout[0].stride;
+	vertex_data.resize(positions_size + static_cast<std::size_t>(vertices_nb) * interleaved_stride);
+	std::memcpy(vertex_data.data(), sources[0], positions_size);
+
+	for (auto const a : interleaved_order) {
+		if (sources[a] == nullptr)
+			continue;
+		layout[a].offset += static_cast<std::int64_t>(positions_size);
+		layout[a].stride = interleaved_stride;
+
+		auto* destination = vertex_data.data() + layout[a].offset;
+		for (std::uint32_t v = 0u; v < vertices_nb; ++v, destination += interleaved_stride)
+			encode(layout[a].type, sources[a] + 3u * v, destination);
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief How the attributes of a mesh are encoded and laid out in its
+	//!        vertex buffer.
+	//!
+	//! Each vertex buffer holds two streams, one after the other: the
+	//! positions alone, as three floats per vertex, which is all the
+	//! silhouette passes fetch besides texture coordinates, followed by
+	//! all other attributes interleaved, which only the G-buffer pass
+	//! reads in full. Directions (normals, tangents and binormals) and
+	//! texture coordinates can be quantised, bringing a fully-featured
+	//! vertex from 60 bytes down to 28.
+	//!
+	//! Nothing in here touches OpenGL; `uploadSceneData()` maps each
+	//! `format` to the matching `glVertexAttribPointer()` arguments.
+	namespace vertex_layout
+	{
+		enum class format : std::uint32_t
+		{
+			float3 = 0u,        //!< three 32-bit floats, 12 bytes
+			snorm_10_10_10_2,   //!< normalised GL_INT_2_10_10_10_REV, 4 bytes; w is left at 0
+			octahedral_snorm16, //!< two normalised 16-bit integers, 4 bytes, see `encode_octahedral()`
+			half2,              //!< two 16-bit floats, 4 bytes; drops the third texture coordinate
+			count
+		};
+
+		//! \brief Where an attribute lives within a vertex buffer.
+		struct attribute
+		{
+			std::int64_t offset{-1};       //!< byte offset of the first vertex, or -1 if the attribute is missing
+			std::uint32_t stride{0u};      //!< bytes between two consecutive vertices
+			format type{format::float3};
+		};
+
+		//! \brief Layout of all attributes of a mesh, indexed by
+		//!        `shader_bindings`.
+		using attributes = std::array<attribute, 5>;
+
+		//! \brief How to encode the attributes which can be quantised;
+		//!        positions always are stored as three floats.
+		struct config
+		{
+			format directions{format::snorm_10_10_10_2}; //!< float3, snorm_10_10_10_2 or octahedral_snorm16
+			format texcoords{format::half2};             //!< float3 or half2
+		};
+
+		//! \brief Size in bytes of one element of |type|.
+		std::uint32_t size_of(format type);
+
+		//! \brief Check |attribute| lies within a vertex buffer of
+		//!        |data_size| bytes holding |vertices_nb| vertices;
+		//!        missing attributes always fit.
+		bool fits(attribute const& attribute, std::uint32_t vertices_nb, std::uint64_t data_size);
+
+		//! \brief Map a unit vector onto the [-1, 1]² square, by
+		//!        projecting it onto an octahedron and unfolding its lower
+		//!        half; a lot more precise than 10:10:10:2 for the same
+		//!        size once stored as two snorm16.
+		glm::vec2 encode_octahedral(glm::vec3 const& direction);
+
+		//! \brief Inverse of `encode_octahedral()`, as done by
+		//!        `NPR/fill_gbuffer.vert`.
+		glm::vec3 decode_octahedral(glm::vec2 const& encoded);
+
+		//! \brief Encode and lay out the attributes of a mesh.
+		//!
+		//! @param [in] layout_config how to encode the attributes
+		//! @param [in] vertices_nb number of vertices of the mesh
+		//! @param [in] sources three floats per vertex for each attribute,
+		//!             indexed by `shader_bindings`, or nullptr for
+		//!             missing ones; positions are required
+		//! @param [out] vertex_data content of the vertex buffer
+		//! @param [out] layout where each attribute got stored in
+		//!              |vertex_data|
+		void build(config const& layout_config, std::uint32_t vertices_nb,
+		           std::array<float const*, 5> const& sources,
+		           std::vector<std::uint8_t>& vertex_data, attributes& layout);
+	}
+}
@@ -0,0 +1,216 @@
+#include "welding.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+	constexpr std::uint32_t invalid_index = std::numeric_limits<std::uint32_t>::max();
+
+	// The bits of a position, for exact welding.
+	using ExactKey = std::array<std::uint32_t, 3>;
+
+	// Wide enough for the grid cells of far away positions as well.
+	using CellKey = std::array<std::uint64_t, 3>;
+
+	//! \brief Open-addressing hash table with linear probing, mapping
+	//!        three words to a 32-bit value.
+	//!
+	//! All slots live in a single flat array and nothing is ever removed,
+	//! which keeps lookups to a handful of contiguous memory accesses.
+	template<typename Key>
+	class FlatTable
+	{
+	public:
+		explicit FlatTable(std::uint32_t expected_entries)
+		{
+			std::size_t capacity = 16u;
+			while (capacity < 2u * static_cast<std::size_t>(expected_entries))
+				capacity <<= 1u;
+			_slots.resize(capacity);
+			_mask = capacity - 1u;
+		}
+
+		//! \brief Return the value stored for |key|, or |invalid_index|.
+		std::uint32_t find(Key const& key) const
+		{
+			for (auto i = hash(key) & _mask;; i = (i + 1u) & _mask) {
+				auto const& slot = _slots[i];
+				if (slot.value == invalid_index)
+					return invalid_index;
+				if (slot.key == key)
+					return slot.value;
+			}
+		}
+
+		//! \brief Return the value stored for |key|, storing |value| first
+		//!        if |key| was not present yet.
+		std::uint32_t findOrInsert(Key const& key, std::uint32_t value)
+		{
+			assert(value != invalid_index);
+			for (auto i = hash(key) & _mask;; i = (i + 1u) & _mask) {
+				auto& slot = _slots[i];
+				if (slot.value == invalid_index) {
+					slot.key = key;
+					slot.value = value;
+					return value;
+				}
+				if (slot.key == key)
+					return slot.value;
+			}
+		}
+
+		//! \brief Replace the value stored for |key|, inserting it if
+		//!        needed.
+		void assign(Key const& key, std::uint32_t value)
+		{
+			for (auto i = hash(key) & _mask;; i = (i + 1u) & _mask) {
+				auto& slot = _slots[i];
+				if (slot.value == invalid_index || slot.key == key) {
+					slot.key = key;
+					slot.value = value;
+					return;
+				}
+			}
+		}
+
+	private:
+		struct Slot
+		{
+			Key key{};
+			std::uint32_t value{invalid_index};
+		};
+
+		static std::size_t hash(Key const& key)
+		{
+			// Mix all bits of each word, so that positions differing only in
+			// their low mantissa bits still end up far apart.
+			std::uint64_t h = 0x9E3779B97F4A7C15ULL;
+			for (auto const word : key) {
+				h ^= static_cast<std::uint64_t>(word);
+				h *= 0xFF51AFD7ED558CCDULL;
+				h ^= h >> 32u;
+			}
+			return static_cast<std::size_t>(h);
+		}
+
+		std::vector<Slot> _slots;
+		std::size_t _mask{0u};
+	};
+
+	//! \brief Cells are clamped to well within the range of 64-bit
+	//!        integers, so that the cell and its neighbours can be computed
+	//!        without overflowing; positions this far away end up sharing
+	//!        cells, which only makes their welding slower.
+	constexpr double max_cell = 4611686018427387904.0; // 2^62
+
+	std::int64_t getCell(float coordinate, double inverse_cell_size)
+	{
+		auto const cell = std::floor(static_cast<double>(coordinate) * inverse_cell_size);
+		return static_cast<std::int64_t>(std::min(std::max(cell, -max_cell), max_cell));
+	}
+
+	std::uint32_t floatBits(float value)
+	{
+		// -0 and +0 compare equal, so they should weld as well.
+		if (value == 0.0f)
+			value = 0.0f;
+
+		std::uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	bonobo::welding::result weldExact(float const* positions, std::uint32_t vertices_nb)
+	{
+		bonobo::welding::result result;
+		result.remap.resize(vertices_nb);
+
+		FlatTable<ExactKey> table(vertices_nb);
+		for (std::uint32_t i = 0u; i < vertices_nb; ++i) {
+			auto const* position = positions + 3u * static_cast<std::size_t>(i);
+			auto const key = ExactKey{floatBits(position[0]), floatBits(position[1]), floatBits(position[2])};
+			result.remap[i] = table.findOrInsert(key, i);
+			if (result.remap[i] == i)
+				++result.unique_vertices_nb;
+		}
+
+		return result;
+	}
+
+	bonobo::welding::result weldGrid(float const* positions, std::uint32_t vertices_nb, float epsilon)
+	{
+		bonobo::welding::result result;
+		result.remap.resize(vertices_nb);
+
+		// Each cell stores the most recently kept vertex it contains, and
+		// |next_in_cell| chains it to the previous ones.
+		std::vector<std::uint32_t> next_in_cell(vertices_nb, invalid_index);
+		FlatTable<CellKey> table(vertices_nb);
+
+		auto const inverse_cell_size = 1.0 / static_cast<double>(epsilon);
+		for (std::uint32_t i = 0u; i < vertices_nb; ++i) {
+			auto const* position = positions + 3u * static_cast<std::size_t>(i);
+
+			// NaNs and infinities are never within |epsilon| of anything,
+			// and have no cell; they are kept as they are.
+			if (!std::isfinite(position[0]) || !std::isfinite(position[1]) || !std::isfinite(position[2])) {
+				result.remap[i] = i;
+				++result.unique_vertices_nb;
+				continue;
+			}
+
+			std::array<std::int64_t, 3> cell;
+			for (std::size_t axis = 0u; axis < 3u; ++axis)
+				cell[axis] = getCell(position[axis], inverse_cell_size);
+
+			auto match = invalid_index;
+			for (std::int64_t dz = -1; dz <= 1 && match == invalid_index; ++dz) {
+				for (std::int64_t dy = -1; dy <= 1 && match == invalid_index; ++dy) {
+					for (std::int64_t dx = -1; dx <= 1 && match == invalid_index; ++dx) {
+						auto const neighbour = CellKey{static_cast<std::uint64_t>(cell[0] + dx),
+						                               static_cast<std::uint64_t>(cell[1] + dy),
+						                               static_cast<std::uint64_t>(cell[2] + dz)};
+						for (auto candidate = table.find(neighbour); candidate != invalid_index; candidate = next_in_cell[candidate]) {
+							auto const* other = positions + 3u * static_cast<std::size_t>(candidate);
+							if (std::abs(other[0] - position[0]) <= epsilon
+							 && std::abs(other[1] - position[1]) <= epsilon
+							 && std::abs(other[2] - position[2]) <= epsilon) {
+								match = candidate;
+								break;
+							}
+						}
+					}
+				}
+			}
+
+			if (match != invalid_index) {
+				result.remap[i] = match;
+				continue;
+			}
+
+			auto const key = CellKey{static_cast<std::uint64_t>(cell[0]),
+			                         static_cast<std::uint64_t>(cell[1]),
+			                         static_cast<std::uint64_t>(cell[2])};
+			next_in_cell[i] = table.find(key);
+			table.assign(key, i);
+			result.remap[i] = i;
+			++result.unique_vertices_nb;
+		}
+
+		return result;
+	}
+}
+
+bonobo::welding::result
+bonobo::welding::weld(float const* positions, std::uint32_t vertices_nb, config const& weld_config)
+{
+	if (weld_config.mode == mode_t::grid && weld_config.epsilon > 0.0f)
+		return weldGrid(positions, vertices_nb, weld_config.epsilon);
+
+	return weldExact(positions, vertices_nb);
+}
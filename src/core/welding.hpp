@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Helpers for merging vertices sharing the same position.
+	namespace welding
+	{
+		enum class mode_t : unsigned int
+		{
+			exact = 0u, //!< only merge positions with identical bits (+0 and -0 being equal)
+			grid        //!< merge positions closer than an epsilon to each other
+		};
+
+		struct config
+		{
+			mode_t mode{mode_t::exact}; //!< how to compare positions
+			float epsilon{1e-5f};       //!< largest distance, per axis, between merged positions; ignored in exact mode
+		};
+
+		struct result
+		{
+			std::vector<std::uint32_t> remap;   //!< for each input vertex, index of the vertex it was merged into
+			std::uint32_t unique_vertices_nb{0u}; //!< number of vertices that were kept
+		};
+
+		//! \brief Find which vertices share the same position.
+		//!
+		//! Vertices are looked up in order in an open-addressing hash
+		//! table, and are merged into the first vertex seen with a
+		//! matching position. In grid mode, positions are bucketed in
+		//! cells of size |epsilon| and the 27 cells around each vertex are
+		//! searched, so that no match is missed across cell borders.
+		//!
+		//! @param [in] positions three floats per vertex
+		//! @param [in] vertices_nb number of vertices in |positions|
+		//! @param [in] weld_config how positions should be compared
+		//! @return the remapping table, along with how many vertices were
+		//!         kept
+		result weld(float const* positions, std::uint32_t vertices_nb,
+		            config const& weld_config = config{});
+	}
+}
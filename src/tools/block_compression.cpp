@@ -0,0 +1,194 @@
+#include "block_compression.hpp"
+
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+	using color = std::array<float, 4>;
+
+	constexpr std::uint32_t bc7_weights[16] = {0u, 4u, 9u, 13u, 17u, 21u, 26u, 30u, 34u, 38u, 43u, 47u, 51u, 55u, 60u, 64u};
+
+	struct bc7_mode6_candidate
+	{
+		std::array<std::uint32_t, 4> endpoints[2]; // 7-bit values
+		std::uint32_t pbits[2];
+		std::uint8_t indices[16];
+		float error;
+	};
+
+	float dot(color const& lhs, color const& rhs)
+	{
+		return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2] + lhs[3] * rhs[3];
+	}
+
+	// Quantise |low| and |high| for each combination of p-bits, and keep
+	// the one whose palette best fits the texels.
+	void quantiseEndpoints(color const texels[16], color const& low, color const& high, bc7_mode6_candidate& best)
+	{
+		for (std::uint32_t pbits = 0u; pbits < 4u; ++pbits) {
+			bc7_mode6_candidate candidate;
+			candidate.pbits[0] = pbits & 1u;
+			candidate.pbits[1] = pbits >> 1u;
+
+			std::array<std::uint32_t, 4> expanded[2];
+			for (std::uint32_t e = 0u; e < 2u; ++e) {
+				auto const& value = e == 0u ? low : high;
+				for (std::uint32_t c = 0u; c < 4u; ++c) {
+					auto const quantised = std::lround((value[c] - static_cast<float>(candidate.pbits[e])) * 0.5f);
+					candidate.endpoints[e][c] = static_cast<std::uint32_t>(std::min(std::max(quantised, 0L), 127L));
+					expanded[e][c] = (candidate.endpoints[e][c] << 1u) | candidate.pbits[e];
+				}
+			}
+
+			color palette[16];
+			for (std::uint32_t i = 0u; i < 16u; ++i)
+				for (std::uint32_t c = 0u; c < 4u; ++c)
+					palette[i][c] = static_cast<float>(((64u - bc7_weights[i]) * expanded[0][c] + bc7_weights[i] * expanded[1][c] + 32u) >> 6u);
+
+			candidate.error = 0.0f;
+			for (std::uint32_t t = 0u; t < 16u; ++t) {
+				auto best_distance = std::numeric_limits<float>::max();
+				for (std::uint32_t i = 0u; i < 16u; ++i) {
+					color difference;
+					for (std::uint32_t c = 0u; c < 4u; ++c)
+						difference[c] = texels[t][c] - palette[i][c];
+					auto const distance = dot(difference, difference);
+					if (distance < best_distance) {
+						best_distance = distance;
+						candidate.indices[t] = static_cast<std::uint8_t>(i);
+					}
+				}
+				candidate.error += best_distance;
+			}
+
+			if (candidate.error < best.error)
+				best = candidate;
+		}
+	}
+
+	void compressBC7Mode6(std::uint8_t const texels_rgba8[64], std::uint8_t* block)
+	{
+		color texels[16];
+		color mean = {0.0f, 0.0f, 0.0f, 0.0f};
+		for (std::uint32_t t = 0u; t < 16u; ++t)
+			for (std::uint32_t c = 0u; c < 4u; ++c) {
+				texels[t][c] = static_cast<float>(texels_rgba8[4u * t + c]);
+				mean[c] += texels[t][c] / 16.0f;
+			}
+
+		// Principal axis of the texels, through power iteration on their
+		// covariance matrix.
+		float covariance[4][4] = {};
+		for (auto const& texel : texels)
+			for (std::uint32_t i = 0u; i < 4u; ++i)
+				for (std::uint32_t j = 0u; j < 4u; ++j)
+					covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+		color axis = {1.0f, 1.0f, 1.0f, 1.0f};
+		for (std::uint32_t iteration = 0u; iteration < 8u; ++iteration) {
+			color next = {0.0f, 0.0f, 0.0f, 0.0f};
+			for (std::uint32_t i = 0u; i < 4u; ++i)
+				for (std::uint32_t j = 0u; j < 4u; ++j)
+					next[i] += covariance[i][j] * axis[j];
+			auto const length = std::sqrt(dot(next, next));
+			if (length < 1e-6f)
+				break;
+			for (std::uint32_t i = 0u; i < 4u; ++i)
+				axis[i] = next[i] / length;
+		}
+
+		auto t_min = std::numeric_limits<float>::max();
+		auto t_max = std::numeric_limits<float>::lowest();
+		for (auto const& texel : texels) {
+			color offset;
+			for (std::uint32_t c = 0u; c < 4u; ++c)
+				offset[c] = texel[c] - mean[c];
+			auto const t = dot(offset, axis);
+			t_min = std::min(t_min, t);
+			t_max = std::max(t_max, t);
+		}
+		color low, high;
+		for (std::uint32_t c = 0u; c < 4u; ++c) {
+			low[c] = std::min(std::max(mean[c] + t_min * axis[c], 0.0f), 255.0f);
+			high[c] = std::min(std::max(mean[c] + t_max * axis[c], 0.0f), 255.0f);
+		}
+
+		bc7_mode6_candidate best;
+		best.error = std::numeric_limits<float>::max();
+		quantiseEndpoints(texels, low, high, best);
+
+		// Refine the endpoints once by least squares, keeping the indices
+		// just found.
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		color ax = {0.0f, 0.0f, 0.0f, 0.0f}, bx = {0.0f, 0.0f, 0.0f, 0.0f};
+		for (std::uint32_t t = 0u; t < 16u; ++t) {
+			auto const w = static_cast<float>(bc7_weights[best.indices[t]]) / 64.0f;
+			aa += (1.0f - w) * (1.0f - w);
+			ab += (1.0f - w) * w;
+			bb += w * w;
+			for (std::uint32_t c = 0u; c < 4u; ++c) {
+				ax[c] += (1.0f - w) * texels[t][c];
+				bx[c] += w * texels[t][c];
+			}
+		}
+		auto const determinant = aa * bb - ab * ab;
+		if (std::abs(determinant) > 1e-6f) {
+			for (std::uint32_t c = 0u; c < 4u; ++c) {
+				low[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / determinant, 0.0f), 255.0f);
+				high[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / determinant, 0.0f), 255.0f);
+			}
+			quantiseEndpoints(texels, low, high, best);
+		}
+
+		// The most significant bit of the first index is implicitly zero.
+		if (best.indices[0] >= 8u) {
+			std::swap(best.endpoints[0], best.endpoints[1]);
+			std::swap(best.pbits[0], best.pbits[1]);
+			for (auto& index : best.indices)
+				index = static_cast<std::uint8_t>(15u - index);
+		}
+
+		std::uint64_t bits[2] = {0u, 0u};
+		std::uint32_t position = 0u;
+		auto const write = [&bits, &position](std::uint64_t value, std::uint32_t count) {
+			for (std::uint32_t i = 0u; i < count; ++i, ++position)
+				bits[position / 64u] |= ((value >> i) & 1u) << (position % 64u);
+		};
+		write(1u << 6u, 7u);
+		for (std::uint32_t c = 0u; c < 4u; ++c) {
+			write(best.endpoints[0][c], 7u);
+			write(best.endpoints[1][c], 7u);
+		}
+		write(best.pbits[0], 1u);
+		write(best.pbits[1], 1u);
+		write(best.indices[0], 3u);
+		for (std::uint32_t t = 1u; t < 16u; ++t)
+			write(best.indices[t], 4u);
+
+		for (std::uint32_t i = 0u; i < 16u; ++i)
+			block[i] = static_cast<std::uint8_t>(bits[i / 8u] >> (8u * (i % 8u)));
+	}
+}
+
+void
+block_compression::compress_block(bonobo::texture_container::format const block_format,
+                                  std::uint8_t const texels[64], std::uint8_t* const block)
+{
+	switch (block_format) {
+	case bonobo::texture_container::format::bc1:
+		stb_compress_dxt_block(block, texels, 0, STB_DXT_HIGHQUAL);
+		break;
+	case bonobo::texture_container::format::bc3:
+		stb_compress_dxt_block(block, texels, 1, STB_DXT_HIGHQUAL);
+		break;
+	case bonobo::texture_container::format::bc7:
+		compressBC7Mode6(texels, block);
+		break;
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "core/texture_container.hpp"
+
+#include <cstdint>
+
+namespace block_compression
+{
+	//! \brief Encode one 4×4 block of RGBA8 texels, stored row by row.
+	//!
+	//! BC1 and BC3 go through stb_dxt in its high-quality mode. BC7 only
+	//! uses mode 6, a single RGBA line with sixteen interpolation steps,
+	//! whose endpoints follow the principal axis of the block before being
+	//! refined once by least squares.
+	//!
+	//! @param [in] block_format BC1, BC3 or BC7
+	//! @param [in] texels the 16 texels of the block
+	//! @param [out] block 8 bytes for BC1, 16 bytes otherwise
+	void compress_block(bonobo::texture_container::format block_format,
+	                    std::uint8_t const texels[64], std::uint8_t* block);
+}
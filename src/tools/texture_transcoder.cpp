@@ -0,0 +1,256 @@
+// Convert images into block-compressed DDS or KTX2 containers, with their
+// whole mipmap chain, so that `bonobo::loadTexture2D()` can upload them
+// as is instead of decoding them and generating mipmaps at load time.
+
+#include "block_compression.hpp"
+
+#include "core/parallel.hpp"
+#include "core/texture_container.hpp"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using bonobo::texture_container::compressed_image;
+	using bonobo::texture_container::format;
+
+	struct options
+	{
+		bool pick_format{true};
+		format block_format{format::bc1};
+		std::string container_extension{".ktx2"};
+		bool is_srgb{false};
+		bool generate_mipmap{true};
+		std::vector<std::string> inputs;
+	};
+
+	void printUsage(char const* program)
+	{
+		std::fprintf(stderr,
+		             "Usage: %s [options] <image>...\n"
+		             "\n"
+		             "Each image is written next to itself, with its extension replaced by\n"
+		             "the one of the container.\n"
+		             "\n"
+		             "Options:\n"
+		             "  --format auto|bc1|bc3|bc7  block format; auto picks BC1 for opaque\n"
+		             "                             images and BC3 otherwise (default: auto)\n"
+		             "  --container ktx2|dds       container to write (default: ktx2)\n"
+		             "  --srgb                     mark the texels as sRGB-encoded, and filter\n"
+		             "                             the mipmaps accordingly\n"
+		             "  --no-mipmaps               only store the full-resolution level\n",
+		             program);
+	}
+
+	bool parseOptions(int argc, char* argv[], options& parsed)
+	{
+		for (int i = 1; i < argc; ++i) {
+			auto const argument = std::string(argv[i]);
+			if (argument == "--format" && i + 1 < argc) {
+				auto const value = std::string(argv[++i]);
+				parsed.pick_format = value == "auto";
+				if (value == "bc1")
+					parsed.block_format = format::bc1;
+				else if (value == "bc3")
+					parsed.block_format = format::bc3;
+				else if (value == "bc7")
+					parsed.block_format = format::bc7;
+				else if (value != "auto")
+					return false;
+			} else if (argument == "--container" && i + 1 < argc) {
+				auto const value = std::string(argv[++i]);
+				if (value != "ktx2" && value != "dds")
+					return false;
+				parsed.container_extension = "." + value;
+			} else if (argument == "--srgb") {
+				parsed.is_srgb = true;
+			} else if (argument == "--no-mipmaps") {
+				parsed.generate_mipmap = false;
+			} else if (argument.compare(0u, 2u, "--") == 0) {
+				return false;
+			} else {
+				parsed.inputs.push_back(argument);
+			}
+		}
+
+		return !parsed.inputs.empty();
+	}
+
+	float toLinear(float value)
+	{
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float toSRGB(float value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	// Halve an RGBA8 image with a box filter; sRGB colours are averaged in
+	// linear space, while alpha always is.
+	std::vector<std::uint8_t> downsample(std::vector<std::uint8_t> const& texels, std::uint32_t width, std::uint32_t height, bool is_srgb)
+	{
+		auto const next_width = std::max(width / 2u, 1u);
+		auto const next_height = std::max(height / 2u, 1u);
+		std::vector<std::uint8_t> next(next_width * next_height * 4u);
+
+		for (std::uint32_t y = 0u; y < next_height; ++y)
+			for (std::uint32_t x = 0u; x < next_width; ++x)
+				for (std::uint32_t c = 0u; c < 4u; ++c) {
+					float sum = 0.0f;
+					for (std::uint32_t dy = 0u; dy < 2u; ++dy)
+						for (std::uint32_t dx = 0u; dx < 2u; ++dx) {
+							auto const sx = std::min(2u * x + dx, width - 1u);
+							auto const sy = std::min(2u * y + dy, height - 1u);
+							auto const value = static_cast<float>(texels[(sy * width + sx) * 4u + c]) / 255.0f;
+							sum += is_srgb && c < 3u ? toLinear(value) : value;
+						}
+					auto const average = sum / 4.0f;
+					auto const encoded = is_srgb && c < 3u ? toSRGB(average) : average;
+					next[(y * next_width + x) * 4u + c] = static_cast<std::uint8_t>(std::lround(std::min(std::max(encoded, 0.0f), 1.0f) * 255.0f));
+				}
+
+		return next;
+	}
+
+	// Blocks overlapping the right or top edge replicate the last column
+	// or row of texels.
+	void compressLevel(std::vector<std::uint8_t> const& texels, std::uint32_t width, std::uint32_t height,
+	                   format block_format, std::uint8_t* output)
+	{
+		auto const blocks_x = (width + 3u) / 4u;
+		auto const blocks_y = (height + 3u) / 4u;
+		auto const block_size = bonobo::texture_container::block_size(block_format);
+
+		utils::parallel::for_each_chunk(blocks_y, 4u, [&](std::size_t begin, std::size_t end, std::size_t) {
+			std::uint8_t block_texels[64];
+			for (auto by = static_cast<std::uint32_t>(begin); by < end; ++by)
+				for (std::uint32_t bx = 0u; bx < blocks_x; ++bx) {
+					for (std::uint32_t y = 0u; y < 4u; ++y)
+						for (std::uint32_t x = 0u; x < 4u; ++x) {
+							auto const sx = std::min(4u * bx + x, width - 1u);
+							auto const sy = std::min(4u * by + y, height - 1u);
+							std::memcpy(block_texels + (y * 4u + x) * 4u, texels.data() + (sy * width + sx) * 4u, 4u);
+						}
+					block_compression::compress_block(block_format, block_texels, output + (by * blocks_x + bx) * block_size);
+				}
+		});
+	}
+
+	std::string replaceExtension(std::string const& filename, std::string const& extension)
+	{
+		auto const extension_start = filename.find_last_of('.');
+		auto const separator = filename.find_last_of("/\\");
+		if (extension_start == std::string::npos || (separator != std::string::npos && extension_start < separator))
+			return filename + extension;
+		return filename.substr(0u, extension_start) + extension;
+	}
+
+	float millisecondsSince(std::chrono::high_resolution_clock::time_point start_time)
+	{
+		return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+	}
+
+	bool transcode(std::string const& input, options const& settings)
+	{
+		// Flip the image the same way `bonobo::getTextureData()` does, so
+		// that the blocks end up in the order OpenGL expects.
+		auto const decode_start_time = std::chrono::high_resolution_clock::now();
+		int width = 0, height = 0;
+		stbi_set_flip_vertically_on_load(1);
+		auto* const decoded = stbi_load(input.c_str(), &width, &height, nullptr, 4);
+		if (decoded == nullptr) {
+			std::fprintf(stderr, "Failed to decode \"%s\": %s\n", input.c_str(), stbi_failure_reason());
+			return false;
+		}
+		std::vector<std::uint8_t> texels(decoded, decoded + static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4u);
+		stbi_image_free(decoded);
+		auto const decode_duration = millisecondsSince(decode_start_time);
+
+		compressed_image image;
+		image.width = static_cast<std::uint32_t>(width);
+		image.height = static_cast<std::uint32_t>(height);
+		image.is_srgb = settings.is_srgb;
+		image.block_format = settings.block_format;
+		if (settings.pick_format) {
+			bool is_opaque = true;
+			for (std::size_t i = 3u; i < texels.size() && is_opaque; i += 4u)
+				is_opaque = texels[i] == 255u;
+			image.block_format = is_opaque ? format::bc1 : format::bc3;
+		}
+
+		auto const encode_start_time = std::chrono::high_resolution_clock::now();
+		std::size_t uncompressed_size = 0u;
+		auto level_width = image.width;
+		auto level_height = image.height;
+		for (;;) {
+			bonobo::texture_container::level level;
+			level.width = level_width;
+			level.height = level_height;
+			level.offset = image.data.size();
+			level.size = bonobo::texture_container::level_size(image.block_format, level_width, level_height);
+			image.levels.push_back(level);
+			image.data.resize(level.offset + level.size);
+			compressLevel(texels, level_width, level_height, image.block_format, image.data.data() + level.offset);
+			uncompressed_size += texels.size();
+
+			if (!settings.generate_mipmap || (level_width == 1u && level_height == 1u))
+				break;
+			texels = downsample(texels, level_width, level_height, settings.is_srgb);
+			level_width = std::max(level_width / 2u, 1u);
+			level_height = std::max(level_height / 2u, 1u);
+		}
+		auto const encode_duration = millisecondsSince(encode_start_time);
+
+		auto const output = replaceExtension(input, settings.container_extension);
+		if (!bonobo::texture_container::write(output, image))
+			return false;
+
+		// Read it back the way the application would, to compare with
+		// decoding the source image.
+		auto const read_start_time = std::chrono::high_resolution_clock::now();
+		compressed_image read_back;
+		if (!bonobo::texture_container::read(output, read_back))
+			return false;
+		auto const read_duration = millisecondsSince(read_start_time);
+
+		std::printf("%s -> %s\n"
+		            "  %ux%u, %zu levels, %s%s, encoded in %.1f ms\n"
+		            "  GPU memory: %.1f KiB instead of %.1f KiB as RGBA8 (%.1f:1)\n"
+		            "  Load time: %.3f ms to read instead of %.3f ms to decode\n",
+		            input.c_str(), output.c_str(),
+		            image.width, image.height, image.levels.size(),
+		            bonobo::texture_container::format_name(image.block_format), image.is_srgb ? " sRGB" : "",
+		            encode_duration,
+		            static_cast<float>(image.data.size()) / 1024.0f, static_cast<float>(uncompressed_size) / 1024.0f,
+		            static_cast<float>(uncompressed_size) / static_cast<float>(image.data.size()),
+		            read_duration, decode_duration);
+
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	options settings;
+	if (!parseOptions(argc, argv, settings)) {
+		printUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	int result = EXIT_SUCCESS;
+	for (auto const& input : settings.inputs)
+		if (!transcode(input, settings))
+			result = EXIT_FAILURE;
+
+	return result;
+}